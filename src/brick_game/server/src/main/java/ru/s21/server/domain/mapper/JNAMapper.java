@@ -22,12 +22,12 @@ public class JNAMapper {
         };
     }
 
-    public static StateModel toModel(GameInfo gameInfo) throws IllegalArgumentException {
-        int[][] field = new int[20][10];
-        Pointer[] fieldPointerArray = gameInfo.getField().getPointerArray(0, 20);
+    public static StateModel toModel(GameInfo gameInfo, int rows, int cols) throws IllegalArgumentException {
+        int[][] field = new int[rows][cols];
+        Pointer[] fieldPointerArray = gameInfo.getField().getPointerArray(0, rows);
 
-        for (int i = 0; i < 20; i++) {
-            int[] row = fieldPointerArray[i].getIntArray(0, 10);
+        for (int i = 0; i < rows; i++) {
+            int[] row = fieldPointerArray[i].getIntArray(0, cols);
             field[i] = Arrays.copyOf(row, row.length);
         }
 
@@ -45,6 +45,8 @@ public class JNAMapper {
 
         return StateModel.builder()
                 .field(field)
+                .rows(rows)
+                .cols(cols)
                 .next(next)
                 .level(gameInfo.getLevel())
                 .pause(gameInfo.getPause() == 1)
@@ -34,6 +34,8 @@ public class RaceMapper {
     public static StateModel toModel(State gameState) {
         return StateModel.builder()
                 .field(gameState.field())
+                .rows(gameState.field().length)
+                .cols(gameState.field().length > 0 ? gameState.field()[0].length : 0)
                 .next(gameState.next())
                 .speed(gameState.speed())
                 .level(gameState.level())
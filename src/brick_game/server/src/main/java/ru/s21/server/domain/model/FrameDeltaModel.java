@@ -0,0 +1,15 @@
+package ru.s21.server.domain.model;
+
+import lombok.Builder;
+import lombok.Data;
+
+@Data
+@Builder
+public class FrameDeltaModel {
+    long generation;
+    long base;
+    // Серии измененных клеток: индекс, длина, значения, ...
+    int[] changes;
+    GameStatusModel status;
+    StateModel state;
+}
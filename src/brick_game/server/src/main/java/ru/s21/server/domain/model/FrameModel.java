@@ -0,0 +1,13 @@
+package ru.s21.server.domain.model;
+
+import lombok.Builder;
+import lombok.Data;
+
+@Data
+@Builder
+public class FrameModel {
+    // Растет при каждом изменении статуса или состояния игры
+    long generation;
+    GameStatusModel status;
+    StateModel state;
+}
@@ -7,6 +7,8 @@ import lombok.Data;
 @Builder
 public class StateModel {
     int[][] field;
+    int rows;
+    int cols;
     int[][] next;
     int score;
     int highScore;
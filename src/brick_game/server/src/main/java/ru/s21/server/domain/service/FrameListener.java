@@ -0,0 +1,14 @@
+package ru.s21.server.domain.service;
+
+import ru.s21.server.domain.model.FrameModel;
+
+public interface FrameListener {
+    /**
+     * Receives a frame with a new generation.
+     *
+     * @return false to unsubscribe
+     */
+    boolean onFrame(FrameModel frame);
+
+    void onClose();
+}
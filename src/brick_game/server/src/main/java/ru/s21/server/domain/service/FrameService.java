@@ -0,0 +1,141 @@
+package ru.s21.server.domain.service;
+
+import org.springframework.beans.factory.annotation.Value;
+import org.springframework.scheduling.annotation.Scheduled;
+import org.springframework.stereotype.Service;
+import ru.s21.server.domain.model.FrameDeltaModel;
+import ru.s21.server.domain.model.FrameModel;
+import ru.s21.server.domain.model.GameStatusModel;
+import ru.s21.server.domain.model.StateModel;
+
+import java.util.ArrayDeque;
+import java.util.Arrays;
+import java.util.Deque;
+import java.util.List;
+import java.util.concurrent.CopyOnWriteArrayList;
+
+/**
+ * Numbers the frames of the current game: the generation grows only when
+ * the status or the state differ from the previous capture, so clients can
+ * tell a new frame from the one they already have. The last frames are
+ * kept to send a client only the cells changed since the one it has.
+ */
+@Service
+public class FrameService {
+    private final List<FrameListener> listeners = new CopyOnWriteArrayList<>();
+    private final Deque<FrameModel> history = new ArrayDeque<>();
+    private final int historySize;
+    private GameService gameService;
+    private FrameModel lastFrame;
+    private long generation;
+    private long publishedGeneration;
+
+    public FrameService(@Value("${brickgame.frame-history:64}") int historySize) {
+        this.historySize = historySize;
+    }
+
+    public synchronized void setGameService(GameService gameService) {
+        this.gameService = gameService;
+        lastFrame = null;
+        history.clear();
+        if (gameService == null) {
+            listeners.forEach(FrameListener::onClose);
+            listeners.clear();
+        }
+    }
+
+    public synchronized FrameModel capture() {
+        GameStatusModel status = gameService.getGameStatus();
+        StateModel state = gameService.updateCurrentState();
+        if (lastFrame == null || lastFrame.getStatus() != status || !lastFrame.getState().equals(state)) {
+            lastFrame = FrameModel.builder()
+                    .generation(++generation)
+                    .status(status)
+                    .state(state)
+                    .build();
+            history.addLast(lastFrame);
+            if (history.size() > historySize) {
+                history.removeFirst();
+            }
+        }
+        return lastFrame;
+    }
+
+    /**
+     * Captures a frame and diffs its field against the given generation.
+     *
+     * @return null if that generation is no longer kept or the field size
+     * changed, the caller sends the full frame then
+     */
+    public synchronized FrameDeltaModel captureDelta(long since) {
+        FrameModel frame = capture();
+        FrameModel base = history.stream()
+                .filter(kept -> kept.getGeneration() == since)
+                .findFirst().orElse(null);
+        if (base == null) {
+            return null;
+        }
+        int[] changes = diff(base.getState().getField(), frame.getState().getField());
+        if (changes == null) {
+            return null;
+        }
+        return FrameDeltaModel.builder()
+                .generation(frame.getGeneration())
+                .base(since)
+                .changes(changes)
+                .status(frame.getStatus())
+                .state(frame.getState())
+                .build();
+    }
+
+    // Серии подряд идущих измененных клеток в построчной нумерации
+    static int[] diff(int[][] from, int[][] to) {
+        if (from == null || to == null || from.length != to.length) {
+            return null;
+        }
+        int cols = to.length > 0 ? to[0].length : 0;
+        int[] changes = new int[to.length * cols * 3];
+        int size = 0;
+        int runStart = -1;
+        for (int i = 0; i < to.length; i++) {
+            if (from[i].length != cols || to[i].length != cols) {
+                return null;
+            }
+            for (int j = 0; j < cols; j++) {
+                if (from[i][j] == to[i][j]) {
+                    runStart = -1;
+                    continue;
+                }
+                if (runStart < 0) {
+                    runStart = size;
+                    changes[size++] = i * cols + j;
+                    changes[size++] = 0;
+                }
+                changes[runStart + 1]++;
+                changes[size++] = to[i][j];
+            }
+        }
+        return Arrays.copyOf(changes, size);
+    }
+
+    public synchronized void subscribe(FrameListener listener) {
+        if (gameService == null || listener.onFrame(capture())) {
+            listeners.add(listener);
+        }
+    }
+
+    // Игра идет по таймеру внутри updateCurrentState, поэтому пока есть
+    // подписчики, кадры снимает сервер, а не опрос клиентов
+    @Scheduled(fixedRateString = "${brickgame.stream-period-ms:10}")
+    public synchronized void publish() {
+        if (gameService == null || listeners.isEmpty()) {
+            return;
+        }
+        FrameModel frame = capture();
+        if (frame.getGeneration() == publishedGeneration) {
+            return;
+        }
+        publishedGeneration = frame.getGeneration();
+        listeners.removeIf(listener -> !listener.onFrame(frame));
+    }
+}
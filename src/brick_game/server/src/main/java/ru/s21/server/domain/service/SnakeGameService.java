@@ -1,5 +1,6 @@
 package ru.s21.server.domain.service;
 
+import org.springframework.beans.factory.annotation.Value;
 import org.springframework.stereotype.Service;
 import ru.s21.server.domain.mapper.JNAMapper;
 import ru.s21.server.domain.model.GameStatusModel;
@@ -11,6 +12,15 @@ import ru.s21.server.domain.util.SnakeLibraryInterface;
 @Service
 public class SnakeGameService implements GameService {
     private final SnakeLibraryInterface library = SnakeLibraryInterface.INSTANCE;
+
+    public SnakeGameService(@Value("${brickgame.session-pool-size:1}") int sessionPoolSize,
+                            @Value("${brickgame.hibernation-timeout-ms:30000}") int hibernationTimeout,
+                            @Value("${brickgame.journal-directory:}") String journalDirectory) {
+        library.setSessionPoolSize(sessionPoolSize);
+        library.setHibernationTimeout(hibernationTimeout);
+        library.setJournalDirectory(journalDirectory);
+    }
+
     @Override
     public synchronized void initializeGame() {
         library.initializeGame();
@@ -32,7 +42,7 @@ public class SnakeGameService implements GameService {
         state.setAutoRead(false);
         state.setAutoWrite(false);
         state.read();
-        StateModel stateModel = JNAMapper.toModel(state);
+        StateModel stateModel = JNAMapper.toModel(state, library.getFieldRows(), library.getFieldCols());
         library.freeGameInfo(state);
         return stateModel;
     }
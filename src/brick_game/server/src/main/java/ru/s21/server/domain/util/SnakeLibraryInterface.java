@@ -10,9 +10,19 @@ public interface SnakeLibraryInterface extends Library {
 
     GameInfo.ByValue updateScene();
 
+    int getFieldRows();
+
+    int getFieldCols();
+
     void processUserAction(int action, boolean hold);
 
     void initializeGame();
 
     void freeGameInfo(GameInfo.ByValue gameInfo);
+
+    void setSessionPoolSize(int size);
+
+    void setHibernationTimeout(int milliseconds);
+
+    void setJournalDirectory(String directory);
 }
@@ -1,11 +1,20 @@
 package ru.s21.server.web.controller;
 
+import org.springframework.http.MediaType;
+import org.springframework.http.ResponseEntity;
 import org.springframework.web.bind.annotation.*;
+import org.springframework.web.context.request.WebRequest;
+import org.springframework.web.servlet.mvc.method.annotation.SseEmitter;
 import ru.s21.server.domain.model.ActionModel;
+import ru.s21.server.domain.model.FrameDeltaModel;
+import ru.s21.server.domain.model.FrameModel;
 import ru.s21.server.domain.service.AvailableGamesService;
+import ru.s21.server.domain.service.FrameService;
 import ru.s21.server.domain.service.GameService;
 import ru.s21.server.exception.*;
+import ru.s21.server.web.mapper.PackedFrameMapper;
 import ru.s21.server.web.mapper.WebMapper;
+import ru.s21.server.web.model.FrameDTO;
 import ru.s21.server.web.model.GameInfoDTO;
 import ru.s21.server.web.model.GameStatusDTO;
 import ru.s21.server.web.model.StateDTO;
@@ -21,11 +30,14 @@ import java.util.stream.Collectors;
 public class GameRestController {
     private final Map<String, GameService> serviceMap;
     private final AvailableGamesService availableGamesService;
+    private final FrameService frameService;
     private GameService currentGameService;
 
-    public GameRestController(Map<String, GameService> serviceMap, AvailableGamesService availableGamesService) {
+    public GameRestController(Map<String, GameService> serviceMap, AvailableGamesService availableGamesService,
+                              FrameService frameService) {
         this.serviceMap = serviceMap;
         this.availableGamesService = availableGamesService;
+        this.frameService = frameService;
     }
 
     @GetMapping("/games")
@@ -46,10 +58,31 @@ public class GameRestController {
 
         currentGameService = serviceMap.get(availableGamesService.getGameNameById(gameId));
         currentGameService.initializeGame();
+        frameService.setGameService(currentGameService);
     }
 
+    // С frame=true ответ содержит кадр после действия, отдельный запрос состояния не нужен.
+    // Завершившее игру действие получает 204 без тела: кадра больше нет
     @PostMapping("/actions")
-    void submitAction(@RequestBody UserActionDTO userActionDTO) {
+    ResponseEntity<FrameDTO> submitAction(@RequestBody UserActionDTO userActionDTO,
+                                          @RequestParam(defaultValue = "false") boolean frame) {
+        boolean running = applyAction(userActionDTO);
+        if(!frame) {
+            return ResponseEntity.ok().build();
+        }
+        return running ? ResponseEntity.ok(WebMapper.toDTO(frameService.capture()))
+                : ResponseEntity.noContent().build();
+    }
+
+    @PostMapping(path = "/actions", params = "frame=true", produces = PackedFrameMapper.MEDIA_TYPE)
+    ResponseEntity<byte[]> submitPackedAction(@RequestBody UserActionDTO userActionDTO) {
+        boolean running = applyAction(userActionDTO);
+        return running ? ResponseEntity.ok(PackedFrameMapper.toBytes(frameService.capture()))
+                : ResponseEntity.noContent().build();
+    }
+
+    // Возвращает false, если игра завершена
+    private boolean applyAction(UserActionDTO userActionDTO) {
         if(currentGameService == null) {
             throw new GameNotStartedException("Game not started");
         }
@@ -57,15 +90,65 @@ public class GameRestController {
 
         if(WebMapper.toModel(userActionDTO).getAction() == ActionModel.Terminate) {
             currentGameService = null;
+            frameService.setGameService(null);
+            return false;
         }
+        return true;
     }
 
     @GetMapping("/state")
-    StateDTO getState() {
+    Object getState(@RequestParam(required = false) Long since) {
+        if(currentGameService == null) {
+            throw new GameNotStartedException("Game not started");
+        }
+        // Клиент с известным поколением получает только измененные клетки
+        if(since != null) {
+            FrameDeltaModel delta = frameService.captureDelta(since);
+            if(delta != null) {
+                return WebMapper.toDTO(delta);
+            }
+        }
+        return WebMapper.toStateDTO(frameService.capture());
+    }
+
+    // Клиенты, принимающие application/x-brickgame-frame, получают кадр вместе со статусом в ~240 байт
+    @GetMapping(path = "/state", produces = PackedFrameMapper.MEDIA_TYPE)
+    byte[] getPackedState() {
+        if(currentGameService == null) {
+            throw new GameNotStartedException("Game not started");
+        }
+        return PackedFrameMapper.toBytes(frameService.capture());
+    }
+
+    // Статус, поле и поколение одним согласованным снимком.
+    // Клиент, у которого уже есть кадр этого поколения, получает 304 без тела
+    @GetMapping("/frame")
+    FrameDTO getFrame(WebRequest request) {
+        if(currentGameService == null) {
+            throw new GameNotStartedException("Game not started");
+        }
+        FrameModel frame = frameService.capture();
+        if(request.checkNotModified(eTag(frame, "json"))) {
+            return null;
+        }
+        return WebMapper.toDTO(frame);
+    }
+
+    @GetMapping(path = "/frame", produces = PackedFrameMapper.MEDIA_TYPE)
+    byte[] getPackedFrame(WebRequest request) {
         if(currentGameService == null) {
             throw new GameNotStartedException("Game not started");
         }
-        return WebMapper.toDTO(currentGameService.updateCurrentState());
+        FrameModel frame = frameService.capture();
+        if(request.checkNotModified(eTag(frame, "packed"))) {
+            return null;
+        }
+        return PackedFrameMapper.toBytes(frame);
+    }
+
+    // Поколение однозначно задает кадр, формат различает представления
+    private static String eTag(FrameModel frame, String format) {
+        return "\"" + frame.getGeneration() + "-" + format + "\"";
     }
 
     @GetMapping("/status")
@@ -75,4 +158,15 @@ public class GameRestController {
         }
         return WebMapper.toDTO(currentGameService.getGameStatus());
     }
+
+    @GetMapping(path = "/stream", produces = MediaType.TEXT_EVENT_STREAM_VALUE)
+    SseEmitter streamFrames() {
+        if(currentGameService == null) {
+            throw new GameNotStartedException("Game not started");
+        }
+        // Кадры приходят только при смене поколения, без таймаута
+        SseEmitter emitter = new SseEmitter(0L);
+        frameService.subscribe(new SseFrameListener(emitter));
+        return emitter;
+    }
 }
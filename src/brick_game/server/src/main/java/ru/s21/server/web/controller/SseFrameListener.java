@@ -0,0 +1,37 @@
+package ru.s21.server.web.controller;
+
+import org.springframework.http.MediaType;
+import org.springframework.web.servlet.mvc.method.annotation.SseEmitter;
+import ru.s21.server.domain.model.FrameModel;
+import ru.s21.server.domain.service.FrameListener;
+import ru.s21.server.web.mapper.WebMapper;
+
+import java.io.IOException;
+
+class SseFrameListener implements FrameListener {
+    private final SseEmitter emitter;
+
+    SseFrameListener(SseEmitter emitter) {
+        this.emitter = emitter;
+    }
+
+    @Override
+    public boolean onFrame(FrameModel frame) {
+        try {
+            emitter.send(SseEmitter.event()
+                    .name("frame")
+                    .id(String.valueOf(frame.getGeneration()))
+                    .data(WebMapper.toDTO(frame), MediaType.APPLICATION_JSON));
+            return true;
+        } catch (IOException | IllegalStateException e) {
+            // Клиент отключился
+            emitter.completeWithError(e);
+            return false;
+        }
+    }
+
+    @Override
+    public void onClose() {
+        emitter.complete();
+    }
+}
@@ -0,0 +1,56 @@
+package ru.s21.server.web.mapper;
+
+import ru.s21.server.domain.model.FrameModel;
+import ru.s21.server.domain.model.StateModel;
+
+import java.nio.ByteBuffer;
+
+/**
+ * Binary frame format (application/x-brickgame-frame), the layout is
+ * described in client_library/s21_packed_frame.h: a 24 byte header with
+ * the status, flags, counters and generation, one byte per cell and the
+ * next figure if there is one.
+ */
+public class PackedFrameMapper {
+    public static final String MEDIA_TYPE = "application/x-brickgame-frame";
+    private static final int VERSION = 1;
+    private static final int HEADER_SIZE = 24;
+    private static final int FLAG_PAUSE = 0x01;
+    private static final int FLAG_NEXT = 0x02;
+    private static final int NEXT_SIZE = 4;
+
+    public static byte[] toBytes(FrameModel frameModel) {
+        StateModel state = frameModel.getState();
+        int rows = state.getRows();
+        int cols = state.getCols();
+        int[][] next = state.getNext();
+        int nextSize = next != null ? NEXT_SIZE * NEXT_SIZE : 0;
+
+        ByteBuffer buffer = ByteBuffer.allocate(HEADER_SIZE + rows * cols + nextSize);
+        buffer.put((byte) VERSION);
+        buffer.put((byte) frameModel.getStatus().ordinal());
+        buffer.put((byte) ((state.isPause() ? FLAG_PAUSE : 0) | (next != null ? FLAG_NEXT : 0)));
+        buffer.put((byte) state.getLevel());
+        buffer.putLong(frameModel.getGeneration());
+        buffer.putInt(state.getScore());
+        buffer.putInt(state.getHighScore());
+        buffer.put((byte) state.getSpeed());
+        buffer.put((byte) rows);
+        buffer.put((byte) cols);
+        buffer.put((byte) 0);
+        putMatrix(buffer, state.getField(), rows, cols);
+        if (next != null) {
+            putMatrix(buffer, next, NEXT_SIZE, NEXT_SIZE);
+        }
+        return buffer.array();
+    }
+
+    private static void putMatrix(ByteBuffer buffer, int[][] matrix, int rows, int cols) {
+        for (int i = 0; i < rows; i++) {
+            for (int j = 0; j < cols; j++) {
+                boolean present = i < matrix.length && j < matrix[i].length;
+                buffer.put((byte) (present ? matrix[i][j] : 0));
+            }
+        }
+    }
+}
@@ -2,9 +2,11 @@ package ru.s21.server.web.mapper;
 
 import ru.s21.server.domain.model.*;
 import ru.s21.server.exception.InvalidActionException;
+import ru.s21.server.web.model.FrameDTO;
 import ru.s21.server.web.model.GameInfoDTO;
 import ru.s21.server.web.model.GameStatusDTO;
 import ru.s21.server.web.model.StateDTO;
+import ru.s21.server.web.model.StateDeltaDTO;
 import ru.s21.server.web.model.UserActionDTO;
 
 public class WebMapper {
@@ -25,6 +27,48 @@ public class WebMapper {
     public static StateDTO toDTO(StateModel stateModel) {
         return StateDTO.builder()
                 .field(stateModel.getField())
+                .rows(stateModel.getRows())
+                .cols(stateModel.getCols())
+                .next(stateModel.getNext())
+                .level(stateModel.getLevel())
+                .pause(stateModel.isPause())
+                .score(stateModel.getScore())
+                .speed(stateModel.getSpeed())
+                .highScore(stateModel.getHighScore())
+                .build();
+    }
+
+    public static FrameDTO toDTO(FrameModel frameModel) {
+        StateModel stateModel = frameModel.getState();
+        return FrameDTO.builder()
+                .generation(frameModel.getGeneration())
+                .status(toDTO(frameModel.getStatus()).getStatus())
+                .field(stateModel.getField())
+                .rows(stateModel.getRows())
+                .cols(stateModel.getCols())
+                .next(stateModel.getNext())
+                .level(stateModel.getLevel())
+                .pause(stateModel.isPause())
+                .score(stateModel.getScore())
+                .speed(stateModel.getSpeed())
+                .highScore(stateModel.getHighScore())
+                .build();
+    }
+
+    public static StateDTO toStateDTO(FrameModel frameModel) {
+        StateDTO stateDTO = toDTO(frameModel.getState());
+        stateDTO.setGeneration(frameModel.getGeneration());
+        return stateDTO;
+    }
+
+    public static StateDeltaDTO toDTO(FrameDeltaModel frameDeltaModel) {
+        StateModel stateModel = frameDeltaModel.getState();
+        return StateDeltaDTO.builder()
+                .generation(frameDeltaModel.getGeneration())
+                .base(frameDeltaModel.getBase())
+                .changes(frameDeltaModel.getChanges())
+                .rows(stateModel.getRows())
+                .cols(stateModel.getCols())
                 .next(stateModel.getNext())
                 .level(stateModel.getLevel())
                 .pause(stateModel.isPause())
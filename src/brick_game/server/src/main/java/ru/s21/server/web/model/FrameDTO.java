@@ -0,0 +1,20 @@
+package ru.s21.server.web.model;
+
+import lombok.Builder;
+import lombok.Data;
+
+@Data
+@Builder
+public class FrameDTO {
+    long generation;
+    String status;
+    int[][] field;
+    int rows;
+    int cols;
+    int[][] next;
+    int score;
+    int highScore;
+    int level;
+    int speed;
+    boolean pause;
+}
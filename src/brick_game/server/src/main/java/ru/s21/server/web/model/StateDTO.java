@@ -6,8 +6,11 @@ import lombok.Data;
 @Data
 @Builder
 public class StateDTO {
+    long generation;
     // Jackson способен серилиазовать матрицу, поэтому не обязательно маппить ее в строку
     int[][] field;
+    int rows;
+    int cols;
     int[][] next;
     int score;
     int highScore;
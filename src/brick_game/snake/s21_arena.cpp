@@ -0,0 +1,318 @@
+/**
+ * @file s21_arena.cpp
+ * @brief Multi-snake arena source code.
+ */
+
+#include "s21_arena.h"
+
+#include <algorithm>
+
+namespace s21 {
+
+static_assert((ARENA_MAX_LENGTH & (ARENA_MAX_LENGTH - 1)) == 0,
+              "Arena body rings are indexed with a mask");
+static_assert((uint64_t)ARENA_MAX_SIDE * ARENA_MAX_SIDE <= 1u << 30,
+              "Arena segments pack the cell index into 30 bits");
+
+static const uint32_t offBoard = ~0u;
+static const uint8_t claimedCell = 0x80;   ///< Flags of cell codes, set
+static const uint8_t contestedCell = 0x40;  ///< during a tick only
+static const int rowStep[4] = {-1, 1, 0, 0};  ///< By Snake::direction
+static const int colStep[4] = {0, 0, -1, 1};
+
+uint8_t Arena::codes_[2][4][5];
+
+void Arena::buildCodes() {
+  for (int head = 0; head < 2; ++head) {
+    for (int dir = 0; dir < 4; ++dir) {
+      SnakeElement elem(0, 0, (Snake::direction)dir);
+      elem.isHead_ = head;
+      for (int next = 0; next < 4; ++next) {
+        SnakeElement behind(0, 0, (Snake::direction)next);
+        codes_[head][dir][next] = Snake::segmentCode(&elem, &behind);
+      }
+      codes_[head][dir][4] = Snake::segmentCode(&elem, nullptr);
+    }
+  }
+}
+
+Arena::Arena(int rows, int cols, int maxSnakes, int foodCount, uint64_t seed)
+    : geometry_(std::clamp(rows, startSize, ARENA_MAX_SIDE),
+                std::clamp(cols, startSize, ARENA_MAX_SIDE)),
+      maxSnakes_(std::max(maxSnakes, 1)),
+      foodCount_(std::max(foodCount, 0)),
+      rngState_(seed != 0 ? seed : 1) {
+  cells_.assign(geometry_.cells(), BLANK);
+  alive_.assign(maxSnakes_, 0);
+  rotate_.assign(maxSnakes_, 0);
+  dies_.assign(maxSnakes_, 0);
+  head_.assign(maxSnakes_, 0);
+  length_.assign(maxSnakes_, 0);
+  score_.assign(maxSnakes_, 0);
+  target_.assign(maxSnakes_, offBoard);
+  headRow_.assign(maxSnakes_, 0);
+  headCol_.assign(maxSnakes_, 0);
+  heading_.assign(maxSnakes_, Snake::right);
+  body_.assign((size_t)maxSnakes_ * ARENA_MAX_LENGTH, 0);
+
+  static std::once_flag codesBuilt;
+  std::call_once(codesBuilt, buildCodes);
+  for (int i = 0; i < foodCount_; ++i) {
+    placeFood();
+  }
+}
+
+uint32_t Arena::nextRandom() {
+  return nextXorshift64Star(rngState_);
+}
+
+void Arena::placeFood() {
+  /* The board is mostly empty, give up rather than scan a crowded one */
+  for (int attempt = 0; attempt < 64; ++attempt) {
+    size_t cell = nextRandom() % cells_.size();
+    if (cells_[cell] == BLANK) {
+      cells_[cell] = FOOD;
+      ++foodOnBoard_;
+      return;
+    }
+  }
+}
+
+void Arena::refresh(int snake, uint32_t k) {
+  uint32_t value = body_[segment(snake, k)];
+  int next = k + 1 < length_[snake] ? body_[segment(snake, k + 1)] & 3 : 4;
+  cells_[value >> 2] = codes_[k == 0][value & 3][next];
+}
+
+int Arena::spawnSnake() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  int snake = std::find(alive_.begin(), alive_.end(), 0) - alive_.begin();
+  if (snake == maxSnakes_) {
+    return -1;
+  }
+
+  for (int attempt = 0; attempt < 64; ++attempt) {
+    int row = nextRandom() % getRows();
+    int col = startSize - 1 + nextRandom() % (getCols() - startSize + 1);
+    bool vacant = true;
+    for (int i = 0; i < startSize && vacant; ++i) {
+      vacant = cells_[geometry_.index(row, col - i)] == BLANK;
+    }
+    if (!vacant) {
+      continue;
+    }
+
+    /* Tail first, so the head ends up at ring index startSize - 1 */
+    head_[snake] = ARENA_MAX_LENGTH - 1;
+    for (int i = startSize - 1; i >= 0; --i) {
+      head_[snake] = (head_[snake] + 1) & (ARENA_MAX_LENGTH - 1);
+      body_[segment(snake, 0)] =
+          geometry_.index(row, col - i) << 2 | Snake::right;
+    }
+    length_[snake] = startSize;
+    headRow_[snake] = row;
+    headCol_[snake] = col;
+    heading_[snake] = Snake::right;
+    score_[snake] = 0;
+    rotate_[snake] = 1;
+    alive_[snake] = 1;
+    for (int k = 0; k < startSize; ++k) {
+      refresh(snake, k);
+    }
+    return snake;
+  }
+  return -1;
+}
+
+void Arena::steer(int snake, UserAction_t action) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (!valid(snake) || !alive_[snake] || !rotate_[snake]) {
+    return;
+  }
+  Snake::direction direction;
+  switch (action) {
+    case Left:
+      direction = Snake::left;
+      break;
+    case Right:
+      direction = Snake::right;
+      break;
+    case Up:
+      direction = Snake::up;
+      break;
+    case Down:
+      direction = Snake::down;
+      break;
+    default:
+      return;
+  }
+
+  Snake::direction current = (Snake::direction)heading_[snake];
+  bool vertical = direction == Snake::up || direction == Snake::down;
+  bool movingVertically = current == Snake::up || current == Snake::down;
+  if (vertical != movingVertically) {
+    heading_[snake] = direction;
+    uint32_t& head = body_[segment(snake, 0)];
+    head = (head & ~3u) | direction;
+    rotate_[snake] = 0;
+    refresh(snake, 0);
+  }
+}
+
+void Arena::kill(int snake) {
+  for (uint32_t k = 0; k < length_[snake]; ++k) {
+    cells_[body_[segment(snake, k)] >> 2] = BLANK;
+  }
+  alive_[snake] = 0;
+  length_[snake] = 0;
+}
+
+void Arena::move(int snake) {
+  /* refresh() of the head, neck and tail, with the ring read once */
+  const uint32_t mask = ARENA_MAX_LENGTH - 1;
+  uint32_t* ring = &body_[(size_t)snake * ARENA_MAX_LENGTH];
+  uint32_t head = head_[snake];
+  uint32_t length = length_[snake];
+  uint32_t neck = ring[head];
+  uint32_t tail = ring[(head - length + 1) & mask];
+  uint32_t cell = target_[snake];
+  uint8_t direction = heading_[snake];
+  bool eat = (cells_[cell] & ~claimedCell) == FOOD;
+
+  /* The tail is read first, the new head may take its ring slot */
+  head = (head + 1) & mask;
+  head_[snake] = head;
+  ring[head] = cell << 2 | direction;
+  cells_[cell] = codes_[1][direction][neck & 3];
+  cells_[neck >> 2] = codes_[0][neck & 3][ring[(head - 2) & mask] & 3];
+
+  if (eat) {
+    ++score_[snake];
+    --foodOnBoard_;
+  }
+  if (eat && length < ARENA_MAX_LENGTH) {
+    length_[snake] = length + 1;
+  } else {
+    cells_[tail >> 2] = BLANK;
+    tail = ring[(head - length + 1) & mask];
+    cells_[tail >> 2] = codes_[0][tail & 3][4];
+  }
+  rotate_[snake] = 1;
+}
+
+int Arena::tick() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  bool conflicts = false;
+
+  /* Pass 1: every head picks its cell against the board before the tick
+     and claims it with a flag in the grid */
+  for (int snake = 0; snake < maxSnakes_; ++snake) {
+    if (!alive_[snake]) {
+      continue;
+    }
+    /* Tables rather than a switch: headings are random across snakes */
+    int row = headRow_[snake] + rowStep[heading_[snake]];
+    int col = headCol_[snake] + colStep[heading_[snake]];
+    target_[snake] = offBoard;
+    if (!geometry_.contains(row, col)) {
+      dies_[snake] = 1;
+      continue;
+    }
+
+    uint32_t cell = geometry_.index(row, col);
+    uint8_t code = cells_[cell];
+    if (code & claimedCell) {
+      /* Heads meeting in one cell kill each other */
+      cells_[cell] = code | contestedCell;
+      conflicts = true;
+      dies_[snake] = 1;
+      continue;
+    }
+    dies_[snake] = code != BLANK && code != FOOD;
+    if (!dies_[snake]) {
+      cells_[cell] = code | claimedCell;
+      target_[snake] = cell;
+      headRow_[snake] = row;  // moved in pass 2, unless the snake dies
+      headCol_[snake] = col;
+    }
+  }
+
+  /* The first claimant of a contested cell only learns about it now */
+  for (int snake = 0; conflicts && snake < maxSnakes_; ++snake) {
+    if (alive_[snake] && !dies_[snake] &&
+        (cells_[target_[snake]] & contestedCell)) {
+      dies_[snake] = 1;
+    }
+  }
+
+  /* Pass 2: the dead leave the board, the others move */
+  for (int snake = 0; snake < maxSnakes_; ++snake) {
+    if (alive_[snake] && dies_[snake]) {
+      if (target_[snake] != offBoard) {
+        cells_[target_[snake]] &= ~(claimedCell | contestedCell);
+      }
+      kill(snake);
+    }
+  }
+  int alive = 0;
+  for (int snake = 0; snake < maxSnakes_; ++snake) {
+    if (alive_[snake]) {
+      move(snake);
+      ++alive;
+    }
+  }
+
+  /* Food is replaced once all heads are in place */
+  while (foodOnBoard_ < foodCount_) {
+    int before = foodOnBoard_;
+    placeFood();
+    if (foodOnBoard_ == before) {
+      break;
+    }
+  }
+  return alive;
+}
+
+void Arena::renderViewport(int top, int left, int rows, int cols, int* out) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  std::fill(out, out + (size_t)rows * cols, 0);
+  int rowBegin = std::max(top, 0);
+  int rowEnd = (int)std::min<int64_t>((int64_t)top + rows, getRows());
+  int colBegin = std::max(left, 0);
+  int colEnd = (int)std::min<int64_t>((int64_t)left + cols, getCols());
+  for (int row = rowBegin; row < rowEnd; ++row) {
+    const uint8_t* source = &cells_[geometry_.index(row, colBegin)];
+    int* target = out + (size_t)(row - top) * cols + (colBegin - left);
+    for (int i = 0; i < colEnd - colBegin; ++i) {
+      target[i] = source[i];
+    }
+  }
+}
+
+bool Arena::isAlive(int snake) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return valid(snake) && alive_[snake];
+}
+
+int Arena::getScore(int snake) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return valid(snake) ? score_[snake] : 0;
+}
+
+int Arena::getLength(int snake) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return valid(snake) ? length_[snake] : 0;
+}
+
+void Arena::getHead(int snake, int* row, int* col) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (valid(snake) && alive_[snake]) {
+    *row = headRow_[snake];
+    *col = headCol_[snake];
+  } else {
+    *row = -1;
+    *col = -1;
+  }
+}
+
+}  // namespace s21
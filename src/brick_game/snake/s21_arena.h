@@ -0,0 +1,128 @@
+/**
+ * @file s21_arena.h
+ * @brief Multi-snake arena header file.
+ *
+ * Hundreds of snakes and their food share one board and advance together
+ * in a single tick pass. Snake state is kept as structure-of-arrays: one
+ * array per field, indexed by snake id, and the bodies are ring buffers
+ * of ARENA_MAX_LENGTH packed segments in one shared array. Collisions
+ * are resolved through a dense grid of cell codes (the same codes the
+ * GUIs draw): every head looks up the cell it moves into and claims it
+ * with a flag, so heads meeting in one cell find each other without a
+ * search and a tick costs O(number of snakes) whatever their lengths.
+ *
+ * Moves are simultaneous. A head dies when it leaves the board or moves
+ * into a body cell as it was before the tick (tails that are about to
+ * move away included, as in the classic game), and heads moving into the
+ * same cell die together.
+ */
+#ifndef SRC_SNAKE_ARENA_H
+#define SRC_SNAKE_ARENA_H
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "s21_snake.h"
+
+namespace s21 {
+
+#define ARENA_MAX_SIDE 4096
+#define ARENA_MAX_LENGTH 256  ///< Segments per snake, a power of two
+#define ARENA_DEFAULT_FOOD 256
+
+/**
+ * @brief Many snakes on one board.
+ */
+class Arena {
+ public:
+  /**
+   * @param rows Board height, up to ARENA_MAX_SIDE
+   * @param cols Board width, up to ARENA_MAX_SIDE
+   * @param maxSnakes Snake slots
+   * @param foodCount Food items kept on the board
+   * @param seed PRNG seed (spawns and food), zero is replaced with one
+   **/
+  Arena(int rows, int cols, int maxSnakes, int foodCount, uint64_t seed);
+
+  Arena(const Arena& other) = delete;
+  Arena& operator=(const Arena& other) = delete;
+
+  /**
+   * @brief Places a new snake on a free row segment of the board.
+   * @return Snake id or -1 if all slots are taken or no place was found
+   **/
+  int spawnSnake();
+
+  /**
+   * @brief Turns a snake (arrows only, once per tick, no reversing).
+   **/
+  void steer(int snake, UserAction_t action);
+
+  /**
+   * @brief Advances all live snakes by one cell.
+   * @return Number of snakes alive after the tick
+   **/
+  int tick();
+
+  /**
+   * @brief Renders a rectangle of the board, row by row. Cells outside
+   * of the board are 0.
+   **/
+  void renderViewport(int top, int left, int rows, int cols, int* out);
+
+  bool isAlive(int snake);
+  int getScore(int snake);
+  int getLength(int snake);
+  void getHead(int snake, int* row, int* col);
+  int getRows() const { return geometry_.rows(); }
+  int getCols() const { return geometry_.cols(); }
+  int getMaxSnakes() const { return maxSnakes_; }
+
+ private:
+  bool valid(int snake) const { return snake >= 0 && snake < maxSnakes_; }
+  size_t segment(int snake, uint32_t k) const {
+    return (size_t)snake * ARENA_MAX_LENGTH +
+           ((head_[snake] - k) & (ARENA_MAX_LENGTH - 1));
+  }
+  void refresh(int snake, uint32_t k);  ///< Redraws segment k, 0 is head
+  static void buildCodes();
+  void kill(int snake);
+  void move(int snake);
+  void placeFood();
+  uint32_t nextRandom();
+
+  std::mutex mutex_;
+  DynamicBoard geometry_;
+  std::vector<uint8_t> cells_;  ///< Cell codes, row-major
+  int maxSnakes_;
+  int foodCount_;
+  int foodOnBoard_{0};
+  uint64_t rngState_;
+
+  /* Per snake */
+  std::vector<uint8_t> alive_;
+  std::vector<uint8_t> rotate_;  ///< May still turn this tick
+  std::vector<uint8_t> dies_;    ///< Scratch of the current tick
+  std::vector<uint32_t> head_;   ///< Ring index of the head segment
+  std::vector<uint32_t> length_;
+  std::vector<int32_t> score_;
+  std::vector<uint32_t> target_;  ///< Cell the head moves into
+  std::vector<uint16_t> headRow_;  ///< Copies of the head segment, so the
+  std::vector<uint16_t> headCol_;  ///< collision pass streams through
+  std::vector<uint8_t> heading_;   ///< arrays instead of the rings
+
+  /* Per segment, ARENA_MAX_LENGTH per snake: cell index << 2 | direction,
+     one word so a move touches one cache line per end of the snake */
+  std::vector<uint32_t> body_;
+
+  static constexpr int startSize = 4;
+
+  /* Snake::segmentCode() by head flag, direction, direction of the
+     segment behind (4 for the tail) */
+  static uint8_t codes_[2][4][5];
+};
+
+}  // namespace s21
+
+#endif  // SRC_SNAKE_ARENA_H
@@ -0,0 +1,336 @@
+/**
+ * @file s21_autopilot.cpp
+ * @brief Snake autopilot source code.
+ */
+
+#include "s21_autopilot.h"
+
+#include <bitset>
+
+namespace s21 {
+
+static const int rowStep[4] = {-1, 1, 0, 0};  ///< By Snake::direction
+static const int colStep[4] = {0, 0, -1, 1};
+
+Autopilot::Autopilot(Game& game) : game_(game) {
+  layers_.reserve(Game::Board::cells());
+  buildCycle();
+}
+
+void Autopilot::buildCycle() {
+  /* Row 0 left to right, the other rows zigzag over columns 1.., then
+     column 0 back up. Rows must be even for the zigzag to end next to
+     column 0, otherwise the same is done with rows and columns swapped */
+  bool transposed = rows % 2 != 0;
+  int outer = transposed ? cols : rows;
+  int inner = transposed ? rows : cols;
+  if (outer % 2 != 0 || inner < 2) {
+    return;
+  }
+  std::vector<Cell> order;
+  for (int i = 0; i < inner; ++i) {
+    order.push_back({0, i});
+  }
+  for (int line = 1; line < outer; ++line) {
+    for (int i = 1; i < inner; ++i) {
+      order.push_back({line, line % 2 != 0 ? inner - i : i});
+    }
+  }
+  for (int line = outer - 1; line > 0; --line) {
+    order.push_back({line, 0});
+  }
+
+  cycleIndex_.assign(Game::Board::cells(), 0);
+  for (size_t i = 0; i < order.size(); ++i) {
+    Cell cell = transposed ? Cell{order[i].col, order[i].row} : order[i];
+    cycle_.push_back(cell);
+    cycleIndex_[Game::Board::index(cell.row, cell.col)] = (int)i;
+  }
+}
+
+void Autopilot::expand(const Bits& from, const Bits& passable, Bits& to) {
+  for (int row = 0; row < rows; ++row) {
+    uint32_t grown = from[row] | from[row] << 1 | from[row] >> 1;
+    if (row > 0) {
+      grown |= from[row - 1];
+    }
+    if (row + 1 < rows) {
+      grown |= from[row + 1];
+    }
+    to[row] = grown & passable[row];
+  }
+}
+
+int Autopilot::fill(Bits& reached, const Bits& passable) {
+  /* In place, top-down then bottom-up: a sweep can carry the fill across
+     many rows, so a few sweeps cover the field */
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int pass = 0; pass < 2; ++pass) {
+      for (int i = 0; i < rows; ++i) {
+        int row = pass == 0 ? i : rows - 1 - i;
+        uint32_t grown = reached[row] | reached[row] << 1 |
+                         reached[row] >> 1;
+        if (row > 0) {
+          grown |= reached[row - 1];
+        }
+        if (row + 1 < rows) {
+          grown |= reached[row + 1];
+        }
+        grown = reached[row] | (grown & passable[row]);
+        /* Spread along the row until it stops growing */
+        uint32_t previous;
+        do {
+          previous = grown;
+          grown |= ((grown << 1) | (grown >> 1)) & passable[row];
+        } while (grown != previous);
+        changed |= grown != reached[row];
+        reached[row] = grown;
+      }
+    }
+  }
+  int count = 0;
+  for (uint32_t word : reached) {
+    count += std::bitset<32>(word).count();
+  }
+  return count;
+}
+
+bool Autopilot::findPath(const Bits& passable, Cell start, Cell target,
+                         std::vector<Cell>& path) {
+  /* layers_[k] holds the cells at distance k */
+  layers_.clear();
+  Bits frontier{};
+  Bits visited{};
+  frontier[start.row] = 1u << start.col;
+  visited = frontier;
+  uint32_t targetBit = 1u << target.col;
+  while (!(frontier[target.row] & targetBit)) {
+    layers_.push_back(frontier);
+    Bits next;
+    Bits unvisited;
+    for (int row = 0; row < rows; ++row) {
+      unvisited[row] = passable[row] & ~visited[row];
+    }
+    expand(frontier, unvisited, next);
+    bool empty = true;
+    for (int row = 0; row < rows; ++row) {
+      visited[row] |= next[row];
+      empty = empty && next[row] == 0;
+    }
+    if (empty) {
+      return false;
+    }
+    frontier = next;
+  }
+
+  /* Walk back through the layers, any neighbour one layer closer will do */
+  path.assign(layers_.size() + 1, target);
+  Cell cell = target;
+  for (size_t k = layers_.size(); k-- > 0;) {
+    for (int dir = 0; dir < 4; ++dir) {
+      int row = cell.row + rowStep[dir];
+      int col = cell.col + colStep[dir];
+      if (Game::Board::contains(row, col) && (layers_[k][row] >> col & 1)) {
+        cell = {row, col};
+        break;
+      }
+    }
+    path[k] = cell;
+  }
+  return true;
+}
+
+bool Autopilot::tailReachable(const std::vector<Cell>& body) {
+  Bits passable;
+  passable.fill(colMask);
+  for (const Cell& cell : body) {
+    passable[cell.row] &= ~(1u << cell.col);
+  }
+  const Cell& tail = body.back();
+  passable[tail.row] |= 1u << tail.col;
+
+  Bits reached{};
+  reached[body.front().row] = 1u << body.front().col;
+  fill(reached, passable);
+  return reached[tail.row] >> tail.col & 1;
+}
+
+void Autopilot::advance(const std::vector<Cell>& path, bool grow,
+                        std::vector<Cell>& body) const {
+  /* The new head is the end of the path, then the path backwards, then
+     the old body, cut to the old length (plus one if food was eaten) */
+  size_t length = body_.size() + (grow ? 1 : 0);
+  body.clear();
+  for (size_t i = path.size(); i-- > 1 && body.size() < length;) {
+    body.push_back(path[i]);
+  }
+  for (size_t i = 0; i < body_.size() && body.size() < length; ++i) {
+    body.push_back(body_[i]);
+  }
+}
+
+void Autopilot::readGame() {
+  body_.clear();
+  for (SnakeElement* elem : game_.snake_->snakeBody_) {
+    body_.push_back({elem->rowCoord_, elem->colCoord_});
+  }
+  food_ = {game_.food_->rowCoord_, game_.food_->colCoord_};
+  game_.occupancy(free_.data());
+  for (uint32_t& word : free_) {
+    word = ~word & colMask;
+  }
+}
+
+UserAction_t Autopilot::toward(Cell from, Cell to) {
+  if (to.row < from.row) {
+    return Up;
+  }
+  if (to.row > from.row) {
+    return Down;
+  }
+  return to.col < from.col ? Left : Right;
+}
+
+int Autopilot::cycleDistance(Cell from, Cell to) const {
+  int size = (int)cycle_.size();
+  return (cycleIndex_[Game::Board::index(to.row, to.col)] -
+          cycleIndex_[Game::Board::index(from.row, from.col)] + size) %
+         size;
+}
+
+bool Autopilot::followsCycle() const {
+  /* From the tail to the head, every element is further along the cycle */
+  const Cell& tail = body_.back();
+  int previous = 0;
+  for (size_t i = body_.size() - 1; i-- > 0;) {
+    int distance = cycleDistance(tail, body_[i]);
+    if (distance <= previous) {
+      return false;
+    }
+    previous = distance;
+  }
+  return true;
+}
+
+UserAction_t Autopilot::decideOnCycle() {
+  /* The body lies on the cycle between the tail and the head and every
+     cell after the head up to the tail is free, so the next cell of the
+     cycle is always safe. A move jumping ahead on the cycle keeps that
+     true as long as it lands well before the tail */
+  Cell head = body_.front();
+  int toTail = cycleDistance(head, body_.back());
+  int toFood = cycleDistance(head, food_);
+  int limit = toTail - shortcutMargin;
+  bool shortcuts = body_.size() < cycle_.size() * shortcutShare / 100;
+
+  if (shortcuts && findPath(free_, head, food_, path_)) {
+    int ahead = cycleDistance(head, path_[1]);
+    if (ahead < limit && ahead <= toFood) {
+      path_.resize(2);
+      advance(path_, ahead == toFood, future_);
+      if (tailReachable(future_)) {
+        return toward(head, path_[1]);
+      }
+    }
+  }
+
+  size_t index = cycleIndex_[Game::Board::index(head.row, head.col)];
+  Cell best = cycle_[(index + 1) % cycle_.size()];
+  int bestAhead = 1;
+  for (int dir = 0; dir < 4 && shortcuts; ++dir) {
+    Cell cell = {head.row + rowStep[dir], head.col + colStep[dir]};
+    if (!Game::Board::contains(cell.row, cell.col) ||
+        !(free_[cell.row] >> cell.col & 1)) {
+      continue;
+    }
+    int ahead = cycleDistance(head, cell);
+    if (ahead > bestAhead && ahead < limit && ahead <= toFood) {
+      best = cell;
+      bestAhead = ahead;
+    }
+  }
+  return toward(head, best);
+}
+
+UserAction_t Autopilot::decideGreedy() {
+  Cell head = body_.front();
+  if (findPath(free_, head, food_, path_)) {
+    advance(path_, true, future_);
+    if (tailReachable(future_)) {
+      return toward(head, path_[1]);
+    }
+  }
+
+  /* Free neighbours of the head; the tail cell is not free, the engine
+     checks collisions before the tail moves away */
+  Cell moves[4];
+  int regions[4];
+  bool safe[4];
+  int count = 0;
+  for (int dir = 0; dir < 4; ++dir) {
+    Cell cell = {head.row + rowStep[dir], head.col + colStep[dir]};
+    if (!Game::Board::contains(cell.row, cell.col) ||
+        !(free_[cell.row] >> cell.col & 1)) {
+      continue;
+    }
+    bool eats = cell.row == food_.row && cell.col == food_.col;
+    path_.assign({head, cell});
+    advance(path_, eats, future_);
+    Bits passable = free_;
+    passable[cell.row] &= ~(1u << cell.col);
+    Bits reached{};
+    reached[cell.row] = 1u << cell.col;
+    moves[count] = cell;
+    regions[count] = fill(reached, passable);
+    safe[count] = tailReachable(future_);
+    ++count;
+  }
+  if (count == 0) {
+    return Action;  // nowhere to go
+  }
+
+  int best = 0;
+  for (int i = 1; i < count; ++i) {
+    if ((safe[i] && !safe[best]) ||
+        (safe[i] == safe[best] && regions[i] > regions[best])) {
+      best = i;
+    }
+  }
+  return toward(head, moves[best]);
+}
+
+UserAction_t Autopilot::decide() {
+  readGame();
+  if (!cycle_.empty() && followsCycle()) {
+    return decideOnCycle();
+  }
+  return decideGreedy();
+}
+
+GameStatus_t Autopilot::play() {
+  UserAction_t action = Start;
+  switch (game_.getStatus()) {
+    case START:
+    case GAMEOVER:
+      game_.processUserInput(action, false);
+      game_.step(false);  // to SPAWN
+      game_.step(false);  // to MOVING
+      break;
+    case MOVING:
+      action = decide();
+      ++decisions_;
+      game_.processUserInput(action, false);
+      game_.step(true);
+      if (game_.getStatus() == ATTACHING) {
+        game_.step(false);
+      }
+      break;
+    default:
+      break;
+  }
+  return game_.getStatus();
+}
+
+}  // namespace s21
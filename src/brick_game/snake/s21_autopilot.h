@@ -0,0 +1,140 @@
+/**
+ * @file s21_autopilot.h
+ * @brief Snake autopilot header file.
+ *
+ * The autopilot plays a headless classic game (Game(false)) in process,
+ * for bots and soak tests that need many players without network clients.
+ * It works on the occupancy bitmap of the game, one 32-bit word per field
+ * row, so a flood fill grows a whole row of cells with a few shifts and
+ * masks and a breadth-first search is one such step per distance layer.
+ *
+ * A new game starts with the body laid along a Hamiltonian cycle of the
+ * field, and the autopilot keeps it that way: it follows the cycle and
+ * takes the first step of the shortest path to the food as a shortcut
+ * when the step stays ahead of the tail on the cycle and the tail is
+ * still reachable afterwards. Such a snake never traps itself and fills
+ * the field in the end.
+ *
+ * States off the cycle (restored snapshots, fields without a cycle) are
+ * played greedily: the shortest path to the food if the tail is still
+ * reachable once the food is eaten, otherwise a move keeping the tail
+ * reachable, otherwise the move into the largest free region.
+ */
+#ifndef SRC_SNAKE_AUTOPILOT_H
+#define SRC_SNAKE_AUTOPILOT_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "s21_snake.h"
+
+namespace s21 {
+
+/**
+ * @brief Plays a headless snake game.
+ */
+class Autopilot {
+ public:
+  /**
+   * @param game Headless game, must outlive the autopilot
+   **/
+  explicit Autopilot(Game& game);
+
+  Autopilot(const Autopilot& other) = delete;
+  Autopilot& operator=(const Autopilot& other) = delete;
+
+  /**
+   * @brief Picks the next move of a game in the MOVING state.
+   * @return Arrow action towards the chosen cell
+   **/
+  UserAction_t decide();
+
+  /**
+   * @brief Advances the game by one move: starts a new game from START
+   * or GAMEOVER, otherwise decides and steps the FSM through the tick
+   * (and the food attachment, if any).
+   * @return Game status after the move
+   **/
+  GameStatus_t play();
+
+  int getScore() const { return game_.gameInfo_.score; }
+  unsigned long getDecisions() const { return decisions_; }
+
+ private:
+  static constexpr int rows = Game::fieldYSize;
+  static constexpr int cols = Game::fieldXSize;
+  static_assert(cols <= 32, "Field rows must fit into a bitset word");
+  static constexpr uint32_t colMask = cols == 32 ? ~0u : (1u << cols) - 1;
+
+  using Bits = std::array<uint32_t, rows>;  ///< One word per field row
+
+  /* Shortcuts land at least this many cycle steps before the tail, and
+     stop once the snake covers this percentage of the field */
+  static constexpr int shortcutMargin = 4;
+  static constexpr size_t shortcutShare = 50;
+
+  struct Cell {
+    int row;
+    int col;
+  };
+
+  /**
+   * @brief One step of a flood fill: cells of passable next to or in from.
+   **/
+  static void expand(const Bits& from, const Bits& passable, Bits& to);
+
+  /**
+   * @brief Grows reached over passable cells until it stops changing.
+   * @return Number of reached cells
+   **/
+  static int fill(Bits& reached, const Bits& passable);
+
+  /**
+   * @brief Breadth-first search over passable cells, one bit-parallel
+   * step per distance layer.
+   * @param path Output, cells from start to target, both included
+   * @return false if the target cannot be reached
+   **/
+  bool findPath(const Bits& passable, Cell start, Cell target,
+                std::vector<Cell>& path);
+
+  /**
+   * @brief Checks that the head of a body (head first) can reach its tail.
+   **/
+  static bool tailReachable(const std::vector<Cell>& body);
+
+  /**
+   * @brief Body after the head moves along path (path[0] is the head),
+   * eating the food at the end of the path if grow is set.
+   **/
+  void advance(const std::vector<Cell>& path, bool grow,
+               std::vector<Cell>& body) const;
+
+  int cycleDistance(Cell from, Cell to) const;  ///< Steps along the cycle
+  bool followsCycle() const;  ///< The body is in cycle order
+  UserAction_t decideOnCycle();
+  UserAction_t decideGreedy();
+  void buildCycle();
+  void readGame();
+  static UserAction_t toward(Cell from, Cell to);
+
+  Game& game_;
+  unsigned long decisions_{0};
+
+  std::vector<Cell> body_;  ///< Head first
+  Cell food_{0, 0};
+  Bits free_{};
+
+  std::vector<int> cycleIndex_;  ///< Position of each cell in the cycle
+  std::vector<Cell> cycle_;      ///< Empty if the field has no cycle
+
+  /* Scratch, reused between decisions */
+  std::vector<Bits> layers_;
+  std::vector<Cell> path_;
+  std::vector<Cell> future_;
+};
+
+}  // namespace s21
+
+#endif  // SRC_SNAKE_AUTOPILOT_H
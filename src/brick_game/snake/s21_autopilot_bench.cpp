@@ -0,0 +1,66 @@
+/**
+ * @file s21_autopilot_bench.cpp
+ * @brief Autopilot benchmark: plays headless games on all cores and
+ * reports decisions per second and the average score.
+ *
+ * Usage: s21_autopilot_bench [games] [threads]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "s21_autopilot.h"
+
+int main(int argc, char** argv) {
+  int games = argc > 1 ? std::atoi(argv[1]) : 1000;
+  int threads = argc > 2 ? std::atoi(argv[2])
+                         : (int)std::thread::hardware_concurrency();
+  games = std::max(games, 1);
+  threads = std::clamp(threads, 1, games);
+
+  std::atomic<int> nextGame{0};
+  std::atomic<unsigned long> decisions{0};
+  std::atomic<long> totalScore{0};
+  std::atomic<int> bestScore{0};
+
+  auto worker = [&]() {
+    for (int i = nextGame++; i < games; i = nextGame++) {
+      s21::Game game(false);
+      game.seedRandom(i + 1);
+      s21::Autopilot pilot(game);
+      pilot.play();  // START to MOVING
+      while (pilot.play() == s21::MOVING) {
+      }
+      decisions += pilot.getDecisions();
+      totalScore += pilot.getScore();
+      int best = bestScore;
+      while (pilot.getScore() > best &&
+             !bestScore.compare_exchange_weak(best, pilot.getScore())) {
+      }
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (int i = 0; i < threads; ++i) {
+    pool.emplace_back(worker);
+  }
+  for (std::thread& thread : pool) {
+    thread.join();
+  }
+  double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+
+  std::printf("games %d, threads %d, %.2f s\n", games, threads, seconds);
+  std::printf("decisions %lu, %.0f per second\n", decisions.load(),
+              decisions / seconds);
+  std::printf("score average %.1f, best %d\n", (double)totalScore / games,
+              bestScore.load());
+  return 0;
+}
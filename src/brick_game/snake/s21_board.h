@@ -0,0 +1,115 @@
+/**
+ * @file s21_board.h
+ * @brief Board geometry header file.
+ *
+ * Geometry is a template parameter, so board sizes are compile-time
+ * constants: bound checks fold into a single unsigned compare, cell
+ * indexes of power-of-two widths into shifts and masks, and fixed-size
+ * loops unroll. BoardGeometry<dynamicExtent, dynamicExtent> keeps the
+ * sizes at run time and covers any other board with the same interface.
+ *
+ * The classic game stays on ClassicBoard: frame ring slots and snapshot
+ * coordinates are sized for 20x10 (see the asserts in s21_snake.cpp).
+ */
+#ifndef SRC_SNAKE_BOARD_H
+#define SRC_SNAKE_BOARD_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace s21 {
+
+constexpr int dynamicExtent = 0;  ///< Size known at run time only
+
+/**
+ * @brief Board of Rows x Cols cells, rows grow downwards.
+ */
+template <int Rows, int Cols>
+class BoardGeometry {
+  static_assert(Rows > 0 && Cols > 0, "Board must have cells");
+
+ public:
+  static constexpr int rows() { return Rows; }
+  static constexpr int cols() { return Cols; }
+  static constexpr size_t cells() { return (size_t)Rows * Cols; }
+
+  /**
+   * @brief Checks that a cell lies on the board.
+   **/
+  static constexpr bool contains(int row, int col) {
+    return (unsigned)row < (unsigned)Rows && (unsigned)col < (unsigned)Cols;
+  }
+
+  /**
+   * @brief Row-major index of a cell.
+   **/
+  static constexpr size_t index(int row, int col) {
+    if constexpr ((Cols & (Cols - 1)) == 0) {
+      return (size_t)row << shift() | (size_t)col;
+    } else {
+      return (size_t)row * Cols + col;
+    }
+  }
+
+ private:
+  static constexpr int shift() {
+    int bits = 0;
+    while ((1 << bits) < Cols) {
+      ++bits;
+    }
+    return bits;
+  }
+};
+
+/**
+ * @brief Run-time sized fallback.
+ */
+template <>
+class BoardGeometry<dynamicExtent, dynamicExtent> {
+ public:
+  constexpr BoardGeometry(int rows, int cols)
+      : rows_(rows > 0 ? rows : 1), cols_(cols > 0 ? cols : 1) {}
+
+  /**
+   * @brief Copies the sizes of a compile-time board.
+   **/
+  template <int Rows, int Cols>
+  constexpr BoardGeometry(BoardGeometry<Rows, Cols>)
+      : rows_(Rows), cols_(Cols) {}
+
+  constexpr int rows() const { return rows_; }
+  constexpr int cols() const { return cols_; }
+  constexpr size_t cells() const { return (size_t)rows_ * cols_; }
+
+  constexpr bool contains(int row, int col) const {
+    return (unsigned)row < (unsigned)rows_ && (unsigned)col < (unsigned)cols_;
+  }
+
+  constexpr size_t index(int row, int col) const {
+    return (size_t)row * cols_ + col;
+  }
+
+ private:
+  int rows_;
+  int cols_;
+};
+
+using ClassicBoard = BoardGeometry<20, 10>;  ///< Brick game screen
+using DynamicBoard = BoardGeometry<dynamicExtent, dynamicExtent>;
+
+/**
+ * @brief Steps the xorshift64* generator every snake board places its food
+ * with. The whole state is one nonzero word, so snapshots and journals
+ * carry it as is.
+ * @return Upper half of the scrambled state
+ **/
+inline uint32_t nextXorshift64Star(uint64_t& state) {
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return (state * 2685821657736338717ull) >> 32;
+}
+
+}  // namespace s21
+
+#endif  // SRC_SNAKE_BOARD_H
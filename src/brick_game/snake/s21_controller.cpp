@@ -14,6 +14,10 @@ GameStatus_t getGameStatus() {
 
 GameInfo_t updateScene() { return updateCurrentState(); }
 
+int getFieldRows() { return Game::fieldYSize; }
+
+int getFieldCols() { return Game::fieldXSize; }
+
 void processUserAction(UserAction_t action, bool hold) {
   userInput(action, hold);
 }
@@ -22,5 +26,206 @@ void initializeGame() { SnakeFacade::Instance().initializeGame(); }
 
 void freeGameInfo(GameInfo_t gameInfo) { freeGameState(gameInfo); }
 
+bool exportFrames(const char* name) {
+  return SnakeFacade::Instance().exportFrames(name != nullptr ? name : "");
+}
+
+void stopFrameExport() { SnakeFacade::Instance().stopFrameExport(); }
+
+void setSessionPoolSize(int size) {
+  SnakeFacade::Instance().setSessionPoolSize(size > 0 ? size : 0);
+}
+
+void setHibernationTimeout(int milliseconds) {
+  SnakeFacade::Instance().setHibernationTimeout(
+      std::chrono::milliseconds(milliseconds > 0 ? milliseconds : 0));
+}
+
+int snapshotGame(uint8_t* buffer, int capacity) {
+  std::vector<uint8_t> state;
+  if (!SnakeFacade::Instance().snapshotGame(state)) {
+    return 0;
+  }
+  if (buffer != nullptr && state.size() <= (size_t)capacity) {
+    std::memcpy(buffer, state.data(), state.size());
+  }
+  return state.size();
+}
+
+bool restoreGame(const uint8_t* buffer, int length) {
+  if (buffer == nullptr || length <= 0) {
+    return false;
+  }
+  return SnakeFacade::Instance().restoreGame(
+      std::vector<uint8_t>(buffer, buffer + length));
+}
+
+void setJournalDirectory(const char* directory) {
+  SnakeFacade::Instance().setJournalDirectory(directory != nullptr ? directory
+                                                                   : "");
+}
+
+int replayJournal(const char* path, uint8_t* buffer, int capacity) {
+  ReplayPlayer* player = replayOpen(path);
+  int size = 0;
+  if (player != nullptr && player->seek(player->length())) {
+    size = replaySnapshot(player, buffer, capacity);
+  }
+  replayClose(player);
+  return size;
+}
+
+ReplayPlayer* replayOpen(const char* path) {
+  return path != nullptr ? ReplayPlayer::open(path) : nullptr;
+}
+
+bool replaySeek(ReplayPlayer* player, uint64_t step) {
+  return player->seek(step);
+}
+
+bool replayStep(ReplayPlayer* player) { return player->step(); }
+
+uint64_t replayPosition(ReplayPlayer* player) { return player->position(); }
+
+uint64_t replayLength(ReplayPlayer* player) { return player->length(); }
+
+int replaySnapshot(ReplayPlayer* player, uint8_t* buffer, int capacity) {
+  std::vector<uint8_t> state;
+  player->snapshot(state);
+  if (buffer != nullptr && state.size() <= (size_t)capacity) {
+    std::memcpy(buffer, state.data(), state.size());
+  }
+  return state.size();
+}
+
+void replayClose(ReplayPlayer* player) { delete player; }
+
+void setRewindBudget(int budget) {
+  SnakeFacade::Instance().setRewindBudget(budget > 0 ? budget : 0);
+}
+
+bool rewindWindow(uint64_t* first, uint64_t* last) {
+  return SnakeFacade::Instance().rewindWindow(first, last);
+}
+
+int rewindSnapshot(uint64_t step, uint8_t* buffer, int capacity) {
+  std::vector<uint8_t> state;
+  if (!SnakeFacade::Instance().rewindState(step, state)) {
+    return 0;
+  }
+  if (buffer != nullptr && state.size() <= (size_t)capacity) {
+    std::memcpy(buffer, state.data(), state.size());
+  }
+  return state.size();
+}
+
+bool openLeaderboard(const char* path) {
+  return SnakeFacade::Instance().openLeaderboard(path != nullptr ? path : "");
+}
+
+void setPlayerName(const char* name) {
+  SnakeFacade::Instance().setPlayerName(name != nullptr ? name : "");
+}
+
+int leaderboardBest() { return SnakeFacade::Instance().leaderboardBest(); }
+
+int leaderboardRank(int score) {
+  return SnakeFacade::Instance().leaderboardRank(score);
+}
+
+int leaderboardTop(int count, int* scores, char* players) {
+  std::vector<LeaderboardRecord> records;
+  SnakeFacade::Instance().leaderboardTop(count > 0 ? count : 0, records);
+  for (size_t i = 0; i < records.size(); ++i) {
+    scores[i] = records[i].score;
+    if (players != nullptr) {
+      std::memcpy(players + i * LEADERBOARD_PLAYER_SIZE, records[i].player,
+                  LEADERBOARD_PLAYER_SIZE);
+    }
+  }
+  return records.size();
+}
+
+int leaderboardPlayerBest() {
+  return SnakeFacade::Instance().leaderboardPlayerBest();
+}
+
+HugeGame* hugeGameCreate(int rows, int cols, int foodCount, uint64_t seed) {
+  return new HugeGame(rows, cols, foodCount, seed);
+}
+
+void hugeGameInput(HugeGame* game, UserAction_t action) {
+  game->processUserInput(action);
+}
+
+GameStatus_t hugeGameTick(HugeGame* game) { return game->tick(); }
+
+void hugeGameViewport(HugeGame* game, int top, int left, int rows, int cols,
+                      int* cells) {
+  if (rows > 0 && cols > 0) {
+    game->renderViewport(top, left, rows, cols, cells);
+  }
+}
+
+void hugeGameView(HugeGame* game, int rows, int cols, int* cells, int* top,
+                  int* left) {
+  if (rows > 0 && cols > 0) {
+    game->renderAroundHead(rows, cols, cells, top, left);
+  }
+}
+
+void hugeGameHead(HugeGame* game, int* row, int* col) {
+  game->getHead(row, col);
+}
+
+int hugeGameScore(HugeGame* game) { return game->getScore(); }
+
+void hugeGameDestroy(HugeGame* game) { delete game; }
+
+Arena* arenaCreate(int rows, int cols, int maxSnakes, int foodCount,
+                   uint64_t seed) {
+  return new Arena(rows, cols, maxSnakes, foodCount, seed);
+}
+
+int arenaSpawn(Arena* arena) { return arena->spawnSnake(); }
+
+void arenaSteer(Arena* arena, int snake, UserAction_t action) {
+  arena->steer(snake, action);
+}
+
+int arenaTick(Arena* arena) { return arena->tick(); }
+
+void arenaViewport(Arena* arena, int top, int left, int rows, int cols,
+                   int* cells) {
+  if (rows > 0 && cols > 0) {
+    arena->renderViewport(top, left, rows, cols, cells);
+  }
+}
+
+bool arenaAlive(Arena* arena, int snake) { return arena->isAlive(snake); }
+
+int arenaScore(Arena* arena, int snake) { return arena->getScore(snake); }
+
+void arenaHead(Arena* arena, int snake, int* row, int* col) {
+  arena->getHead(snake, row, col);
+}
+
+void arenaDestroy(Arena* arena) { delete arena; }
+
+VecEnv* vecEnvCreate(int count, int threads) {
+  return new VecEnv(count, threads);
+}
+
+void vecEnvResetAll(VecEnv* env, const uint64_t* seeds, uint8_t* obs) {
+  env->resetAll(seeds, obs);
+}
+
+void vecEnvStepAll(VecEnv* env, const uint8_t* actions, uint8_t* obs,
+                   float* reward, uint8_t* done) {
+  env->stepAll(actions, obs, reward, done);
+}
+
+void vecEnvDestroy(VecEnv* env) { delete env; }
+
 }  // namespace s21
 }
@@ -5,7 +5,11 @@
 #ifndef SRC_SNAKE_CONTROLLER_H
 #define SRC_SNAKE_CONTROLLER_H
 
+#include "s21_arena.h"
+#include "s21_huge_game.h"
+#include "s21_replay.h"
 #include "s21_snake_facade.h"
+#include "s21_vec_env.h"
 using namespace s21;
 
 extern "C" {
@@ -22,6 +26,16 @@ GameStatus_t getGameStatus();
  **/
 GameInfo_t updateScene();
 
+/**
+ * @brief Rows of the field returned by updateScene().
+ **/
+int getFieldRows();
+
+/**
+ * @brief Columns of the field returned by updateScene().
+ **/
+int getFieldCols();
+
 /**
  * @brief Sends user action to model.
  * @param action User action.
@@ -38,6 +52,325 @@ void initializeGame();
  * @brief Frees up allocated memory.
  **/
 void freeGameInfo(GameInfo_t gameInfo);
+
+/**
+ * @brief Starts exporting frames into a shared-memory ring.
+ * Other processes may map the ring by name and read frames without syscalls.
+ * @param name POSIX shm name, e.g. "/s21_snake_frames".
+ * @return true on success.
+ **/
+bool exportFrames(const char* name);
+
+/**
+ * @brief Stops exporting frames and unlinks the ring.
+ **/
+void stopFrameExport();
+
+/**
+ * @brief Sets the number of pre-initialized sessions kept in the pool.
+ * Terminated sessions are reset in place and returned to the pool,
+ * so initializeGame() only claims one of them.
+ * @param size Pool capacity.
+ **/
+void setSessionPoolSize(int size);
+
+/**
+ * @brief Sets idle timeout after which a session in START, PAUSE or
+ * GAMEOVER is hibernated into a compact snapshot. The session is revived
+ * transparently by the next user action, reads are served from the snapshot.
+ * @param milliseconds Idle timeout, 0 disables hibernation.
+ **/
+void setHibernationTimeout(int milliseconds);
+
+/**
+ * @brief Takes a binary snapshot of the current game: field, snake body,
+ * PRNG state, timer, score and FSM status. The format is versioned and
+ * little-endian, see s21_snapshot.h. SNAPSHOT_MAX_SIZE bytes are always
+ * enough.
+ * @param buffer Output buffer.
+ * @param capacity Buffer size.
+ * @return Snapshot size, 0 if no game is running. Nothing is copied if
+ * the size is larger than capacity.
+ **/
+int snapshotGame(uint8_t* buffer, int capacity);
+
+/**
+ * @brief Restores the game from a binary snapshot. Starts a new game if
+ * none is running.
+ * @param buffer Snapshot produced by snapshotGame().
+ * @param length Snapshot size.
+ * @return true on success, the game is untouched otherwise.
+ **/
+bool restoreGame(const uint8_t* buffer, int length);
+
+/**
+ * @brief Enables replay journals: every session appends its starting
+ * snapshot and varint-encoded (step delta, action, hold) records into
+ * its own file in the directory, see s21_journal.h.
+ * @param directory Existing directory, NULL or "" disables journaling.
+ **/
+void setJournalDirectory(const char* directory);
+
+/**
+ * @brief Replays a journal on a headless game.
+ * @param path Journal file.
+ * @param buffer Output buffer for the snapshot of the replayed game.
+ * @param capacity Buffer size.
+ * @return Snapshot size, 0 if the journal is malformed. Nothing is copied
+ * if the size is larger than capacity.
+ **/
+int replayJournal(const char* path, uint8_t* buffer, int capacity);
+
+/**
+ * @brief Opens a journal for playback. Journals carry keyframes every
+ * JOURNAL_KEYFRAME_INTERVAL steps and a keyframe index, so seeking to any
+ * step restores the nearest keyframe and plays only the rest.
+ * @param path Journal file.
+ * @return Player at step 0, NULL if the file is not a snake journal.
+ **/
+ReplayPlayer* replayOpen(const char* path);
+
+/**
+ * @brief Moves the player to the state after the given number of steps.
+ * @return false if the journal ends before the step.
+ **/
+bool replaySeek(ReplayPlayer* player, uint64_t step);
+
+/**
+ * @brief Plays one FSM step.
+ * @return false at the end of the journal.
+ **/
+bool replayStep(ReplayPlayer* player);
+
+/**
+ * @brief Steps played so far.
+ **/
+uint64_t replayPosition(ReplayPlayer* player);
+
+/**
+ * @brief Number of steps in the journal.
+ **/
+uint64_t replayLength(ReplayPlayer* player);
+
+/**
+ * @brief Takes a binary snapshot of the game at the current position.
+ * @return Snapshot size. Nothing is copied if the size is larger than
+ * capacity.
+ **/
+int replaySnapshot(ReplayPlayer* player, uint8_t* buffer, int capacity);
+
+/**
+ * @brief Closes the player.
+ **/
+void replayClose(ReplayPlayer* player);
+
+/**
+ * @brief Enables the rewind buffer: every session keeps its last steps in
+ * memory as snapshots and tiny step records, see s21_rewind.h.
+ * @param budget Memory budget per session in bytes (REWIND_DEFAULT_BUDGET
+ * is a sensible value), 0 disables rewinding.
+ **/
+void setRewindBudget(int budget);
+
+/**
+ * @brief Steps of the current session that can be rebuilt.
+ * @param first Oldest step in the window.
+ * @param last Latest step.
+ * @return false if rewinding is disabled or no game is running.
+ **/
+bool rewindWindow(uint64_t* first, uint64_t* last);
+
+/**
+ * @brief Rebuilds the current session at a step of the rewind window.
+ * @param step Step between first and last.
+ * @param buffer Output buffer for the snapshot.
+ * @param capacity Buffer size.
+ * @return Snapshot size, 0 if the step is outside of the window. Nothing
+ * is copied if the size is larger than capacity.
+ **/
+int rewindSnapshot(uint64_t step, uint8_t* buffer, int capacity);
+
+/**
+ * @brief Maps the leaderboard store shared by all sessions and processes,
+ * see s21_leaderboard.h. Final scores are posted there at game over.
+ * @param path Store file, created if missing. NULL or "" detaches it.
+ * @return false if the store cannot be mapped.
+ **/
+bool openLeaderboard(const char* path);
+
+/**
+ * @brief Sets the name the following sessions post their scores under.
+ **/
+void setPlayerName(const char* name);
+
+/**
+ * @brief Best snake score of the leaderboard, 0 if none is open.
+ **/
+int leaderboardBest();
+
+/**
+ * @brief Rank a snake score would have on the leaderboard.
+ * @return 1 for the best score, 0 if no leaderboard is open.
+ **/
+int leaderboardRank(int score);
+
+/**
+ * @brief Best snake scores of the leaderboard, highest first.
+ * @param count Entries wanted.
+ * @param scores Output scores, count elements.
+ * @param players Output zero-padded player names, count *
+ * LEADERBOARD_PLAYER_SIZE bytes. May be NULL.
+ * @return Number of entries written.
+ **/
+int leaderboardTop(int count, int* scores, char* players);
+
+/**
+ * @brief Best snake score of the current player on the leaderboard.
+ **/
+int leaderboardPlayerBest();
+
+/**
+ * @brief Creates a huge-board game, see s21_huge_game.h. The game has no
+ * threads: the caller moves the snake with hugeGameTick().
+ * @param rows Board height, up to HUGE_BOARD_MAX_SIDE.
+ * @param cols Board width, up to HUGE_BOARD_MAX_SIDE.
+ * @param foodCount Food items kept on the board.
+ * @param seed PRNG seed.
+ * @return New game in START.
+ **/
+HugeGame* hugeGameCreate(int rows, int cols, int foodCount, uint64_t seed);
+
+/**
+ * @brief Sends user action to a huge-board game.
+ **/
+void hugeGameInput(HugeGame* game, UserAction_t action);
+
+/**
+ * @brief Moves the snake one cell.
+ * @return Status after the move.
+ **/
+GameStatus_t hugeGameTick(HugeGame* game);
+
+/**
+ * @brief Renders a rectangle of the board. The cost depends on the size
+ * of the rectangle only, cells outside of the board are 0.
+ * @param cells Output codes, rows * cols elements, row by row.
+ **/
+void hugeGameViewport(HugeGame* game, int top, int left, int rows, int cols,
+                      int* cells);
+
+/**
+ * @brief Renders a rectangle centred on the snake head.
+ * @param cells Output codes, rows * cols elements, row by row.
+ * @param top Output row of the upper left corner.
+ * @param left Output col of the upper left corner.
+ **/
+void hugeGameView(HugeGame* game, int rows, int cols, int* cells, int* top,
+                  int* left);
+
+/**
+ * @brief Position of the snake head.
+ **/
+void hugeGameHead(HugeGame* game, int* row, int* col);
+
+/**
+ * @brief Score of a huge-board game.
+ **/
+int hugeGameScore(HugeGame* game);
+
+/**
+ * @brief Destroys a huge-board game.
+ **/
+void hugeGameDestroy(HugeGame* game);
+
+/**
+ * @brief Creates a multi-snake arena, see s21_arena.h. The arena has no
+ * threads: the caller advances all snakes at once with arenaTick().
+ * @param rows Board height, up to ARENA_MAX_SIDE.
+ * @param cols Board width, up to ARENA_MAX_SIDE.
+ * @param maxSnakes Snake slots.
+ * @param foodCount Food items kept on the board.
+ * @param seed PRNG seed.
+ * @return New arena without snakes.
+ **/
+Arena* arenaCreate(int rows, int cols, int maxSnakes, int foodCount,
+                   uint64_t seed);
+
+/**
+ * @brief Places a new snake on the arena.
+ * @return Snake id, -1 if the arena is full.
+ **/
+int arenaSpawn(Arena* arena);
+
+/**
+ * @brief Turns a snake, only arrow actions are used.
+ **/
+void arenaSteer(Arena* arena, int snake, UserAction_t action);
+
+/**
+ * @brief Advances all snakes by one cell.
+ * @return Number of snakes alive.
+ **/
+int arenaTick(Arena* arena);
+
+/**
+ * @brief Renders a rectangle of the arena, cells outside of the board
+ * are 0.
+ * @param cells Output codes, rows * cols elements, row by row.
+ **/
+void arenaViewport(Arena* arena, int top, int left, int rows, int cols,
+                   int* cells);
+
+/**
+ * @brief Checks whether a snake is alive.
+ **/
+bool arenaAlive(Arena* arena, int snake);
+
+/**
+ * @brief Food eaten by a snake.
+ **/
+int arenaScore(Arena* arena, int snake);
+
+/**
+ * @brief Head of a snake, -1 for both coordinates if it is dead.
+ **/
+void arenaHead(Arena* arena, int snake, int* row, int* col);
+
+/**
+ * @brief Destroys an arena.
+ **/
+void arenaDestroy(Arena* arena);
+
+/**
+ * @brief Creates a batch of headless games, see s21_vec_env.h. Every
+ * game starts with seed i + 1.
+ * @param count Number of environments.
+ * @param threads Worker threads, 0 uses every core.
+ * @return New batch.
+ **/
+VecEnv* vecEnvCreate(int count, int threads);
+
+/**
+ * @brief Starts a new game in every environment.
+ * @param seeds count seeds, NULL for 1..count.
+ * @param obs Output count * rows * cols cell codes, may be NULL.
+ **/
+void vecEnvResetAll(VecEnv* env, const uint64_t* seeds, uint8_t* obs);
+
+/**
+ * @brief Advances every environment by one tick, finished games restart.
+ * @param actions count actions (UserAction_t values).
+ * @param obs Output count * rows * cols cell codes.
+ * @param reward Output count rewards (food eaten).
+ * @param done Output count flags, 1 if the game ended.
+ **/
+void vecEnvStepAll(VecEnv* env, const uint8_t* actions, uint8_t* obs,
+                   float* reward, uint8_t* done);
+
+/**
+ * @brief Destroys a batch and stops its workers.
+ **/
+void vecEnvDestroy(VecEnv* env);
 }
 
 #endif
@@ -0,0 +1,160 @@
+/**
+ * @file s21_frame_ring.cpp
+ * @brief Shared-memory frame ring source code.
+ */
+
+#include "s21_frame_ring.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace s21 {
+
+FrameRing* FrameRing::create(const std::string& name, uint32_t slotCount) {
+  if (slotCount == 0) {
+    return nullptr;
+  }
+
+  int fd = -1;
+  if (name.empty()) {
+    fd = memfd_create("s21_snake_frames", MFD_CLOEXEC);
+  } else {
+    /* Readers may still map a stale object under this name: replace it
+     * instead of truncating it under them */
+    shm_unlink(name.c_str());
+    fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  }
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  size_t size = sizeof(FrameRingHeader) + sizeof(FrameSlot) * slotCount;
+  FrameRing* ring = new FrameRing();
+  ring->fd_ = fd;
+  ring->name_ = name;
+  ring->owner_ = true;
+  if (ftruncate(fd, size) != 0 || !ring->map(size, true)) {
+    delete ring;
+    return nullptr;
+  }
+
+  /* ftruncate() zero-fills the mapping, so every sequence starts at 0 */
+  ring->header_->version = FRAME_RING_VERSION;
+  ring->header_->slotSize = sizeof(FrameSlot);
+  ring->header_->rows = FRAME_RING_ROWS;
+  ring->header_->cols = FRAME_RING_COLS;
+  ring->header_->slotCount = slotCount;
+  ring->header_->writeIndex.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  ring->header_->magic = FRAME_RING_MAGIC;
+  return ring;
+}
+
+FrameRing* FrameRing::attach(const std::string& name) {
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  struct stat info;
+  FrameRing* ring = new FrameRing();
+  ring->fd_ = fd;
+  ring->name_ = name;
+  if (fstat(fd, &info) != 0 ||
+      (size_t)info.st_size < sizeof(FrameRingHeader) ||
+      !ring->map(info.st_size, false) ||
+      ring->header_->magic != FRAME_RING_MAGIC ||
+      ring->header_->version != FRAME_RING_VERSION ||
+      ring->header_->slotSize != sizeof(FrameSlot) ||
+      sizeof(FrameRingHeader) +
+              (size_t)ring->header_->slotCount * sizeof(FrameSlot) >
+          ring->mappingSize_) {
+    delete ring;
+    return nullptr;
+  }
+  return ring;
+}
+
+FrameRing::~FrameRing() {
+  if (header_ != nullptr) {
+    munmap(header_, mappingSize_);
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+  if (owner_ && !name_.empty()) {
+    shm_unlink(name_.c_str());
+  }
+}
+
+bool FrameRing::map(size_t size, bool writable) {
+  int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+  void* memory = mmap(nullptr, size, protection, MAP_SHARED, fd_, 0);
+  if (memory == MAP_FAILED) {
+    return false;
+  }
+  mappingSize_ = size;
+  header_ = static_cast<FrameRingHeader*>(memory);
+  slots_ = reinterpret_cast<FrameSlot*>(static_cast<char*>(memory) +
+                                        sizeof(FrameRingHeader));
+  return true;
+}
+
+void FrameRing::publish(Frame& frame) {
+  uint64_t index = header_->writeIndex.load(std::memory_order_relaxed);
+  FrameSlot& slot = slots_[index % header_->slotCount];
+  uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+
+  frame.generation = index + 1;
+  slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(&slot.frame, &frame, sizeof(Frame));
+  slot.sequence.store(sequence + 2, std::memory_order_release);
+  header_->writeIndex.store(index + 1, std::memory_order_release);
+}
+
+bool FrameRing::readLatest(Frame* out) const {
+  uint64_t published = header_->writeIndex.load(std::memory_order_acquire);
+  bool result = false;
+  while (published != 0 && !result) {
+    result = read(published, out);
+    if (!result) {
+      published = header_->writeIndex.load(std::memory_order_acquire);
+    }
+  }
+  return result;
+}
+
+bool FrameRing::read(uint64_t generation, Frame* out) const {
+  uint64_t published = header_->writeIndex.load(std::memory_order_acquire);
+  if (generation == 0 || generation > published ||
+      published - generation >= header_->slotCount) {
+    return false;
+  }
+
+  const FrameSlot& slot = slots_[(generation - 1) % header_->slotCount];
+  for (;;) {
+    uint32_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before & 1u) {
+      continue;
+    }
+    std::memcpy(out, &slot.frame, sizeof(Frame));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) == before) {
+      break;
+    }
+  }
+  return out->generation == generation;
+}
+
+uint64_t FrameRing::published() const {
+  return header_->writeIndex.load(std::memory_order_acquire);
+}
+
+int FrameRing::fd() const { return fd_; }
+
+}  // namespace s21
@@ -0,0 +1,141 @@
+/**
+ * @file s21_frame_ring.h
+ * @brief Shared-memory frame ring header file.
+ *
+ * Ring layout (shared with the tetris library, little-endian host order):
+ *   [FrameRingHeader, 64 bytes][FrameSlot * slotCount, 264 bytes each]
+ * Every slot is guarded by its own seqlock: the sequence is odd while the
+ * writer is filling the slot and even once the frame is complete.
+ */
+#ifndef SRC_SNAKE_FRAME_RING_H
+#define SRC_SNAKE_FRAME_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace s21 {
+
+#define FRAME_RING_MAGIC 0x52464742u  ///< "BGFR"
+#define FRAME_RING_VERSION 2
+#define FRAME_RING_ROWS 20  ///< Field capacity of a frame
+#define FRAME_RING_COLS 10
+#define FRAME_RING_DEFAULT_SLOTS 64
+
+/**
+ * @brief Single exported frame.
+ *
+ * @param generation Monotonic frame number inside the ring
+ * @param status Game status (GameStatus_t value)
+ * @param rows Rows of the board, the first rows of field are used
+ * @param cols Columns of the board, the first cols of every row are used
+ * @param field Rendered game field, one byte per cell
+ * @param next Next figure (unused by snake)
+ **/
+struct Frame {
+  uint64_t generation;
+  int32_t status;
+  int32_t score;
+  int32_t highScore;
+  int32_t level;
+  int32_t speed;
+  int32_t pause;
+  uint16_t rows;
+  uint16_t cols;
+  uint32_t reserved;
+  uint8_t field[FRAME_RING_ROWS][FRAME_RING_COLS];
+  uint8_t next[4][4];
+};
+
+/**
+ * @brief Frame slot guarded by a seqlock.
+ **/
+struct FrameSlot {
+  std::atomic<uint32_t> sequence;
+  uint32_t reserved;
+  Frame frame;
+};
+
+/**
+ * @brief Ring header placed at the beginning of the mapping.
+ **/
+struct FrameRingHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t slotSize;
+  uint16_t rows;
+  uint16_t cols;
+  uint32_t slotCount;
+  std::atomic<uint64_t> writeIndex;  ///< Number of published frames
+  uint8_t reserved[40];
+};
+
+static_assert(sizeof(FrameSlot) == 264, "Frame slot ABI changed");
+static_assert(sizeof(FrameRingHeader) == 64, "Frame ring header ABI changed");
+
+/**
+ * @brief Fixed-size ring of frames living in a shared memory mapping.
+ *
+ * The game thread is the only writer, any number of processes may map the
+ * same ring read-only and poll it without syscalls.
+ */
+class FrameRing {
+ public:
+  /**
+   * @brief Creates a writable ring.
+   * @param name POSIX shm name ("/snake_frames"), memfd is used if empty
+   * @param slotCount Number of frame slots
+   * @return New ring or nullptr on failure
+   **/
+  static FrameRing* create(const std::string& name,
+                           uint32_t slotCount = FRAME_RING_DEFAULT_SLOTS);
+
+  /**
+   * @brief Maps an existing ring read-only.
+   * @param name POSIX shm name used by the writer
+   * @return Ring or nullptr on failure
+   **/
+  static FrameRing* attach(const std::string& name);
+
+  ~FrameRing();
+
+  FrameRing(const FrameRing& other) = delete;
+  FrameRing& operator=(const FrameRing& other) = delete;
+
+  /**
+   * @brief Publishes a frame into the next slot (writer only).
+   * Generation of the frame is assigned by the ring.
+   **/
+  void publish(Frame& frame);
+
+  /**
+   * @brief Copies the most recent complete frame.
+   * @return false if nothing was published yet
+   **/
+  bool readLatest(Frame* out) const;
+
+  /**
+   * @brief Copies frame with given generation if it is still in the ring.
+   * @return false if the frame was overwritten or not yet published
+   **/
+  bool read(uint64_t generation, Frame* out) const;
+
+  uint64_t published() const;  ///< Number of published frames
+  int fd() const;              ///< Descriptor to pass to other processes
+
+ private:
+  FrameRing() = default;
+  bool map(size_t size, bool writable);
+
+  int fd_{-1};
+  size_t mappingSize_{0};
+  bool owner_{false};
+  std::string name_;
+  FrameRingHeader* header_{nullptr};
+  FrameSlot* slots_{nullptr};
+};
+
+}  // namespace s21
+
+#endif  // SRC_SNAKE_FRAME_RING_H
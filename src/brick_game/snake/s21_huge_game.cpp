@@ -0,0 +1,197 @@
+/**
+ * @file s21_huge_game.cpp
+ * @brief Huge-board snake source code.
+ */
+
+#include "s21_huge_game.h"
+
+#include <algorithm>
+
+namespace s21 {
+
+HugeGame::HugeGame(int rows, int cols, int foodCount, uint64_t seed)
+    : board_(DynamicBoard(
+          std::clamp(rows, HUGE_BOARD_MIN_SIDE, HUGE_BOARD_MAX_SIDE),
+          std::clamp(cols, HUGE_BOARD_MIN_SIDE, HUGE_BOARD_MAX_SIDE))),
+      foodCount_(std::max(foodCount, 1)),
+      rngState_(seed != 0 ? seed : 1) {
+  reset();
+}
+
+void HugeGame::reset() {
+  board_.clear();
+  body_.clear();
+  direction_ = Snake::right;
+  rotateFlag_ = true;
+  score_ = 0;
+
+  int row = getRows() / 2;
+  int col = getCols() / 2;
+  for (int i = 0; i < startSize; ++i) {
+    body_.emplace_back(row, col - i, Snake::right);
+  }
+  body_.front().isHead_ = true;
+  for (size_t i = 0; i < body_.size(); ++i) {
+    refresh(i);
+  }
+  for (int i = 0; i < foodCount_; ++i) {
+    placeFood();
+  }
+}
+
+void HugeGame::refresh(size_t index) {
+  SnakeElement* next = index + 1 < body_.size() ? &body_[index + 1] : nullptr;
+  board_.set(body_[index].rowCoord_, body_[index].colCoord_,
+             Snake::segmentCode(&body_[index], next));
+}
+
+uint32_t HugeGame::nextRandom() {
+  return nextXorshift64Star(rngState_);
+}
+
+void HugeGame::placeFood() {
+  /* A huge board is mostly empty, a few attempts are almost always enough */
+  for (int attempt = 0; attempt < 64; ++attempt) {
+    int row = nextRandom() % getRows();
+    int col = nextRandom() % getCols();
+    if (board_.get(row, col) == BLANK) {
+      board_.set(row, col, FOOD);
+      return;
+    }
+  }
+}
+
+void HugeGame::turn(Snake::direction direction) {
+  bool vertical = direction == Snake::up || direction == Snake::down;
+  bool movingVertically =
+      direction_ == Snake::up || direction_ == Snake::down;
+  if (rotateFlag_ && vertical != movingVertically) {
+    direction_ = direction;
+    body_.front().elemDirection_ = direction;
+    rotateFlag_ = false;
+    refresh(0);
+  }
+}
+
+void HugeGame::processUserInput(UserAction_t action) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  switch (action) {
+    case Start:
+      if (status_ == START || status_ == GAMEOVER) {
+        if (status_ == GAMEOVER) {
+          reset();
+        }
+        status_ = MOVING;
+      }
+      break;
+    case Pause:
+      if (status_ == MOVING || status_ == PAUSE) {
+        status_ = status_ == MOVING ? PAUSE : MOVING;
+      }
+      break;
+    case Terminate:
+      status_ = EXIT;
+      break;
+    case Left:
+      turn(Snake::left);
+      break;
+    case Right:
+      turn(Snake::right);
+      break;
+    case Up:
+      turn(Snake::up);
+      break;
+    case Down:
+      turn(Snake::down);
+      break;
+    case Action:
+      break;
+  }
+}
+
+GameStatus_t HugeGame::tick() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (status_ != MOVING) {
+    return status_;
+  }
+  rotateFlag_ = true;
+
+  int row = body_.front().rowCoord_;
+  int col = body_.front().colCoord_;
+  switch (direction_) {
+    case Snake::up:
+      --row;
+      break;
+    case Snake::down:
+      ++row;
+      break;
+    case Snake::left:
+      --col;
+      break;
+    case Snake::right:
+      ++col;
+      break;
+  }
+
+  /* Any non-food code is a body cell, the tail included */
+  int target = board_.get(row, col);
+  if (!board_.geometry().contains(row, col) ||
+      (target != BLANK && target != FOOD)) {
+    status_ = GAMEOVER;
+    return status_;
+  }
+
+  body_.front().isHead_ = false;
+  body_.emplace_front(row, col, direction_);
+  body_.front().isHead_ = true;
+  refresh(0);
+  refresh(1);
+  if (target == FOOD) {
+    ++score_;
+    placeFood();
+  } else {
+    board_.set(body_.back().rowCoord_, body_.back().colCoord_, BLANK);
+    body_.pop_back();
+    refresh(body_.size() - 1);
+  }
+  return status_;
+}
+
+void HugeGame::renderViewport(int top, int left, int rows, int cols,
+                              int* out) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  board_.render(top, left, rows, cols, out);
+}
+
+void HugeGame::renderAroundHead(int rows, int cols, int* out, int* top,
+                                int* left) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  *top = std::max(0, std::min(body_.front().rowCoord_ - rows / 2,
+                              getRows() - rows));
+  *left = std::max(0, std::min(body_.front().colCoord_ - cols / 2,
+                               getCols() - cols));
+  board_.render(*top, *left, rows, cols, out);
+}
+
+GameStatus_t HugeGame::getStatus() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return status_;
+}
+
+int HugeGame::getScore() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return score_;
+}
+
+void HugeGame::getHead(int* row, int* col) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  *row = body_.front().rowCoord_;
+  *col = body_.front().colCoord_;
+}
+
+size_t HugeGame::occupiedCells() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return board_.occupied();
+}
+
+}  // namespace s21
@@ -0,0 +1,108 @@
+/**
+ * @file s21_huge_game.h
+ * @brief Huge-board snake header file.
+ *
+ * Boards of up to HUGE_BOARD_MAX_SIDE cells a side do not fit the dense
+ * int** field, so the huge mode keeps its cells in a SparseBoard and
+ * clients ask for a viewport rectangle instead of the whole field. Every
+ * move rewrites a handful of cells (head, neck and tail), collisions and
+ * food are single cell lookups, so neither a move nor a render depends
+ * on the board size.
+ *
+ * The game has no threads of its own: the host calls tick() at the pace
+ * it wants and may render from any other thread.
+ */
+#ifndef SRC_SNAKE_HUGE_GAME_H
+#define SRC_SNAKE_HUGE_GAME_H
+
+#include <deque>
+#include <mutex>
+
+#include "s21_snake.h"
+#include "s21_sparse_board.h"
+
+namespace s21 {
+
+#define HUGE_BOARD_MIN_SIDE 8
+#define HUGE_BOARD_MAX_SIDE 65536
+#define HUGE_DEFAULT_FOOD 64
+
+/**
+ * @brief Single snake on a huge board.
+ */
+class HugeGame {
+ public:
+  /**
+   * @param rows Board height, clamped to the HUGE_BOARD_* limits
+   * @param cols Board width, clamped to the HUGE_BOARD_* limits
+   * @param foodCount Food items kept on the board
+   * @param seed PRNG seed (food placement), zero is replaced with one
+   **/
+  HugeGame(int rows, int cols, int foodCount, uint64_t seed);
+
+  HugeGame(const HugeGame& other) = delete;
+  HugeGame& operator=(const HugeGame& other) = delete;
+
+  /**
+   * @brief Applies a user action: Start begins a new game from START or
+   * GAMEOVER, Pause toggles the pause, arrows turn the snake (once per
+   * tick, as in the classic game), Terminate ends the game.
+   **/
+  void processUserInput(UserAction_t action);
+
+  /**
+   * @brief Moves the snake one cell if the game is running.
+   * @return Status after the move
+   **/
+  GameStatus_t tick();
+
+  /**
+   * @brief Renders a rectangle of the board, see SparseBoard::render().
+   **/
+  void renderViewport(int top, int left, int rows, int cols, int* out);
+
+  /**
+   * @brief Renders a rectangle centred on the snake head, kept inside
+   * the board when the board is large enough.
+   * @param rows Rectangle height
+   * @param cols Rectangle width
+   * @param out rows * cols codes
+   * @param top Output row of the upper left corner
+   * @param left Output col of the upper left corner
+   **/
+  void renderAroundHead(int rows, int cols, int* out, int* top, int* left);
+
+  GameStatus_t getStatus();
+  int getScore();
+  void getHead(int* row, int* col);
+  int getRows() const { return board_.geometry().rows(); }
+  int getCols() const { return board_.geometry().cols(); }
+
+  /**
+   * @brief Non-blank cells of the board (snake and food).
+   **/
+  size_t occupiedCells();
+
+ private:
+  void reset();
+  void placeFood();
+  void refresh(size_t index);  ///< Redraws a body element
+  void turn(Snake::direction direction);
+  uint32_t nextRandom();
+
+  std::mutex mutex_;
+  SparseBoard board_;
+  std::deque<SnakeElement> body_;  ///< Head first
+  Snake::direction direction_{Snake::right};
+  bool rotateFlag_{true};
+  GameStatus_t status_{START};
+  int score_{0};
+  int foodCount_{0};
+  uint64_t rngState_{1};
+
+  static const int startSize = 4;
+};
+
+}  // namespace s21
+
+#endif  // SRC_SNAKE_HUGE_GAME_H
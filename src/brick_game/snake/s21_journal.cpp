@@ -0,0 +1,344 @@
+/**
+ * @file s21_journal.cpp
+ * @brief Replay journal source code.
+ */
+
+#include "s21_journal.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+
+#include "s21_snapshot.h"
+
+namespace s21 {
+
+/* -------------------------------------------------------------------------- */
+/*                        Journal Class Implementation                        */
+/* -------------------------------------------------------------------------- */
+
+Journal* Journal::open(const std::string& path, uint8_t engine,
+                       uint64_t seed, const std::vector<uint8_t>& state) {
+  FILE* file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    return nullptr;
+  }
+
+  Journal* journal = new Journal();
+  journal->file_ = file;
+  journal->buffer_.reserve(JOURNAL_FLUSH_THRESHOLD);
+  SnapshotWriter writer(journal->buffer_);
+  writer.u32(JOURNAL_MAGIC);
+  writer.u16(JOURNAL_VERSION);
+  writer.u8(engine);
+  writer.u8(0);
+  writer.u64(seed);
+  writer.u16(state.size());
+  journal->buffer_.insert(journal->buffer_.end(), state.begin(), state.end());
+  journal->offset_ = journal->buffer_.size();
+
+  JournalFlusher::Instance().add(journal);
+  return journal;
+}
+
+Journal::~Journal() {
+  if (file_ != nullptr) {
+    std::fclose(file_);
+  }
+}
+
+void Journal::step(uint8_t flags) {
+  ++step_;
+  if ((flags & (JOURNAL_INPUT | JOURNAL_TICK)) != 0) {
+    append(flags);
+  }
+}
+
+void Journal::keyframe(const std::vector<uint8_t>& state) {
+  keyframes_.push_back({step_, offset_});
+  keyframeStep_ = step_;
+  append(JOURNAL_KEYFRAME, &state);
+}
+
+void Journal::append(uint8_t flags, const std::vector<uint8_t>* state) {
+  uint64_t delta = step_ - entryStep_;
+  bool full = false;
+  entryStep_ = step_;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    size_t size = buffer_.size();
+    do {
+      uint8_t byte = delta & 0x7f;
+      delta >>= 7;
+      buffer_.push_back(delta != 0 ? byte | 0x80 : byte);
+    } while (delta != 0);
+    buffer_.push_back(flags);
+    if (state != nullptr) {
+      SnapshotWriter(buffer_).u16(state->size());
+      buffer_.insert(buffer_.end(), state->begin(), state->end());
+    }
+    offset_ += buffer_.size() - size;
+    full = buffer_.size() >= JOURNAL_FLUSH_THRESHOLD;
+  }
+  if (full) {
+    JournalFlusher::Instance().wake();
+  }
+}
+
+void Journal::close() {
+  if (step_ != entryStep_) {
+    append(0);
+  }
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    SnapshotWriter writer(buffer_);
+    writer.u8(0);
+    writer.u8(JOURNAL_INDEX);
+    writer.u64(step_);
+    writer.u32(keyframes_.size());
+    for (const JournalKeyframe& keyframe : keyframes_) {
+      writer.u64(keyframe.step);
+      writer.u64(keyframe.offset);
+    }
+    writer.u64(offset_);
+    writer.u32(JOURNAL_INDEX_MAGIC);
+    closed_ = true;
+  }
+  JournalFlusher::Instance().wake();
+}
+
+bool Journal::flush() {
+  bool closed = false;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    spare_.swap(buffer_);
+    closed = closed_;
+  }
+  /* Only the flusher touches the file, the game thread keeps appending */
+  if (!spare_.empty()) {
+    std::fwrite(spare_.data(), 1, spare_.size(), file_);
+    std::fflush(file_);
+    spare_.clear();
+  }
+  return closed;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                     JournalFlusher Class Implementation                    */
+/* -------------------------------------------------------------------------- */
+
+JournalFlusher& JournalFlusher::Instance() {
+  static JournalFlusher flusher;
+  return flusher;
+}
+
+JournalFlusher::JournalFlusher() : thread_(&JournalFlusher::run, this) {}
+
+JournalFlusher::~JournalFlusher() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+  for (Journal* journal : journals_) {
+    journal->flush();
+    delete journal;
+  }
+}
+
+void JournalFlusher::add(Journal* journal) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  journals_.push_back(journal);
+}
+
+void JournalFlusher::wake() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    pending_ = true;
+  }
+  cv_.notify_all();
+}
+
+void JournalFlusher::run() {
+  std::vector<Journal*> journals;
+  std::vector<Journal*> closed;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    cv_.wait_for(lock, std::chrono::milliseconds(100),
+                 [this] { return stop_ || pending_; });
+    pending_ = false;
+    /* Game threads wake the flusher, so the disk is written unlocked. Only
+     * this thread removes journals, the copied ones stay alive */
+    journals.assign(journals_.begin(), journals_.end());
+    lock.unlock();
+    closed.clear();
+    for (Journal* journal : journals) {
+      if (journal->flush()) {
+        closed.push_back(journal);
+      }
+    }
+    if (!closed.empty()) {
+      lock.lock();
+      for (Journal* journal : closed) {
+        journals_.remove(journal);
+      }
+      lock.unlock();
+      for (Journal* journal : closed) {
+        delete journal;
+      }
+    }
+    lock.lock();
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                     JournalReader Class Implementation                     */
+/* -------------------------------------------------------------------------- */
+
+JournalReader* JournalReader::open(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat info;
+  void* memory = MAP_FAILED;
+  if (fstat(fd, &info) == 0 && info.st_size >= JOURNAL_HEADER_SIZE) {
+    memory = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  ::close(fd);
+  if (memory == MAP_FAILED) {
+    return nullptr;
+  }
+
+  JournalReader* reader = new JournalReader();
+  reader->data_ = static_cast<const uint8_t*>(memory);
+  reader->size_ = info.st_size;
+
+  SnapshotReader header(reader->data_, reader->size_);
+  if (header.u32() != JOURNAL_MAGIC || header.u16() != JOURNAL_VERSION) {
+    delete reader;
+    return nullptr;
+  }
+  reader->engine_ = header.u8();
+  header.u8();
+  reader->seed_ = header.u64();
+  reader->stateSize_ = header.u16();
+  if (!header.ok() || header.remaining() < reader->stateSize_) {
+    delete reader;
+    return nullptr;
+  }
+
+  if (!reader->loadIndex()) {
+    reader->scanIndex();
+  }
+  reader->position_ = reader->firstEntry();
+  return reader;
+}
+
+JournalReader::~JournalReader() {
+  if (data_ != nullptr) {
+    munmap(const_cast<uint8_t*>(data_), size_);
+  }
+}
+
+bool JournalReader::loadIndex() {
+  const size_t footerSize = 2 + sizeof(uint64_t) + sizeof(uint32_t);
+  if (size_ < firstEntry() + footerSize + JOURNAL_TRAILER_SIZE) {
+    return false;
+  }
+  SnapshotReader trailer(data_ + size_ - JOURNAL_TRAILER_SIZE,
+                         JOURNAL_TRAILER_SIZE);
+  uint64_t footer = trailer.u64();
+  if (trailer.u32() != JOURNAL_INDEX_MAGIC || footer < firstEntry() ||
+      footer + footerSize > size_ - JOURNAL_TRAILER_SIZE) {
+    return false;
+  }
+
+  SnapshotReader index(data_ + footer,
+                       size_ - JOURNAL_TRAILER_SIZE - footer);
+  if (index.u8() != 0 || index.u8() != JOURNAL_INDEX) {
+    return false;
+  }
+  uint64_t steps = index.u64();
+  uint64_t count = index.u32();
+  if (index.remaining() != count * 2 * sizeof(uint64_t)) {
+    return false;
+  }
+  keyframes_.clear();
+  keyframes_.reserve(count);
+  for (uint64_t i = 0; i < count; ++i) {
+    JournalKeyframe keyframe;
+    keyframe.step = index.u64();
+    keyframe.offset = index.u64();
+    if (keyframe.offset < firstEntry() || keyframe.offset >= footer ||
+        keyframe.step > steps ||
+        (i != 0 && keyframe.step < keyframes_.back().step)) {
+      keyframes_.clear();
+      return false;
+    }
+    keyframes_.push_back(keyframe);
+  }
+  steps_ = steps;
+  end_ = footer;
+  return true;
+}
+
+void JournalReader::scanIndex() {
+  /* Footer is missing (the writer crashed), index keyframes by a scan */
+  keyframes_.clear();
+  end_ = size_;
+  position_ = firstEntry();
+  uint64_t step = 0;
+  size_t offset = position_;
+  JournalRecord record;
+  while (next(&record)) {
+    step += record.delta;
+    if (record.keyframe()) {
+      keyframes_.push_back({step, offset});
+    }
+    offset = position_;
+  }
+  steps_ = step;
+  end_ = offset;
+}
+
+bool JournalReader::next(JournalRecord* record) {
+  uint64_t delta = 0;
+  size_t position = position_;
+  for (int shift = 0; position < end_ && shift < 64; shift += 7) {
+    uint8_t byte = data_[position++];
+    delta |= (uint64_t)(byte & 0x7f) << shift;
+    if ((byte & 0x80) != 0) {
+      continue;
+    }
+    if (position >= end_ || (data_[position] & JOURNAL_INDEX) != 0) {
+      return false;
+    }
+    record->delta = delta;
+    record->flags = data_[position++];
+    record->state = nullptr;
+    record->stateSize = 0;
+    if (record->keyframe()) {
+      if (end_ - position < sizeof(uint16_t)) {
+        return false;
+      }
+      size_t stateSize = data_[position] | data_[position + 1] << 8;
+      position += sizeof(uint16_t);
+      if (end_ - position < stateSize) {
+        return false;
+      }
+      record->state = data_ + position;
+      record->stateSize = stateSize;
+      position += stateSize;
+    }
+    position_ = position;
+    return true;
+  }
+  return false;
+}
+
+}  // namespace s21
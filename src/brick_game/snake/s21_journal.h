@@ -0,0 +1,234 @@
+/**
+ * @file s21_journal.h
+ * @brief Replay journal header file.
+ *
+ * Journal layout (shared with the tetris library, little-endian):
+ *   u32 magic "BGJR", u16 version, u8 engine, u8 reserved, u64 seed,
+ *   u16 state size, snapshot of the game at the start of the journal
+ *   entries: varint step delta, u8 flags [, u16 size, snapshot]
+ *   footer: varint 0, u8 JOURNAL_INDEX, u64 steps, u32 keyframe count,
+ *           (u64 step, u64 offset) per keyframe, u64 footer offset,
+ *           u32 magic "BGJI"
+ * A step is one iteration of the game FSM. Records hold the action
+ * (bits 0..2), hold flag (bit 3), "input delivered" (bit 4) and
+ * "tick used" (bit 5) of a step, their delta counts steps since the
+ * previous entry, the recorded step included. Steps without a record had
+ * no new input and did not use the timer, so a headless game loaded from
+ * the starting snapshot and stepped through the records reproduces the
+ * session exactly. A record without flags only carries trailing steps.
+ *
+ * Keyframes (JOURNAL_KEYFRAME) carry a snapshot of the game after delta
+ * more quiet steps, so a player can seek by restoring the nearest
+ * keyframe. The footer indexes them, it is written when the journal is
+ * closed; journals of crashed processes are indexed by a scan instead.
+ */
+#ifndef SRC_SNAKE_JOURNAL_H
+#define SRC_SNAKE_JOURNAL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace s21 {
+
+#define JOURNAL_MAGIC 0x524a4742u        ///< "BGJR"
+#define JOURNAL_INDEX_MAGIC 0x494a4742u  ///< "BGJI"
+#define JOURNAL_VERSION 2
+#define JOURNAL_HEADER_SIZE 18  ///< Header without the starting snapshot
+#define JOURNAL_TRAILER_SIZE 12
+#define JOURNAL_ACTION_MASK 0x07
+#define JOURNAL_HOLD 0x08
+#define JOURNAL_INPUT 0x10
+#define JOURNAL_TICK 0x20
+#define JOURNAL_KEYFRAME 0x40
+#define JOURNAL_INDEX 0x80
+#define JOURNAL_FLUSH_THRESHOLD 4096
+#define JOURNAL_KEYFRAME_INTERVAL 1024  ///< Steps between keyframes
+
+/**
+ * @brief Single journal entry: a record or a keyframe.
+ **/
+struct JournalRecord {
+  uint64_t delta;  ///< FSM steps since the previous entry
+  uint8_t flags;   ///< JOURNAL_* bits
+  const uint8_t* state{nullptr};  ///< Keyframe snapshot
+  size_t stateSize{0};
+
+  int action() const { return flags & JOURNAL_ACTION_MASK; }
+  bool hold() const { return flags & JOURNAL_HOLD; }
+  bool input() const { return flags & JOURNAL_INPUT; }
+  bool tick() const { return flags & JOURNAL_TICK; }
+  bool keyframe() const { return flags & JOURNAL_KEYFRAME; }
+};
+
+/**
+ * @brief Keyframe position in the journal.
+ **/
+struct JournalKeyframe {
+  uint64_t step;    ///< Steps played before the keyframe
+  uint64_t offset;  ///< File offset of the keyframe entry
+};
+
+/**
+ * @brief Append-only journal of a single session.
+ *
+ * The game thread only encodes entries into an in-memory buffer, the file
+ * is written by the JournalFlusher thread.
+ */
+class Journal {
+ public:
+  /**
+   * @brief Creates the journal file and buffers its header.
+   * @param path File path
+   * @param engine SNAPSHOT_ENGINE_* id
+   * @param seed Session PRNG state at the start of the journal
+   * @param state Snapshot of the game at the start of the journal
+   * @return New journal or nullptr on failure
+   **/
+  static Journal* open(const std::string& path, uint8_t engine,
+                       uint64_t seed, const std::vector<uint8_t>& state);
+
+  Journal(const Journal& other) = delete;
+  Journal& operator=(const Journal& other) = delete;
+
+  /**
+   * @brief Accounts one FSM step (game thread). A record is buffered only
+   * if the step delivered an input or used a timer tick.
+   * @param flags JOURNAL_* bits of the step
+   **/
+  void step(uint8_t flags);
+
+  /**
+   * @brief Checks whether the game thread should add a keyframe.
+   **/
+  bool keyframeDue() const {
+    return step_ - keyframeStep_ >= JOURNAL_KEYFRAME_INTERVAL;
+  }
+
+  /**
+   * @brief Appends a keyframe (game thread).
+   * @param state Snapshot of the game after the last accounted step
+   **/
+  void keyframe(const std::vector<uint8_t>& state);
+
+  /**
+   * @brief Records the trailing steps, writes the keyframe index and hands
+   * the journal over to the flusher, which writes the rest of the buffer,
+   * closes the file and deletes the journal. The journal must be detached
+   * from the game.
+   **/
+  void close();
+
+ private:
+  friend class JournalFlusher;
+  Journal() = default;
+  ~Journal();
+
+  void append(uint8_t flags, const std::vector<uint8_t>* state = nullptr);
+  bool flush();  ///< Writes buffered entries, true once closed and flushed
+
+  /* Game thread only */
+  uint64_t step_{0};          ///< Steps accounted so far
+  uint64_t entryStep_{0};     ///< Step of the last entry
+  uint64_t keyframeStep_{0};  ///< Step of the last keyframe
+  uint64_t offset_{0};        ///< Bytes appended so far
+  std::vector<JournalKeyframe> keyframes_;
+
+  std::mutex mutex_;
+  std::vector<uint8_t> buffer_;
+  std::vector<uint8_t> spare_;  ///< Buffer being written by the flusher
+  FILE* file_{nullptr};
+  bool closed_{false};
+};
+
+/**
+ * @brief Background thread writing journals of all sessions.
+ */
+class JournalFlusher {
+ public:
+  static JournalFlusher& Instance();
+
+  void add(Journal* journal);
+  void wake();
+
+ private:
+  JournalFlusher();
+  ~JournalFlusher();
+  void run();
+
+  std::mutex mutex_;  ///< Guards the list, never held while writing
+  std::condition_variable cv_;
+  std::list<Journal*> journals_;
+  bool stop_{false};
+  bool pending_{false};
+  std::thread thread_;
+};
+
+/**
+ * @brief Journal reader working on a read-only mapping of the file.
+ */
+class JournalReader {
+ public:
+  /**
+   * @brief Maps the journal and loads (or rebuilds) its keyframe index.
+   * @param path File path
+   * @return Reader or nullptr if the file is not a journal
+   **/
+  static JournalReader* open(const std::string& path);
+
+  ~JournalReader();
+
+  JournalReader(const JournalReader& other) = delete;
+  JournalReader& operator=(const JournalReader& other) = delete;
+
+  uint8_t engine() const { return engine_; }
+  uint64_t seed() const { return seed_; }
+  uint64_t steps() const { return steps_; }  ///< Steps in the journal
+
+  /**
+   * @brief Starting snapshot (step 0).
+   **/
+  const uint8_t* state() const { return data_ + JOURNAL_HEADER_SIZE; }
+  size_t stateSize() const { return stateSize_; }
+
+  /**
+   * @brief Keyframes ordered by step.
+   **/
+  const std::vector<JournalKeyframe>& keyframes() const { return keyframes_; }
+
+  /**
+   * @brief Decodes the next entry.
+   * @return false at the end of the journal (or at a torn entry)
+   **/
+  bool next(JournalRecord* record);
+
+  /**
+   * @brief Moves to an entry offset (a keyframe, or the first entry).
+   **/
+  void seek(uint64_t offset) { position_ = offset; }
+  uint64_t firstEntry() const { return JOURNAL_HEADER_SIZE + stateSize_; }
+
+ private:
+  JournalReader() = default;
+  bool loadIndex();
+  void scanIndex();
+
+  const uint8_t* data_{nullptr};
+  size_t size_{0};
+  size_t end_{0};  ///< End of the entries (footer offset)
+  size_t position_{0};
+  size_t stateSize_{0};
+  uint8_t engine_{0};
+  uint64_t seed_{0};
+  uint64_t steps_{0};
+  std::vector<JournalKeyframe> keyframes_;
+};
+
+}  // namespace s21
+
+#endif  // SRC_SNAKE_JOURNAL_H
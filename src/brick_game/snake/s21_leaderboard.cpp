@@ -0,0 +1,226 @@
+/**
+ * @file s21_leaderboard.cpp
+ * @brief Memory-mapped leaderboard source code.
+ */
+
+#include "s21_leaderboard.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace s21 {
+
+Leaderboard* Leaderboard::open(const std::string& path, uint32_t capacity) {
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  /* The first process formats the store, the others wait for it */
+  flock(fd, LOCK_EX);
+  struct stat info;
+  bool result = fstat(fd, &info) == 0;
+  size_t size = info.st_size;
+  if (result && size == 0 && capacity != 0) {
+    size = sizeof(LeaderboardHeader) + sizeof(LeaderboardRecord) * capacity;
+    LeaderboardHeader header{};
+    header.magic = LEADERBOARD_MAGIC;
+    header.version = LEADERBOARD_VERSION;
+    header.recordSize = sizeof(LeaderboardRecord);
+    header.capacity = capacity;
+    result = ftruncate(fd, size) == 0 &&
+             pwrite(fd, &header, sizeof(header), 0) == sizeof(header);
+  }
+  void* memory = MAP_FAILED;
+  if (result && size >= sizeof(LeaderboardHeader)) {
+    memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  flock(fd, LOCK_UN);
+  ::close(fd);
+  if (memory == MAP_FAILED) {
+    return nullptr;
+  }
+
+  Leaderboard* board = new Leaderboard();
+  board->mappingSize_ = size;
+  board->header_ = static_cast<LeaderboardHeader*>(memory);
+  board->records_ = reinterpret_cast<LeaderboardRecord*>(
+      static_cast<char*>(memory) + sizeof(LeaderboardHeader));
+  LeaderboardHeader* header = board->header_;
+  if (header->magic != LEADERBOARD_MAGIC ||
+      header->version != LEADERBOARD_VERSION ||
+      header->recordSize != sizeof(LeaderboardRecord) ||
+      sizeof(LeaderboardHeader) +
+              (size_t)header->capacity * sizeof(LeaderboardRecord) >
+          size) {
+    delete board;
+    return nullptr;
+  }
+
+  /* A writer may have died between its commit and the best score update */
+  LeaderboardRecord record;
+  for (uint64_t i = 0; i < board->size(); ++i) {
+    if (board->read(i, &record)) {
+      board->raiseBest(record.game, record.score);
+    }
+  }
+  return board;
+}
+
+Leaderboard::~Leaderboard() {
+  for (auto index : indexes_) {
+    delete index;
+  }
+  if (header_ != nullptr) {
+    munmap(header_, mappingSize_);
+  }
+}
+
+uint32_t Leaderboard::checksum(const LeaderboardRecord& record) {
+  uint32_t hash = 2166136261u;
+  auto mix = [&hash](const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+      hash = (hash ^ bytes[i]) * 16777619u;
+    }
+  };
+  mix(&record.game, sizeof(record.game));
+  mix(&record.score, sizeof(record.score));
+  mix(&record.timestamp, sizeof(record.timestamp));
+  mix(record.player, sizeof(record.player));
+  return hash;
+}
+
+void Leaderboard::raiseBest(uint8_t game, int score) {
+  if (game >= LEADERBOARD_GAMES) {
+    return;
+  }
+  std::atomic<int32_t>& best = header_->best[game];
+  int32_t current = best.load(std::memory_order_relaxed);
+  while (score > current &&
+         !best.compare_exchange_weak(current, score,
+                                     std::memory_order_relaxed)) {
+  }
+}
+
+bool Leaderboard::post(uint8_t game, const std::string& player, int score) {
+  uint64_t index =
+      header_->reservedSlots.fetch_add(1, std::memory_order_relaxed);
+  if (index >= header_->capacity) {
+    return false;
+  }
+
+  LeaderboardRecord& record = records_[index];
+  record.game = game;
+  record.score = score;
+  record.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+  std::memset(record.player, 0, sizeof(record.player));
+  std::memcpy(record.player, player.data(),
+              std::min(player.size(), sizeof(record.player) - 1));
+  record.checksum = checksum(record);
+  record.commit.store(LEADERBOARD_COMMITTED, std::memory_order_release);
+  raiseBest(game, score);
+  return true;
+}
+
+int Leaderboard::best(uint8_t game) const {
+  if (game >= LEADERBOARD_GAMES) {
+    return 0;
+  }
+  return header_->best[game].load(std::memory_order_relaxed);
+}
+
+uint64_t Leaderboard::size() const {
+  uint64_t size = header_->reservedSlots.load(std::memory_order_acquire);
+  return std::min<uint64_t>(size, header_->capacity);
+}
+
+bool Leaderboard::read(uint64_t index, LeaderboardRecord* out) const {
+  if (index >= size()) {
+    return false;
+  }
+  const LeaderboardRecord& record = records_[index];
+  if (record.commit.load(std::memory_order_acquire) !=
+      LEADERBOARD_COMMITTED) {
+    return false;
+  }
+  out->commit.store(LEADERBOARD_COMMITTED, std::memory_order_relaxed);
+  out->game = record.game;
+  out->score = record.score;
+  out->checksum = record.checksum;
+  out->timestamp = record.timestamp;
+  std::memcpy(out->player, record.player, sizeof(out->player));
+  return checksum(*out) == out->checksum;
+}
+
+LeaderboardIndex* Leaderboard::index(uint8_t game) {
+  if (game >= LEADERBOARD_GAMES) {
+    return nullptr;
+  }
+  /* Tetris scores grow in steps of 100 */
+  static const int widths[LEADERBOARD_GAMES] = {1, 1, 100, 1, 1, 1, 1, 1};
+  LeaderboardRecord record;
+  auto add = [this, &record](uint64_t slot) {
+    if (!read(slot, &record)) {
+      return false;
+    }
+    if (record.game < LEADERBOARD_GAMES) {
+      if (indexes_[record.game] == nullptr) {
+        indexes_[record.game] = new LeaderboardIndex(widths[record.game]);
+      }
+      indexes_[record.game]->insert(
+          slot, record.score,
+          std::string(record.player,
+                      strnlen(record.player, sizeof(record.player))));
+    }
+    return true;
+  };
+
+  /* Slots of writers still filling them (or dead) are retried later */
+  pending_.erase(std::remove_if(pending_.begin(), pending_.end(), add),
+                 pending_.end());
+  for (uint64_t end = size(); indexed_ < end; ++indexed_) {
+    if (!add(indexed_)) {
+      pending_.push_back(indexed_);
+    }
+  }
+  return indexes_[game];
+}
+
+uint64_t Leaderboard::rank(uint8_t game, int score) {
+  std::lock_guard<std::mutex> guard(indexMutex_);
+  LeaderboardIndex* scores = index(game);
+  return scores != nullptr ? scores->rank(score) : 1;
+}
+
+void Leaderboard::top(uint8_t game, size_t count,
+                      std::vector<LeaderboardRecord>& out) {
+  std::lock_guard<std::mutex> guard(indexMutex_);
+  LeaderboardIndex* scores = index(game);
+  std::vector<uint32_t> slots;
+  if (scores != nullptr) {
+    scores->top(count, slots);
+  }
+  std::vector<LeaderboardRecord> records(slots.size());
+  for (size_t i = 0; i < slots.size(); ++i) {
+    read(slots[i], &records[i]);
+  }
+  out.swap(records);
+}
+
+int Leaderboard::playerBest(uint8_t game, const std::string& player) {
+  std::lock_guard<std::mutex> guard(indexMutex_);
+  LeaderboardIndex* scores = index(game);
+  return scores != nullptr ? scores->playerBest(player) : 0;
+}
+
+}  // namespace s21
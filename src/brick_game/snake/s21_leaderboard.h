@@ -0,0 +1,156 @@
+/**
+ * @file s21_leaderboard.h
+ * @brief Memory-mapped leaderboard header file.
+ *
+ * Store layout (shared with the tetris library, little-endian host order):
+ *   [LeaderboardHeader, 64 bytes][LeaderboardRecord * capacity, 64 bytes]
+ * Writers reserve a slot with an atomic increment of the header counter,
+ * fill the record and publish it by storing its commit word last. A
+ * record is valid only if it is committed and its checksum matches, so
+ * slots of writers that crashed before the commit are skipped. The best
+ * score of every game is kept in the header and raised with a CAS.
+ *
+ * Rank and top-K queries go through a process-local LeaderboardIndex per
+ * game, which catches up with the records appended since the last query.
+ */
+#ifndef SRC_SNAKE_LEADERBOARD_H
+#define SRC_SNAKE_LEADERBOARD_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "s21_leaderboard_index.h"
+
+namespace s21 {
+
+#define LEADERBOARD_MAGIC 0x424c4742u  ///< "BGLB"
+#define LEADERBOARD_VERSION 1
+#define LEADERBOARD_COMMITTED 0x54494d43u  ///< "CMIT"
+#define LEADERBOARD_GAMES 8  ///< Best scores indexed by SNAPSHOT_ENGINE_*
+#define LEADERBOARD_PLAYER_SIZE 40
+#define LEADERBOARD_DEFAULT_CAPACITY 65536
+
+/**
+ * @brief Single posted score.
+ *
+ * @param commit LEADERBOARD_COMMITTED once the record is complete
+ * @param game SNAPSHOT_ENGINE_* id
+ * @param checksum FNV-1a of the record without commit and checksum
+ * @param timestamp Unix time in milliseconds
+ * @param player Zero-padded player name
+ **/
+struct LeaderboardRecord {
+  std::atomic<uint32_t> commit;
+  uint8_t game;
+  uint8_t reserved[3];
+  int32_t score;
+  uint32_t checksum;
+  uint64_t timestamp;
+  char player[LEADERBOARD_PLAYER_SIZE];
+};
+
+/**
+ * @brief Store header placed at the beginning of the mapping.
+ **/
+struct LeaderboardHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t recordSize;
+  uint32_t capacity;
+  uint32_t reserved0;
+  std::atomic<uint64_t> reservedSlots;  ///< Slots handed out to writers
+  std::atomic<int32_t> best[LEADERBOARD_GAMES];
+  uint8_t reserved[8];
+};
+
+static_assert(sizeof(LeaderboardRecord) == 64, "Leaderboard record ABI");
+static_assert(sizeof(LeaderboardHeader) == 64, "Leaderboard header ABI");
+
+/**
+ * @brief Leaderboard file shared by all sessions and processes.
+ */
+class Leaderboard {
+ public:
+  /**
+   * @brief Maps the store, creating it if the file does not exist.
+   * @param path Store file
+   * @param capacity Number of records of a new store
+   * @return Store or nullptr on failure
+   **/
+  static Leaderboard* open(const std::string& path,
+                           uint32_t capacity = LEADERBOARD_DEFAULT_CAPACITY);
+
+  ~Leaderboard();
+
+  Leaderboard(const Leaderboard& other) = delete;
+  Leaderboard& operator=(const Leaderboard& other) = delete;
+
+  /**
+   * @brief Appends a score, safe to call from any thread or process.
+   * @param game SNAPSHOT_ENGINE_* id
+   * @param player Player name, truncated to fit the record
+   * @param score Final score
+   * @return false if the store is full
+   **/
+  bool post(uint8_t game, const std::string& player, int score);
+
+  /**
+   * @brief Best score posted for a game (a single memory load).
+   **/
+  int best(uint8_t game) const;
+
+  /**
+   * @brief Number of slots handed out, committed or not.
+   **/
+  uint64_t size() const;
+
+  /**
+   * @brief Copies a committed record.
+   * @return false if the slot is not committed (yet, or ever)
+   **/
+  bool read(uint64_t index, LeaderboardRecord* out) const;
+
+  /**
+   * @brief Rank a score would have among the posted ones, 1 is the best.
+   * @param game SNAPSHOT_ENGINE_* id
+   **/
+  uint64_t rank(uint8_t game, int score);
+
+  /**
+   * @brief Best records of a game, highest score first.
+   * @param game SNAPSHOT_ENGINE_* id
+   * @param count Records wanted
+   * @param out Output records
+   **/
+  void top(uint8_t game, size_t count, std::vector<LeaderboardRecord>& out);
+
+  /**
+   * @brief Best score of a player.
+   * @param game SNAPSHOT_ENGINE_* id
+   * @return 0 if the player has not posted yet
+   **/
+  int playerBest(uint8_t game, const std::string& player);
+
+ private:
+  Leaderboard() = default;
+  static uint32_t checksum(const LeaderboardRecord& record);
+  void raiseBest(uint8_t game, int score);
+  LeaderboardIndex* index(uint8_t game);  ///< indexMutex_ held
+
+  size_t mappingSize_{0};
+  LeaderboardHeader* header_{nullptr};
+  LeaderboardRecord* records_{nullptr};
+
+  std::mutex indexMutex_;
+  LeaderboardIndex* indexes_[LEADERBOARD_GAMES]{};
+  uint64_t indexed_{0};            ///< Slots visited by the index
+  std::vector<uint64_t> pending_;  ///< Visited slots not committed yet
+};
+
+}  // namespace s21
+
+#endif  // SRC_SNAKE_LEADERBOARD_H
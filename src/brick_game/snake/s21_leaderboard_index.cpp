@@ -0,0 +1,92 @@
+/**
+ * @file s21_leaderboard_index.cpp
+ * @brief Rank and top-K index of leaderboard scores source code.
+ */
+
+#include "s21_leaderboard_index.h"
+
+#include <algorithm>
+
+namespace s21 {
+
+static const uint32_t noEntry = UINT32_MAX;
+
+LeaderboardIndex::LeaderboardIndex(int width)
+    : width_(width > 0 ? width : 1),
+      tree_(LEADERBOARD_BUCKETS + 1, 0),
+      heads_(LEADERBOARD_BUCKETS, noEntry) {}
+
+size_t LeaderboardIndex::bucket(int score) const {
+  if (score <= 0) {
+    return 0;
+  }
+  return std::min<size_t>(score / width_, LEADERBOARD_BUCKETS - 1);
+}
+
+void LeaderboardIndex::insert(uint32_t record, int score,
+                              const std::string& player) {
+  size_t index = bucket(score);
+  entries_.push_back({record, score, heads_[index]});
+  heads_[index] = entries_.size() - 1;
+  for (size_t i = index + 1; i <= LEADERBOARD_BUCKETS; i += i & -i) {
+    tree_[i]++;
+  }
+
+  auto best = playerBest_.emplace(player, score);
+  if (!best.second && best.first->second < score) {
+    best.first->second = score;
+  }
+}
+
+uint64_t LeaderboardIndex::countAbove(size_t bucket) const {
+  uint64_t prefix = 0;
+  for (size_t i = bucket + 1; i > 0; i -= i & -i) {
+    prefix += tree_[i];
+  }
+  return entries_.size() - prefix;
+}
+
+size_t LeaderboardIndex::findBucket(uint64_t rank) const {
+  size_t position = 0;
+  for (size_t step = LEADERBOARD_BUCKETS; step > 0; step >>= 1) {
+    if (position + step <= LEADERBOARD_BUCKETS &&
+        tree_[position + step] < rank) {
+      position += step;
+      rank -= tree_[position];
+    }
+  }
+  return position;
+}
+
+uint64_t LeaderboardIndex::rank(int score) const {
+  return countAbove(bucket(score)) + 1;
+}
+
+void LeaderboardIndex::top(size_t count, std::vector<uint32_t>& out) const {
+  out.clear();
+  std::vector<Entry> chain;
+  uint64_t remaining = entries_.size();
+  while (out.size() < count && remaining > 0) {
+    /* Highest bucket among the entries not taken yet */
+    size_t index = findBucket(remaining);
+    chain.clear();
+    for (uint32_t i = heads_[index]; i != noEntry; i = entries_[i].next) {
+      chain.push_back(entries_[i]);
+    }
+    /* Equal scores keep the order they were posted in */
+    std::sort(chain.begin(), chain.end(), [](const Entry& a, const Entry& b) {
+      return a.score != b.score ? a.score > b.score : a.record < b.record;
+    });
+    for (size_t i = 0; i < chain.size() && out.size() < count; ++i) {
+      out.push_back(chain[i].record);
+    }
+    remaining -= chain.size();
+  }
+}
+
+int LeaderboardIndex::playerBest(const std::string& player) const {
+  auto best = playerBest_.find(player);
+  return best != playerBest_.end() ? best->second : 0;
+}
+
+}  // namespace s21
@@ -0,0 +1,83 @@
+/**
+ * @file s21_leaderboard_index.h
+ * @brief Rank and top-K index of leaderboard scores header file.
+ *
+ * Scores of one game are counted in a Fenwick tree over score buckets of
+ * a fixed width, so the rank of a score is a prefix sum (O(log buckets)).
+ * Every bucket also chains its entries, top-K walks the non-empty buckets
+ * from the top, finding each one with a Fenwick descent. Ranks are exact
+ * as long as scores are multiples of the width and below the last
+ * bucket, otherwise scores sharing a bucket tie.
+ */
+#ifndef SRC_SNAKE_LEADERBOARD_INDEX_H
+#define SRC_SNAKE_LEADERBOARD_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace s21 {
+
+#define LEADERBOARD_BUCKETS 65536  ///< Buckets of a game, power of two
+
+/**
+ * @brief Order-statistic index of the scores of one game.
+ */
+class LeaderboardIndex {
+ public:
+  /**
+   * @param width Score range of a bucket
+   **/
+  explicit LeaderboardIndex(int width);
+
+  /**
+   * @brief Adds a committed record.
+   * @param record Record index in the store
+   **/
+  void insert(uint32_t record, int score, const std::string& player);
+
+  /**
+   * @brief Number of indexed scores.
+   **/
+  uint64_t size() const { return entries_.size(); }
+
+  /**
+   * @brief Rank a score would have, 1 for the best one.
+   **/
+  uint64_t rank(int score) const;
+
+  /**
+   * @brief Best records, highest score first.
+   * @param count Records wanted
+   * @param out Record indexes in the store
+   **/
+  void top(size_t count, std::vector<uint32_t>& out) const;
+
+  /**
+   * @brief Best score of a player.
+   * @return 0 if the player has not posted yet
+   **/
+  int playerBest(const std::string& player) const;
+
+ private:
+  struct Entry {
+    uint32_t record;
+    int32_t score;
+    uint32_t next;  ///< Next entry of the bucket
+  };
+
+  size_t bucket(int score) const;
+  uint64_t countAbove(size_t bucket) const;  ///< Entries in higher buckets
+  size_t findBucket(uint64_t rank) const;  ///< Bucket holding rank-th lowest
+
+  int width_;
+  std::vector<uint32_t> tree_;   ///< Fenwick tree, 1-based
+  std::vector<uint32_t> heads_;  ///< First entry of every bucket
+  std::vector<Entry> entries_;
+  std::unordered_map<std::string, int> playerBest_;
+};
+
+}  // namespace s21
+
+#endif  // SRC_SNAKE_LEADERBOARD_INDEX_H
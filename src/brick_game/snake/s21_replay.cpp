@@ -0,0 +1,97 @@
+/**
+ * @file s21_replay.cpp
+ * @brief Replay player source code.
+ */
+
+#include "s21_replay.h"
+
+#include <algorithm>
+
+namespace s21 {
+
+ReplayPlayer* ReplayPlayer::open(const std::string& path) {
+  JournalReader* reader = JournalReader::open(path);
+  if (reader == nullptr) {
+    return nullptr;
+  }
+  ReplayPlayer* player = new ReplayPlayer();
+  player->reader_ = reader;
+  if (reader->engine() != SNAPSHOT_ENGINE_SNAKE ||
+      !player->restart(reader->state(), reader->stateSize(), 0)) {
+    delete player;
+    return nullptr;
+  }
+  reader->seek(reader->firstEntry());
+  return player;
+}
+
+ReplayPlayer::~ReplayPlayer() { delete reader_; }
+
+bool ReplayPlayer::restart(const uint8_t* state, size_t size, uint64_t step) {
+  step_ = step;
+  quiet_ = 0;
+  pending_ = false;
+  return game_.loadState(std::vector<uint8_t>(state, state + size));
+}
+
+bool ReplayPlayer::seek(uint64_t step) {
+  const std::vector<JournalKeyframe>& keyframes = reader_->keyframes();
+  auto keyframe = std::upper_bound(
+      keyframes.begin(), keyframes.end(), step,
+      [](uint64_t value, const JournalKeyframe& k) { return value < k.step; });
+  uint64_t base = keyframe != keyframes.begin() ? (keyframe - 1)->step : 0;
+
+  /* Playing forward is cheaper if no keyframe lies between */
+  if (step < step_ || base > step_) {
+    bool restored = false;
+    if (keyframe == keyframes.begin()) {
+      restored = restart(reader_->state(), reader_->stateSize(), 0);
+      reader_->seek(reader_->firstEntry());
+    } else {
+      JournalRecord record;
+      reader_->seek((keyframe - 1)->offset);
+      restored = reader_->next(&record) && record.keyframe() &&
+                 restart(record.state, record.stateSize, base);
+    }
+    if (!restored) {
+      return false;
+    }
+  }
+
+  bool result = true;
+  while (result && step_ < step) {
+    result = this->step();
+  }
+  return result;
+}
+
+bool ReplayPlayer::step() {
+  while (quiet_ == 0 && !pending_) {
+    if (!reader_->next(&record_)) {
+      return false;
+    }
+    /* Keyframe follows its quiet steps, a record is the last of them */
+    if (record_.keyframe()) {
+      quiet_ = record_.delta;
+    } else {
+      quiet_ = record_.delta != 0 ? record_.delta - 1 : 0;
+      pending_ = true;
+    }
+  }
+
+  if (quiet_ != 0) {
+    --quiet_;
+    game_.step(false);
+  } else {
+    pending_ = false;
+    if (record_.input()) {
+      UserAction_t action = (UserAction_t)record_.action();
+      game_.processUserInput(action, record_.hold());
+    }
+    game_.step(record_.tick());
+  }
+  ++step_;
+  return true;
+}
+
+}  // namespace s21
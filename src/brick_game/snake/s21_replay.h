@@ -0,0 +1,69 @@
+/**
+ * @file s21_replay.h
+ * @brief Replay player header file.
+ */
+#ifndef SRC_SNAKE_REPLAY_H
+#define SRC_SNAKE_REPLAY_H
+
+#include "s21_journal.h"
+#include "s21_snake.h"
+
+namespace s21 {
+
+/**
+ * @brief Plays a journal back on a headless game.
+ *
+ * Seeking restores the nearest keyframe at or before the target step and
+ * plays the rest headlessly, so any step is at most
+ * JOURNAL_KEYFRAME_INTERVAL steps away.
+ */
+class ReplayPlayer {
+ public:
+  /**
+   * @brief Opens a snake journal, the player starts at step 0.
+   * @param path Journal file path
+   * @return Player or nullptr if the file is not a snake journal
+   **/
+  static ReplayPlayer* open(const std::string& path);
+
+  ~ReplayPlayer();
+
+  ReplayPlayer(const ReplayPlayer& other) = delete;
+  ReplayPlayer& operator=(const ReplayPlayer& other) = delete;
+
+  /**
+   * @brief Moves the game to the state after the given number of steps.
+   * @param step Target step, up to length()
+   * @return false if the journal ends before the step
+   **/
+  bool seek(uint64_t step);
+
+  /**
+   * @brief Plays one FSM step.
+   * @return false at the end of the journal
+   **/
+  bool step();
+
+  uint64_t position() const { return step_; }  ///< Steps played
+  uint64_t length() const { return reader_->steps(); }
+
+  /**
+   * @brief Snapshot of the game at the current position.
+   **/
+  void snapshot(std::vector<uint8_t>& state) { game_.saveState(state); }
+
+ private:
+  ReplayPlayer() = default;
+  bool restart(const uint8_t* state, size_t size, uint64_t step);
+
+  JournalReader* reader_{nullptr};
+  Game game_{false};
+  uint64_t step_{0};
+  uint64_t quiet_{0};     ///< Quiet steps left before the pending record
+  bool pending_{false};  ///< record_ is still to be played
+  JournalRecord record_{};
+};
+
+}  // namespace s21
+
+#endif  // SRC_SNAKE_REPLAY_H
@@ -0,0 +1,137 @@
+/**
+ * @file s21_rewind.cpp
+ * @brief In-memory rewind buffer source code.
+ */
+
+#include "s21_rewind.h"
+
+#include "s21_snake.h"
+
+namespace s21 {
+
+RewindBuffer::RewindBuffer(size_t budget) : budget_(budget) {}
+
+void RewindBuffer::step(uint8_t flags) {
+  ++step_;
+  bool record = !empty_ && (flags & (JOURNAL_INPUT | JOURNAL_TICK)) != 0;
+  uint64_t delta = step_ - entryStep_;
+  if (record) {
+    entryStep_ = step_;
+  }
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (record) {
+    std::vector<uint8_t>& records = segments_.back().records;
+    size_t size = records.size();
+    do {
+      uint8_t byte = delta & 0x7f;
+      delta >>= 7;
+      records.push_back(delta != 0 ? byte | 0x80 : byte);
+    } while (delta != 0);
+    records.push_back(flags);
+    used_ += records.size() - size;
+    trim();
+  }
+  last_ = step_;
+}
+
+void RewindBuffer::keyframe(const std::vector<uint8_t>& state) {
+  entryStep_ = step_;
+  keyframeStep_ = step_;
+  empty_ = false;
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  /* Buffers of the dropped segment are reused, so the tick does not
+     allocate once the window is full */
+  Segment segment = std::move(spare_);
+  segment.step = step_;
+  segment.state.assign(state.begin(), state.end());
+  segment.records.clear();
+  used_ += segment.state.size();
+  segments_.push_back(std::move(segment));
+  last_ = step_;
+  trim();
+}
+
+void RewindBuffer::trim() {
+  while (used_ > budget_ && segments_.size() > 1) {
+    Segment& front = segments_.front();
+    used_ -= front.state.size() + front.records.size();
+    spare_ = std::move(front);
+    segments_.pop_front();
+  }
+}
+
+bool RewindBuffer::window(uint64_t* first, uint64_t* last) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (segments_.empty()) {
+    return false;
+  }
+  *first = segments_.front().step;
+  *last = last_;
+  return true;
+}
+
+size_t RewindBuffer::used() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return used_;
+}
+
+bool RewindBuffer::rebuild(uint64_t step, std::vector<uint8_t>& state) {
+  /* Only the segment holding the step is copied, the game thread keeps
+     appending meanwhile */
+  uint64_t current = 0;
+  std::vector<uint8_t> records;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (segments_.empty() || step < segments_.front().step || step > last_) {
+      return false;
+    }
+    auto segment = segments_.end();
+    do {
+      --segment;
+    } while (segment->step > step);
+    current = segment->step;
+    state = segment->state;
+    records = segment->records;
+  }
+
+  Game game(false);
+  if (!game.loadState(state)) {
+    return false;
+  }
+  /* Headless game has no threads, so steps run without gameMutex_ */
+  size_t position = 0;
+  while (current < step) {
+    uint64_t delta = 0;
+    uint8_t flags = 0;
+    for (int shift = 0; position < records.size(); shift += 7) {
+      uint8_t byte = records[position++];
+      delta |= (uint64_t)(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        flags = records[position++];
+        break;
+      }
+    }
+    if (delta == 0 || current + delta > step) {
+      /* Only quiet steps are left before the target */
+      for (; current < step; ++current) {
+        game.step(false);
+      }
+      break;
+    }
+    for (uint64_t i = 1; i < delta; ++i) {
+      game.step(false);
+    }
+    if ((flags & JOURNAL_INPUT) != 0) {
+      UserAction_t action = (UserAction_t)(flags & JOURNAL_ACTION_MASK);
+      game.processUserInput(action, flags & JOURNAL_HOLD);
+    }
+    game.step(flags & JOURNAL_TICK);
+    current += delta;
+  }
+  game.saveState(state);
+  return true;
+}
+
+}  // namespace s21
@@ -0,0 +1,101 @@
+/**
+ * @file s21_rewind.h
+ * @brief In-memory rewind buffer header file.
+ *
+ * The buffer keeps the most recent FSM steps of a session as segments: a
+ * full snapshot followed by journal-style records (varint step delta,
+ * u8 flags, see s21_journal.h) of the steps that delivered an input or
+ * used a timer tick. A new segment starts every REWIND_KEYFRAME_INTERVAL
+ * steps, the oldest segments are dropped to stay within the budget, so
+ * the window always starts at a snapshot.
+ */
+#ifndef SRC_SNAKE_REWIND_H
+#define SRC_SNAKE_REWIND_H
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace s21 {
+
+#define REWIND_KEYFRAME_INTERVAL 256  ///< Steps between snapshots
+#define REWIND_DEFAULT_BUDGET 16384
+
+/**
+ * @brief Bounded window of the last steps of a session.
+ */
+class RewindBuffer {
+ public:
+  /**
+   * @param budget Memory budget in bytes (snapshots and records). The
+   * current segment is kept even if it alone exceeds the budget.
+   **/
+  explicit RewindBuffer(size_t budget);
+
+  RewindBuffer(const RewindBuffer& other) = delete;
+  RewindBuffer& operator=(const RewindBuffer& other) = delete;
+
+  /**
+   * @brief Accounts one FSM step (game thread).
+   * @param flags JOURNAL_* bits of the step
+   **/
+  void step(uint8_t flags);
+
+  /**
+   * @brief Checks whether the game thread should start a new segment.
+   **/
+  bool keyframeDue() const {
+    return step_ - keyframeStep_ >= REWIND_KEYFRAME_INTERVAL || empty_;
+  }
+
+  /**
+   * @brief Starts a new segment (game thread).
+   * @param state Snapshot of the game after the last accounted step
+   **/
+  void keyframe(const std::vector<uint8_t>& state);
+
+  /**
+   * @brief Steps the buffer can rebuild.
+   * @param first Oldest step in the window
+   * @param last Latest accounted step
+   * @return false if the buffer is empty
+   **/
+  bool window(uint64_t* first, uint64_t* last);
+
+  /**
+   * @brief Rebuilds the game at a step of the window on a headless game.
+   * @param step Step between first and last
+   * @param state Output snapshot
+   * @return false if the step is outside of the window
+   **/
+  bool rebuild(uint64_t step, std::vector<uint8_t>& state);
+
+  size_t used();  ///< Bytes held by the window
+
+ private:
+  struct Segment {
+    uint64_t step;  ///< Steps accounted before the snapshot
+    std::vector<uint8_t> state;
+    std::vector<uint8_t> records;
+  };
+
+  void trim();
+
+  /* Game thread only */
+  uint64_t step_{0};          ///< Steps accounted so far
+  uint64_t entryStep_{0};     ///< Step of the last record or snapshot
+  uint64_t keyframeStep_{0};  ///< Step of the last snapshot
+  bool empty_{true};
+
+  std::mutex mutex_;
+  std::deque<Segment> segments_;
+  Segment spare_;  ///< Dropped segment, its buffers are reused
+  size_t budget_;
+  size_t used_{0};
+  uint64_t last_{0};  ///< Latest step visible to readers
+};
+
+}  // namespace s21
+
+#endif  // SRC_SNAKE_REWIND_H
@@ -0,0 +1,186 @@
+/**
+ * @file s21_score_writer.cpp
+ * @brief Background high score writer source code.
+ */
+
+#include "s21_score_writer.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <set>
+#include <vector>
+
+namespace s21 {
+
+namespace {
+
+/* Score in the file, 0 if there is none */
+int readScore(const std::string& path) {
+  FILE* file = std::fopen(path.c_str(), "r");
+  int score = 0;
+  if (file != nullptr) {
+    if (std::fscanf(file, "%d", &score) != 1) {
+      score = 0;
+    }
+    std::fclose(file);
+  }
+  return score;
+}
+
+bool renameScore(const std::string& path, int score) {
+  std::string temporary = path + ".tmp." + std::to_string(getpid());
+  FILE* file = std::fopen(temporary.c_str(), "w");
+  if (file == nullptr) {
+    return false;
+  }
+  bool written = std::fprintf(file, "%d", score) > 0 &&
+                 std::fflush(file) == 0 && fsync(fileno(file)) == 0;
+  written = std::fclose(file) == 0 && written;
+  written = written && std::rename(temporary.c_str(), path.c_str()) == 0;
+  if (!written) {
+    std::remove(temporary.c_str());
+  }
+  return written;
+}
+
+/**
+ * @brief Replaces the file with the better of the score and the one on
+ * disk. Other processes write the file too, so the read and the rename
+ * are made under a lock file next to it.
+ * @param stored Output, score the file holds afterwards
+ * @return false if the file could not be written
+ **/
+bool replaceScore(const std::string& path, int score, int& stored) {
+  int lock = open((path + ".lock").c_str(), O_CREAT | O_RDWR | O_CLOEXEC,
+                  0644);
+  if (lock < 0) {
+    return false;
+  }
+  bool written = false;
+  if (flock(lock, LOCK_EX) == 0) {
+    stored = readScore(path);
+    written = stored >= score || renameScore(path, score);
+    if (written) {
+      stored = std::max(stored, score);
+    }
+  }
+  close(lock);  // Releases the lock
+  return written;
+}
+
+}  // namespace
+
+ScoreWriter& ScoreWriter::Instance() {
+  static ScoreWriter writer;
+  return writer;
+}
+
+ScoreWriter::ScoreWriter() : thread_(&ScoreWriter::run, this) {}
+
+ScoreWriter::~ScoreWriter() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+}
+
+ScoreWriter::Entry& ScoreWriter::entry(const std::string& path) {
+  Entry& entry = entries_[path];
+  if (!entry.loaded) {
+    /* Called with mutex_ held, only the first access reads the file */
+    int score = readScore(path);
+    entry.written = score;
+    entry.score = std::max(entry.score, score);
+    entry.loaded = true;
+  }
+  return entry;
+}
+
+void ScoreWriter::submit(const std::string& path, int score) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  Entry& entry = entries_[path];
+  if (score > entry.score) {
+    entry.score = score;
+    pending_ = true;
+    cv_.notify_all();
+  }
+}
+
+int ScoreWriter::load(const std::string& path) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return entry(path).score;
+}
+
+void ScoreWriter::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  int delayMs = SCORE_WRITER_BATCH_MS;
+  while (!stop_) {
+    cv_.wait(lock, [this] { return stop_ || pending_; });
+    /* Let a burst of points land in the same batch, and back off while
+     * the disk keeps failing */
+    cv_.wait_for(lock, std::chrono::milliseconds(delayMs),
+                 [this] { return stop_; });
+    delayMs = writeBatch(lock)
+                  ? SCORE_WRITER_BATCH_MS
+                  : std::min(delayMs * 2, SCORE_WRITER_RETRY_MAX_MS);
+  }
+  writeBatch(lock);
+}
+
+bool ScoreWriter::writeBatch(std::unique_lock<std::mutex>& lock) {
+  pending_ = false;
+  std::vector<std::pair<std::string, int>> batch;
+  for (auto& item : entries_) {
+    Entry& entry = this->entry(item.first);
+    if (entry.score > entry.written) {
+      batch.emplace_back(item.first, entry.score);
+    }
+  }
+  if (batch.empty()) {
+    return true;
+  }
+
+  /* Disk is touched without the mutex, game threads keep submitting */
+  lock.unlock();
+  std::set<std::string> directories;
+  std::vector<std::pair<std::string, int>> done;
+  for (const auto& item : batch) {
+    int stored = 0;
+    if (replaceScore(item.first, item.second, stored)) {
+      done.emplace_back(item.first, stored);
+      size_t slash = item.first.rfind('/');
+      directories.insert(slash == std::string::npos
+                             ? std::string(".")
+                             : item.first.substr(0, slash + 1));
+    }
+  }
+  for (const std::string& directory : directories) {
+    int fd = open(directory.c_str(), O_RDONLY);
+    if (fd >= 0) {
+      fsync(fd);
+      close(fd);
+    }
+  }
+  lock.lock();
+  /* Another process may have stored a better score */
+  for (const auto& item : done) {
+    Entry& entry = entries_[item.first];
+    entry.written = std::max(entry.written, item.second);
+    entry.score = std::max(entry.score, item.second);
+  }
+  /* Failed files keep the batch pending, so they are retried */
+  if (done.size() != batch.size()) {
+    pending_ = true;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace s21
@@ -0,0 +1,76 @@
+/**
+ * @file s21_score_writer.h
+ * @brief Background high score writer header file.
+ */
+#ifndef SRC_SNAKE_SCORE_WRITER_H
+#define SRC_SNAKE_SCORE_WRITER_H
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace s21 {
+
+#define SCORE_WRITER_BATCH_MS 100  ///< Updates coalesced into one write
+#define SCORE_WRITER_RETRY_MAX_MS 6400  ///< Longest back-off after a failure
+
+/**
+ * @brief Background thread persisting high scores.
+ *
+ * Game threads only record the score, the writer thread coalesces all
+ * updates of a batch and replaces every changed file atomically: the
+ * score goes into a temporary file, which is fsync'ed and renamed over
+ * the old one, then the directories are fsync'ed once per batch. Scores
+ * of a file never go down: the file is re-read under a lock file
+ * (<path>.lock) and the better score is kept, so sessions and processes
+ * racing on the same file keep the best one. A failed write is retried,
+ * backing off up to SCORE_WRITER_RETRY_MAX_MS.
+ */
+class ScoreWriter {
+ public:
+  static ScoreWriter& Instance();
+
+  /**
+   * @brief Schedules a score to be written (never blocks on disk).
+   * @param path Score file
+   * @param score New high score
+   **/
+  void submit(const std::string& path, int score);
+
+  /**
+   * @brief Reads the high score, including updates not written yet.
+   * @param path Score file
+   * @return Best known score, 0 if there is none
+   **/
+  int load(const std::string& path);
+
+ private:
+  struct Entry {
+    int score{0};        ///< Best known score
+    int written{0};      ///< Score on disk
+    bool loaded{false};  ///< File was read
+  };
+
+  ScoreWriter();
+  ~ScoreWriter();
+  void run();
+  /**
+   * @brief Writes every changed file (writer thread only).
+   * @return false if a file is left to retry
+   **/
+  bool writeBatch(std::unique_lock<std::mutex>& lock);
+  Entry& entry(const std::string& path);
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::map<std::string, Entry> entries_;
+  bool pending_{false};
+  bool stop_{false};
+  std::thread thread_;
+};
+
+}  // namespace s21
+
+#endif  // SRC_SNAKE_SCORE_WRITER_H
@@ -5,13 +5,22 @@
 
 #include "s21_snake.h"
 
+#include <algorithm>
+
 namespace s21 {
 
+static_assert(Game::fieldYSize <= FRAME_RING_ROWS &&
+                  Game::fieldXSize <= FRAME_RING_COLS,
+              "Game field must fit into a frame");
+static_assert(Game::fieldYSize <= 32 && Game::fieldXSize <= 16,
+              "Snapshot body encoding must hold the field coordinates");
+static_assert(Game::fieldXSize <= 32, "Occupancy rows are 32-bit words");
+
 /* -------------------------------------------------------------------------- */
 /*                         Game Class Implementation                          */
 /* -------------------------------------------------------------------------- */
 
-Game::Game() {
+Game::Game(bool startThreads) {
   gameInfo_.field = nullptr;
   gameInfo_.next = nullptr;
   gameInfo_.score = 0;
@@ -24,31 +33,34 @@ Game::Game() {
   gameTimer_ = 0.0f;
 
   snake_ = new Snake(this);
+  snake_->reset();
   food_ = new Food();
   food_->setAssociatedGame(this);
 
-  std::ifstream file("snake_score");
-  if (file.eof()) {
-    gameInfo_.high_score = 0;
-  } else {
-    file >> gameInfo_.high_score;
-  }
-  file.close();
-
   holdFlag_ = false;
   actionUsedFlag_ = false;
   userAction_ = Action;
+  seedRandom(std::chrono::steady_clock::now().time_since_epoch().count() ^
+             (uintptr_t)this);
+
+  if (startThreads) {
+    gameInfo_.high_score = ScoreWriter::Instance().load(scoreFile);
 
-  timerThread_ = new std::thread(&Game::processTimer, this);
-  gameThread_ = new std::thread(&Game::handleGameProcessing, this);
+    timerThread_ = new std::thread(&Game::processTimer, this);
+    gameThread_ = new std::thread(&Game::handleGameProcessing, this);
+  }
 }
 
 Game::~Game() {
-  currentGameStatus_ = EXIT;
-  if (timerThread_->joinable()) {
+  {
+    std::lock_guard<std::mutex> guard(parkMutex_);
+    currentGameStatus_ = EXIT;
+  }
+  parkCv_.notify_all();
+  if (timerThread_ != nullptr && timerThread_->joinable()) {
     timerThread_->join();
   }
-  if (gameThread_->joinable()) {
+  if (gameThread_ != nullptr && gameThread_->joinable()) {
     gameThread_->join();
   }
   delete timerThread_;
@@ -62,10 +74,15 @@ void Game::processUserInput(UserAction_t& action, bool hold) {
   userAction_ = action;
   holdFlag_ = hold;
   actionUsedFlag_ = false;
+  ++inputCount_;
+}
+
+bool Game::isSettled() {
+  std::lock_guard<std::mutex> guard(gameMutex_);
+  return settledInputCount_ == inputCount_;
 }
 
 void Game::gameStart() {
-  srand(time(nullptr));
   gameInfo_.score = 0;
   gameInfo_.level = 1;
   gameInfo_.speed = 1;
@@ -78,9 +95,10 @@ void Game::scoreHandler() {
   gameInfo_.score += 1;
   if (gameInfo_.score > gameInfo_.high_score) {
     gameInfo_.high_score = gameInfo_.score;
-    std::ofstream file("snake_score");
-    file << gameInfo_.score;
-    file.close();
+    /* Headless games (replays) must not touch the score file */
+    if (gameThread_ != nullptr) {
+      ScoreWriter::Instance().submit(scoreFile, gameInfo_.score);
+    }
   }
   if (gameInfo_.score % 5 == 0 && gameInfo_.level < 10) {
     gameInfo_.level += 1;
@@ -101,63 +119,169 @@ int** Game::renderField() {
   if (currentGameStatus_ != START && currentGameStatus_ != SPAWN) {
     field[food_->rowCoord_][food_->colCoord_] = FOOD;
 
-    auto bodyIterator = ++snake_->snakeBody_.begin();
-    for (auto elem : snake_->snakeBody_) {
-      int row = elem->getRowCoord();
-      int col = elem->getColCoord();
-      if (row >= 0 && row < fieldYSize && col >= 0 && col < fieldXSize) {
-        switch (elem->getElemDirection()) {
-          case Snake::up:
-            if (elem->isHead()) {
-              field[row][col] = SNAKE_HEAD_UP;
-            } else if (elem == snake_->snakeBody_.back()) {
-              field[row][col] = SNAKE_TAIL_UP;
-            } else {
-              field[row][col] = SNAKE_UP;
-            }
-            break;
-          case Snake::down:
-            if (elem->isHead()) {
-              field[row][col] = SNAKE_HEAD_DOWN;
-            } else if (elem == snake_->snakeBody_.back()) {
-              field[row][col] = SNAKE_TAIL_DOWN;
-            } else {
-              field[row][col] = SNAKE_DOWN;
-            }
-            break;
-          case Snake::left:
-            if (elem->isHead()) {
-              field[row][col] = SNAKE_HEAD_LEFT;
-            } else if (elem == snake_->snakeBody_.back()) {
-              field[row][col] = SNAKE_TAIL_LEFT;
-            } else {
-              field[row][col] = SNAKE_LEFT;
-            }
-            break;
-          case Snake::right:
-            if (elem->isHead()) {
-              field[row][col] = SNAKE_HEAD_RIGHT;
-            } else if (elem == snake_->snakeBody_.back()) {
-              field[row][col] = SNAKE_TAIL_RIGHT;
-            } else {
-              field[row][col] = SNAKE_RIGHT;
-            }
-            break;
-        }
-
-        if (bodyIterator != snake_->snakeBody_.end() &&
-            (*bodyIterator)->getElemDirection() != elem->getElemDirection()) {
-          field[row][col] = snake_->bodyRotationType(elem, (*bodyIterator));
-        }
+    for (size_t i = 0; i < snake_->snakeBody_.size(); ++i) {
+      int row = snake_->snakeBody_[i]->getRowCoord();
+      int col = snake_->snakeBody_[i]->getColCoord();
+      if (Board::contains(row, col)) {
+        field[row][col] = elementCode(i);
       }
-      ++bodyIterator;
     }
   }
   return field;
 }
 
+void Game::occupancy(uint32_t* rows) {
+  std::fill(rows, rows + fieldYSize, 0u);
+  for (SnakeElement* elem : snake_->snakeBody_) {
+    if (Board::contains(elem->rowCoord_, elem->colCoord_)) {
+      rows[elem->rowCoord_] |= 1u << elem->colCoord_;
+    }
+  }
+}
+
+void Game::renderCells(uint8_t* cells) {
+  std::fill(cells, cells + Board::cells(), (uint8_t)BLANK);
+  if (currentGameStatus_ == START || currentGameStatus_ == SPAWN) {
+    return;
+  }
+  cells[Board::index(food_->rowCoord_, food_->colCoord_)] = FOOD;
+  for (size_t i = 0; i < snake_->snakeBody_.size(); ++i) {
+    int row = snake_->snakeBody_[i]->rowCoord_;
+    int col = snake_->snakeBody_[i]->colCoord_;
+    if (Board::contains(row, col)) {
+      cells[Board::index(row, col)] = elementCode(i);
+    }
+  }
+}
+
+int Game::elementCode(size_t index) {
+  std::vector<SnakeElement*>& body = snake_->snakeBody_;
+  return Snake::segmentCode(
+      body[index], index + 1 < body.size() ? body[index + 1] : nullptr);
+}
+
+void Game::setFrameRing(FrameRing* frameRing) {
+  std::lock_guard<std::mutex> guard(gameMutex_);
+  frameRing_ = frameRing;
+  lastFrame_.status = -1;
+}
+
+void Game::publishFrame() {
+  Frame frame{};
+  frame.status = currentGameStatus_;
+  frame.score = gameInfo_.score;
+  frame.highScore = gameInfo_.high_score;
+  frame.level = gameInfo_.level;
+  frame.speed = gameInfo_.speed;
+  frame.pause = gameInfo_.pause;
+  frame.rows = fieldYSize;
+  frame.cols = fieldXSize;
+
+  if (currentGameStatus_ != START && currentGameStatus_ != SPAWN) {
+    frame.field[food_->rowCoord_][food_->colCoord_] = FOOD;
+    for (size_t i = 0; i < snake_->snakeBody_.size(); ++i) {
+      int row = snake_->snakeBody_[i]->getRowCoord();
+      int col = snake_->snakeBody_[i]->getColCoord();
+      if (Board::contains(row, col)) {
+        frame.field[row][col] = elementCode(i);
+      }
+    }
+  }
+
+  /* Readers only care about changes, so identical frames are not exported */
+  frame.generation = lastFrame_.generation;
+  if (std::memcmp(&frame, &lastFrame_, sizeof(Frame)) != 0) {
+    frameRing_->publish(frame);
+    lastFrame_ = frame;
+  }
+}
+
+bool Game::suspend() {
+  if (gameThread_ == nullptr) {
+    return true;
+  }
+  std::unique_lock<std::mutex> lock(parkMutex_);
+  parkRequested_ = true;
+  parkCv_.notify_all();
+  parkCv_.wait(lock, [this] {
+    return parkedThreads_ == threadCount || currentGameStatus_ == EXIT;
+  });
+  return currentGameStatus_ != EXIT;
+}
+
+void Game::resume() {
+  {
+    std::lock_guard<std::mutex> guard(parkMutex_);
+    parkRequested_ = false;
+  }
+  parkCv_.notify_all();
+}
+
+bool Game::park(std::vector<uint8_t>* state) {
+  if (!suspend()) {
+    return false;
+  }
+  /* Both threads are blocked in waitWhileParked(), nothing races with us */
+  if (state != nullptr) {
+    saveState(*state);
+  }
+  resetSession();
+  return true;
+}
+
+void Game::unpark(int highScore) {
+  if (highScore > gameInfo_.high_score) {
+    gameInfo_.high_score = highScore;
+  }
+  resume();
+}
+
+void Game::resetSession() {
+  gameInfo_.score = 0;
+  gameInfo_.level = 1;
+  gameInfo_.speed = 1;
+  gameInfo_.pause = 0;
+
+  currentGameStatus_ = START;
+  gameTimer_ = 0.0f;
+  holdFlag_ = false;
+  actionUsedFlag_ = false;
+  userAction_ = Action;
+  rotateFlag_ = true;
+
+  snake_->reset();
+  food_->reset();
+  frameRing_ = nullptr;
+  lastFrame_ = Frame{};
+  journal_ = nullptr;
+  rewind_ = nullptr;
+  leaderboard_ = nullptr;
+  seedRandom(std::chrono::steady_clock::now().time_since_epoch().count() ^
+             (uintptr_t)this);
+}
+
+void Game::waitWhileParked() {
+  std::unique_lock<std::mutex> lock(parkMutex_);
+  if (parkRequested_) {
+    ++parkedThreads_;
+    parkCv_.notify_all();
+    parkCv_.wait(lock, [this] {
+      return !parkRequested_ || currentGameStatus_ == EXIT;
+    });
+    --parkedThreads_;
+  }
+}
+
+void Game::sleepFor(std::chrono::microseconds period) {
+  std::unique_lock<std::mutex> lock(parkMutex_);
+  parkCv_.wait_for(lock, period, [this] {
+    return parkRequested_ || currentGameStatus_ == EXIT;
+  });
+}
+
 void Game::processTimer() {
   while (currentGameStatus_ != EXIT) {
+    waitWhileParked();
     {
       std::lock_guard<std::mutex> guard(timerMutex_);
       if (holdFlag_) {
@@ -170,126 +294,360 @@ void Game::processTimer() {
         }
       }
     }
-    std::this_thread::sleep_for(std::chrono::microseconds((int)(5 * 10e3)));
+    sleepFor(std::chrono::microseconds((int)(5 * 10e3)));
+  }
+}
+
+void Game::saveState(std::vector<uint8_t>& state) {
+  std::vector<SnakeElement*>& body = snake_->snakeBody_;
+  state.clear();
+  state.reserve(snapshotHeaderSize + body.size() * sizeof(uint16_t));
+
+  SnapshotWriter writer(state);
+  writer.u32(SNAPSHOT_MAGIC);
+  writer.u16(SNAPSHOT_VERSION);
+  writer.u8(SNAPSHOT_ENGINE_SNAKE);
+  writer.u8(0);
+
+  writer.u8(currentGameStatus_);
+  writer.u8(userAction_);
+  writer.u8((gameInfo_.pause ? 1 : 0) | (rotateFlag_ ? 2 : 0) |
+            (actionUsedFlag_ ? 4 : 0));
+  writer.u8(snake_->snakeDirection_);
+  writer.u32(gameInfo_.score);
+  writer.u32(gameInfo_.high_score);
+  writer.u8(gameInfo_.level);
+  writer.u8(gameInfo_.speed);
+  writer.u8(food_->rowCoord_);
+  writer.u8(food_->colCoord_);
+  writer.f32(gameTimer_);
+  writer.u64(rngState_);
+
+  /* Body element: row in bits 6..10, col in bits 2..5, direction in 0..1 */
+  writer.u16(body.size());
+  for (SnakeElement* elem : body) {
+    writer.u16((elem->rowCoord_ & 0x1f) << 6 | (elem->colCoord_ & 0xf) << 2 |
+               elem->elemDirection_);
+  }
+}
+
+bool Game::loadState(const std::vector<uint8_t>& state) {
+  SnapshotReader reader(state.data(), state.size());
+  if (reader.u32() != SNAPSHOT_MAGIC || reader.u16() != SNAPSHOT_VERSION ||
+      reader.u8() != SNAPSHOT_ENGINE_SNAKE) {
+    return false;
+  }
+  reader.u8();
+
+  int status = reader.u8();
+  int action = reader.u8();
+  int flags = reader.u8();
+  int direction = reader.u8();
+  int score = (int32_t)reader.u32();
+  int highScore = (int32_t)reader.u32();
+  int level = reader.u8();
+  int speed = reader.u8();
+  int foodRow = reader.u8();
+  int foodCol = reader.u8();
+  float timer = reader.f32();
+  uint64_t rngState = reader.u64();
+  size_t bodyLength = reader.u16();
+  if (!reader.ok() || status > PAUSE || action > Action || direction > 3 ||
+      foodRow >= fieldYSize || foodCol >= fieldXSize || bodyLength == 0 ||
+      bodyLength > (size_t)fieldXSize * fieldYSize ||
+      reader.remaining() != bodyLength * sizeof(uint16_t)) {
+    return false;
+  }
+
+  /* Cells are used as indices by the renderers, so they are checked here.
+   * A crash leaves the head on the cell it came from, so only a live snake
+   * never repeats a cell */
+  bool alive = status == MOVING || status == SHIFTING ||
+               status == ATTACHING || status == PAUSE;
+  std::vector<uint16_t> packedBody(bodyLength);
+  std::vector<bool> occupied(Board::cells());
+  for (uint16_t& packed : packedBody) {
+    packed = reader.u16();
+    int row = packed >> 6 & 0x1f;
+    int col = packed >> 2 & 0xf;
+    if (!Board::contains(row, col) ||
+        (occupied[Board::index(row, col)] && alive)) {
+      return false;
+    }
+    occupied[Board::index(row, col)] = true;
   }
+
+  std::vector<SnakeElement*>& body = snake_->snakeBody_;
+  for (auto elem : body) {
+    delete elem;
+  }
+  body.clear();
+  body.reserve(bodyLength);
+  for (uint16_t packed : packedBody) {
+    body.push_back(new SnakeElement(packed >> 6 & 0x1f, packed >> 2 & 0xf,
+                                    (Snake::direction)(packed & 0x3)));
+  }
+  body[0]->isHead_ = true;
+  snake_->snakeDirection_ = (Snake::direction)direction;
+
+  food_->rowCoord_ = foodRow;
+  food_->colCoord_ = foodCol;
+  gameInfo_.score = score;
+  gameInfo_.high_score = highScore;
+  gameInfo_.level = level;
+  gameInfo_.speed = speed;
+  gameInfo_.pause = flags & 1;
+  rotateFlag_ = flags & 2;
+  actionUsedFlag_ = flags & 4;
+  userAction_ = (UserAction_t)action;
+  holdFlag_ = false;
+  gameTimer_ = timer;
+  rngState_ = rngState != 0 ? rngState : 1;
+  currentGameStatus_ = (GameStatus_t)status;
+  return true;
+}
+
+GameStatus_t Game::savedStatus(const std::vector<uint8_t>& state) {
+  SnapshotReader reader(state.data(), state.size());
+  if (reader.u32() != SNAPSHOT_MAGIC || reader.u16() != SNAPSHOT_VERSION ||
+      reader.u8() != SNAPSHOT_ENGINE_SNAKE) {
+    return EXIT;
+  }
+  reader.u8();
+  int status = reader.u8();
+  return reader.ok() && status <= PAUSE ? (GameStatus_t)status : EXIT;
+}
+
+bool Game::snapshot(std::vector<uint8_t>& state) {
+  if (!suspend()) {
+    return false;
+  }
+  saveState(state);
+  resume();
+  return true;
+}
+
+bool Game::restore(const std::vector<uint8_t>& state) {
+  if (!suspend()) {
+    return false;
+  }
+  bool result = loadState(state);
+  lastFrame_.status = -1;
+  resume();
+  return result;
+}
+
+void Game::seedRandom(uint64_t seed) { rngState_ = seed != 0 ? seed : 1; }
+
+uint32_t Game::nextRandom() {
+  return nextXorshift64Star(rngState_);
 }
 
 GameStatus_t Game::getStatus() { return currentGameStatus_; }
 
-void Game::handleGameProcessing() {
-  static bool rotateFlag = true;
+int Game::getHighScore() { return gameInfo_.high_score; }
 
+void Game::handleGameProcessing() {
   while (currentGameStatus_ != EXIT) {
-    switch (currentGameStatus_) {
-      case START: {
-        std::lock_guard<std::mutex> guard(gameMutex_);
-        if (userAction_ == Start) {
-          currentGameStatus_ = SPAWN;
-          actionUsedFlag_ = true;
-        } else if (userAction_ == Terminate) {
-          currentGameStatus_ = EXIT;
-          actionUsedFlag_ = true;
-        }
-      } break;
-      case SPAWN:
-        gameStart();
-        currentGameStatus_ = MOVING;
-        break;
-      case MOVING: {
-        {
-          std::lock_guard<std::mutex> guard(gameMutex_);
-          switch (userAction_) {
-            case Left:
-              snake_->moveLeft(rotateFlag);
-              actionUsedFlag_ = true;
-              break;
-            case Right:
-              snake_->moveRight(rotateFlag);
-              actionUsedFlag_ = true;
-              break;
-            case Up:
-              snake_->moveUp(rotateFlag);
-              actionUsedFlag_ = true;
-              break;
-            case Down:
-              snake_->moveDown(rotateFlag);
-              actionUsedFlag_ = true;
-              break;
-            case Terminate:
-              currentGameStatus_ = EXIT;
-              actionUsedFlag_ = true;
-              break;
-            case Pause:
-              pauseGame();
-              currentGameStatus_ = PAUSE;
-              actionUsedFlag_ = true;
-              break;
-            default:
-              break;
+    waitWhileParked();
+    bool tickDue = false;
+    {
+      std::lock_guard<std::mutex> guard(timerMutex_);
+      tickDue = gameTimer_ > 1.5;
+    }
+
+    {
+      std::lock_guard<std::mutex> guard(gameMutex_);
+      unsigned seenInputCount = inputCount_;
+      uint8_t input =
+          JOURNAL_INPUT | userAction_ | (holdFlag_ ? JOURNAL_HOLD : 0);
+      uint8_t tick = step(tickDue) ? JOURNAL_TICK : 0;
+      settledInputCount_ = seenInputCount;
+      if (journal_ != nullptr) {
+        journal_->step((seenInputCount != journaledInputCount_ ? input : 0) |
+                       tick);
+        journaledInputCount_ = seenInputCount;
+        if (journal_->keyframeDue()) {
+          std::vector<uint8_t> state;
+          {
+            std::lock_guard<std::mutex> timerGuard(timerMutex_);
+            saveState(state);
           }
+          journal_->keyframe(state);
         }
-        __attribute__((fallthrough));
       }
-
-      case SHIFTING: {
-        std::lock_guard<std::mutex> guard(timerMutex_);
-        if (gameTimer_ > 1.5 && gameInfo_.pause != 1) {
-          rotateFlag = true;
-          if (!snake_->moveForward()) {
-            currentGameStatus_ = GAMEOVER;
-          } else if (snake_->attachFood()) {
-            currentGameStatus_ = ATTACHING;
-          } else {
-            currentGameStatus_ = MOVING;
+      if (rewind_ != nullptr) {
+        rewind_->step((seenInputCount != rewoundInputCount_ ? input : 0) |
+                      tick);
+        rewoundInputCount_ = seenInputCount;
+        if (rewind_->keyframeDue()) {
+          {
+            std::lock_guard<std::mutex> timerGuard(timerMutex_);
+            saveState(rewindState_);
           }
-          gameTimer_ = 0;
+          rewind_->keyframe(rewindState_);
         }
-      } break;
+      }
+      if (frameRing_ != nullptr) {
+        publishFrame();
+      }
+    }
 
-      case ATTACHING:
-        scoreHandler();
-        food_->spawnFood();
-        if (gameInfo_.score == 200) {
+    sleepFor(std::chrono::microseconds((int)(20 * 10e3)));
+  }
+}
+
+bool Game::step(bool tickDue) {
+  bool tickUsed = false;
+  switch (currentGameStatus_) {
+    case START:
+      if (userAction_ == Start) {
+        currentGameStatus_ = SPAWN;
+        actionUsedFlag_ = true;
+      } else if (userAction_ == Terminate) {
+        currentGameStatus_ = EXIT;
+        actionUsedFlag_ = true;
+      }
+      break;
+    case SPAWN:
+      gameStart();
+      currentGameStatus_ = MOVING;
+      break;
+    case MOVING:
+      switch (userAction_) {
+        case Left:
+          snake_->moveLeft(rotateFlag_);
+          actionUsedFlag_ = true;
+          break;
+        case Right:
+          snake_->moveRight(rotateFlag_);
+          actionUsedFlag_ = true;
+          break;
+        case Up:
+          snake_->moveUp(rotateFlag_);
+          actionUsedFlag_ = true;
+          break;
+        case Down:
+          snake_->moveDown(rotateFlag_);
+          actionUsedFlag_ = true;
+          break;
+        case Terminate:
+          currentGameStatus_ = EXIT;
+          actionUsedFlag_ = true;
+          break;
+        case Pause:
+          pauseGame();
+          currentGameStatus_ = PAUSE;
+          actionUsedFlag_ = true;
+          break;
+        default:
+          break;
+      }
+      __attribute__((fallthrough));
+
+    case SHIFTING:
+      if (tickDue && gameInfo_.pause != 1) {
+        tickUsed = true;
+        rotateFlag_ = true;
+        if (!snake_->moveForward()) {
           currentGameStatus_ = GAMEOVER;
+          postScore();
+        } else if (snake_->attachFood()) {
+          currentGameStatus_ = ATTACHING;
         } else {
           currentGameStatus_ = MOVING;
         }
-        break;
+        std::lock_guard<std::mutex> guard(timerMutex_);
+        gameTimer_ = 0;
+      }
+      break;
 
-      case GAMEOVER: {
-        if (userAction_ == Start) {
-          currentGameStatus_ = SPAWN;
-        } else if (userAction_ == Terminate) {
-          currentGameStatus_ = EXIT;
-        }
-      } break;
-
-      case PAUSE: {
-        {
-          std::lock_guard<std::mutex> guard(gameMutex_);
-          if (userAction_ == Pause) {
-            pauseGame();
-            actionUsedFlag_ = true;
-          }
-        }
-        if (gameInfo_.pause == 0) {
-          currentGameStatus_ = MOVING;
-        }
-      } break;
+    case ATTACHING:
+      scoreHandler();
+      /* A snake filling the whole field leaves no place for food */
+      if (snake_->snakeBody_.size() < Board::cells()) {
+        food_->spawnFood();
+      }
+      if (gameInfo_.score == 200 ||
+          snake_->snakeBody_.size() >= Board::cells()) {
+        currentGameStatus_ = GAMEOVER;
+        postScore();
+      } else {
+        currentGameStatus_ = MOVING;
+      }
+      break;
 
-      case EXIT:
-        break;
-    }
+    case GAMEOVER:
+      if (userAction_ == Start) {
+        currentGameStatus_ = SPAWN;
+      } else if (userAction_ == Terminate) {
+        currentGameStatus_ = EXIT;
+      }
+      break;
 
-    {
-      std::lock_guard<std::mutex> guard(gameMutex_);
-      if (actionUsedFlag_) {
-        userAction_ = Action;
+    case PAUSE:
+      if (userAction_ == Pause) {
+        pauseGame();
+        actionUsedFlag_ = true;
       }
-      holdFlag_ = false;
-    }
+      if (gameInfo_.pause == 0) {
+        currentGameStatus_ = MOVING;
+      }
+      break;
+
+    case EXIT:
+      break;
+  }
+
+  if (actionUsedFlag_) {
+    userAction_ = Action;
+  }
+  holdFlag_ = false;
+  return tickUsed;
+}
+
+Journal* Game::startJournal(const std::string& path) {
+  std::lock_guard<std::mutex> guard(gameMutex_);
+  std::vector<uint8_t> state;
+  {
+    std::lock_guard<std::mutex> timerGuard(timerMutex_);
+    saveState(state);
+  }
+  Journal* journal =
+      Journal::open(path, SNAPSHOT_ENGINE_SNAKE, rngState_, state);
+  if (journal != nullptr) {
+    journal_ = journal;
+    journaledInputCount_ = inputCount_;
+  }
+  return journal;
+}
+
+void Game::setJournal(Journal* journal) {
+  std::lock_guard<std::mutex> guard(gameMutex_);
+  journal_ = journal;
+  journaledInputCount_ = inputCount_;
+}
+
+void Game::setRewind(RewindBuffer* rewind) {
+  std::lock_guard<std::mutex> guard(gameMutex_);
+  rewind_ = rewind;
+  rewoundInputCount_ = inputCount_;
+}
 
-    std::this_thread::sleep_for(std::chrono::microseconds((int)(20 * 10e3)));
+void Game::setLeaderboard(Leaderboard* board, const std::string& player) {
+  std::lock_guard<std::mutex> guard(gameMutex_);
+  leaderboard_ = board;
+  playerName_ = player;
+  if (board != nullptr && board->best(SNAPSHOT_ENGINE_SNAKE) >
+                              gameInfo_.high_score) {
+    gameInfo_.high_score = board->best(SNAPSHOT_ENGINE_SNAKE);
+  }
+}
+
+void Game::postScore() {
+  /* Headless games (replays) must not post */
+  if (leaderboard_ != nullptr && gameThread_ != nullptr) {
+    leaderboard_->post(SNAPSHOT_ENGINE_SNAKE, playerName_, gameInfo_.score);
   }
 }
 
@@ -349,11 +707,8 @@ bool Snake::checkCollision() {
     }
   }
 
-  if (snakeBody_[0]->getRowCoord() < 0 || snakeBody_[0]->getRowCoord() > 19 ||
-      snakeBody_[0]->getColCoord() < 0 || snakeBody_[0]->getColCoord() > 9) {
-    return true;
-  }
-  return false;
+  return !Game::Board::contains(snakeBody_[0]->getRowCoord(),
+                                snakeBody_[0]->getColCoord());
 }
 
 bool Snake::attachFood() {
@@ -419,7 +774,7 @@ void Snake::reset() {
   snakeBody_.clear();
 
   for (int i = startSize; i > 0; --i) {
-    snakeBody_.push_back(new SnakeElement(10, i, right));
+    snakeBody_.push_back(new SnakeElement(Game::fieldYSize / 2, i, right));
   }
   snakeBody_[0]->isHead_ = true;
   snakeDirection_ = right;
@@ -498,14 +853,63 @@ int Snake::bodyRotationType(SnakeElement* curElem, SnakeElement* prevElem) {
   return result;
 }
 
+int Snake::segmentCode(SnakeElement* elem, SnakeElement* next) {
+  int code = BLANK;
+
+  switch (elem->getElemDirection()) {
+    case Snake::up:
+      if (elem->isHead()) {
+        code = SNAKE_HEAD_UP;
+      } else if (next == nullptr) {
+        code = SNAKE_TAIL_UP;
+      } else {
+        code = SNAKE_UP;
+      }
+      break;
+    case Snake::down:
+      if (elem->isHead()) {
+        code = SNAKE_HEAD_DOWN;
+      } else if (next == nullptr) {
+        code = SNAKE_TAIL_DOWN;
+      } else {
+        code = SNAKE_DOWN;
+      }
+      break;
+    case Snake::left:
+      if (elem->isHead()) {
+        code = SNAKE_HEAD_LEFT;
+      } else if (next == nullptr) {
+        code = SNAKE_TAIL_LEFT;
+      } else {
+        code = SNAKE_LEFT;
+      }
+      break;
+    case Snake::right:
+      if (elem->isHead()) {
+        code = SNAKE_HEAD_RIGHT;
+      } else if (next == nullptr) {
+        code = SNAKE_TAIL_RIGHT;
+      } else {
+        code = SNAKE_RIGHT;
+      }
+      break;
+  }
+
+  if (next != nullptr &&
+      next->getElemDirection() != elem->getElemDirection()) {
+    code = bodyRotationType(elem, next);
+  }
+  return code;
+}
+
 /* -------------------------------------------------------------------------- */
 /*                       Food Class Implementation                            */
 /* -------------------------------------------------------------------------- */
 
 void Food::spawnFood() {
   do {
-    rowCoord_ = rand() % Game::fieldYSize;
-    colCoord_ = rand() % Game::fieldXSize;
+    rowCoord_ = currentGame_->nextRandom() % Game::fieldYSize;
+    colCoord_ = currentGame_->nextRandom() % Game::fieldXSize;
   } while (currentGame_->snake_->attachFood());
 }
 
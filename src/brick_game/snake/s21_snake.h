@@ -6,15 +6,25 @@
 #define SRC_SNAKE_H
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
-#include <fstream>
 #include <map>
 #include <mutex>
 #include <thread>
 #include <utility>
 #include <vector>
 
+#include "s21_board.h"
+#include "s21_frame_ring.h"
+#include "s21_journal.h"
+#include "s21_leaderboard.h"
+#include "s21_rewind.h"
+#include "s21_score_writer.h"
+#include "s21_snapshot.h"
+
 namespace s21 {
 
 class SnakeElement;
@@ -125,6 +135,7 @@ class Food {
 
  private:
   friend class Game;
+  friend class Autopilot;
   Game* currentGame_{nullptr};
   int rowCoord_{0};
   int colCoord_{0};
@@ -157,10 +168,18 @@ class Snake {
    * @param prevElem Previous element of snake body
    * @return Body rotation type (macros define these types)
    */
-  int bodyRotationType(SnakeElement* curElem, SnakeElement* prevElem);
+  static int bodyRotationType(SnakeElement* curElem, SnakeElement* prevElem);
+
+  /**
+   * @brief Field code of a body element, as drawn by GUIs.
+   * @param elem Body element
+   * @param next Element behind it, nullptr for the tail
+   */
+  static int segmentCode(SnakeElement* elem, SnakeElement* next);
 
  private:
   friend class Game;
+  friend class Autopilot;
   Game* currentGame{nullptr};
   direction snakeDirection_{right};
   std::vector<SnakeElement*> snakeBody_;
@@ -184,6 +203,10 @@ class SnakeElement {
 
  private:
   friend class Snake;
+  friend class Game;
+  friend class HugeGame;
+  friend class Arena;
+  friend class Autopilot;
   int rowCoord_{0};
   int colCoord_{0};
   Snake::direction elemDirection_{Snake::right};
@@ -195,10 +218,15 @@ class SnakeElement {
  */
 class Game {
  public:
-  static const int fieldXSize = 10;  ///< Col size of game field
-  static const int fieldYSize = 20;  ///< Row size of game field
+  using Board = ClassicBoard;                         ///< Field geometry
+  static constexpr int fieldXSize = Board::cols();  ///< Col size of field
+  static constexpr int fieldYSize = Board::rows();  ///< Row size of field
 
-  Game();
+  /**
+   * @param startThreads false creates a headless game: no timer and FSM
+   * threads, used to inspect a saved state without running it
+   **/
+  explicit Game(bool startThreads = true);
   ~Game();
 
   Game(Game& other) = delete;
@@ -207,13 +235,129 @@ class Game {
   friend GameInfo_t updateCurrentState();
 
   void processUserInput(UserAction_t& action, bool hold);
+
+  /**
+   * @brief Checks that the FSM has already seen the latest user input,
+   * so the current status reflects it.
+   **/
+  bool isSettled();
   void gameStart();
   void scoreHandler();
   void pauseGame();
   int** renderField();
   void processTimer();
 
+  /**
+   * @brief Starts (or stops, if nullptr) exporting frames into the ring.
+   * Frames are published by the game thread only when they change.
+   * @param frameRing Ring owned by the caller
+   **/
+  void setFrameRing(FrameRing* frameRing);
+
+  /**
+   * @brief Brings both game threads to a safe point, resets the game
+   * in place and keeps the threads asleep until unpark() is called.
+   * @param state If not nullptr, receives the state saved before the reset
+   * @return false if the game threads are already gone
+   **/
+  bool park(std::vector<uint8_t>* state = nullptr);
+
+  /**
+   * @brief Wakes up a parked game.
+   * @param highScore Most recent known high score
+   **/
+  void unpark(int highScore);
+
+  /**
+   * @brief Serializes the game into a snapshot (see s21_snapshot.h).
+   * Game threads must be parked (or absent) while the state is saved.
+   *
+   * Snake payload: u8 status, u8 pending action, u8 flags (pause, rotate,
+   * action used), u8 direction, i32 score, i32 high score, u8 level,
+   * u8 speed, u8 food row, u8 food col, f32 timer, u64 PRNG state,
+   * u16 body length, packed body elements (u16 each, head first).
+   * @param state Output snapshot
+   **/
+  void saveState(std::vector<uint8_t>& state);
+
+  /**
+   * @brief Restores the game from a snapshot produced by saveState().
+   * Game threads must be parked (or absent) while the state is loaded.
+   * @param state Snapshot
+   * @return false if the snapshot is malformed, the game is untouched then
+   **/
+  bool loadState(const std::vector<uint8_t>& state);
+
+  /**
+   * @brief Reads game status out of a snapshot without restoring it.
+   * @param state Snapshot
+   * @return Saved status or EXIT if the snapshot is malformed
+   **/
+  static GameStatus_t savedStatus(const std::vector<uint8_t>& state);
+
+  /**
+   * @brief Takes a snapshot of a running game at a safe point.
+   * @return false if the game threads are already gone
+   **/
+  bool snapshot(std::vector<uint8_t>& state);
+
+  /**
+   * @brief Replaces the state of a running game at a safe point.
+   * @return false if the snapshot is malformed
+   **/
+  bool restore(const std::vector<uint8_t>& state);
+
+  /**
+   * @brief Starts a replay journal from the current state of the game.
+   * @param path Journal file path
+   * @return New journal owned by the caller (release it with close()
+   * after setJournal(nullptr)), nullptr on failure
+   **/
+  Journal* startJournal(const std::string& path);
+
+  /**
+   * @brief Attaches a journal that is already started (nullptr detaches).
+   * Used to continue the journal after the session moves to another game,
+   * the game must be parked then.
+   **/
+  void setJournal(Journal* journal);
+
+  /**
+   * @brief Attaches a rewind buffer (nullptr detaches). The buffer takes
+   * its first snapshot on the next FSM step and keeps following the game.
+   * @param rewind Buffer owned by the caller
+   **/
+  void setRewind(RewindBuffer* rewind);
+
+  /**
+   * @brief Attaches a leaderboard (nullptr detaches). Final scores are
+   * posted to it and its best snake score raises the high score.
+   * @param board Store owned by the caller
+   * @param player Name the scores are posted under
+   **/
+  void setLeaderboard(Leaderboard* board, const std::string& player);
+
+  /**
+   * @brief Seeds the game PRNG (food placement).
+   * @param seed Any value, zero is replaced with one
+   **/
+  void seedRandom(uint64_t seed);
+
+  /**
+   * @brief Occupancy bitmap of the snake body: one word per field row,
+   * bit i set when column i holds a body element. Food is not included.
+   * @param rows Output, fieldYSize words
+   **/
+  void occupancy(uint32_t* rows);
+
+  /**
+   * @brief Renders the field like renderField(), one byte per cell.
+   * @param cells Output, fieldYSize * fieldXSize codes, row by row
+   **/
+  void renderCells(uint8_t* cells);
+
   GameStatus_t getStatus();
+  int getHighScore();
 
 #ifdef TESTING
   float& getTimer() { return gameTimer_; }
@@ -223,16 +367,51 @@ class Game {
  private:
   friend class Snake;
   friend class Food;
+  friend class ReplayPlayer;
+  friend class RewindBuffer;
+  friend class Autopilot;
+  friend class VecEnv;
 
   void handleGameProcessing();
 
+  /**
+   * @brief Performs one FSM step, gameMutex_ must be held by running games.
+   * Everything the step depends on besides the game state is the pending
+   * user input and tickDue, which makes the step replayable.
+   * @param tickDue Timer has reached the shift threshold
+   * @return true if the step consumed the timer tick
+   **/
+  bool step(bool tickDue);
+  void publishFrame();
+  bool suspend();
+  void resume();
+  uint32_t nextRandom();
+  void resetSession();
+  void postScore();
+  void waitWhileParked();
+  void sleepFor(std::chrono::microseconds period);
+
+  /**
+   * @brief Field code of the snake body element, as drawn by GUIs.
+   * @param index Index of the element in snake body
+   **/
+  int elementCode(size_t index);
+
   /* --- Data members --- */
   bool holdFlag_{false};
   UserAction_t userAction_{Action};
   bool actionUsedFlag_{false};
+  unsigned inputCount_{0};         ///< Inputs received so far
+  unsigned settledInputCount_{0};  ///< Inputs seen by a finished FSM step
 
   std::mutex timerMutex_;
   std::mutex gameMutex_;
+  std::mutex parkMutex_;
+  std::condition_variable parkCv_;
+  bool parkRequested_{false};
+  int parkedThreads_{0};
+  static const int threadCount = 2;
+  bool rotateFlag_{true};
   std::thread* timerThread_{nullptr};
   std::thread* gameThread_{nullptr};
 
@@ -243,6 +422,23 @@ class Game {
   Food* food_{nullptr};
 
   float gameTimer_{0.f};
+  uint64_t rngState_{1};
+
+  static const size_t snapshotHeaderSize = 38;  ///< Snapshot without body
+  static constexpr const char* scoreFile = "snake_score";
+
+  FrameRing* frameRing_{nullptr};
+  Frame lastFrame_{};
+
+  Journal* journal_{nullptr};
+  unsigned journaledInputCount_{0};  ///< Inputs already in the journal
+
+  RewindBuffer* rewind_{nullptr};
+  unsigned rewoundInputCount_{0};     ///< Inputs already in the rewind buffer
+  std::vector<uint8_t> rewindState_;  ///< Keyframe scratch, reused
+
+  Leaderboard* leaderboard_{nullptr};
+  std::string playerName_;
 };
 
 }  // namespace s21
@@ -6,11 +6,32 @@ namespace s21 {
 /*                         SnakeFacade Implementation                         */
 /* -------------------------------------------------------------------------- */
 
-SnakeFacade::SnakeFacade() { currentGame_ = nullptr; }
+SnakeFacade::SnakeFacade() {
+  currentGame_ = nullptr;
+  /* Constructed first, so the writers outlive the facade */
+  JournalFlusher::Instance();
+  ScoreWriter::Instance();
+}
 SnakeFacade::~SnakeFacade() {
+  if (monitorThread_ != nullptr) {
+    {
+      std::lock_guard<std::mutex> lock(facadeMutex_);
+      monitorStop_ = true;
+    }
+    monitorCv_.notify_all();
+    monitorThread_->join();
+    delete monitorThread_;
+  }
+  closeJournal();
+  closeRewind();
   if (currentGame_ != nullptr) {
     delete currentGame_;
   }
+  for (auto game : sessionPool_) {
+    delete game;
+  }
+  delete frameRing_;
+  delete leaderboard_;
 }
 
 SnakeFacade& SnakeFacade::Instance() {
@@ -19,14 +40,329 @@ SnakeFacade& SnakeFacade::Instance() {
 }
 
 void SnakeFacade::initializeGame() {
-  currentGame_ = new Game();
+  std::lock_guard<std::mutex> lock(facadeMutex_);
+  startMonitor();
+  hibernated_ = false;
+  std::vector<uint8_t>().swap(hibernatedState_);
+  lastActivity_ = std::chrono::steady_clock::now();
+
+  if (!sessionPool_.empty()) {
+    currentGame_ = sessionPool_.front();
+    sessionPool_.pop_front();
+    currentGame_->unpark(highScore_);
+  } else {
+    currentGame_ = new Game();
+  }
+  if (frameRing_ != nullptr) {
+    currentGame_->setFrameRing(frameRing_);
+  }
+  if (leaderboard_ != nullptr) {
+    currentGame_->setLeaderboard(leaderboard_, playerName_);
+  }
+  closeJournal();
+  openJournal();
   validationFlag_ = true;
+  closeRewind();
+  openRewind();
 }
 
 void SnakeFacade::terminateGame() {
   validationFlag_ = false;
-  delete currentGame_;
+  hibernated_ = false;
+  std::vector<uint8_t>().swap(hibernatedState_);
+  if (currentGame_ != nullptr) {
+    releaseGame(nullptr);
+  }
+  closeJournal();
+  closeRewind();
+}
+
+bool SnakeFacade::releaseGame(std::vector<uint8_t>* state) {
+  bool pooled = sessionPool_.size() < sessionPoolSize_;
+  bool parked = (pooled || state != nullptr) && currentGame_->park(state);
+  if (parked && currentGame_->getHighScore() > highScore_) {
+    highScore_ = currentGame_->getHighScore();
+  }
+  if (parked && pooled) {
+    sessionPool_.push_back(currentGame_);
+  } else {
+    delete currentGame_;
+  }
   currentGame_ = nullptr;
+  return parked;
+}
+
+void SnakeFacade::hibernateGame() {
+  std::vector<uint8_t> state;
+  if (releaseGame(&state)) {
+    hibernatedState_.swap(state);
+    hibernated_ = true;
+  } else {
+    validationFlag_ = false;
+    closeJournal();
+    closeRewind();
+  }
+}
+
+bool SnakeFacade::startGame(const std::vector<uint8_t>& state) {
+  Game* game = nullptr;
+  if (!sessionPool_.empty()) {
+    game = sessionPool_.front();
+    sessionPool_.pop_front();
+  } else {
+    /* Threads of a fresh game must be parked before the state is loaded */
+    game = new Game();
+    game->park();
+  }
+  if (!game->loadState(state)) {
+    if (sessionPool_.size() < sessionPoolSize_) {
+      sessionPool_.push_front(game);
+    } else {
+      delete game;
+    }
+    return false;
+  }
+  if (frameRing_ != nullptr) {
+    game->setFrameRing(frameRing_);
+  }
+  if (journal_ != nullptr) {
+    game->setJournal(journal_);
+  }
+  if (rewind_ != nullptr) {
+    game->setRewind(rewind_);
+  }
+  if (leaderboard_ != nullptr) {
+    game->setLeaderboard(leaderboard_, playerName_);
+  }
+  game->unpark(highScore_);
+  currentGame_ = game;
+  return true;
+}
+
+void SnakeFacade::reviveGame() {
+  if (!startGame(hibernatedState_)) {
+    validationFlag_ = false;
+    closeJournal();
+    closeRewind();
+  }
+  hibernated_ = false;
+  std::vector<uint8_t>().swap(hibernatedState_);
+}
+
+void SnakeFacade::startMonitor() {
+  if (monitorThread_ == nullptr) {
+    monitorThread_ = new std::thread(&SnakeFacade::monitorIdleSessions, this);
+  }
+}
+
+void SnakeFacade::monitorIdleSessions() {
+  std::unique_lock<std::mutex> lock(facadeMutex_);
+  while (!monitorStop_) {
+    std::chrono::milliseconds period(1000);
+    if (hibernationTimeout_.count() > 0 && hibernationTimeout_ / 4 < period) {
+      period = std::max(hibernationTimeout_ / 4, std::chrono::milliseconds(10));
+    }
+    monitorCv_.wait_for(lock, period);
+
+    if (monitorStop_ || !validationFlag_ || hibernated_ ||
+        currentGame_ == nullptr || hibernationTimeout_.count() == 0 ||
+        std::chrono::steady_clock::now() - lastActivity_ <
+            hibernationTimeout_) {
+      continue;
+    }
+    GameStatus_t status = currentGame_->getStatus();
+    if ((status == START || status == PAUSE || status == GAMEOVER) &&
+        currentGame_->isSettled()) {
+      hibernateGame();
+    }
+  }
+}
+
+void SnakeFacade::setHibernationTimeout(std::chrono::milliseconds timeout) {
+  {
+    std::lock_guard<std::mutex> lock(facadeMutex_);
+    hibernationTimeout_ = timeout;
+  }
+  monitorCv_.notify_all();
+}
+
+const std::vector<uint8_t>* SnakeFacade::hibernatedState() {
+  return hibernated_ ? &hibernatedState_ : nullptr;
+}
+
+bool SnakeFacade::snapshotGame(std::vector<uint8_t>& state) {
+  std::lock_guard<std::mutex> lock(facadeMutex_);
+  if (!validationFlag_) {
+    return false;
+  } else if (hibernated_) {
+    state = hibernatedState_;
+    return true;
+  } else {
+    return currentGame_->snapshot(state);
+  }
+}
+
+bool SnakeFacade::restoreGame(const std::vector<uint8_t>& state) {
+  std::lock_guard<std::mutex> lock(facadeMutex_);
+  /* Check the whole blob before anything is touched: savedStatus() only
+   * reads the header, loadState() validates the rest */
+  Game probe(false);
+  if (!probe.loadState(state)) {
+    return false;
+  }
+
+  /* Restored state does not follow from the journal, start a new one */
+  closeJournal();
+  closeRewind();
+  bool result = false;
+  if (validationFlag_ && !hibernated_) {
+    result = currentGame_->restore(state);
+  } else if (startGame(state)) {
+    hibernated_ = false;
+    std::vector<uint8_t>().swap(hibernatedState_);
+    validationFlag_ = true;
+    result = true;
+  }
+  if (result) {
+    startMonitor();
+    lastActivity_ = std::chrono::steady_clock::now();
+  }
+  if (validationFlag_) {
+    openJournal();
+    openRewind();
+  }
+  return result;
+}
+
+void SnakeFacade::setJournalDirectory(const std::string& directory) {
+  std::lock_guard<std::mutex> lock(facadeMutex_);
+  journalDirectory_ = directory;
+}
+
+void SnakeFacade::openJournal() {
+  if (journalDirectory_.empty() || currentGame_ == nullptr) {
+    return;
+  }
+  std::string path = journalDirectory_ + "/snake-" +
+                     std::to_string(std::time(nullptr)) + "-" +
+                     std::to_string(++journalCount_) + ".bgj";
+  journal_ = currentGame_->startJournal(path);
+}
+
+void SnakeFacade::closeJournal() {
+  if (journal_ == nullptr) {
+    return;
+  }
+  if (currentGame_ != nullptr) {
+    currentGame_->setJournal(nullptr);
+  }
+  journal_->close();
+  journal_ = nullptr;
+}
+
+void SnakeFacade::setRewindBudget(size_t budget) {
+  std::lock_guard<std::mutex> lock(facadeMutex_);
+  rewindBudget_ = budget;
+  closeRewind();
+  openRewind();
+}
+
+void SnakeFacade::openRewind() {
+  if (rewindBudget_ == 0 || !validationFlag_) {
+    return;
+  }
+  rewind_ = new RewindBuffer(rewindBudget_);
+  if (currentGame_ != nullptr) {
+    currentGame_->setRewind(rewind_);
+  }
+}
+
+void SnakeFacade::closeRewind() {
+  if (rewind_ == nullptr) {
+    return;
+  }
+  if (currentGame_ != nullptr) {
+    currentGame_->setRewind(nullptr);
+  }
+  delete rewind_;
+  rewind_ = nullptr;
+}
+
+bool SnakeFacade::rewindWindow(uint64_t* first, uint64_t* last) {
+  std::lock_guard<std::mutex> lock(facadeMutex_);
+  return rewind_ != nullptr && rewind_->window(first, last);
+}
+
+bool SnakeFacade::rewindState(uint64_t step, std::vector<uint8_t>& state) {
+  std::lock_guard<std::mutex> lock(facadeMutex_);
+  return rewind_ != nullptr && rewind_->rebuild(step, state);
+}
+
+bool SnakeFacade::openLeaderboard(const std::string& path) {
+  std::lock_guard<std::mutex> lock(facadeMutex_);
+  Leaderboard* board = path.empty() ? nullptr : Leaderboard::open(path);
+  if (currentGame_ != nullptr) {
+    currentGame_->setLeaderboard(board, playerName_);
+  }
+  delete leaderboard_;
+  leaderboard_ = board;
+  return path.empty() || board != nullptr;
+}
+
+void SnakeFacade::setPlayerName(const std::string& name) {
+  std::lock_guard<std::mutex> lock(facadeMutex_);
+  playerName_ = name;
+}
+
+int SnakeFacade::leaderboardBest() {
+  std::lock_guard<std::mutex> lock(facadeMutex_);
+  return leaderboard_ != nullptr ? leaderboard_->best(SNAPSHOT_ENGINE_SNAKE)
+                                 : 0;
+}
+
+uint64_t SnakeFacade::leaderboardRank(int score) {
+  std::lock_guard<std::mutex> lock(facadeMutex_);
+  return leaderboard_ != nullptr
+             ? leaderboard_->rank(SNAPSHOT_ENGINE_SNAKE, score)
+             : 0;
+}
+
+void SnakeFacade::leaderboardTop(size_t count,
+                                 std::vector<LeaderboardRecord>& out) {
+  std::lock_guard<std::mutex> lock(facadeMutex_);
+  if (leaderboard_ != nullptr) {
+    leaderboard_->top(SNAPSHOT_ENGINE_SNAKE, count, out);
+  } else {
+    std::vector<LeaderboardRecord>().swap(out);
+  }
+}
+
+int SnakeFacade::leaderboardPlayerBest() {
+  std::lock_guard<std::mutex> lock(facadeMutex_);
+  return leaderboard_ != nullptr
+             ? leaderboard_->playerBest(SNAPSHOT_ENGINE_SNAKE, playerName_)
+             : 0;
+}
+
+void SnakeFacade::touchGame() {
+  lastActivity_ = std::chrono::steady_clock::now();
+  if (hibernated_) {
+    reviveGame();
+  }
+}
+
+void SnakeFacade::setSessionPoolSize(size_t size) {
+  std::lock_guard<std::mutex> lock(facadeMutex_);
+  sessionPoolSize_ = size;
+  while (sessionPool_.size() > sessionPoolSize_) {
+    delete sessionPool_.back();
+    sessionPool_.pop_back();
+  }
+  while (sessionPool_.size() < sessionPoolSize_) {
+    Game* game = new Game();
+    game->park();
+    sessionPool_.push_back(game);
+  }
 }
 
 void SnakeFacade::invalidateGame() { validationFlag_ = false; }
@@ -37,32 +373,77 @@ std::mutex& SnakeFacade::getMutex() { return facadeMutex_; }
 
 Game& SnakeFacade::getCurrentGame() { return *currentGame_; }
 
+bool SnakeFacade::exportFrames(const std::string& name) {
+  std::lock_guard<std::mutex> lock(facadeMutex_);
+  /* The old ring unlinks its name, so it goes before the new one takes it */
+  if (currentGame_ != nullptr) {
+    currentGame_->setFrameRing(nullptr);
+  }
+  delete frameRing_;
+  frameRing_ = FrameRing::create(name);
+  if (frameRing_ == nullptr) {
+    return false;
+  }
+  if (currentGame_ != nullptr) {
+    currentGame_->setFrameRing(frameRing_);
+  }
+  return true;
+}
+
+void SnakeFacade::stopFrameExport() {
+  std::lock_guard<std::mutex> lock(facadeMutex_);
+  if (currentGame_ != nullptr) {
+    currentGame_->setFrameRing(nullptr);
+  }
+  delete frameRing_;
+  frameRing_ = nullptr;
+}
+
 GameStatus_t SnakeFacade::getCurrentGameStatus() {
   std::lock_guard<std::mutex> lock(SnakeFacade::Instance().getMutex());
-  if (SnakeFacade::Instance().isValid()) {
-    return currentGame_->getStatus();
-  } else {
+  if (!SnakeFacade::Instance().isValid()) {
     return EXIT;
+  } else if (hibernated_) {
+    return Game::savedStatus(hibernatedState_);
+  } else {
+    return currentGame_->getStatus();
   }
 }
 
 void userInput(UserAction_t action, bool hold) {
   std::lock_guard<std::mutex> lock(SnakeFacade::Instance().getMutex());
   if (SnakeFacade::Instance().isValid()) {
-    SnakeFacade::Instance().getCurrentGame().processUserInput(action, hold);
     if (action == Terminate) {
       SnakeFacade::Instance().invalidateGame();
       SnakeFacade::Instance().terminateGame();
+    } else {
+      SnakeFacade::Instance().touchGame();
+      /* A session that failed to revive is gone */
+      if (SnakeFacade::Instance().isValid()) {
+        SnakeFacade::Instance().getCurrentGame().processUserInput(action,
+                                                                  hold);
+      }
     }
   }
 }
 
 GameInfo_t updateCurrentState() {
+  std::lock_guard<std::mutex> lock(SnakeFacade::Instance().getMutex());
   GameInfo_t gameInfoCopy;
   if (SnakeFacade::Instance().isValid()) {
-    Game& game = SnakeFacade::Instance().getCurrentGame();
-    gameInfoCopy = game.gameInfo_;
-    gameInfoCopy.field = game.renderField();
+    const std::vector<uint8_t>* state =
+        SnakeFacade::Instance().hibernatedState();
+    if (state != nullptr) {
+      /* Hibernated session is rendered from its blob, it stays asleep */
+      Game view(false);
+      view.loadState(*state);
+      gameInfoCopy = view.gameInfo_;
+      gameInfoCopy.field = view.renderField();
+    } else {
+      Game& game = SnakeFacade::Instance().getCurrentGame();
+      gameInfoCopy = game.gameInfo_;
+      gameInfoCopy.field = game.renderField();
+    }
   }
   return gameInfoCopy;
 }
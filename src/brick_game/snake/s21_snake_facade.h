@@ -1,6 +1,9 @@
 #ifndef S21_SNAKE_FACADE_H
 #define S21_SNAKE_FACADE_H
 
+#include <algorithm>
+#include <deque>
+
 #include "s21_snake.h"
 
 namespace s21 {
@@ -17,13 +20,167 @@ class SnakeFacade {
   GameStatus_t getCurrentGameStatus();
   Game& getCurrentGame();
 
+  /**
+   * @brief Starts exporting frames into a shared-memory ring. A ring
+   * already exported is unlinked first, even if the new one cannot be
+   * created.
+   **/
+  bool exportFrames(const std::string& name);
+  void stopFrameExport();
+
+  /**
+   * @brief Sets the number of pre-initialized sessions kept in the pool.
+   * Missing sessions are created right away, extra ones are destroyed.
+   * @param size Pool capacity
+   **/
+  void setSessionPoolSize(size_t size);
+
+  /**
+   * @brief Sets how long a session may stay idle in START, PAUSE or
+   * GAMEOVER before it is hibernated: its state is saved into a compact
+   * blob and the game (threads and heap) is released.
+   * @param timeout Idle timeout, zero disables hibernation
+   **/
+  void setHibernationTimeout(std::chrono::milliseconds timeout);
+
+  /**
+   * @brief Saved state of the hibernated session.
+   * @return nullptr if the current session is alive
+   **/
+  const std::vector<uint8_t>* hibernatedState();
+
+  /**
+   * @brief Revives the hibernated session, if any, and records user
+   * activity for the idle timer.
+   **/
+  void touchGame();
+
+  /**
+   * @brief Takes a snapshot of the current session (hibernated included).
+   * @param state Output snapshot
+   * @return false if no game is running
+   **/
+  bool snapshotGame(std::vector<uint8_t>& state);
+
+  /**
+   * @brief Replaces the current session with a snapshot. If no game is
+   * running, a new session is started from the snapshot.
+   * @param state Snapshot produced by snapshotGame()
+   * @return false if the snapshot is malformed, the session (hibernated
+   * or not) is untouched then
+   **/
+  bool restoreGame(const std::vector<uint8_t>& state);
+
+  /**
+   * @brief Sets the directory for replay journals. Every new session
+   * (and every restored one) gets its own journal file there.
+   * @param directory Existing directory, empty string disables journaling
+   **/
+  void setJournalDirectory(const std::string& directory);
+
+  /**
+   * @brief Sets the memory budget of the rewind buffer that keeps the
+   * last steps of the session (see s21_rewind.h). The current session
+   * starts a new buffer with the budget, so do the following ones.
+   * @param budget Bytes per session, zero disables rewinding
+   **/
+  void setRewindBudget(size_t budget);
+
+  /**
+   * @brief Steps of the current session that can be rebuilt.
+   * @return false if rewinding is disabled or no game is running
+   **/
+  bool rewindWindow(uint64_t* first, uint64_t* last);
+
+  /**
+   * @brief Rebuilds the current session at a step of the rewind window.
+   * @param step Step returned by rewindWindow()
+   * @param state Output snapshot
+   * @return false if the step is outside of the window
+   **/
+  bool rewindState(uint64_t step, std::vector<uint8_t>& state);
+
+  /**
+   * @brief Maps the leaderboard store shared by all sessions and
+   * processes (see s21_leaderboard.h), creating it if needed. Sessions
+   * post their final scores there and start with its best score.
+   * @param path Store file, empty string detaches the store
+   * @return false if the store cannot be mapped
+   **/
+  bool openLeaderboard(const std::string& path);
+
+  /**
+   * @brief Sets the name the following sessions post their scores under.
+   **/
+  void setPlayerName(const std::string& name);
+
+  /**
+   * @brief Best snake score of the leaderboard.
+   * @return 0 if no leaderboard is open
+   **/
+  int leaderboardBest();
+
+  /**
+   * @brief Rank a snake score would have on the leaderboard, 1 is best.
+   * @return 0 if no leaderboard is open
+   **/
+  uint64_t leaderboardRank(int score);
+
+  /**
+   * @brief Best snake records of the leaderboard, highest score first.
+   * @param count Records wanted
+   * @param out Output records, empty if no leaderboard is open
+   **/
+  void leaderboardTop(size_t count, std::vector<LeaderboardRecord>& out);
+
+  /**
+   * @brief Best snake score of the current player on the leaderboard.
+   * @return 0 if the player has not posted or no leaderboard is open
+   **/
+  int leaderboardPlayerBest();
+
  private:
   SnakeFacade();
   ~SnakeFacade();
+
+  bool releaseGame(std::vector<uint8_t>* state);
+  void hibernateGame();
+  bool startGame(const std::vector<uint8_t>& state);
+  void reviveGame();
+  void startMonitor();
+  void monitorIdleSessions();
+  void openJournal();
+  void closeJournal();
+  void openRewind();
+  void closeRewind();
+
   std::mutex facadeMutex_;
 
   Game* currentGame_{nullptr};
   bool validationFlag_{false};
+  FrameRing* frameRing_{nullptr};
+
+  std::deque<Game*> sessionPool_;  ///< Parked sessions ready to be claimed
+  size_t sessionPoolSize_{1};
+  int highScore_{0};  ///< Best score of the sessions returned to the pool
+
+  std::vector<uint8_t> hibernatedState_;
+  bool hibernated_{false};
+  std::chrono::steady_clock::time_point lastActivity_;
+  std::chrono::milliseconds hibernationTimeout_{30000};
+  std::thread* monitorThread_{nullptr};
+  std::condition_variable monitorCv_;
+  bool monitorStop_{false};
+
+  std::string journalDirectory_;
+  unsigned journalCount_{0};
+  Journal* journal_{nullptr};  ///< Journal of the current session
+
+  size_t rewindBudget_{0};
+  RewindBuffer* rewind_{nullptr};  ///< Rewind buffer of the current session
+
+  Leaderboard* leaderboard_{nullptr};
+  std::string playerName_{"player"};
 };
 
 void userInput(UserAction_t action, bool hold);
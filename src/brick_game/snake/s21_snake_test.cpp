@@ -0,0 +1,553 @@
+/**
+ * @file s21_snake_test.cpp
+ * @brief Checks that a snapshot holds the whole snake game.
+ *
+ * A restored game must save the very same bytes and keep playing exactly
+ * like the original one. Malformed snapshots must be rejected without
+ * touching the game. A journal seeked to any step, forward or backward,
+ * and a rewind buffer rebuilt at any step of its window must hold the game
+ * a plain replay reaches there. The arena must agree with a brute-force
+ * model of its collision rules, and a batch of environments must not
+ * depend on the number of threads stepping it.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "s21_arena.h"
+#include "s21_autopilot.h"
+#include "s21_journal.h"
+#include "s21_replay.h"
+#include "s21_rewind.h"
+#include "s21_vec_env.h"
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                \
+  do {                                                                  \
+    if (!(condition)) {                                                 \
+      std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #condition); \
+      failures++;                                                       \
+    }                                                                   \
+  } while (0)
+
+/* Offset of the u16 body length in a snake snapshot */
+constexpr size_t bodyLengthOffset = 36;
+
+/* Plays a number of moves, starting over after a game over */
+void playMoves(s21::Game& game, int moves) {
+  s21::Autopilot pilot(game);
+  for (int i = 0; i < moves; ++i) {
+    pilot.play();
+  }
+}
+
+void testRoundTrip() {
+  s21::Game game(false);
+  game.seedRandom(7);
+  for (int round = 0; round < 20; ++round) {
+    playMoves(game, 37);
+    std::vector<uint8_t> saved;
+    game.saveState(saved);
+
+    s21::Game copy(false);
+    CHECK(copy.loadState(saved));
+    std::vector<uint8_t> resaved;
+    copy.saveState(resaved);
+    CHECK(resaved == saved);
+
+    /* Food placement comes from the saved PRNG state as well */
+    s21::Game original(false);
+    CHECK(original.loadState(saved));
+    playMoves(original, 200);
+    playMoves(copy, 200);
+    std::vector<uint8_t> left;
+    std::vector<uint8_t> right;
+    original.saveState(left);
+    copy.saveState(right);
+    CHECK(left == right);
+    CHECK(left != saved);
+  }
+}
+
+void testMalformed() {
+  s21::Game game(false);
+  game.seedRandom(11);
+  playMoves(game, 50);
+  std::vector<uint8_t> saved;
+  game.saveState(saved);
+
+  s21::Game target(false);
+  target.seedRandom(3);
+  playMoves(target, 20);
+  std::vector<uint8_t> before;
+  target.saveState(before);
+
+  std::vector<std::vector<uint8_t>> broken;
+  for (size_t size = 0; size < saved.size(); ++size) {
+    broken.emplace_back(saved.begin(), saved.begin() + size);
+  }
+  std::vector<uint8_t> longer = saved;
+  longer.push_back(0);
+  broken.push_back(longer);
+  std::vector<uint8_t> empty(saved.begin(),
+                             saved.begin() + bodyLengthOffset + 2);
+  empty[bodyLengthOffset] = 0;
+  empty[bodyLengthOffset + 1] = 0;
+  broken.push_back(empty);
+  /* Body cells off the board or on top of each other */
+  const size_t head = bodyLengthOffset + 2;
+  std::vector<uint8_t> lowRow = saved;
+  lowRow[head + 1] |= 0x07;
+  broken.push_back(lowRow);
+  std::vector<uint8_t> farCol = saved;
+  farCol[head] |= 0x3c;
+  broken.push_back(farCol);
+  CHECK(saved[bodyLengthOffset] >= 2 &&
+        s21::Game::savedStatus(saved) != s21::GAMEOVER);
+  std::vector<uint8_t> twice = saved;
+  twice[head + 2] = twice[head];
+  twice[head + 3] = twice[head + 1];
+  broken.push_back(twice);
+  std::vector<uint8_t> engine = saved;
+  engine[6] = SNAPSHOT_ENGINE_TETRIS;
+  broken.push_back(engine);
+  std::vector<uint8_t> magic = saved;
+  magic[0] ^= 1;
+  broken.push_back(magic);
+
+  for (const std::vector<uint8_t>& state : broken) {
+    CHECK(!target.loadState(state));
+    std::vector<uint8_t> after;
+    target.saveState(after);
+    CHECK(after == before);
+  }
+}
+
+/* Steps of the test journals, a few keyframe intervals and a bit more */
+constexpr uint64_t journalSteps = 3 * JOURNAL_KEYFRAME_INTERVAL + 100;
+
+/* A turn every seventh step and Start in between, which only restarts a
+ * lost game, with a timer tick on each step */
+std::vector<uint8_t> journalFlags() {
+  static const s21::UserAction_t turns[] = {s21::Left, s21::Right, s21::Up,
+                                            s21::Down};
+  std::vector<uint8_t> flags(journalSteps, JOURNAL_TICK);
+  uint64_t moves = 5;
+  for (uint64_t i = 0; i < journalSteps; ++i) {
+    if (i % 7 == 0) {
+      flags[i] |= JOURNAL_INPUT | s21::Start;
+    } else if (i % 7 == 4) {
+      flags[i] |= JOURNAL_INPUT | turns[s21::nextXorshift64Star(moves) % 4];
+    }
+  }
+  return flags;
+}
+
+/* The flusher writes the file after close(), the index comes last */
+bool waitForIndex(const std::string& path) {
+  for (int attempt = 0; attempt < 500; ++attempt) {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> data((std::istreambuf_iterator<char>(file)),
+                           std::istreambuf_iterator<char>());
+    if (data.size() >= 4) {
+      uint32_t magic = 0;
+      for (int i = 0; i < 4; ++i) {
+        magic |= (uint32_t)(uint8_t)data[data.size() - 4 + i] << (8 * i);
+      }
+      if (magic == JOURNAL_INDEX_MAGIC) {
+        return true;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return false;
+}
+
+/**
+ * @brief Writes a journal of the flags, with keyframes taken from the
+ * states after each step if they are given.
+ **/
+bool writeJournal(const std::string& path, uint64_t seed,
+                  const std::vector<uint8_t>& start,
+                  const std::vector<uint8_t>& flags,
+                  const std::vector<std::vector<uint8_t>>* states) {
+  s21::Journal* journal =
+      s21::Journal::open(path, SNAPSHOT_ENGINE_SNAKE, seed, start);
+  if (journal == nullptr) {
+    return false;
+  }
+  for (size_t i = 0; i < flags.size(); ++i) {
+    journal->step(flags[i]);
+    if (states != nullptr && journal->keyframeDue()) {
+      journal->keyframe((*states)[i + 1]);
+    }
+  }
+  journal->close();
+  return waitForIndex(path);
+}
+
+/**
+ * @brief States after every step of a plain replay of the flags.
+ * @return false if the journal could not be written or replayed
+ **/
+bool replayStates(const std::vector<uint8_t>& start,
+                  const std::vector<uint8_t>& flags,
+                  std::vector<std::vector<uint8_t>>& states) {
+  const std::string plainPath = "s21_snake_test_plain.journal";
+  CHECK(writeJournal(plainPath, 5, start, flags, nullptr));
+  s21::ReplayPlayer* plain = s21::ReplayPlayer::open(plainPath);
+  std::remove(plainPath.c_str());
+  CHECK(plain != nullptr);
+  if (plain == nullptr) return false;
+  CHECK(plain->length() == flags.size());
+  states.assign(1, {});
+  plain->snapshot(states[0]);
+  while (plain->step()) {
+    states.emplace_back();
+    plain->snapshot(states.back());
+  }
+  delete plain;
+  CHECK(states.size() == flags.size() + 1);
+  CHECK(states[flags.size()] != states[0]);
+  return states.size() == flags.size() + 1;
+}
+
+/* Start of the test games */
+std::vector<uint8_t> startState() {
+  s21::Game game(false);
+  game.seedRandom(5);
+  std::vector<uint8_t> start;
+  game.saveState(start);
+  return start;
+}
+
+void testJournalSeek() {
+  const std::string keyedPath = "s21_snake_test_keyed.journal";
+  std::vector<uint8_t> start = startState();
+  std::vector<uint8_t> flags = journalFlags();
+  std::vector<std::vector<uint8_t>> states;
+  if (!replayStates(start, flags, states)) return;
+
+  CHECK(writeJournal(keyedPath, 5, start, flags, &states));
+  s21::JournalReader* reader = s21::JournalReader::open(keyedPath);
+  CHECK(reader != nullptr);
+  if (reader != nullptr) {
+    CHECK(reader->keyframes().size() ==
+          journalSteps / JOURNAL_KEYFRAME_INTERVAL);
+    delete reader;
+  }
+
+  s21::ReplayPlayer* player = s21::ReplayPlayer::open(keyedPath);
+  CHECK(player != nullptr);
+  if (player == nullptr) return;
+  const uint64_t targets[] = {journalSteps, 0,    1500, 1024, 3000,
+                              5,            2048, 2047, 1023, journalSteps};
+  std::vector<uint8_t> state;
+  for (uint64_t target : targets) {
+    CHECK(player->seek(target));
+    CHECK(player->position() == target);
+    player->snapshot(state);
+    CHECK(state == states[target]);
+  }
+  CHECK(!player->seek(journalSteps + 1));
+
+  /* Stepping through keyframes must not disturb the game either */
+  CHECK(player->seek(0));
+  for (uint64_t step = 1; step <= journalSteps; ++step) {
+    CHECK(player->step());
+    player->snapshot(state);
+    CHECK(state == states[step]);
+  }
+  CHECK(!player->step());
+  delete player;
+  std::remove(keyedPath.c_str());
+}
+
+/* Every step of the window must rebuild to the state of a plain replay */
+void checkRewindWindow(s21::RewindBuffer& rewind,
+                       const std::vector<std::vector<uint8_t>>& states) {
+  uint64_t first = 0;
+  uint64_t last = 0;
+  CHECK(rewind.window(&first, &last));
+  std::vector<uint8_t> state;
+  for (uint64_t step = first; step <= last; ++step) {
+    CHECK(rewind.rebuild(step, state));
+    CHECK(state == states[step]);
+  }
+  CHECK(first == 0 || !rewind.rebuild(first - 1, state));
+  CHECK(!rewind.rebuild(last + 1, state));
+}
+
+void testRewind() {
+  std::vector<uint8_t> flags = journalFlags();
+  std::vector<std::vector<uint8_t>> states;
+  if (!replayStates(startState(), flags, states)) return;
+
+  /* Room for a few segments, the oldest ones have to go */
+  const size_t budget = 1536;
+  s21::RewindBuffer rewind(budget);
+  uint64_t previousFirst = 0;
+  for (size_t i = 0; i < flags.size(); ++i) {
+    rewind.step(flags[i]);
+    if (rewind.keyframeDue()) {
+      rewind.keyframe(states[i + 1]);
+    }
+    uint64_t first = 0;
+    uint64_t last = 0;
+    CHECK(rewind.window(&first, &last));
+    CHECK(last == i + 1 && first >= previousFirst && first <= last);
+    CHECK((first - 1) % REWIND_KEYFRAME_INTERVAL == 0);
+    previousFirst = first;
+    if ((i + 1) % 1000 == 0) {
+      checkRewindWindow(rewind, states);
+    }
+  }
+  CHECK(previousFirst > 2 * REWIND_KEYFRAME_INTERVAL);
+  CHECK(rewind.used() <= budget + states.back().size() +
+                             2 * REWIND_KEYFRAME_INTERVAL);
+  checkRewindWindow(rewind, states);
+}
+
+/* A snake of the arena model, cells from the head to the tail */
+struct ModelSnake {
+  bool alive = false;
+  int heading = s21::Snake::right;
+  int score = 0;
+  std::deque<std::pair<int, int>> body;
+};
+
+/* Picks up a snake the arena has just spawned: a row to the left of the
+ * head, heading right */
+void modelSpawn(s21::Arena& arena, int snake, std::vector<ModelSnake>& model) {
+  ModelSnake& spawned = model[snake];
+  int row = 0;
+  int col = 0;
+  arena.getHead(snake, &row, &col);
+  spawned = ModelSnake();
+  spawned.alive = true;
+  for (int i = 0; i < arena.getLength(snake); ++i) {
+    spawned.body.emplace_back(row, col - i);
+  }
+}
+
+/* Turns the model the way Arena::steer() does, once per tick */
+void modelSteer(ModelSnake& snake, s21::UserAction_t action) {
+  static const int directions[] = {s21::Snake::left, s21::Snake::right,
+                                   s21::Snake::up, s21::Snake::down};
+  int direction = directions[action - s21::Left];
+  bool vertical = direction == s21::Snake::up || direction == s21::Snake::down;
+  bool movingVertically = snake.heading == s21::Snake::up ||
+                          snake.heading == s21::Snake::down;
+  if (vertical != movingVertically) {
+    snake.heading = direction;
+  }
+}
+
+/**
+ * @brief One tick of the arena rules, checking every head against every
+ * cell of every body and every other head.
+ * @param food Food cells before the tick
+ * @return Number of snakes that ate
+ **/
+int modelTick(int rows, int cols, const std::vector<bool>& food,
+               std::vector<ModelSnake>& model) {
+  static const int rowStep[4] = {-1, 1, 0, 0};
+  static const int colStep[4] = {0, 0, -1, 1};
+  const size_t count = model.size();
+  std::vector<std::pair<int, int>> targets(count);
+  std::vector<bool> dies(count, false);
+  for (size_t i = 0; i < count; ++i) {
+    if (!model[i].alive) continue;
+    std::pair<int, int> head = model[i].body.front();
+    targets[i] = {head.first + rowStep[model[i].heading],
+                  head.second + colStep[model[i].heading]};
+    dies[i] = targets[i].first < 0 || targets[i].first >= rows ||
+              targets[i].second < 0 || targets[i].second >= cols;
+    for (size_t j = 0; j < count && !dies[i]; ++j) {
+      for (size_t k = 0; model[j].alive && k < model[j].body.size(); ++k) {
+        dies[i] = dies[i] || model[j].body[k] == targets[i];
+      }
+    }
+  }
+  std::vector<bool> meets(count, false);
+  int meals = 0;
+  for (size_t i = 0; i < count; ++i) {
+    for (size_t j = i + 1; j < count; ++j) {
+      if (model[i].alive && model[j].alive && !dies[i] && !dies[j] &&
+          targets[i] == targets[j]) {
+        meets[i] = true;
+        meets[j] = true;
+      }
+    }
+  }
+  for (size_t i = 0; i < count; ++i) {
+    if (!model[i].alive) continue;
+    if (dies[i] || meets[i]) {
+      model[i].alive = false;
+      model[i].body.clear();
+      continue;
+    }
+    model[i].body.push_front(targets[i]);
+    bool eat = food[targets[i].first * cols + targets[i].second];
+    model[i].score += eat;
+    meals += eat;
+    if (!eat || model[i].body.size() > ARENA_MAX_LENGTH) {
+      model[i].body.pop_back();
+    }
+  }
+  return meals;
+}
+
+/* The arena must hold the very snakes of the model, cell by cell */
+bool sameArena(s21::Arena& arena, const std::vector<ModelSnake>& model,
+               const std::vector<int>& cells) {
+  bool same = true;
+  size_t occupied = 0;
+  for (int snake = 0; snake < (int)model.size(); ++snake) {
+    const ModelSnake& expected = model[snake];
+    int row = -1;
+    int col = -1;
+    arena.getHead(snake, &row, &col);
+    same = same && arena.isAlive(snake) == expected.alive &&
+           arena.getLength(snake) == (int)expected.body.size();
+    if (!expected.alive) continue;
+    same = same && arena.getScore(snake) == expected.score &&
+           row == expected.body.front().first &&
+           col == expected.body.front().second;
+    for (const std::pair<int, int>& cell : expected.body) {
+      int code = cells[cell.first * arena.getCols() + cell.second];
+      same = same && code != BLANK && code != FOOD;
+    }
+    occupied += expected.body.size();
+  }
+  for (int code : cells) {
+    occupied -= code != BLANK && code != FOOD;
+  }
+  return same && occupied == 0;
+}
+
+void testArena() {
+  const int rows = 32;
+  const int cols = 32;
+  const int snakes = 40;
+  s21::Arena arena(rows, cols, snakes, 64, 9);
+  std::vector<ModelSnake> model(snakes);
+  std::vector<int> cells(rows * cols);
+  std::vector<bool> food(rows * cols);
+  uint64_t moves = 9;
+  int deaths = 0;
+  int meals = 0;
+  const int failuresBefore = failures;
+  for (int tick = 0; tick < 20000; ++tick) {
+    for (int snake = 0; snake < snakes; ++snake) {
+      if (!model[snake].alive && arena.spawnSnake() == snake) {
+        modelSpawn(arena, snake, model);
+      }
+      uint64_t move = s21::nextXorshift64Star(moves);
+      if (model[snake].alive && move % 4 == 0) {
+        s21::UserAction_t action =
+            (s21::UserAction_t)(s21::Left + move / 4 % 4);
+        arena.steer(snake, action);
+        modelSteer(model[snake], action);
+      }
+    }
+    arena.renderViewport(0, 0, rows, cols, cells.data());
+    for (size_t cell = 0; cell < cells.size(); ++cell) {
+      food[cell] = cells[cell] == FOOD;
+    }
+
+    int before = 0;
+    for (const ModelSnake& snake : model) {
+      before += snake.alive;
+    }
+    int alive = arena.tick();
+    meals += modelTick(rows, cols, food, model);
+    int expected = 0;
+    for (const ModelSnake& snake : model) {
+      expected += snake.alive;
+    }
+    arena.renderViewport(0, 0, rows, cols, cells.data());
+    CHECK(alive == expected);
+    CHECK(sameArena(arena, model, cells));
+    if (failures != failuresBefore) {
+      std::fprintf(stderr, "arena differs at tick %d\n", tick);
+      return;
+    }
+    deaths += before - expected;
+  }
+  /* The run must have gone through collisions and meals */
+  CHECK(deaths > 1000);
+  CHECK(meals > 1000);
+}
+
+/* Outputs of a VecEnv run, every step one after the other */
+struct VecEnvRun {
+  std::vector<uint8_t> obs;
+  std::vector<float> reward;
+  std::vector<uint8_t> done;
+};
+
+/* Plays the same random actions on a batch of the given thread count */
+VecEnvRun runVecEnv(int count, int threads, int steps) {
+  const size_t cells = (size_t)count * s21::VecEnv::rows * s21::VecEnv::cols;
+  s21::VecEnv env(count, threads);
+  CHECK(env.getThreads() == threads);
+  VecEnvRun run;
+  run.obs.resize(cells * (steps + 1));
+  run.reward.resize((size_t)count * steps);
+  run.done.resize((size_t)count * steps);
+  env.resetAll(nullptr, run.obs.data());
+  std::vector<uint8_t> actions(count);
+  uint64_t moves = 13;
+  for (int step = 0; step < steps; ++step) {
+    for (uint8_t& action : actions) {
+      action = s21::nextXorshift64Star(moves) % (s21::Action + 1);
+    }
+    env.stepAll(actions.data(), run.obs.data() + cells * (step + 1),
+                run.reward.data() + (size_t)count * step,
+                run.done.data() + (size_t)count * step);
+  }
+  return run;
+}
+
+void testVecEnv() {
+  /* Not a multiple of VEC_ENV_CHUNK, so the last chunk is a short one */
+  const int count = 100;
+  const int steps = 2000;
+  VecEnvRun single = runVecEnv(count, 1, steps);
+  VecEnvRun pooled = runVecEnv(count, 4, steps);
+  CHECK(single.obs == pooled.obs);
+  CHECK(std::memcmp(single.reward.data(), pooled.reward.data(),
+                    single.reward.size() * sizeof(float)) == 0);
+  CHECK(single.done == pooled.done);
+  CHECK(std::count(single.done.begin(), single.done.end(), 1) > count);
+  CHECK(std::count(single.reward.begin(), single.reward.end(), 1.0f) > count);
+}
+
+}  // namespace
+
+int main() {
+  testRoundTrip();
+  testMalformed();
+  testJournalSeek();
+  testRewind();
+  testArena();
+  testVecEnv();
+  if (failures != 0) {
+    std::fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+  std::printf("snake: all checks passed\n");
+  return 0;
+}
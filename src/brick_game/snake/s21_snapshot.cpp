@@ -0,0 +1,65 @@
+/**
+ * @file s21_snapshot.cpp
+ * @brief Binary game snapshot source code.
+ */
+
+#include "s21_snapshot.h"
+
+#include <cstring>
+
+namespace s21 {
+
+void SnapshotWriter::u8(uint8_t value) { out_.push_back(value); }
+
+void SnapshotWriter::u16(uint16_t value) {
+  out_.push_back(value & 0xff);
+  out_.push_back(value >> 8);
+}
+
+void SnapshotWriter::u32(uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    out_.push_back(value >> (8 * i) & 0xff);
+  }
+}
+
+void SnapshotWriter::u64(uint64_t value) {
+  for (int i = 0; i < 8; ++i) {
+    out_.push_back(value >> (8 * i) & 0xff);
+  }
+}
+
+void SnapshotWriter::f32(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  u32(bits);
+}
+
+uint64_t SnapshotReader::read(int bytes) {
+  uint64_t value = 0;
+  if (!ok_ || size_ - position_ < (size_t)bytes) {
+    ok_ = false;
+    return 0;
+  }
+  for (int i = 0; i < bytes; ++i) {
+    value |= (uint64_t)data_[position_ + i] << (8 * i);
+  }
+  position_ += bytes;
+  return value;
+}
+
+uint8_t SnapshotReader::u8() { return read(1); }
+
+uint16_t SnapshotReader::u16() { return read(2); }
+
+uint32_t SnapshotReader::u32() { return read(4); }
+
+uint64_t SnapshotReader::u64() { return read(8); }
+
+float SnapshotReader::f32() {
+  uint32_t bits = u32();
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+}  // namespace s21
@@ -0,0 +1,72 @@
+/**
+ * @file s21_snapshot.h
+ * @brief Binary game snapshot header file.
+ *
+ * Snapshot layout (all integers are little-endian, floats are IEEE 754):
+ *   u32 magic "BGSS", u16 version, u8 engine, u8 reserved
+ *   engine specific payload (see Game::saveState())
+ * The layout is the same on every host, so snapshots may be moved between
+ * processes and machines.
+ */
+#ifndef SRC_SNAKE_SNAPSHOT_H
+#define SRC_SNAKE_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace s21 {
+
+#define SNAPSHOT_MAGIC 0x53534742u  ///< "BGSS"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_ENGINE_SNAKE 1
+#define SNAPSHOT_ENGINE_TETRIS 2
+#define SNAPSHOT_MAX_SIZE 512  ///< Enough for any snapshot of both engines
+
+/**
+ * @brief Appends little-endian values to a byte buffer.
+ */
+class SnapshotWriter {
+ public:
+  explicit SnapshotWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+  void u8(uint8_t value);
+  void u16(uint16_t value);
+  void u32(uint32_t value);
+  void u64(uint64_t value);
+  void f32(float value);
+
+ private:
+  std::vector<uint8_t>& out_;
+};
+
+/**
+ * @brief Reads little-endian values from a byte buffer.
+ * Reading past the end yields zeros and clears the ok() flag.
+ */
+class SnapshotReader {
+ public:
+  SnapshotReader(const uint8_t* data, size_t size)
+      : data_(data), size_(size) {}
+
+  uint8_t u8();
+  uint16_t u16();
+  uint32_t u32();
+  uint64_t u64();
+  float f32();
+
+  bool ok() const { return ok_; }
+  size_t remaining() const { return size_ - position_; }
+
+ private:
+  uint64_t read(int bytes);
+
+  const uint8_t* data_;
+  size_t size_;
+  size_t position_{0};
+  bool ok_{true};
+};
+
+}  // namespace s21
+
+#endif  // SRC_SNAKE_SNAPSHOT_H
@@ -0,0 +1,96 @@
+/**
+ * @file s21_sparse_board.cpp
+ * @brief Chunked sparse board source code.
+ */
+
+#include "s21_sparse_board.h"
+
+#include <algorithm>
+
+namespace s21 {
+
+SparseBoard::~SparseBoard() { clear(); }
+
+SparseBoard::Chunk* SparseBoard::find(uint64_t key) const {
+  if (key != lastKey_) {
+    auto it = chunks_.find(key);
+    lastChunk_ = it != chunks_.end() ? it->second : nullptr;
+    lastKey_ = key;
+  }
+  return lastChunk_;
+}
+
+int SparseBoard::get(int row, int col) const {
+  if (!geometry_.contains(row, col)) {
+    return 0;
+  }
+  Chunk* chunk = find(chunkKey(row, col));
+  return chunk != nullptr ? chunk->cells[cellIndex(row, col)] : 0;
+}
+
+void SparseBoard::set(int row, int col, int code) {
+  if (!geometry_.contains(row, col)) {
+    return;
+  }
+  uint64_t key = chunkKey(row, col);
+  Chunk* chunk = find(key);
+  if (chunk == nullptr) {
+    if (code == 0) {
+      return;
+    }
+    chunk = new Chunk();
+    chunks_.emplace(key, chunk);
+    lastChunk_ = chunk;
+  }
+
+  uint8_t& cell = chunk->cells[cellIndex(row, col)];
+  chunk->occupied += (code != 0) - (cell != 0);
+  occupied_ += (code != 0) - (cell != 0);
+  cell = code;
+  if (chunk->occupied == 0) {
+    chunks_.erase(key);
+    delete chunk;
+    lastChunk_ = nullptr;
+  }
+}
+
+void SparseBoard::clear() {
+  for (auto& entry : chunks_) {
+    delete entry.second;
+  }
+  chunks_.clear();
+  occupied_ = 0;
+  lastKey_ = ~0ull;
+  lastChunk_ = nullptr;
+}
+
+void SparseBoard::render(int top, int left, int rows, int cols,
+                         int* out) const {
+  std::fill(out, out + (size_t)rows * cols, 0);
+  int rowBegin = std::max(top, 0);
+  int rowEnd = (int)std::min<int64_t>((int64_t)top + rows, geometry_.rows());
+  int colBegin = std::max(left, 0);
+  int colEnd = (int)std::min<int64_t>((int64_t)left + cols, geometry_.cols());
+
+  /* Walk the rectangle chunk by chunk, empty chunks stay zero */
+  for (int chunkRow = rowBegin; chunkRow < rowEnd;) {
+    int chunkRowEnd =
+        std::min(rowEnd, (chunkRow | (SPARSE_CHUNK_SIDE - 1)) + 1);
+    for (int chunkCol = colBegin; chunkCol < colEnd;) {
+      int chunkColEnd =
+          std::min(colEnd, (chunkCol | (SPARSE_CHUNK_SIDE - 1)) + 1);
+      Chunk* chunk = find(chunkKey(chunkRow, chunkCol));
+      for (int row = chunkRow; chunk != nullptr && row < chunkRowEnd; ++row) {
+        const uint8_t* source = chunk->cells + cellIndex(row, chunkCol);
+        int* target = out + (size_t)(row - top) * cols + (chunkCol - left);
+        for (int i = 0; i < chunkColEnd - chunkCol; ++i) {
+          target[i] = source[i];
+        }
+      }
+      chunkCol = chunkColEnd;
+    }
+    chunkRow = chunkRowEnd;
+  }
+}
+
+}  // namespace s21
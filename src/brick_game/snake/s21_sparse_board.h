@@ -0,0 +1,94 @@
+/**
+ * @file s21_sparse_board.h
+ * @brief Chunked sparse board header file.
+ *
+ * Cells of huge boards are kept in square chunks of SPARSE_CHUNK_SIDE
+ * cells, allocated when the first cell of the chunk is set and released
+ * when its last cell is cleared, so memory follows the occupied cells
+ * and not the board size. Rendering a rectangle costs one chunk lookup
+ * per chunk it crosses plus one copy per cell.
+ */
+#ifndef SRC_SNAKE_SPARSE_BOARD_H
+#define SRC_SNAKE_SPARSE_BOARD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include "s21_board.h"
+
+namespace s21 {
+
+#define SPARSE_CHUNK_SHIFT 5
+#define SPARSE_CHUNK_SIDE (1 << SPARSE_CHUNK_SHIFT)  ///< 32x32 cells
+
+/**
+ * @brief Board of cell codes (0 for empty cells) stored in chunks.
+ */
+class SparseBoard {
+ public:
+  explicit SparseBoard(DynamicBoard geometry) : geometry_(geometry) {}
+  ~SparseBoard();
+
+  SparseBoard(const SparseBoard& other) = delete;
+  SparseBoard& operator=(const SparseBoard& other) = delete;
+
+  const DynamicBoard& geometry() const { return geometry_; }
+
+  /**
+   * @brief Code of a cell, 0 outside of the board.
+   **/
+  int get(int row, int col) const;
+
+  /**
+   * @brief Sets a cell, 0 clears it. Cells outside are ignored.
+   **/
+  void set(int row, int col, int code);
+
+  /**
+   * @brief Clears the whole board and releases all chunks.
+   **/
+  void clear();
+
+  /**
+   * @brief Copies a rectangle of the board, row by row.
+   * Cells outside of the board are rendered as 0.
+   * @param top Row of the upper left corner, may be negative
+   * @param left Col of the upper left corner, may be negative
+   * @param rows Rectangle height
+   * @param cols Rectangle width
+   * @param out rows * cols codes
+   **/
+  void render(int top, int left, int rows, int cols, int* out) const;
+
+  size_t occupied() const { return occupied_; }  ///< Non-blank cells
+  size_t chunks() const { return chunks_.size(); }  ///< Allocated chunks
+
+ private:
+  struct Chunk {
+    uint8_t cells[SPARSE_CHUNK_SIDE * SPARSE_CHUNK_SIDE];
+    int occupied;
+  };
+
+  static uint64_t chunkKey(int row, int col) {
+    return (uint64_t)(uint32_t)(row >> SPARSE_CHUNK_SHIFT) << 32 |
+           (uint32_t)(col >> SPARSE_CHUNK_SHIFT);
+  }
+  static size_t cellIndex(int row, int col) {
+    return (size_t)(row & (SPARSE_CHUNK_SIDE - 1)) << SPARSE_CHUNK_SHIFT |
+           (size_t)(col & (SPARSE_CHUNK_SIDE - 1));
+  }
+  Chunk* find(uint64_t key) const;
+
+  DynamicBoard geometry_;
+  std::unordered_map<uint64_t, Chunk*> chunks_;
+  size_t occupied_{0};
+
+  /* Moves touch the same few chunks over and over */
+  mutable uint64_t lastKey_{~0ull};
+  mutable Chunk* lastChunk_{nullptr};
+};
+
+}  // namespace s21
+
+#endif  // SRC_SNAKE_SPARSE_BOARD_H
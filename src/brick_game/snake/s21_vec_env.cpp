@@ -0,0 +1,166 @@
+/**
+ * @file s21_vec_env.cpp
+ * @brief Vectorized snake environments source code.
+ */
+
+#include "s21_vec_env.h"
+
+#include <algorithm>
+#include <system_error>
+
+namespace s21 {
+
+VecEnv::VecEnv(int count, int threads) {
+  count = std::max(count, 1);
+  if (threads <= 0) {
+    threads = std::max((int)std::thread::hardware_concurrency(), 1);
+  }
+  chunks_ = (count + VEC_ENV_CHUNK - 1) / VEC_ENV_CHUNK;
+  threads = std::min(threads, chunks_);
+
+  for (int i = 0; i < count; ++i) {
+    games_.push_back(std::make_unique<Game>(false));
+  }
+  scores_.assign(count, 0);
+  shards_ = std::vector<Shard>(threads);
+  try {
+    for (int worker = 1; worker < threads; ++worker) {
+      threads_.emplace_back(&VecEnv::workerLoop, this, worker);
+    }
+  } catch (const std::system_error&) {
+    /* Jobs wait for every worker, so only the started ones may count */
+    std::lock_guard<std::mutex> guard(mutex_);
+    shards_ = std::vector<Shard>(threads_.size() + 1);
+  }
+  resetAll(nullptr, nullptr);
+}
+
+VecEnv::~VecEnv() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+void VecEnv::run() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    int count = (int)shards_.size();
+    for (int worker = 0; worker < count; ++worker) {
+      shards_[worker].next.store(chunks_ * worker / count,
+                                 std::memory_order_relaxed);
+      shards_[worker].end = chunks_ * (worker + 1) / count;
+    }
+    busy_ = (int)threads_.size();
+    ++generation_;
+  }
+  wake_.notify_all();
+  work(0);
+  std::unique_lock<std::mutex> lock(mutex_);
+  finished_.wait(lock, [this] { return busy_ == 0; });
+}
+
+void VecEnv::workerLoop(int worker) {
+  uint64_t seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+      if (stop_) {
+        return;
+      }
+      seen = generation_;
+    }
+    work(worker);
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (--busy_ == 0) {
+      finished_.notify_one();
+    }
+  }
+}
+
+void VecEnv::work(int worker) {
+  /* Own share first, then the leftovers of the others */
+  int count = (int)shards_.size();
+  for (int i = 0; i < count; ++i) {
+    Shard& shard = shards_[(worker + i) % count];
+    int chunk;
+    while ((chunk = shard.next.fetch_add(1, std::memory_order_relaxed)) <
+           shard.end) {
+      int begin = chunk * VEC_ENV_CHUNK;
+      int end = std::min(begin + VEC_ENV_CHUNK, getCount());
+      for (int env = begin; env < end; ++env) {
+        if (resetJob_) {
+          resetOne(env);
+        } else {
+          stepOne(env);
+        }
+      }
+    }
+  }
+}
+
+void VecEnv::start(Game& game) {
+  /* START or GAMEOVER -> SPAWN -> MOVING, as a player pressing Start */
+  UserAction_t action = Start;
+  game.processUserInput(action, false);
+  game.step(false);
+  game.step(false);
+}
+
+void VecEnv::resetOne(int env) {
+  games_[env] = std::make_unique<Game>(false);
+  Game& game = *games_[env];
+  game.seedRandom(seeds_ != nullptr ? seeds_[env] : (uint64_t)env + 1);
+  start(game);
+  scores_[env] = 0;
+  if (obs_ != nullptr) {
+    game.renderCells(obs_ + (size_t)env * rows * cols);
+  }
+}
+
+void VecEnv::stepOne(int env) {
+  Game& game = *games_[env];
+  UserAction_t action = (UserAction_t)actions_[env];
+  if (action != Left && action != Right && action != Up && action != Down) {
+    action = Action;
+  }
+  game.processUserInput(action, false);
+  game.step(true);
+  if (game.getStatus() == ATTACHING) {
+    game.step(false);
+  }
+
+  int score = game.gameInfo_.score;
+  reward_[env] = (float)(score - scores_[env]);
+  done_[env] = game.getStatus() == GAMEOVER;
+  if (done_[env]) {
+    start(game);
+    score = 0;
+  }
+  scores_[env] = score;
+  game.renderCells(obs_ + (size_t)env * rows * cols);
+}
+
+void VecEnv::resetAll(const uint64_t* seeds, uint8_t* obs) {
+  resetJob_ = true;
+  seeds_ = seeds;
+  obs_ = obs;
+  run();
+}
+
+void VecEnv::stepAll(const uint8_t* actions, uint8_t* obs, float* reward,
+                     uint8_t* done) {
+  resetJob_ = false;
+  actions_ = actions;
+  obs_ = obs;
+  reward_ = reward;
+  done_ = done;
+  run();
+}
+
+}  // namespace s21
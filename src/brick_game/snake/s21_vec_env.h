@@ -0,0 +1,115 @@
+/**
+ * @file s21_vec_env.h
+ * @brief Vectorized snake environments header file.
+ *
+ * VecEnv owns N headless classic games (Game(false)) and advances all of
+ * them together: one call applies one action per game, moves every snake
+ * by one cell and writes all fields into a single [N][rows][cols] byte
+ * buffer, one cell code per byte. Training loops and capacity models get
+ * a whole batch per call instead of N round trips.
+ *
+ * Games are split into chunks of VEC_ENV_CHUNK environments. Every worker
+ * of the pool (the calling thread included) starts on its own share of
+ * the chunks and, once done, steals chunks left in the shares of the
+ * others, so a slow share does not hold the batch back. A chunk is
+ * claimed with one atomic increment and games never move between
+ * threads within a call, so no locks are taken per game.
+ */
+#ifndef SRC_SNAKE_VEC_ENV_H
+#define SRC_SNAKE_VEC_ENV_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "s21_snake.h"
+
+namespace s21 {
+
+#define VEC_ENV_CHUNK 16  ///< Environments claimed at once by a worker
+
+/**
+ * @brief Batch of headless snake games.
+ */
+class VecEnv {
+ public:
+  static constexpr int rows = Game::fieldYSize;
+  static constexpr int cols = Game::fieldXSize;
+
+  /**
+   * @param count Number of environments, at least one
+   * @param threads Worker threads, the calling one included; 0 or less
+   * uses every core
+   **/
+  VecEnv(int count, int threads);
+  ~VecEnv();
+
+  VecEnv(const VecEnv& other) = delete;
+  VecEnv& operator=(const VecEnv& other) = delete;
+
+  /**
+   * @brief Starts a new game in every environment.
+   * @param seeds count PRNG seeds (food placement), nullptr seeds
+   * environment i with i + 1
+   * @param obs Output [count][rows][cols] cell codes, may be nullptr
+   **/
+  void resetAll(const uint64_t* seeds, uint8_t* obs);
+
+  /**
+   * @brief Advances every environment by one tick. A finished game is
+   * restarted right away (its PRNG goes on), so obs holds the first
+   * field of the new game and done marks the restart.
+   * @param actions count actions (UserAction_t), only arrows turn the
+   * snake, anything else keeps it going
+   * @param obs Output [count][rows][cols] cell codes
+   * @param reward Output, food eaten during the tick
+   * @param done Output, 1 if the game ended during the tick
+   **/
+  void stepAll(const uint8_t* actions, uint8_t* obs, float* reward,
+               uint8_t* done);
+
+  int getCount() const { return (int)games_.size(); }
+  int getThreads() const { return (int)shards_.size(); }
+
+ private:
+  struct alignas(64) Shard {
+    std::atomic<int> next{0};  ///< Next chunk to claim
+    int end{0};
+  };
+
+  void run();  ///< Runs the current job on the pool and waits for it
+  void work(int worker);
+  void workerLoop(int worker);
+  void resetOne(int env);
+  void stepOne(int env);
+  static void start(Game& game);
+
+  std::vector<std::unique_ptr<Game>> games_;
+  std::vector<int> scores_;  ///< Score after the previous tick
+  int chunks_{0};
+
+  std::vector<Shard> shards_;
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable finished_;
+  uint64_t generation_{0};
+  int busy_{0};
+  bool stop_{false};
+
+  /* Current job */
+  bool resetJob_{false};
+  const uint64_t* seeds_{nullptr};
+  const uint8_t* actions_{nullptr};
+  uint8_t* obs_{nullptr};
+  float* reward_{nullptr};
+  uint8_t* done_{nullptr};
+};
+
+}  // namespace s21
+
+#endif  // SRC_SNAKE_VEC_ENV_H
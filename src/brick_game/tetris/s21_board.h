@@ -0,0 +1,53 @@
+/**
+ * @file s21_board.h
+ * @brief Board geometry header file.
+ *
+ * The tetris board size is fixed at compile time (build with
+ * -DBOARD_ROWS=... -DBOARD_COLS=... for another board that still fits a
+ * frame ring slot, 20x10 at most), so bound checks and field loops work on
+ * constants. BoardGeometry carries sizes known at run time only, e.g. the
+ * ones read from a frame ring of another engine.
+ */
+#ifndef S21_BOARD_H
+#define S21_BOARD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef BOARD_ROWS
+#define BOARD_ROWS 20
+#endif
+#ifndef BOARD_COLS
+#define BOARD_COLS 10
+#endif
+#define BOARD_CELLS (BOARD_ROWS * BOARD_COLS)
+
+_Static_assert(BOARD_ROWS > 0 && BOARD_COLS > 0, "Board must have cells");
+
+/**
+ * @brief Checks that a cell lies on the compile-time board.
+ **/
+static inline bool board_contains(int row, int col) {
+  return (unsigned)row < BOARD_ROWS && (unsigned)col < BOARD_COLS;
+}
+
+/**
+ * @brief Run-time sized board.
+ **/
+typedef struct {
+  int rows;
+  int cols;
+} BoardGeometry;
+
+static inline bool board_geometry_contains(BoardGeometry board, int row,
+                                           int col) {
+  return (unsigned)row < (unsigned)board.rows &&
+         (unsigned)col < (unsigned)board.cols;
+}
+
+static inline size_t board_geometry_index(BoardGeometry board, int row,
+                                          int col) {
+  return (size_t)row * board.cols + col;
+}
+
+#endif
@@ -4,10 +4,14 @@
  */
 #include "s21_controller.h"
 
-GameStatus_t getGameStatus() { return *get_status_instance(); }
+GameStatus_t getGameStatus() { return current_game_status(); }
 
 GameInfo_t updateScene() { return updateCurrentState(); }
 
+int getFieldRows(void) { return ROWS_FIELD; }
+
+int getFieldCols(void) { return COLS_FIELD; }
+
 void processUserAction(UserAction_t action, bool hold) {
   userInput(action, hold);
 }
@@ -24,3 +28,86 @@ void freeGameInfo(GameInfo_t game_info) {
   }
   free(game_info.next);
 }
+
+bool exportFrames(const char* name) { return export_frames(name); }
+
+void stopFrameExport() { stop_frame_export(); }
+
+void setSessionPoolSize(int size) { set_session_pool_size(size); }
+
+void setHibernationTimeout(int milliseconds) {
+  set_hibernation_timeout(milliseconds);
+}
+
+int snapshotGame(uint8_t* buffer, int capacity) {
+  return snapshot_game(buffer, capacity);
+}
+
+bool restoreGame(const uint8_t* buffer, int length) {
+  return restore_game(buffer, length);
+}
+
+void setJournalDirectory(const char* directory) {
+  set_journal_directory(directory);
+}
+
+int replayJournal(const char* path, uint8_t* buffer, int capacity) {
+  return replay_journal(path, buffer, capacity);
+}
+
+ReplayPlayer* replayOpen(const char* path) { return replay_open(path); }
+
+bool replaySeek(ReplayPlayer* player, uint64_t step) {
+  return replay_seek(player, step);
+}
+
+bool replayStep(ReplayPlayer* player) { return replay_step(player); }
+
+uint64_t replayPosition(ReplayPlayer* player) { return player->step; }
+
+uint64_t replayLength(ReplayPlayer* player) { return player->reader.steps; }
+
+int replaySnapshot(ReplayPlayer* player, uint8_t* buffer, int capacity) {
+  return replay_snapshot(player, buffer, capacity);
+}
+
+void replayClose(ReplayPlayer* player) { replay_close(player); }
+
+void setRewindBudget(int budget) { set_rewind_budget(budget); }
+
+bool rewindWindow(uint64_t* first, uint64_t* last) {
+  return rewind_game_window(first, last);
+}
+
+int rewindSnapshot(uint64_t step, uint8_t* buffer, int capacity) {
+  return rewind_snapshot(step, buffer, capacity);
+}
+
+bool openLeaderboard(const char* path) { return open_leaderboard(path); }
+
+void setPlayerName(const char* name) { set_player_name(name); }
+
+int leaderboardBest(void) { return leaderboard_game_best(); }
+
+int leaderboardRank(int score) { return leaderboard_game_rank(score); }
+
+int leaderboardTop(int count, int* scores, char* players) {
+  return leaderboard_game_top(count, scores, players);
+}
+
+int leaderboardPlayerBest(void) { return leaderboard_player_game_best(); }
+
+VecEnv* vecEnvCreate(int count, int threads) {
+  return vec_env_create(count, threads);
+}
+
+void vecEnvResetAll(VecEnv* env, const uint64_t* seeds, uint8_t* obs) {
+  vec_env_reset_all(env, seeds, obs);
+}
+
+void vecEnvStepAll(VecEnv* env, const uint8_t* actions, uint8_t* obs,
+                   float* reward, uint8_t* done) {
+  vec_env_step_all(env, actions, obs, reward, done);
+}
+
+void vecEnvDestroy(VecEnv* env) { vec_env_destroy(env); }
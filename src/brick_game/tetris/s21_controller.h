@@ -6,6 +6,7 @@
 #define SRC_TETRIS_CONTROLLER_H
 
 #include "s21_tetris.h"
+#include "s21_vec_env.h"
 
 /**
  * @brief Gets current model(game) status.
@@ -19,6 +20,16 @@ GameStatus_t getGameStatus();
  **/
 GameInfo_t updateScene();
 
+/**
+ * @brief Rows of the field returned by updateScene().
+ **/
+int getFieldRows(void);
+
+/**
+ * @brief Columns of the field returned by updateScene().
+ **/
+int getFieldCols(void);
+
 /**
  * @brief Sends user action to model.
  * @param action User action.
@@ -38,4 +49,211 @@ void initializeGame();
  **/
 void freeGameInfo(GameInfo_t game_info);
 
+/**
+ * @brief Starts exporting frames into a shared-memory ring.
+ * Other processes may map the ring by name and read frames without syscalls.
+ * @param name POSIX shm name, e.g. "/s21_tetris_frames".
+ * @return true on success.
+ **/
+bool exportFrames(const char* name);
+
+/**
+ * @brief Stops exporting frames and unlinks the ring.
+ **/
+void stopFrameExport();
+
+/**
+ * @brief Sets how many parked sessions are kept ready for initializeGame().
+ * Pooled sessions keep their threads alive, so starting a game only wakes
+ * them up. Size 0 disables pooling.
+ * @param size Pool capacity.
+ **/
+void setSessionPoolSize(int size);
+
+/**
+ * @brief Sets idle timeout after which a session in START, PAUSE or
+ * GAMEOVER is hibernated into a compact snapshot. The session is revived
+ * transparently by the next user action, reads are served from the snapshot.
+ * @param milliseconds Idle timeout, 0 disables hibernation.
+ **/
+void setHibernationTimeout(int milliseconds);
+
+/**
+ * @brief Takes a binary snapshot of the current game: field, falling and
+ * next figures, PRNG state, timer, score and FSM status. The format is
+ * versioned and little-endian, see s21_snapshot.h. SNAPSHOT_MAX_SIZE bytes
+ * are always enough.
+ * @param buffer Output buffer.
+ * @param capacity Buffer size.
+ * @return Snapshot size, 0 if no game is running. Nothing is copied if
+ * the size is larger than capacity.
+ **/
+int snapshotGame(uint8_t* buffer, int capacity);
+
+/**
+ * @brief Restores the game from a binary snapshot. Starts a new game if
+ * none is running.
+ * @param buffer Snapshot produced by snapshotGame().
+ * @param length Snapshot size.
+ * @return true on success, the game is untouched otherwise.
+ **/
+bool restoreGame(const uint8_t* buffer, int length);
+
+/**
+ * @brief Enables replay journals: every session appends its starting
+ * snapshot and varint-encoded (step delta, action, hold) records into
+ * its own file in the directory, see s21_journal.h.
+ * @param directory Existing directory, NULL or "" disables journaling.
+ **/
+void setJournalDirectory(const char* directory);
+
+/**
+ * @brief Replays a journal on a headless session.
+ * @param path Journal file.
+ * @param buffer Output buffer for the snapshot of the replayed game.
+ * @param capacity Buffer size.
+ * @return Snapshot size, 0 if the journal is malformed. Nothing is copied
+ * if the size is larger than capacity.
+ **/
+int replayJournal(const char* path, uint8_t* buffer, int capacity);
+
+/**
+ * @brief Opens a journal for playback. Journals carry keyframes every
+ * JOURNAL_KEYFRAME_INTERVAL steps and a keyframe index, so seeking to any
+ * step restores the nearest keyframe and plays only the rest.
+ * @param path Journal file.
+ * @return Player at step 0, NULL if the file is not a tetris journal.
+ **/
+ReplayPlayer* replayOpen(const char* path);
+
+/**
+ * @brief Moves the player to the state after the given number of steps.
+ * @return false if the journal ends before the step.
+ **/
+bool replaySeek(ReplayPlayer* player, uint64_t step);
+
+/**
+ * @brief Plays one FSM step.
+ * @return false at the end of the journal.
+ **/
+bool replayStep(ReplayPlayer* player);
+
+/**
+ * @brief Steps played so far.
+ **/
+uint64_t replayPosition(ReplayPlayer* player);
+
+/**
+ * @brief Number of steps in the journal.
+ **/
+uint64_t replayLength(ReplayPlayer* player);
+
+/**
+ * @brief Takes a binary snapshot of the game at the current position.
+ * @return Snapshot size. Nothing is copied if the size is larger than
+ * capacity.
+ **/
+int replaySnapshot(ReplayPlayer* player, uint8_t* buffer, int capacity);
+
+/**
+ * @brief Closes the player.
+ **/
+void replayClose(ReplayPlayer* player);
+
+/**
+ * @brief Enables the rewind buffer: every session keeps its last steps in
+ * memory as snapshots and tiny step records, see s21_rewind.h.
+ * @param budget Memory budget per session in bytes (REWIND_DEFAULT_BUDGET
+ * is a sensible value), 0 disables rewinding.
+ **/
+void setRewindBudget(int budget);
+
+/**
+ * @brief Steps of the current session that can be rebuilt.
+ * @param first Oldest step in the window.
+ * @param last Latest step.
+ * @return false if rewinding is disabled or no game is running.
+ **/
+bool rewindWindow(uint64_t* first, uint64_t* last);
+
+/**
+ * @brief Rebuilds the current session at a step of the rewind window.
+ * @param step Step between first and last.
+ * @param buffer Output buffer for the snapshot.
+ * @param capacity Buffer size.
+ * @return Snapshot size, 0 if the step is outside of the window. Nothing
+ * is copied if the size is larger than capacity.
+ **/
+int rewindSnapshot(uint64_t step, uint8_t* buffer, int capacity);
+
+/**
+ * @brief Maps the leaderboard store shared by all sessions and processes,
+ * see s21_leaderboard.h. Final scores are posted there at game over.
+ * @param path Store file, created if missing. NULL or "" detaches it.
+ * @return false if the store cannot be mapped.
+ **/
+bool openLeaderboard(const char* path);
+
+/**
+ * @brief Sets the name the following sessions post their scores under.
+ **/
+void setPlayerName(const char* name);
+
+/**
+ * @brief Best tetris score of the leaderboard, 0 if none is open.
+ **/
+int leaderboardBest(void);
+
+/**
+ * @brief Rank a tetris score would have on the leaderboard.
+ * @return 1 for the best score, 0 if no leaderboard is open.
+ **/
+int leaderboardRank(int score);
+
+/**
+ * @brief Best tetris scores of the leaderboard, highest first.
+ * @param count Entries wanted.
+ * @param scores Output scores, count elements.
+ * @param players Output zero-padded player names, count *
+ * LEADERBOARD_PLAYER_SIZE bytes. May be NULL.
+ * @return Number of entries written.
+ **/
+int leaderboardTop(int count, int* scores, char* players);
+
+/**
+ * @brief Best tetris score of the current player on the leaderboard.
+ **/
+int leaderboardPlayerBest(void);
+
+/**
+ * @brief Creates a batch of headless sessions, see s21_vec_env.h. Every
+ * session starts with seed i + 1.
+ * @param count Number of sessions.
+ * @param threads Worker threads, 0 uses every core.
+ * @return New batch, NULL on failure.
+ **/
+VecEnv* vecEnvCreate(int count, int threads);
+
+/**
+ * @brief Starts a new game in every session.
+ * @param seeds count seeds, NULL for 1..count.
+ * @param obs Output count * rows * cols cells, may be NULL.
+ **/
+void vecEnvResetAll(VecEnv* env, const uint64_t* seeds, uint8_t* obs);
+
+/**
+ * @brief Advances every session by one tick, finished games restart.
+ * @param actions count actions (UserAction_t values).
+ * @param obs Output count * rows * cols cells.
+ * @param reward Output count rewards (points scored).
+ * @param done Output count flags, 1 if the game ended.
+ **/
+void vecEnvStepAll(VecEnv* env, const uint8_t* actions, uint8_t* obs,
+                   float* reward, uint8_t* done);
+
+/**
+ * @brief Destroys a batch and stops its workers.
+ **/
+void vecEnvDestroy(VecEnv* env);
+
 #endif
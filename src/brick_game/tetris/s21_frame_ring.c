@@ -0,0 +1,184 @@
+/**
+ * @file s21_frame_ring.c
+ * @brief Shared-memory frame ring source code.
+ */
+
+// Needs for memfd_create()
+#define _GNU_SOURCE
+
+#include "s21_frame_ring.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static bool frame_ring_map(FrameRing* ring, size_t size, bool writable) {
+  int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+  void* memory = mmap(NULL, size, protection, MAP_SHARED, ring->fd, 0);
+  if (memory == MAP_FAILED) {
+    return false;
+  }
+  ring->mapping_size = size;
+  ring->header = (FrameRingHeader*)memory;
+  ring->slots = (FrameSlot*)((char*)memory + sizeof(FrameRingHeader));
+  return true;
+}
+
+static FrameRing* frame_ring_new(int fd, const char* name, bool owner) {
+  FrameRing* ring = (FrameRing*)calloc(1, sizeof(FrameRing));
+  if (ring != NULL) {
+    ring->fd = fd;
+    ring->owner = owner;
+    if (name != NULL) {
+      strncpy(ring->name, name, FRAME_RING_NAME_SIZE - 1);
+    }
+  } else {
+    close(fd);
+  }
+  return ring;
+}
+
+FrameRing* frame_ring_create(const char* name, uint32_t slot_count) {
+  if (slot_count == 0 ||
+      (name != NULL && strlen(name) >= FRAME_RING_NAME_SIZE)) {
+    return NULL;
+  }
+
+  int fd = -1;
+  if (name == NULL || name[0] == '\0') {
+    fd = memfd_create("s21_tetris_frames", MFD_CLOEXEC);
+  } else {
+    /* Readers may still map a stale object under this name: replace it
+     * instead of truncating it under them */
+    shm_unlink(name);
+    fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+  }
+  if (fd < 0) {
+    return NULL;
+  }
+
+  FrameRing* ring = frame_ring_new(fd, name, true);
+  if (ring == NULL) {
+    return NULL;
+  }
+
+  size_t size = sizeof(FrameRingHeader) + sizeof(FrameSlot) * slot_count;
+  if (ftruncate(fd, size) != 0 || !frame_ring_map(ring, size, true)) {
+    frame_ring_destroy(ring);
+    return NULL;
+  }
+
+  /* ftruncate() zero-fills the mapping, so every sequence starts at 0 */
+  ring->header->version = FRAME_RING_VERSION;
+  ring->header->slot_size = sizeof(FrameSlot);
+  ring->header->rows = FRAME_RING_ROWS;
+  ring->header->cols = FRAME_RING_COLS;
+  ring->header->slot_count = slot_count;
+  atomic_store_explicit(&ring->header->write_index, 0, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  ring->header->magic = FRAME_RING_MAGIC;
+  return ring;
+}
+
+FrameRing* frame_ring_attach(const char* name) {
+  if (name == NULL || strlen(name) >= FRAME_RING_NAME_SIZE) {
+    return NULL;
+  }
+
+  int fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  FrameRing* ring = frame_ring_new(fd, name, false);
+  if (ring == NULL) {
+    return NULL;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      (size_t)info.st_size < sizeof(FrameRingHeader) ||
+      !frame_ring_map(ring, info.st_size, false) ||
+      ring->header->magic != FRAME_RING_MAGIC ||
+      ring->header->version != FRAME_RING_VERSION ||
+      ring->header->slot_size != sizeof(FrameSlot) ||
+      sizeof(FrameRingHeader) +
+              (size_t)ring->header->slot_count * sizeof(FrameSlot) >
+          ring->mapping_size) {
+    frame_ring_destroy(ring);
+    return NULL;
+  }
+  return ring;
+}
+
+void frame_ring_destroy(FrameRing* ring) {
+  if (ring == NULL) return;
+  if (ring->header != NULL) {
+    munmap(ring->header, ring->mapping_size);
+  }
+  if (ring->fd >= 0) {
+    close(ring->fd);
+  }
+  if (ring->owner && ring->name[0] != '\0') {
+    shm_unlink(ring->name);
+  }
+  free(ring);
+}
+
+void frame_ring_publish(FrameRing* ring, Frame* frame) {
+  uint64_t index =
+      atomic_load_explicit(&ring->header->write_index, memory_order_relaxed);
+  FrameSlot* slot = &ring->slots[index % ring->header->slot_count];
+  uint32_t sequence =
+      atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+
+  frame->generation = index + 1;
+  atomic_store_explicit(&slot->sequence, sequence + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  memcpy(&slot->frame, frame, sizeof(Frame));
+  atomic_store_explicit(&slot->sequence, sequence + 2, memory_order_release);
+  atomic_store_explicit(&ring->header->write_index, index + 1,
+                        memory_order_release);
+}
+
+bool frame_ring_read_latest(const FrameRing* ring, Frame* out) {
+  uint64_t published = atomic_load_explicit(
+      (_Atomic uint64_t*)&ring->header->write_index, memory_order_acquire);
+  bool result = false;
+  while (published != 0 && !result) {
+    result = frame_ring_read(ring, published, out);
+    if (!result) {
+      published = atomic_load_explicit(
+          (_Atomic uint64_t*)&ring->header->write_index, memory_order_acquire);
+    }
+  }
+  return result;
+}
+
+bool frame_ring_read(const FrameRing* ring, uint64_t generation, Frame* out) {
+  uint64_t published = atomic_load_explicit(
+      (_Atomic uint64_t*)&ring->header->write_index, memory_order_acquire);
+  if (generation == 0 || generation > published ||
+      published - generation >= ring->header->slot_count) {
+    return false;
+  }
+
+  FrameSlot* slot = &ring->slots[(generation - 1) % ring->header->slot_count];
+  for (;;) {
+    uint32_t before =
+        atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    if (before & 1u) {
+      continue;
+    }
+    memcpy(out, &slot->frame, sizeof(Frame));
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&slot->sequence, memory_order_relaxed) ==
+        before) {
+      break;
+    }
+  }
+  return out->generation == generation;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file s21_frame_ring.h
+ * @brief Shared-memory frame ring header file.
+ *
+ * Ring layout (shared with the snake library, little-endian host order):
+ *   [FrameRingHeader, 64 bytes][FrameSlot * slot_count, 264 bytes each]
+ * Every slot is guarded by its own seqlock: the sequence is odd while the
+ * writer is filling the slot and even once the frame is complete.
+ */
+#ifndef S21_FRAME_RING_H
+#define S21_FRAME_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FRAME_RING_MAGIC 0x52464742u /* "BGFR" */
+#define FRAME_RING_VERSION 2
+#define FRAME_RING_ROWS 20 /* Field capacity of a frame */
+#define FRAME_RING_COLS 10
+#define FRAME_RING_DEFAULT_SLOTS 64
+#define FRAME_RING_NAME_SIZE 64
+
+/**
+ * @brief Single exported frame.
+ *
+ * @param generation Monotonic frame number inside the ring
+ * @param status Game status (GameStatus_t value)
+ * @param rows Rows of the board, the first rows of field are used
+ * @param cols Columns of the board, the first cols of every row are used
+ * @param field Rendered game field (with the falling figure), byte per cell
+ * @param next Next figure
+ **/
+typedef struct {
+  uint64_t generation;
+  int32_t status;
+  int32_t score;
+  int32_t high_score;
+  int32_t level;
+  int32_t speed;
+  int32_t pause;
+  uint16_t rows;
+  uint16_t cols;
+  uint32_t reserved;
+  uint8_t field[FRAME_RING_ROWS][FRAME_RING_COLS];
+  uint8_t next[4][4];
+} Frame;
+
+/**
+ * @brief Frame slot guarded by a seqlock.
+ **/
+typedef struct {
+  _Atomic uint32_t sequence;
+  uint32_t reserved;
+  Frame frame;
+} FrameSlot;
+
+/**
+ * @brief Ring header placed at the beginning of the mapping.
+ **/
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t slot_size;
+  uint16_t rows;
+  uint16_t cols;
+  uint32_t slot_count;
+  _Atomic uint64_t write_index; /* Number of published frames */
+  uint8_t reserved[40];
+} FrameRingHeader;
+
+_Static_assert(sizeof(FrameSlot) == 264, "Frame slot ABI changed");
+_Static_assert(sizeof(FrameRingHeader) == 64, "Frame ring header ABI changed");
+
+/**
+ * @brief Process-local handle of a mapped ring.
+ **/
+typedef struct {
+  int fd;
+  size_t mapping_size;
+  bool owner;
+  char name[FRAME_RING_NAME_SIZE];
+  FrameRingHeader* header;
+  FrameSlot* slots;
+} FrameRing;
+
+/**
+ * @brief Creates a writable ring.
+ * @param name POSIX shm name ("/tetris_frames"), memfd is used if NULL or ""
+ * @param slot_count Number of frame slots
+ * @return New ring or NULL on failure
+ **/
+FrameRing* frame_ring_create(const char* name, uint32_t slot_count);
+
+/**
+ * @brief Maps an existing ring read-only.
+ * @param name POSIX shm name used by the writer
+ * @return Ring or NULL on failure
+ **/
+FrameRing* frame_ring_attach(const char* name);
+
+/**
+ * @brief Unmaps the ring. The owner also unlinks the shm name.
+ * @param ring Ring to destroy
+ **/
+void frame_ring_destroy(FrameRing* ring);
+
+/**
+ * @brief Publishes a frame into the next slot (writer only).
+ * Generation of the frame is assigned by the ring.
+ * @param ring Writable ring
+ * @param frame Frame to publish
+ **/
+void frame_ring_publish(FrameRing* ring, Frame* frame);
+
+/**
+ * @brief Copies the most recent complete frame.
+ * @return false if nothing was published yet
+ **/
+bool frame_ring_read_latest(const FrameRing* ring, Frame* out);
+
+/**
+ * @brief Copies frame with given generation if it is still in the ring.
+ * @return false if the frame was overwritten or not yet published
+ **/
+bool frame_ring_read(const FrameRing* ring, uint64_t generation, Frame* out);
+
+#endif  // S21_FRAME_RING_H
@@ -0,0 +1,469 @@
+/**
+ * @file s21_journal.c
+ * @brief Replay journal source code.
+ */
+
+#define _XOPEN_SOURCE 600
+
+#include "s21_journal.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Background thread writing journals of all sessions.
+ **/
+typedef struct {
+  pthread_mutex_t mutex;       /* Guards the list, never held while writing */
+  pthread_mutex_t write_mutex; /* Held while journals are written */
+  pthread_cond_t cond;
+  Journal* head;
+  bool started;
+  bool pending;
+} JournalFlusher;
+
+static JournalFlusher* get_journal_flusher(void) {
+  static JournalFlusher flusher = {
+      PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+      PTHREAD_COND_INITIALIZER, NULL, false, false};
+  return &flusher;
+}
+
+static void put_le(uint8_t* cursor, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; ++i) {
+    cursor[i] = value >> (8 * i) & 0xff;
+  }
+}
+
+static uint64_t get_le(const uint8_t* cursor, int bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; ++i) {
+    value |= (uint64_t)cursor[i] << (8 * i);
+  }
+  return value;
+}
+
+/* Buffer is guarded by the journal mutex */
+static bool journal_reserve(Journal* journal, size_t extra) {
+  if (journal->size + extra <= journal->capacity) {
+    return true;
+  }
+  size_t capacity = journal->capacity * 2;
+  if (capacity < journal->size + extra) {
+    capacity = journal->size + extra;
+  }
+  uint8_t* buffer = (uint8_t*)realloc(journal->buffer, capacity);
+  if (buffer == NULL) {
+    return false;
+  }
+  journal->buffer = buffer;
+  journal->capacity = capacity;
+  return true;
+}
+
+/* Writes buffered records, returns true once the journal is closed and
+   flushed. Called by the flusher with its write mutex held. */
+static bool journal_flush(Journal* journal) {
+  pthread_mutex_lock(&journal->mutex);
+  uint8_t* buffer = journal->buffer;
+  size_t size = journal->size;
+  size_t capacity = journal->capacity;
+  journal->buffer = journal->spare;
+  journal->capacity = journal->spare_capacity;
+  journal->size = 0;
+  bool closed = journal->closed;
+  pthread_mutex_unlock(&journal->mutex);
+
+  /* Only the flusher touches the file, the game thread keeps appending */
+  if (size != 0) {
+    fwrite(buffer, 1, size, journal->file);
+    fflush(journal->file);
+  }
+  journal->spare = buffer;
+  journal->spare_capacity = capacity;
+  return closed;
+}
+
+static void journal_free(Journal* journal) {
+  fclose(journal->file);
+  pthread_mutex_destroy(&journal->mutex);
+  free(journal->buffer);
+  free(journal->spare);
+  free(journal->keyframes);
+  free(journal);
+}
+
+/* Game threads only push journals in front of the head, and only the
+   holder of the write mutex unlinks them, so the list is walked unlocked
+   and the game threads never wait for the disk */
+static void journal_flush_all(void) {
+  JournalFlusher* flusher = get_journal_flusher();
+  pthread_mutex_lock(&flusher->mutex);
+  Journal* journal = flusher->head;
+  pthread_mutex_unlock(&flusher->mutex);
+  while (journal != NULL) {
+    Journal* next = journal->next;
+    if (journal_flush(journal)) {
+      pthread_mutex_lock(&flusher->mutex);
+      Journal** link = &flusher->head;
+      while (*link != journal) {
+        link = &(*link)->next;
+      }
+      *link = next;
+      pthread_mutex_unlock(&flusher->mutex);
+      journal_free(journal);
+    }
+    journal = next;
+  }
+}
+
+static void* journal_flusher_thread(void* arg) {
+  (void)arg;
+  JournalFlusher* flusher = get_journal_flusher();
+
+  pthread_mutex_lock(&flusher->mutex);
+  while (true) {
+    if (!flusher->pending) {
+      struct timespec deadline;
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_nsec += 100 * 1000000L;
+      deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+      deadline.tv_nsec %= 1000000000L;
+      pthread_cond_timedwait(&flusher->cond, &flusher->mutex, &deadline);
+    }
+    flusher->pending = false;
+    pthread_mutex_unlock(&flusher->mutex);
+    pthread_mutex_lock(&flusher->write_mutex);
+    journal_flush_all();
+    pthread_mutex_unlock(&flusher->write_mutex);
+    pthread_mutex_lock(&flusher->mutex);
+  }
+  pthread_mutex_unlock(&flusher->mutex);
+  return NULL;
+}
+
+/* Registered with atexit(), so no buffered record is lost on exit. Open
+   journals are not freed, game threads may still append to them. */
+static void journal_flusher_exit(void) {
+  JournalFlusher* flusher = get_journal_flusher();
+  pthread_mutex_lock(&flusher->write_mutex);
+  journal_flush_all();
+  pthread_mutex_unlock(&flusher->write_mutex);
+}
+
+static void journal_flusher_wake(void) {
+  JournalFlusher* flusher = get_journal_flusher();
+  pthread_mutex_lock(&flusher->mutex);
+  flusher->pending = true;
+  pthread_cond_signal(&flusher->cond);
+  pthread_mutex_unlock(&flusher->mutex);
+}
+
+Journal* journal_open(const char* path, uint8_t engine, uint64_t seed,
+                      const uint8_t* state, size_t state_size) {
+  if (state_size > UINT16_MAX) {
+    return NULL;
+  }
+  Journal* journal = (Journal*)calloc(1, sizeof(Journal));
+  if (journal == NULL) {
+    return NULL;
+  }
+  journal->file = fopen(path, "wb");
+  if (journal->file == NULL ||
+      !journal_reserve(journal, JOURNAL_FLUSH_THRESHOLD)) {
+    if (journal->file != NULL) fclose(journal->file);
+    free(journal->buffer);
+    free(journal);
+    return NULL;
+  }
+  pthread_mutex_init(&journal->mutex, NULL);
+
+  uint8_t* header = journal->buffer;
+  put_le(header, JOURNAL_MAGIC, 4);
+  put_le(header + 4, JOURNAL_VERSION, 2);
+  header[6] = engine;
+  header[7] = 0;
+  put_le(header + 8, seed, 8);
+  put_le(header + 16, state_size, 2);
+  journal->size = JOURNAL_HEADER_SIZE;
+  if (journal_reserve(journal, state_size)) {
+    memcpy(journal->buffer + journal->size, state, state_size);
+    journal->size += state_size;
+  }
+  journal->offset = journal->size;
+
+  JournalFlusher* flusher = get_journal_flusher();
+  pthread_mutex_lock(&flusher->mutex);
+  if (!flusher->started) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, journal_flusher_thread, NULL) == 0) {
+      pthread_detach(thread);
+      atexit(journal_flusher_exit);
+      flusher->started = true;
+    }
+  }
+  journal->next = flusher->head;
+  flusher->head = journal;
+  pthread_mutex_unlock(&flusher->mutex);
+  return journal;
+}
+
+static void journal_append(Journal* journal, uint8_t flags,
+                           const uint8_t* state, size_t state_size) {
+  uint64_t delta = journal->step - journal->entry_step;
+  journal->entry_step = journal->step;
+
+  pthread_mutex_lock(&journal->mutex);
+  size_t size = journal->size;
+  /* Varint takes at most 10 bytes for a 64-bit delta */
+  if (journal_reserve(journal, 13 + state_size)) {
+    do {
+      uint8_t byte = delta & 0x7f;
+      delta >>= 7;
+      journal->buffer[journal->size++] = delta != 0 ? byte | 0x80 : byte;
+    } while (delta != 0);
+    journal->buffer[journal->size++] = flags;
+    if (state != NULL) {
+      put_le(journal->buffer + journal->size, state_size, 2);
+      memcpy(journal->buffer + journal->size + 2, state, state_size);
+      journal->size += 2 + state_size;
+    }
+  }
+  journal->offset += journal->size - size;
+  bool full = journal->size >= JOURNAL_FLUSH_THRESHOLD;
+  pthread_mutex_unlock(&journal->mutex);
+
+  if (full) {
+    journal_flusher_wake();
+  }
+}
+
+void journal_step(Journal* journal, uint8_t flags) {
+  journal->step++;
+  if ((flags & (JOURNAL_INPUT | JOURNAL_TICK)) != 0) {
+    journal_append(journal, flags, NULL, 0);
+  }
+}
+
+bool journal_keyframe_due(const Journal* journal) {
+  return journal->step - journal->keyframe_step >= JOURNAL_KEYFRAME_INTERVAL;
+}
+
+void journal_keyframe(Journal* journal, const uint8_t* state,
+                      size_t state_size) {
+  if (journal->keyframe_count == journal->keyframe_capacity) {
+    size_t capacity =
+        journal->keyframe_capacity != 0 ? journal->keyframe_capacity * 2 : 16;
+    JournalKeyframe* keyframes = (JournalKeyframe*)realloc(
+        journal->keyframes, capacity * sizeof(JournalKeyframe));
+    if (keyframes == NULL) {
+      return;
+    }
+    journal->keyframes = keyframes;
+    journal->keyframe_capacity = capacity;
+  }
+  JournalKeyframe* keyframe = &journal->keyframes[journal->keyframe_count++];
+  keyframe->step = journal->step;
+  keyframe->offset = journal->offset;
+  journal->keyframe_step = journal->step;
+  journal_append(journal, JOURNAL_KEYFRAME, state, state_size);
+}
+
+void journal_close(Journal* journal) {
+  if (journal == NULL) return;
+  if (journal->step != journal->entry_step) {
+    journal_append(journal, 0, NULL, 0);
+  }
+  pthread_mutex_lock(&journal->mutex);
+  size_t footer_size = 2 + 8 + 4 + journal->keyframe_count * 16 + 8 + 4;
+  if (journal_reserve(journal, footer_size)) {
+    uint8_t* cursor = journal->buffer + journal->size;
+    cursor[0] = 0;
+    cursor[1] = JOURNAL_INDEX;
+    put_le(cursor + 2, journal->step, 8);
+    put_le(cursor + 10, journal->keyframe_count, 4);
+    cursor += 14;
+    for (size_t i = 0; i < journal->keyframe_count; ++i, cursor += 16) {
+      put_le(cursor, journal->keyframes[i].step, 8);
+      put_le(cursor + 8, journal->keyframes[i].offset, 8);
+    }
+    put_le(cursor, journal->offset, 8);
+    put_le(cursor + 8, JOURNAL_INDEX_MAGIC, 4);
+    journal->size += footer_size;
+  }
+  journal->closed = true;
+  pthread_mutex_unlock(&journal->mutex);
+  journal_flusher_wake();
+}
+
+size_t journal_reader_first_entry(const JournalReader* reader) {
+  return JOURNAL_HEADER_SIZE + reader->state_size;
+}
+
+static bool journal_reader_load_index(JournalReader* reader) {
+  const size_t footer_size = 2 + 8 + 4;
+  const size_t first = journal_reader_first_entry(reader);
+  if (reader->size < first + footer_size + JOURNAL_TRAILER_SIZE) {
+    return false;
+  }
+  const uint8_t* trailer = reader->data + reader->size - JOURNAL_TRAILER_SIZE;
+  uint64_t footer = get_le(trailer, 8);
+  if (get_le(trailer + 8, 4) != JOURNAL_INDEX_MAGIC || footer < first ||
+      footer + footer_size > reader->size - JOURNAL_TRAILER_SIZE) {
+    return false;
+  }
+
+  const uint8_t* index = reader->data + footer;
+  if (index[0] != 0 || index[1] != JOURNAL_INDEX) {
+    return false;
+  }
+  uint64_t steps = get_le(index + 2, 8);
+  uint64_t count = get_le(index + 10, 4);
+  if (reader->size - JOURNAL_TRAILER_SIZE - footer - footer_size !=
+      count * 16) {
+    return false;
+  }
+  JournalKeyframe* keyframes = NULL;
+  if (count != 0) {
+    keyframes = (JournalKeyframe*)malloc(count * sizeof(JournalKeyframe));
+    if (keyframes == NULL) {
+      return false;
+    }
+  }
+  bool result = true;
+  index += footer_size;
+  for (uint64_t i = 0; result && i < count; ++i, index += 16) {
+    keyframes[i].step = get_le(index, 8);
+    keyframes[i].offset = get_le(index + 8, 8);
+    result = keyframes[i].offset >= first && keyframes[i].offset < footer &&
+             keyframes[i].step <= steps &&
+             (i == 0 || keyframes[i].step >= keyframes[i - 1].step);
+  }
+  if (result) {
+    reader->keyframes = keyframes;
+    reader->keyframe_count = count;
+    reader->steps = steps;
+    reader->end = footer;
+  } else {
+    free(keyframes);
+  }
+  return result;
+}
+
+/* Footer is missing (the writer crashed), index keyframes by a scan */
+static void journal_reader_scan_index(JournalReader* reader) {
+  size_t capacity = 0;
+  reader->end = reader->size;
+  reader->position = journal_reader_first_entry(reader);
+  uint64_t step = 0;
+  size_t offset = reader->position;
+  JournalRecord record;
+  while (journal_reader_next(reader, &record)) {
+    step += record.delta;
+    if ((record.flags & JOURNAL_KEYFRAME) != 0) {
+      if (reader->keyframe_count == capacity) {
+        capacity = capacity != 0 ? capacity * 2 : 16;
+        JournalKeyframe* keyframes = (JournalKeyframe*)realloc(
+            reader->keyframes, capacity * sizeof(JournalKeyframe));
+        if (keyframes == NULL) {
+          break;
+        }
+        reader->keyframes = keyframes;
+      }
+      reader->keyframes[reader->keyframe_count].step = step;
+      reader->keyframes[reader->keyframe_count].offset = offset;
+      reader->keyframe_count++;
+    }
+    offset = reader->position;
+  }
+  reader->steps = step;
+  reader->end = offset;
+}
+
+bool journal_reader_open(JournalReader* reader, const char* path) {
+  memset(reader, 0, sizeof(JournalReader));
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  void* memory = MAP_FAILED;
+  if (fstat(fd, &info) == 0 && info.st_size >= JOURNAL_HEADER_SIZE) {
+    memory = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (memory == MAP_FAILED) {
+    return false;
+  }
+  reader->data = (const uint8_t*)memory;
+  reader->size = info.st_size;
+
+  const uint8_t* header = reader->data;
+  bool result = get_le(header, 4) == JOURNAL_MAGIC &&
+                get_le(header + 4, 2) == JOURNAL_VERSION;
+  if (result) {
+    reader->engine = header[6];
+    reader->seed = get_le(header + 8, 8);
+    reader->state_size = get_le(header + 16, 2);
+    reader->state = header + JOURNAL_HEADER_SIZE;
+    result = journal_reader_first_entry(reader) <= reader->size;
+  }
+  if (result) {
+    if (!journal_reader_load_index(reader)) {
+      journal_reader_scan_index(reader);
+    }
+    reader->position = journal_reader_first_entry(reader);
+  } else {
+    journal_reader_close(reader);
+  }
+  return result;
+}
+
+bool journal_reader_next(JournalReader* reader, JournalRecord* record) {
+  const uint8_t* data = reader->data;
+  uint64_t delta = 0;
+  size_t position = reader->position;
+  for (int shift = 0; position < reader->end && shift < 64; shift += 7) {
+    uint8_t byte = data[position++];
+    delta |= (uint64_t)(byte & 0x7f) << shift;
+    if ((byte & 0x80) != 0) {
+      continue;
+    }
+    if (position >= reader->end || (data[position] & JOURNAL_INDEX) != 0) {
+      return false;
+    }
+    record->delta = delta;
+    record->flags = data[position++];
+    record->state = NULL;
+    record->state_size = 0;
+    if ((record->flags & JOURNAL_KEYFRAME) != 0) {
+      if (reader->end - position < 2) {
+        return false;
+      }
+      size_t state_size = get_le(data + position, 2);
+      position += 2;
+      if (reader->end - position < state_size) {
+        return false;
+      }
+      record->state = data + position;
+      record->state_size = state_size;
+      position += state_size;
+    }
+    reader->position = position;
+    return true;
+  }
+  return false;
+}
+
+void journal_reader_close(JournalReader* reader) {
+  if (reader->data != NULL) {
+    munmap((void*)reader->data, reader->size);
+  }
+  free(reader->keyframes);
+  memset(reader, 0, sizeof(JournalReader));
+}
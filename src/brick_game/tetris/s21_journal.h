@@ -0,0 +1,184 @@
+/**
+ * @file s21_journal.h
+ * @brief Replay journal header file.
+ *
+ * Journal layout (shared with the snake library, little-endian):
+ *   u32 magic "BGJR", u16 version, u8 engine, u8 reserved, u64 seed,
+ *   u16 state size, snapshot of the game at the start of the journal
+ *   entries: varint step delta, u8 flags [, u16 size, snapshot]
+ *   footer: varint 0, u8 JOURNAL_INDEX, u64 steps, u32 keyframe count,
+ *           (u64 step, u64 offset) per keyframe, u64 footer offset,
+ *           u32 magic "BGJI"
+ * A step is one iteration of the game FSM. Records hold the action
+ * (bits 0..2), hold flag (bit 3), "input delivered" (bit 4) and
+ * "tick used" (bit 5) of a step, their delta counts steps since the
+ * previous entry, the recorded step included. Steps without a record had
+ * no new input and did not use the timer, so a headless session loaded
+ * from the starting snapshot and stepped through the records reproduces
+ * the session exactly. A record without flags only carries trailing steps.
+ *
+ * Keyframes (JOURNAL_KEYFRAME) carry a snapshot of the game after delta
+ * more quiet steps, so a player can seek by restoring the nearest
+ * keyframe. The footer indexes them, it is written when the journal is
+ * closed; journals of crashed processes are indexed by a scan instead.
+ */
+#ifndef S21_JOURNAL_H
+#define S21_JOURNAL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define JOURNAL_MAGIC 0x524a4742u       /* "BGJR" */
+#define JOURNAL_INDEX_MAGIC 0x494a4742u /* "BGJI" */
+#define JOURNAL_VERSION 2
+#define JOURNAL_HEADER_SIZE 18 /* Header without the starting snapshot */
+#define JOURNAL_TRAILER_SIZE 12
+#define JOURNAL_ACTION_MASK 0x07
+#define JOURNAL_HOLD 0x08
+#define JOURNAL_INPUT 0x10
+#define JOURNAL_TICK 0x20
+#define JOURNAL_KEYFRAME 0x40
+#define JOURNAL_INDEX 0x80
+#define JOURNAL_FLUSH_THRESHOLD 4096
+#define JOURNAL_KEYFRAME_INTERVAL 1024 /* Steps between keyframes */
+#define JOURNAL_PATH_SIZE 256
+
+/**
+ * @brief Keyframe position in the journal.
+ *
+ * @param step Steps played before the keyframe
+ * @param offset File offset of the keyframe entry
+ **/
+typedef struct {
+  uint64_t step;
+  uint64_t offset;
+} JournalKeyframe;
+
+/**
+ * @brief Append-only journal of a single session.
+ *
+ * The game thread only encodes records into an in-memory buffer, the file
+ * is written by the flusher thread shared by all journals.
+ **/
+typedef struct Journal {
+  FILE* file;
+  pthread_mutex_t mutex; /* Guards buffer and closed flag */
+  uint8_t* buffer;
+  size_t size;
+  size_t capacity;
+  uint8_t* spare; /* Buffer being written by the flusher */
+  size_t spare_capacity;
+  /* Game thread only */
+  uint64_t step;          /* Steps accounted so far */
+  uint64_t entry_step;    /* Step of the last entry */
+  uint64_t keyframe_step; /* Step of the last keyframe */
+  uint64_t offset;        /* Bytes appended so far */
+  JournalKeyframe* keyframes;
+  size_t keyframe_count;
+  size_t keyframe_capacity;
+  bool closed;
+  struct Journal* next; /* Flusher list */
+} Journal;
+
+/**
+ * @brief Single journal entry: a record or a keyframe.
+ *
+ * @param delta FSM steps since the previous entry
+ * @param flags JOURNAL_* bits
+ * @param state Keyframe snapshot, points into the mapping
+ **/
+typedef struct {
+  uint64_t delta;
+  uint8_t flags;
+  const uint8_t* state;
+  size_t state_size;
+} JournalRecord;
+
+/**
+ * @brief Journal reader working on a read-only mapping of the file.
+ **/
+typedef struct {
+  const uint8_t* data;
+  size_t size;
+  size_t end; /* End of the entries (footer offset) */
+  size_t position;
+  uint8_t engine;
+  uint64_t seed;
+  uint64_t steps;       /* Steps in the journal */
+  const uint8_t* state; /* Starting snapshot (step 0) */
+  size_t state_size;
+  JournalKeyframe* keyframes; /* Ordered by step */
+  size_t keyframe_count;
+} JournalReader;
+
+/**
+ * @brief Creates the journal file and buffers its header.
+ * @param path File path
+ * @param engine SNAPSHOT_ENGINE_* id
+ * @param seed Session PRNG state at the start of the journal
+ * @param state Snapshot of the game at the start of the journal
+ * @param state_size Snapshot size
+ * @return New journal or NULL on failure
+ **/
+Journal* journal_open(const char* path, uint8_t engine, uint64_t seed,
+                      const uint8_t* state, size_t state_size);
+
+/**
+ * @brief Accounts one FSM step (game thread). A record is buffered only
+ * if the step delivered an input or used a timer tick.
+ * @param journal Journal of the session
+ * @param flags JOURNAL_* bits of the step
+ **/
+void journal_step(Journal* journal, uint8_t flags);
+
+/**
+ * @brief Checks whether the game thread should add a keyframe.
+ **/
+bool journal_keyframe_due(const Journal* journal);
+
+/**
+ * @brief Appends a keyframe (game thread).
+ * @param journal Journal of the session
+ * @param state Snapshot of the game after the last accounted step
+ * @param state_size Snapshot size
+ **/
+void journal_keyframe(Journal* journal, const uint8_t* state,
+                      size_t state_size);
+
+/**
+ * @brief Records the trailing steps, writes the keyframe index and hands
+ * the journal over to the flusher, which writes the rest of the buffer,
+ * closes the file and frees the journal. The journal must be detached from
+ * the session.
+ * @param journal Journal to close, NULL is ignored
+ **/
+void journal_close(Journal* journal);
+
+/**
+ * @brief Maps the journal and loads (or rebuilds) its keyframe index.
+ * @param reader Output reader, positioned at the first entry
+ * @param path File path
+ * @return false if the file is not a journal
+ **/
+bool journal_reader_open(JournalReader* reader, const char* path);
+
+/**
+ * @brief Decodes the next entry.
+ * @return false at the end of the journal (or at a torn entry)
+ **/
+bool journal_reader_next(JournalReader* reader, JournalRecord* record);
+
+/**
+ * @brief Offset of the first entry, right after the starting snapshot.
+ **/
+size_t journal_reader_first_entry(const JournalReader* reader);
+
+/**
+ * @brief Unmaps the journal and frees the index.
+ **/
+void journal_reader_close(JournalReader* reader);
+
+#endif  // S21_JOURNAL_H
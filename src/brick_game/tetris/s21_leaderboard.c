@@ -0,0 +1,277 @@
+/**
+ * @file s21_leaderboard.c
+ * @brief Memory-mapped leaderboard source code.
+ */
+
+// Needs for flock() and clock_gettime()
+#define _DEFAULT_SOURCE
+
+#include "s21_leaderboard.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "s21_leaderboard_index.h"
+
+static uint32_t leaderboard_checksum(const LeaderboardRecord* record) {
+  const struct {
+    const void* data;
+    size_t size;
+  } parts[] = {{&record->game, sizeof(record->game)},
+               {&record->score, sizeof(record->score)},
+               {&record->timestamp, sizeof(record->timestamp)},
+               {record->player, sizeof(record->player)}};
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < sizeof(parts) / sizeof(parts[0]); ++i) {
+    const uint8_t* bytes = (const uint8_t*)parts[i].data;
+    for (size_t j = 0; j < parts[i].size; ++j) {
+      hash = (hash ^ bytes[j]) * 16777619u;
+    }
+  }
+  return hash;
+}
+
+static void leaderboard_raise_best(Leaderboard* board, uint8_t game,
+                                   int score) {
+  if (game >= LEADERBOARD_GAMES) {
+    return;
+  }
+  _Atomic int32_t* best = &board->header->best[game];
+  int32_t current = atomic_load_explicit(best, memory_order_relaxed);
+  while (score > current &&
+         !atomic_compare_exchange_weak_explicit(
+             best, &current, score, memory_order_relaxed,
+             memory_order_relaxed)) {
+  }
+}
+
+static bool leaderboard_valid(const Leaderboard* board) {
+  const LeaderboardHeader* header = board->header;
+  return header->magic == LEADERBOARD_MAGIC &&
+         header->version == LEADERBOARD_VERSION &&
+         header->record_size == sizeof(LeaderboardRecord) &&
+         sizeof(LeaderboardHeader) +
+                 (size_t)header->capacity * sizeof(LeaderboardRecord) <=
+             board->mapping_size;
+}
+
+Leaderboard* leaderboard_open(const char* path, uint32_t capacity) {
+  int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  /* The first process formats the store, the others wait for it */
+  flock(fd, LOCK_EX);
+  struct stat info;
+  bool result = fstat(fd, &info) == 0;
+  size_t size = result ? (size_t)info.st_size : 0;
+  if (result && size == 0 && capacity != 0) {
+    size = sizeof(LeaderboardHeader) + sizeof(LeaderboardRecord) * capacity;
+    LeaderboardHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = LEADERBOARD_MAGIC;
+    header.version = LEADERBOARD_VERSION;
+    header.record_size = sizeof(LeaderboardRecord);
+    header.capacity = capacity;
+    result = ftruncate(fd, size) == 0 &&
+             pwrite(fd, &header, sizeof(header), 0) == sizeof(header);
+  }
+  void* memory = MAP_FAILED;
+  if (result && size >= sizeof(LeaderboardHeader)) {
+    memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  flock(fd, LOCK_UN);
+  close(fd);
+  if (memory == MAP_FAILED) {
+    return NULL;
+  }
+
+  Leaderboard* board = (Leaderboard*)calloc(1, sizeof(Leaderboard));
+  if (board == NULL) {
+    munmap(memory, size);
+    return NULL;
+  }
+  pthread_mutex_init(&board->index_mutex, NULL);
+  board->mapping_size = size;
+  board->header = (LeaderboardHeader*)memory;
+  board->records =
+      (LeaderboardRecord*)((char*)memory + sizeof(LeaderboardHeader));
+  if (!leaderboard_valid(board)) {
+    leaderboard_close(board);
+    return NULL;
+  }
+
+  /* A writer may have died between its commit and the best score update */
+  LeaderboardRecord record;
+  for (uint64_t i = 0; i < leaderboard_size(board); ++i) {
+    if (leaderboard_read(board, i, &record)) {
+      leaderboard_raise_best(board, record.game, record.score);
+    }
+  }
+  return board;
+}
+
+void leaderboard_close(Leaderboard* board) {
+  if (board == NULL) return;
+  for (int i = 0; i < LEADERBOARD_GAMES; ++i) {
+    leaderboard_index_free(board->indexes[i]);
+  }
+  free(board->pending);
+  pthread_mutex_destroy(&board->index_mutex);
+  munmap(board->header, board->mapping_size);
+  free(board);
+}
+
+bool leaderboard_post(Leaderboard* board, uint8_t game, const char* player,
+                      int score) {
+  uint64_t index = atomic_fetch_add_explicit(&board->header->reserved_slots,
+                                             1, memory_order_relaxed);
+  if (index >= board->header->capacity) {
+    return false;
+  }
+
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  LeaderboardRecord* record = &board->records[index];
+  record->game = game;
+  record->score = score;
+  record->timestamp =
+      (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+  memset(record->player, 0, sizeof(record->player));
+  if (player != NULL) {
+    strncpy(record->player, player, sizeof(record->player) - 1);
+  }
+  record->checksum = leaderboard_checksum(record);
+  atomic_store_explicit(&record->commit, LEADERBOARD_COMMITTED,
+                        memory_order_release);
+  leaderboard_raise_best(board, game, score);
+  return true;
+}
+
+int leaderboard_best(const Leaderboard* board, uint8_t game) {
+  if (game >= LEADERBOARD_GAMES) {
+    return 0;
+  }
+  return atomic_load_explicit(&board->header->best[game],
+                              memory_order_relaxed);
+}
+
+uint64_t leaderboard_size(const Leaderboard* board) {
+  uint64_t size = atomic_load_explicit(&board->header->reserved_slots,
+                                       memory_order_acquire);
+  return size < board->header->capacity ? size : board->header->capacity;
+}
+
+bool leaderboard_read(const Leaderboard* board, uint64_t index,
+                      LeaderboardRecord* out) {
+  if (index >= leaderboard_size(board)) {
+    return false;
+  }
+  const LeaderboardRecord* record = &board->records[index];
+  if (atomic_load_explicit(&record->commit, memory_order_acquire) !=
+      LEADERBOARD_COMMITTED) {
+    return false;
+  }
+  atomic_store_explicit(&out->commit, LEADERBOARD_COMMITTED,
+                        memory_order_relaxed);
+  out->game = record->game;
+  out->score = record->score;
+  out->checksum = record->checksum;
+  out->timestamp = record->timestamp;
+  memcpy(out->player, record->player, sizeof(out->player));
+  return leaderboard_checksum(out) == out->checksum;
+}
+
+/* Adds a committed slot to the index of its game, false if the slot is not
+   committed (yet) */
+static bool leaderboard_index_slot_add(Leaderboard* board, uint64_t slot) {
+  /* Tetris scores grow in steps of 100 */
+  static const int widths[LEADERBOARD_GAMES] = {1, 1, 100, 1, 1, 1, 1, 1};
+  LeaderboardRecord record;
+  if (!leaderboard_read(board, slot, &record)) {
+    return false;
+  }
+  if (record.game < LEADERBOARD_GAMES) {
+    LeaderboardIndex** index = &board->indexes[record.game];
+    if (*index == NULL) {
+      *index = leaderboard_index_create(widths[record.game]);
+    }
+    if (*index != NULL) {
+      leaderboard_index_insert(*index, slot, record.score, record.player);
+    }
+  }
+  return true;
+}
+
+/* Catches the indexes up with the store, index mutex held */
+static LeaderboardIndex* leaderboard_index(Leaderboard* board, uint8_t game) {
+  if (game >= LEADERBOARD_GAMES) {
+    return NULL;
+  }
+  /* Slots of writers still filling them (or dead) are retried later */
+  size_t kept = 0;
+  for (size_t i = 0; i < board->pending_count; ++i) {
+    if (!leaderboard_index_slot_add(board, board->pending[i])) {
+      board->pending[kept++] = board->pending[i];
+    }
+  }
+  board->pending_count = kept;
+  for (uint64_t end = leaderboard_size(board); board->indexed < end;
+       ++board->indexed) {
+    if (leaderboard_index_slot_add(board, board->indexed)) continue;
+    if (board->pending_count == board->pending_capacity) {
+      size_t capacity =
+          board->pending_capacity ? board->pending_capacity * 2 : 16;
+      uint64_t* pending =
+          (uint64_t*)realloc(board->pending, capacity * sizeof(uint64_t));
+      if (pending == NULL) break;
+      board->pending = pending;
+      board->pending_capacity = capacity;
+    }
+    board->pending[board->pending_count++] = board->indexed;
+  }
+  return board->indexes[game];
+}
+
+uint64_t leaderboard_rank(Leaderboard* board, uint8_t game, int score) {
+  pthread_mutex_lock(&board->index_mutex);
+  LeaderboardIndex* index = leaderboard_index(board, game);
+  uint64_t rank = index != NULL ? leaderboard_index_rank(index, score) : 1;
+  pthread_mutex_unlock(&board->index_mutex);
+  return rank;
+}
+
+size_t leaderboard_top(Leaderboard* board, uint8_t game, size_t count,
+                       LeaderboardRecord* out) {
+  uint32_t* slots = (uint32_t*)malloc((count ? count : 1) * sizeof(uint32_t));
+  if (slots == NULL) {
+    return 0;
+  }
+  pthread_mutex_lock(&board->index_mutex);
+  LeaderboardIndex* index = leaderboard_index(board, game);
+  size_t written =
+      index != NULL ? leaderboard_index_top(index, count, slots) : 0;
+  pthread_mutex_unlock(&board->index_mutex);
+  for (size_t i = 0; i < written; ++i) {
+    leaderboard_read(board, slots[i], &out[i]);
+  }
+  free(slots);
+  return written;
+}
+
+int leaderboard_player_best(Leaderboard* board, uint8_t game,
+                            const char* player) {
+  pthread_mutex_lock(&board->index_mutex);
+  LeaderboardIndex* index = leaderboard_index(board, game);
+  int best =
+      index != NULL ? leaderboard_index_player_best(index, player) : 0;
+  pthread_mutex_unlock(&board->index_mutex);
+  return best;
+}
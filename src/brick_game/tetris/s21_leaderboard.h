@@ -0,0 +1,154 @@
+/**
+ * @file s21_leaderboard.h
+ * @brief Memory-mapped leaderboard header file.
+ *
+ * Store layout (shared with the snake library, little-endian host order):
+ *   [LeaderboardHeader, 64 bytes][LeaderboardRecord * capacity, 64 bytes]
+ * Writers reserve a slot with an atomic increment of the header counter,
+ * fill the record and publish it by storing its commit word last. A
+ * record is valid only if it is committed and its checksum matches, so
+ * slots of writers that crashed before the commit are skipped. The best
+ * score of every game is kept in the header and raised with a CAS.
+ *
+ * Rank and top-K queries go through a process-local LeaderboardIndex per
+ * game (see s21_leaderboard_index.h), which catches up with the records
+ * appended since the last query.
+ */
+#ifndef S21_LEADERBOARD_H
+#define S21_LEADERBOARD_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LEADERBOARD_MAGIC 0x424c4742u     /* "BGLB" */
+#define LEADERBOARD_VERSION 1
+#define LEADERBOARD_COMMITTED 0x54494d43u /* "CMIT" */
+#define LEADERBOARD_GAMES 8 /* Best scores indexed by SNAPSHOT_ENGINE_* */
+#define LEADERBOARD_PLAYER_SIZE 40
+#define LEADERBOARD_DEFAULT_CAPACITY 65536
+
+/**
+ * @brief Single posted score.
+ *
+ * @param commit LEADERBOARD_COMMITTED once the record is complete
+ * @param game SNAPSHOT_ENGINE_* id
+ * @param checksum FNV-1a of the record without commit and checksum
+ * @param timestamp Unix time in milliseconds
+ * @param player Zero-padded player name
+ **/
+typedef struct {
+  _Atomic uint32_t commit;
+  uint8_t game;
+  uint8_t reserved[3];
+  int32_t score;
+  uint32_t checksum;
+  uint64_t timestamp;
+  char player[LEADERBOARD_PLAYER_SIZE];
+} LeaderboardRecord;
+
+/**
+ * @brief Store header placed at the beginning of the mapping.
+ **/
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t record_size;
+  uint32_t capacity;
+  uint32_t reserved0;
+  _Atomic uint64_t reserved_slots; /* Slots handed out to writers */
+  _Atomic int32_t best[LEADERBOARD_GAMES];
+  uint8_t reserved[8];
+} LeaderboardHeader;
+
+_Static_assert(sizeof(LeaderboardRecord) == 64, "Leaderboard record ABI");
+_Static_assert(sizeof(LeaderboardHeader) == 64, "Leaderboard header ABI");
+
+struct LeaderboardIndex;
+
+/**
+ * @brief Process-local handle of a mapped store.
+ *
+ * @param index_mutex Guards the indexes
+ * @param indexed Slots visited by the indexes
+ * @param pending Visited slots not committed yet
+ **/
+typedef struct {
+  size_t mapping_size;
+  LeaderboardHeader* header;
+  LeaderboardRecord* records;
+  pthread_mutex_t index_mutex;
+  struct LeaderboardIndex* indexes[LEADERBOARD_GAMES];
+  uint64_t indexed;
+  uint64_t* pending;
+  size_t pending_count;
+  size_t pending_capacity;
+} Leaderboard;
+
+/**
+ * @brief Maps the store, creating it if the file does not exist.
+ * @param path Store file
+ * @param capacity Number of records of a new store
+ * @return Store or NULL on failure
+ **/
+Leaderboard* leaderboard_open(const char* path, uint32_t capacity);
+
+/**
+ * @brief Unmaps the store and frees the handle.
+ **/
+void leaderboard_close(Leaderboard* board);
+
+/**
+ * @brief Appends a score, safe to call from any thread or process.
+ * @param game SNAPSHOT_ENGINE_* id
+ * @param player Player name, truncated to fit the record
+ * @param score Final score
+ * @return false if the store is full
+ **/
+bool leaderboard_post(Leaderboard* board, uint8_t game, const char* player,
+                      int score);
+
+/**
+ * @brief Best score posted for a game (a single memory load).
+ **/
+int leaderboard_best(const Leaderboard* board, uint8_t game);
+
+/**
+ * @brief Number of slots handed out, committed or not.
+ **/
+uint64_t leaderboard_size(const Leaderboard* board);
+
+/**
+ * @brief Copies a committed record.
+ * @return false if the slot is not committed (yet, or ever)
+ **/
+bool leaderboard_read(const Leaderboard* board, uint64_t index,
+                      LeaderboardRecord* out);
+
+/**
+ * @brief Rank a score would have among the posted ones, 1 is the best.
+ * @param game SNAPSHOT_ENGINE_* id
+ **/
+uint64_t leaderboard_rank(Leaderboard* board, uint8_t game, int score);
+
+/**
+ * @brief Best records of a game, highest score first.
+ * @param game SNAPSHOT_ENGINE_* id
+ * @param count Records wanted
+ * @param out Output records, count elements
+ * @return Number of records written
+ **/
+size_t leaderboard_top(Leaderboard* board, uint8_t game, size_t count,
+                       LeaderboardRecord* out);
+
+/**
+ * @brief Best score of a player.
+ * @param game SNAPSHOT_ENGINE_* id
+ * @return 0 if the player has not posted yet
+ **/
+int leaderboard_player_best(Leaderboard* board, uint8_t game,
+                            const char* player);
+
+#endif
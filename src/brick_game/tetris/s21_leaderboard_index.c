@@ -0,0 +1,211 @@
+/**
+ * @file s21_leaderboard_index.c
+ * @brief Rank and top-K index of leaderboard scores source code.
+ */
+
+#include "s21_leaderboard_index.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NO_ENTRY UINT32_MAX
+
+LeaderboardIndex* leaderboard_index_create(int width) {
+  LeaderboardIndex* index =
+      (LeaderboardIndex*)calloc(1, sizeof(LeaderboardIndex));
+  if (index == NULL) {
+    return NULL;
+  }
+  index->width = width > 0 ? width : 1;
+  index->tree = (uint32_t*)calloc(LEADERBOARD_BUCKETS + 1, sizeof(uint32_t));
+  index->heads = (uint32_t*)malloc(LEADERBOARD_BUCKETS * sizeof(uint32_t));
+  if (index->tree == NULL || index->heads == NULL) {
+    leaderboard_index_free(index);
+    return NULL;
+  }
+  memset(index->heads, 0xff, LEADERBOARD_BUCKETS * sizeof(uint32_t));
+  return index;
+}
+
+void leaderboard_index_free(LeaderboardIndex* index) {
+  if (index == NULL) return;
+  free(index->tree);
+  free(index->heads);
+  free(index->entries);
+  free(index->players);
+  free(index);
+}
+
+static size_t leaderboard_index_bucket(const LeaderboardIndex* index,
+                                       int score) {
+  if (score <= 0) {
+    return 0;
+  }
+  size_t bucket = score / index->width;
+  return bucket < LEADERBOARD_BUCKETS ? bucket : LEADERBOARD_BUCKETS - 1;
+}
+
+static size_t leaderboard_index_hash(const char* player, size_t capacity) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < LEADERBOARD_PLAYER_SIZE && player[i]; ++i) {
+    hash = (hash ^ (uint8_t)player[i]) * 16777619u;
+  }
+  return hash & (capacity - 1);
+}
+
+/* Slot of the player, or the empty slot it would take */
+static LeaderboardPlayer* leaderboard_index_slot(LeaderboardPlayer* players,
+                                                 size_t capacity,
+                                                 const char* player) {
+  size_t slot = leaderboard_index_hash(player, capacity);
+  while (players[slot].used &&
+         strncmp(players[slot].player, player,
+                 LEADERBOARD_PLAYER_SIZE) != 0) {
+    slot = (slot + 1) & (capacity - 1);
+  }
+  return &players[slot];
+}
+
+static bool leaderboard_index_grow_players(LeaderboardIndex* index) {
+  size_t capacity = index->player_capacity ? index->player_capacity * 2 : 64;
+  LeaderboardPlayer* players =
+      (LeaderboardPlayer*)calloc(capacity, sizeof(LeaderboardPlayer));
+  if (players == NULL) {
+    return false;
+  }
+  for (size_t i = 0; i < index->player_capacity; ++i) {
+    if (index->players[i].used) {
+      *leaderboard_index_slot(players, capacity, index->players[i].player) =
+          index->players[i];
+    }
+  }
+  free(index->players);
+  index->players = players;
+  index->player_capacity = capacity;
+  return true;
+}
+
+bool leaderboard_index_insert(LeaderboardIndex* index, uint32_t record,
+                              int score, const char* player) {
+  if (index->size == index->capacity) {
+    size_t capacity = index->capacity ? index->capacity * 2 : 1024;
+    LeaderboardEntry* entries = (LeaderboardEntry*)realloc(
+        index->entries, capacity * sizeof(LeaderboardEntry));
+    if (entries == NULL) {
+      return false;
+    }
+    index->entries = entries;
+    index->capacity = capacity;
+  }
+  /* Players table is kept at most half full */
+  if (2 * (index->player_count + 1) > index->player_capacity &&
+      !leaderboard_index_grow_players(index)) {
+    return false;
+  }
+
+  size_t bucket = leaderboard_index_bucket(index, score);
+  LeaderboardEntry* entry = &index->entries[index->size];
+  entry->record = record;
+  entry->score = score;
+  entry->next = index->heads[bucket];
+  index->heads[bucket] = index->size++;
+  for (size_t i = bucket + 1; i <= LEADERBOARD_BUCKETS; i += i & -i) {
+    index->tree[i]++;
+  }
+
+  LeaderboardPlayer* slot =
+      leaderboard_index_slot(index->players, index->player_capacity, player);
+  if (!slot->used) {
+    slot->used = true;
+    slot->best = score;
+    strncpy(slot->player, player, LEADERBOARD_PLAYER_SIZE);
+    index->player_count++;
+  } else if (slot->best < score) {
+    slot->best = score;
+  }
+  return true;
+}
+
+/* Entries in buckets above the given one */
+static uint64_t leaderboard_index_count_above(const LeaderboardIndex* index,
+                                              size_t bucket) {
+  uint64_t prefix = 0;
+  for (size_t i = bucket + 1; i > 0; i -= i & -i) {
+    prefix += index->tree[i];
+  }
+  return index->size - prefix;
+}
+
+/* Bucket holding the rank-th lowest entry */
+static size_t leaderboard_index_find(const LeaderboardIndex* index,
+                                     uint64_t rank) {
+  size_t position = 0;
+  for (size_t step = LEADERBOARD_BUCKETS; step > 0; step >>= 1) {
+    if (position + step <= LEADERBOARD_BUCKETS &&
+        index->tree[position + step] < rank) {
+      position += step;
+      rank -= index->tree[position];
+    }
+  }
+  return position;
+}
+
+uint64_t leaderboard_index_rank(const LeaderboardIndex* index, int score) {
+  return leaderboard_index_count_above(
+             index, leaderboard_index_bucket(index, score)) +
+         1;
+}
+
+/* Equal scores keep the order they were posted in */
+static int leaderboard_index_compare(const void* a, const void* b) {
+  const LeaderboardEntry* left = (const LeaderboardEntry*)a;
+  const LeaderboardEntry* right = (const LeaderboardEntry*)b;
+  if (left->score != right->score) {
+    return left->score > right->score ? -1 : 1;
+  }
+  return left->record < right->record ? -1 : left->record > right->record;
+}
+
+size_t leaderboard_index_top(const LeaderboardIndex* index, size_t count,
+                             uint32_t* out) {
+  size_t written = 0;
+  uint64_t remaining = index->size;
+  LeaderboardEntry* chain = NULL;
+  size_t chain_capacity = 0;
+  while (written < count && remaining > 0) {
+    /* Highest bucket among the entries not taken yet */
+    size_t bucket = leaderboard_index_find(index, remaining);
+    size_t length = 0;
+    for (uint32_t i = index->heads[bucket]; i != NO_ENTRY;
+         i = index->entries[i].next) {
+      if (length == chain_capacity) {
+        chain_capacity = chain_capacity ? chain_capacity * 2 : 64;
+        LeaderboardEntry* grown = (LeaderboardEntry*)realloc(
+            chain, chain_capacity * sizeof(LeaderboardEntry));
+        if (grown == NULL) {
+          free(chain);
+          return written;
+        }
+        chain = grown;
+      }
+      chain[length++] = index->entries[i];
+    }
+    qsort(chain, length, sizeof(LeaderboardEntry), leaderboard_index_compare);
+    for (size_t i = 0; i < length && written < count; ++i) {
+      out[written++] = chain[i].record;
+    }
+    remaining -= length;
+  }
+  free(chain);
+  return written;
+}
+
+int leaderboard_index_player_best(const LeaderboardIndex* index,
+                                  const char* player) {
+  if (index->player_capacity == 0) {
+    return 0;
+  }
+  const LeaderboardPlayer* slot =
+      leaderboard_index_slot(index->players, index->player_capacity, player);
+  return slot->used ? slot->best : 0;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file s21_leaderboard_index.h
+ * @brief Rank and top-K index of leaderboard scores header file.
+ *
+ * Scores of one game are counted in a Fenwick tree over score buckets of
+ * a fixed width, so the rank of a score is a prefix sum (O(log buckets)).
+ * Every bucket also chains its entries, top-K walks the non-empty buckets
+ * from the top, finding each one with a Fenwick descent. Ranks are exact
+ * as long as scores are multiples of the width and below the last
+ * bucket, otherwise scores sharing a bucket tie.
+ */
+#ifndef S21_LEADERBOARD_INDEX_H
+#define S21_LEADERBOARD_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "s21_leaderboard.h"
+
+#define LEADERBOARD_BUCKETS 65536 /* Buckets of a game, power of two */
+
+/**
+ * @brief Indexed record.
+ *
+ * @param record Record index in the store
+ * @param next Next entry of the bucket
+ **/
+typedef struct {
+  uint32_t record;
+  int32_t score;
+  uint32_t next;
+} LeaderboardEntry;
+
+/**
+ * @brief Best score of a player, slot of an open addressing table.
+ **/
+typedef struct {
+  bool used;
+  int32_t best;
+  char player[LEADERBOARD_PLAYER_SIZE];
+} LeaderboardPlayer;
+
+/**
+ * @brief Order-statistic index of the scores of one game.
+ *
+ * @param width Score range of a bucket
+ * @param tree Fenwick tree, 1-based
+ * @param heads First entry of every bucket
+ **/
+typedef struct LeaderboardIndex {
+  int width;
+  uint32_t* tree;
+  uint32_t* heads;
+  LeaderboardEntry* entries;
+  size_t size;
+  size_t capacity;
+  LeaderboardPlayer* players;
+  size_t player_count;
+  size_t player_capacity;
+} LeaderboardIndex;
+
+/**
+ * @brief Allocates an empty index.
+ * @param width Score range of a bucket
+ * @return Index or NULL on allocation failure
+ **/
+LeaderboardIndex* leaderboard_index_create(int width);
+
+void leaderboard_index_free(LeaderboardIndex* index);
+
+/**
+ * @brief Adds a committed record.
+ * @param record Record index in the store
+ * @param player Zero-padded player name
+ * @return false on allocation failure
+ **/
+bool leaderboard_index_insert(LeaderboardIndex* index, uint32_t record,
+                              int score, const char* player);
+
+/**
+ * @brief Rank a score would have, 1 for the best one.
+ **/
+uint64_t leaderboard_index_rank(const LeaderboardIndex* index, int score);
+
+/**
+ * @brief Best records, highest score first.
+ * @param count Records wanted
+ * @param out Record indexes in the store, count elements
+ * @return Number of records written
+ **/
+size_t leaderboard_index_top(const LeaderboardIndex* index, size_t count,
+                             uint32_t* out);
+
+/**
+ * @brief Best score of a player.
+ * @return 0 if the player has not posted yet
+ **/
+int leaderboard_index_player_best(const LeaderboardIndex* index,
+                                  const char* player);
+
+#endif
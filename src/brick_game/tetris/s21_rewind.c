@@ -0,0 +1,207 @@
+/**
+ * @file s21_rewind.c
+ * @brief In-memory rewind buffer source code.
+ */
+
+#include "s21_rewind.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "s21_journal.h"
+
+static bool rewind_reserve(uint8_t** buffer, size_t* capacity, size_t size) {
+  if (size <= *capacity) {
+    return true;
+  }
+  size_t grown = *capacity != 0 ? *capacity * 2 : 256;
+  if (grown < size) {
+    grown = size;
+  }
+  uint8_t* data = (uint8_t*)realloc(*buffer, grown);
+  if (data == NULL) {
+    return false;
+  }
+  *buffer = data;
+  *capacity = grown;
+  return true;
+}
+
+RewindBuffer* rewind_create(size_t budget) {
+  RewindBuffer* rewind = (RewindBuffer*)calloc(1, sizeof(RewindBuffer));
+  if (rewind != NULL) {
+    pthread_mutex_init(&rewind->mutex, NULL);
+    rewind->budget = budget;
+    rewind->empty = true;
+  }
+  return rewind;
+}
+
+void rewind_free(RewindBuffer* rewind) {
+  if (rewind == NULL) return;
+  for (size_t i = 0; i < rewind->slots; ++i) {
+    rewind_segment_free(&rewind->segments[i]);
+  }
+  free(rewind->segments);
+  pthread_mutex_destroy(&rewind->mutex);
+  free(rewind);
+}
+
+void rewind_segment_free(RewindSegment* segment) {
+  free(segment->state);
+  free(segment->records);
+  memset(segment, 0, sizeof(RewindSegment));
+}
+
+static RewindSegment* rewind_segment(RewindBuffer* rewind, size_t index) {
+  return &rewind->segments[(rewind->head + index) % rewind->slots];
+}
+
+/* Drops the oldest segments, their buffers stay in the ring for reuse */
+static void rewind_trim(RewindBuffer* rewind) {
+  while (rewind->used > rewind->budget && rewind->count > 1) {
+    RewindSegment* front = rewind_segment(rewind, 0);
+    rewind->used -= front->state_size + front->size;
+    rewind->head = (rewind->head + 1) % rewind->slots;
+    rewind->count--;
+  }
+}
+
+void rewind_step(RewindBuffer* rewind, uint8_t flags) {
+  rewind->step++;
+  bool record =
+      !rewind->empty && (flags & (JOURNAL_INPUT | JOURNAL_TICK)) != 0;
+  uint64_t delta = rewind->step - rewind->entry_step;
+  if (record) {
+    rewind->entry_step = rewind->step;
+  }
+
+  pthread_mutex_lock(&rewind->mutex);
+  RewindSegment* segment = NULL;
+  if (record) {
+    segment = rewind_segment(rewind, rewind->count - 1);
+  }
+  /* Varint takes at most 10 bytes for a 64-bit delta */
+  if (segment != NULL &&
+      rewind_reserve(&segment->records, &segment->capacity,
+                     segment->size + 11)) {
+    size_t size = segment->size;
+    do {
+      uint8_t byte = delta & 0x7f;
+      delta >>= 7;
+      segment->records[segment->size++] = delta != 0 ? byte | 0x80 : byte;
+    } while (delta != 0);
+    segment->records[segment->size++] = flags;
+    rewind->used += segment->size - size;
+    rewind_trim(rewind);
+  }
+  rewind->last = rewind->step;
+  pthread_mutex_unlock(&rewind->mutex);
+}
+
+bool rewind_keyframe_due(const RewindBuffer* rewind) {
+  return rewind->empty ||
+         rewind->step - rewind->keyframe_step >= REWIND_KEYFRAME_INTERVAL;
+}
+
+void rewind_keyframe(RewindBuffer* rewind, const uint8_t* state,
+                     size_t state_size) {
+  pthread_mutex_lock(&rewind->mutex);
+  if (rewind->count == rewind->slots) {
+    /* Unwrap the ring, dropped segments keep their buffers */
+    size_t slots = rewind->slots != 0 ? rewind->slots * 2 : 4;
+    RewindSegment* segments =
+        (RewindSegment*)calloc(slots, sizeof(RewindSegment));
+    if (segments == NULL) {
+      pthread_mutex_unlock(&rewind->mutex);
+      return;
+    }
+    for (size_t i = 0; i < rewind->slots; ++i) {
+      segments[i] = *rewind_segment(rewind, i);
+    }
+    free(rewind->segments);
+    rewind->segments = segments;
+    rewind->slots = slots;
+    rewind->head = 0;
+  }
+
+  RewindSegment* segment = rewind_segment(rewind, rewind->count);
+  if (rewind_reserve(&segment->state, &segment->state_capacity,
+                     state_size)) {
+    memcpy(segment->state, state, state_size);
+    segment->state_size = state_size;
+    segment->size = 0;
+    segment->step = rewind->step;
+    rewind->count++;
+    rewind->used += state_size;
+    rewind->last = rewind->step;
+    rewind->entry_step = rewind->step;
+    rewind->keyframe_step = rewind->step;
+    rewind->empty = false;
+    rewind_trim(rewind);
+  }
+  pthread_mutex_unlock(&rewind->mutex);
+}
+
+bool rewind_window(RewindBuffer* rewind, uint64_t* first, uint64_t* last) {
+  pthread_mutex_lock(&rewind->mutex);
+  bool result = rewind->count != 0;
+  if (result) {
+    *first = rewind_segment(rewind, 0)->step;
+    *last = rewind->last;
+  }
+  pthread_mutex_unlock(&rewind->mutex);
+  return result;
+}
+
+bool rewind_copy_segment(RewindBuffer* rewind, uint64_t step,
+                         RewindSegment* segment) {
+  memset(segment, 0, sizeof(RewindSegment));
+  pthread_mutex_lock(&rewind->mutex);
+  bool result = rewind->count != 0 &&
+                step >= rewind_segment(rewind, 0)->step &&
+                step <= rewind->last;
+  if (result) {
+    size_t index = rewind->count - 1;
+    while (rewind_segment(rewind, index)->step > step) {
+      index--;
+    }
+    const RewindSegment* source = rewind_segment(rewind, index);
+    segment->step = source->step;
+    result = rewind_reserve(&segment->state, &segment->state_capacity,
+                            source->state_size) &&
+             rewind_reserve(&segment->records, &segment->capacity,
+                            source->size + 1);
+    if (result) {
+      memcpy(segment->state, source->state, source->state_size);
+      segment->state_size = source->state_size;
+      memcpy(segment->records, source->records, source->size);
+      segment->size = source->size;
+    }
+  }
+  pthread_mutex_unlock(&rewind->mutex);
+  if (!result) {
+    rewind_segment_free(segment);
+  }
+  return result;
+}
+
+bool rewind_next_record(const RewindSegment* segment, size_t* position,
+                        uint64_t* delta, uint8_t* flags) {
+  uint64_t value = 0;
+  size_t cursor = *position;
+  for (int shift = 0; cursor < segment->size && shift < 64; shift += 7) {
+    uint8_t byte = segment->records[cursor++];
+    value |= (uint64_t)(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      if (cursor >= segment->size) {
+        break;
+      }
+      *delta = value;
+      *flags = segment->records[cursor++];
+      *position = cursor;
+      return true;
+    }
+  }
+  return false;
+}
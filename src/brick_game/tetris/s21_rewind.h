@@ -0,0 +1,114 @@
+/**
+ * @file s21_rewind.h
+ * @brief In-memory rewind buffer header file.
+ *
+ * The buffer keeps the most recent FSM steps of a session as segments: a
+ * full snapshot followed by journal-style records (varint step delta,
+ * u8 flags, see s21_journal.h) of the steps that delivered an input or
+ * used a timer tick. A new segment starts every REWIND_KEYFRAME_INTERVAL
+ * steps, the oldest segments are dropped to stay within the budget, so
+ * the window always starts at a snapshot.
+ */
+#ifndef S21_REWIND_H
+#define S21_REWIND_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define REWIND_KEYFRAME_INTERVAL 256 /* Steps between snapshots */
+#define REWIND_DEFAULT_BUDGET 16384
+
+/**
+ * @brief Snapshot and the records that follow it.
+ *
+ * @param step Steps accounted before the snapshot
+ * @param records Encoded records, buffers of dropped segments are reused
+ **/
+typedef struct {
+  uint64_t step;
+  uint8_t* state;
+  size_t state_size;
+  size_t state_capacity;
+  uint8_t* records;
+  size_t size;
+  size_t capacity;
+} RewindSegment;
+
+/**
+ * @brief Bounded window of the last steps of a session.
+ **/
+typedef struct {
+  /* Game thread only */
+  uint64_t step;          /* Steps accounted so far */
+  uint64_t entry_step;    /* Step of the last record or snapshot */
+  uint64_t keyframe_step; /* Step of the last snapshot */
+  bool empty;
+
+  pthread_mutex_t mutex;
+  RewindSegment* segments; /* Ring, live segments start at head */
+  size_t head;
+  size_t count;
+  size_t slots;
+  size_t budget;
+  size_t used;   /* Bytes held by the live segments */
+  uint64_t last; /* Latest step visible to readers */
+} RewindBuffer;
+
+/**
+ * @brief Creates an empty buffer.
+ * @param budget Memory budget in bytes (snapshots and records). The
+ * current segment is kept even if it alone exceeds the budget.
+ * @return New buffer or NULL
+ **/
+RewindBuffer* rewind_create(size_t budget);
+
+/**
+ * @brief Frees the buffer, it must be detached from the session.
+ **/
+void rewind_free(RewindBuffer* rewind);
+
+/**
+ * @brief Accounts one FSM step (game thread).
+ * @param flags JOURNAL_* bits of the step
+ **/
+void rewind_step(RewindBuffer* rewind, uint8_t flags);
+
+/**
+ * @brief Checks whether the game thread should start a new segment.
+ **/
+bool rewind_keyframe_due(const RewindBuffer* rewind);
+
+/**
+ * @brief Starts a new segment (game thread).
+ * @param state Snapshot of the game after the last accounted step
+ **/
+void rewind_keyframe(RewindBuffer* rewind, const uint8_t* state,
+                     size_t state_size);
+
+/**
+ * @brief Steps the buffer can rebuild.
+ * @return false if the buffer is empty
+ **/
+bool rewind_window(RewindBuffer* rewind, uint64_t* first, uint64_t* last);
+
+/**
+ * @brief Copies the segment holding a step of the window.
+ * @param segment Output segment, free it with rewind_segment_free()
+ * @return false if the step is outside of the window
+ **/
+bool rewind_copy_segment(RewindBuffer* rewind, uint64_t step,
+                         RewindSegment* segment);
+
+/**
+ * @brief Decodes a record of a segment.
+ * @param position Offset in the records, advanced past the record
+ * @return false after the last record
+ **/
+bool rewind_next_record(const RewindSegment* segment, size_t* position,
+                        uint64_t* delta, uint8_t* flags);
+
+void rewind_segment_free(RewindSegment* segment);
+
+#endif
@@ -0,0 +1,253 @@
+/**
+ * @file s21_score_writer.c
+ * @brief Background high score writer source code.
+ */
+
+#define _XOPEN_SOURCE 600
+// Needs for flock()
+#define _DEFAULT_SOURCE
+
+#include "s21_score_writer.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Background thread writing score files.
+ **/
+typedef struct {
+  pthread_mutex_t mutex;       /* Guards the files */
+  pthread_mutex_t write_mutex; /* Serializes batches, held while writing */
+  pthread_cond_t cond;
+  ScoreFile files[SCORE_WRITER_FILES];
+  bool loaded[SCORE_WRITER_FILES];
+  int count;
+  bool started;
+  bool pending;
+} ScoreWriter;
+
+static ScoreWriter* get_score_writer(void) {
+  static ScoreWriter writer = {PTHREAD_MUTEX_INITIALIZER,
+                               PTHREAD_MUTEX_INITIALIZER,
+                               PTHREAD_COND_INITIALIZER,
+                               {{{0}, 0, 0}},
+                               {false},
+                               0,
+                               false,
+                               false};
+  return &writer;
+}
+
+/* Score in the file, 0 if there is none */
+static int score_writer_read(const char* path) {
+  int score = 0;
+  FILE* database = fopen(path, "r");
+  if (database != NULL) {
+    if (fscanf(database, "%d", &score) != 1) {
+      score = 0;
+    }
+    fclose(database);
+  }
+  return score;
+}
+
+/* Called with the writer mutex held, only the first lookup of a file that
+   needs its contents reads it */
+static ScoreFile* score_writer_file(ScoreWriter* writer, const char* path,
+                                    bool load) {
+  int index = 0;
+  while (index < writer->count && strcmp(writer->files[index].path, path)) {
+    index++;
+  }
+  if (index == writer->count) {
+    if (index == SCORE_WRITER_FILES ||
+        strlen(path) >= SCORE_WRITER_PATH_SIZE) {
+      return NULL;
+    }
+    strcpy(writer->files[index].path, path);
+    writer->count++;
+  }
+
+  ScoreFile* file = &writer->files[index];
+  if (load && !writer->loaded[index]) {
+    int score = score_writer_read(path);
+    file->written = score;
+    if (score > file->score) {
+      file->score = score;
+    }
+    writer->loaded[index] = true;
+  }
+  return file;
+}
+
+static bool score_writer_rename(const char* path, int score) {
+  char temporary[SCORE_WRITER_PATH_SIZE + 32];
+  snprintf(temporary, sizeof(temporary), "%s.tmp.%ld", path, (long)getpid());
+  FILE* database = fopen(temporary, "w");
+  if (database == NULL) {
+    return false;
+  }
+  bool written = fprintf(database, "%d", score) > 0 &&
+                 fflush(database) == 0 && fsync(fileno(database)) == 0;
+  written = fclose(database) == 0 && written;
+  written = written && rename(temporary, path) == 0;
+  if (!written) {
+    remove(temporary);
+  }
+  return written;
+}
+
+/**
+ * @brief Replaces the file with the better of the score and the one on
+ * disk. Other processes write the file too, so the read and the rename
+ * are made under a lock file next to it.
+ * @param stored Output, score the file holds afterwards
+ * @return false if the file could not be written
+ **/
+static bool score_writer_replace(const char* path, int score, int* stored) {
+  char lock_path[SCORE_WRITER_PATH_SIZE + 8];
+  snprintf(lock_path, sizeof(lock_path), "%s.lock", path);
+  int lock = open(lock_path, O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+  if (lock < 0) {
+    return false;
+  }
+  bool written = false;
+  if (flock(lock, LOCK_EX) == 0) {
+    *stored = score_writer_read(path);
+    written = *stored >= score || score_writer_rename(path, score);
+    if (written && *stored < score) {
+      *stored = score;
+    }
+  }
+  close(lock); /* Releases the lock */
+  return written;
+}
+
+static void score_writer_directory(const char* path, char* directory) {
+  const char* slash = strrchr(path, '/');
+  if (slash != NULL) {
+    memcpy(directory, path, slash - path + 1);
+    directory[slash - path + 1] = '\0';
+  } else {
+    strcpy(directory, ".");
+  }
+}
+
+/* Writes every changed file, disk is touched without the writer mutex.
+   Returns false if a file is left to retry */
+static bool score_writer_batch(void) {
+  ScoreWriter* writer = get_score_writer();
+  ScoreFile batch[SCORE_WRITER_FILES];
+  bool done[SCORE_WRITER_FILES];
+  int stored[SCORE_WRITER_FILES];
+  int count = 0;
+
+  pthread_mutex_lock(&writer->write_mutex);
+  pthread_mutex_lock(&writer->mutex);
+  writer->pending = false;
+  for (int i = 0; i < writer->count; ++i) {
+    ScoreFile* file = score_writer_file(writer, writer->files[i].path, true);
+    if (file->score > file->written) {
+      batch[count++] = *file;
+    }
+  }
+  pthread_mutex_unlock(&writer->mutex);
+
+  for (int i = 0; i < count; ++i) {
+    done[i] = score_writer_replace(batch[i].path, batch[i].score, &stored[i]);
+  }
+  /* Renames of the batch are made durable together, one fsync for each
+     directory */
+  char directories[SCORE_WRITER_FILES][SCORE_WRITER_PATH_SIZE];
+  for (int i = 0; i < count; ++i) {
+    score_writer_directory(batch[i].path, directories[i]);
+    bool synced = !done[i];
+    for (int j = 0; j < i && !synced; ++j) {
+      synced = done[j] && strcmp(directories[i], directories[j]) == 0;
+    }
+    int fd = synced ? -1 : open(directories[i], O_RDONLY);
+    if (fd >= 0) {
+      fsync(fd);
+      close(fd);
+    }
+  }
+
+  pthread_mutex_lock(&writer->mutex);
+  /* Failed files keep the batch pending, so they are retried */
+  bool all_done = true;
+  for (int i = 0; i < count; ++i) {
+    ScoreFile* file = score_writer_file(writer, batch[i].path, false);
+    if (!done[i]) {
+      all_done = false;
+      writer->pending = true;
+    } else {
+      /* Another process may have stored a better score */
+      if (file->written < stored[i]) file->written = stored[i];
+      if (file->score < stored[i]) file->score = stored[i];
+    }
+  }
+  pthread_mutex_unlock(&writer->mutex);
+  pthread_mutex_unlock(&writer->write_mutex);
+  return all_done;
+}
+
+static void* score_writer_thread(void* arg) {
+  (void)arg;
+  ScoreWriter* writer = get_score_writer();
+  long delay_ms = SCORE_WRITER_BATCH_MS;
+  while (true) {
+    pthread_mutex_lock(&writer->mutex);
+    while (!writer->pending) {
+      pthread_cond_wait(&writer->cond, &writer->mutex);
+    }
+    pthread_mutex_unlock(&writer->mutex);
+
+    /* Let a burst of points land in the same batch, and back off while
+       the disk keeps failing */
+    struct timespec delay = {delay_ms / 1000, delay_ms % 1000 * 1000000L};
+    nanosleep(&delay, NULL);
+    if (score_writer_batch()) {
+      delay_ms = SCORE_WRITER_BATCH_MS;
+    } else if (delay_ms * 2 <= SCORE_WRITER_RETRY_MAX_MS) {
+      delay_ms *= 2;
+    }
+  }
+  return NULL;
+}
+
+/* Registered with atexit(), so no pending score is lost on exit */
+static void score_writer_exit(void) { (void)score_writer_batch(); }
+
+void score_writer_submit(const char* path, int score) {
+  ScoreWriter* writer = get_score_writer();
+  pthread_mutex_lock(&writer->mutex);
+  if (!writer->started) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, score_writer_thread, NULL) == 0) {
+      pthread_detach(thread);
+      atexit(score_writer_exit);
+      writer->started = true;
+    }
+  }
+  ScoreFile* file = score_writer_file(writer, path, false);
+  if (file != NULL && score > file->score) {
+    file->score = score;
+    writer->pending = true;
+    pthread_cond_signal(&writer->cond);
+  }
+  pthread_mutex_unlock(&writer->mutex);
+}
+
+int score_writer_load(const char* path) {
+  ScoreWriter* writer = get_score_writer();
+  pthread_mutex_lock(&writer->mutex);
+  ScoreFile* file = score_writer_file(writer, path, true);
+  int score = file != NULL ? file->score : 0;
+  pthread_mutex_unlock(&writer->mutex);
+  return score;
+}
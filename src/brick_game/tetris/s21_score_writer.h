@@ -0,0 +1,51 @@
+/**
+ * @file s21_score_writer.h
+ * @brief Background high score writer header file.
+ *
+ * Game threads only record the score, the writer thread coalesces all
+ * updates of a batch and replaces every changed file atomically: the
+ * score goes into a temporary file, which is fsync'ed and renamed over
+ * the old one, then the directories are fsync'ed once per batch. Scores
+ * of a file never go down: the file is re-read under a lock file
+ * (<path>.lock) and the better score is kept, so sessions and processes
+ * racing on the same file keep the best one. A failed write is retried,
+ * backing off up to SCORE_WRITER_RETRY_MAX_MS.
+ */
+#ifndef S21_SCORE_WRITER_H
+#define S21_SCORE_WRITER_H
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#define SCORE_WRITER_BATCH_MS 100 /* Updates coalesced into one write */
+#define SCORE_WRITER_RETRY_MAX_MS 6400 /* Longest back-off after a failure */
+#define SCORE_WRITER_FILES 4
+#define SCORE_WRITER_PATH_SIZE 256
+
+/**
+ * @brief Score file known to the writer.
+ *
+ * @param score Best known score
+ * @param written Score on disk
+ **/
+typedef struct {
+  char path[SCORE_WRITER_PATH_SIZE];
+  int score;
+  int written;
+} ScoreFile;
+
+/**
+ * @brief Schedules a score to be written (never blocks on disk).
+ * @param path Score file
+ * @param score New high score
+ **/
+void score_writer_submit(const char* path, int score);
+
+/**
+ * @brief Reads the high score, including updates not written yet.
+ * @param path Score file
+ * @return Best known score, 0 if there is none
+ **/
+int score_writer_load(const char* path);
+
+#endif
@@ -0,0 +1,120 @@
+/**
+ * @file s21_snapshot.c
+ * @brief Binary game snapshot source code.
+ */
+
+#include "s21_snapshot.h"
+
+#include <string.h>
+
+static uint8_t* put_le(uint8_t* cursor, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; ++i) {
+    *cursor++ = value >> (8 * i) & 0xff;
+  }
+  return cursor;
+}
+
+static const uint8_t* get_le(const uint8_t* cursor, uint64_t* value,
+                             int bytes) {
+  *value = 0;
+  for (int i = 0; i < bytes; ++i) {
+    *value |= (uint64_t)cursor[i] << (8 * i);
+  }
+  return cursor + bytes;
+}
+
+size_t snapshot_encode(const SessionState* state, uint8_t* buffer,
+                       size_t capacity) {
+  if (buffer == NULL || capacity < SNAPSHOT_TETRIS_SIZE) {
+    return SNAPSHOT_TETRIS_SIZE;
+  }
+
+  uint32_t timerBits;
+  memcpy(&timerBits, &state->timer, sizeof(timerBits));
+
+  uint8_t* cursor = buffer;
+  cursor = put_le(cursor, SNAPSHOT_MAGIC, 4);
+  cursor = put_le(cursor, SNAPSHOT_VERSION, 2);
+  *cursor++ = SNAPSHOT_ENGINE_TETRIS;
+  *cursor++ = 0;
+
+  *cursor++ = state->status;
+  *cursor++ = state->action;
+  *cursor++ = state->flags;
+  *cursor++ = state->level;
+  *cursor++ = state->speed;
+  *cursor++ = state->figure_index;
+  *cursor++ = state->handler_figure_index;
+  *cursor++ = state->next_index;
+  cursor = put_le(cursor, (uint32_t)state->score, 4);
+  cursor = put_le(cursor, (uint32_t)state->high_score, 4);
+  cursor = put_le(cursor, timerBits, 4);
+  cursor = put_le(cursor, state->rng_state, 8);
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      *cursor++ = (uint8_t)state->coords[i][j];
+    }
+  }
+  memcpy(cursor, state->field, SNAPSHOT_FIELD_SIZE);
+  return SNAPSHOT_TETRIS_SIZE;
+}
+
+bool snapshot_decode(const uint8_t* buffer, size_t length,
+                     SessionState* state) {
+  if (buffer == NULL || length != SNAPSHOT_TETRIS_SIZE) {
+    return false;
+  }
+
+  uint64_t magic = 0;
+  uint64_t version = 0;
+  const uint8_t* cursor = buffer;
+  cursor = get_le(cursor, &magic, 4);
+  cursor = get_le(cursor, &version, 2);
+  if (magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION ||
+      *cursor != SNAPSHOT_ENGINE_TETRIS) {
+    return false;
+  }
+  cursor += 2;
+
+  SessionState decoded;
+  uint64_t value = 0;
+  decoded.status = *cursor++;
+  decoded.action = *cursor++;
+  decoded.flags = *cursor++;
+  decoded.level = *cursor++;
+  decoded.speed = *cursor++;
+  decoded.figure_index = *cursor++;
+  decoded.handler_figure_index = *cursor++;
+  decoded.next_index = *cursor++;
+  cursor = get_le(cursor, &value, 4);
+  decoded.score = (int32_t)(uint32_t)value;
+  cursor = get_le(cursor, &value, 4);
+  decoded.high_score = (int32_t)(uint32_t)value;
+  cursor = get_le(cursor, &value, 4);
+  uint32_t timerBits = value;
+  memcpy(&decoded.timer, &timerBits, sizeof(timerBits));
+  cursor = get_le(cursor, &decoded.rng_state, 8);
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      decoded.coords[i][j] = (int8_t)*cursor++;
+    }
+  }
+  memcpy(decoded.field, cursor, SNAPSHOT_FIELD_SIZE);
+
+  /* Values are used as indices by the engine, so they are checked here */
+  bool valid = decoded.status <= 7 && decoded.action <= 7 &&
+               decoded.figure_index <= 7 && decoded.handler_figure_index <= 7 &&
+               (decoded.next_index < 7 ||
+                decoded.next_index == SESSION_STATE_NO_FIGURE);
+  for (int i = 0; i < 4 && valid; ++i) {
+    valid = decoded.coords[0][i] >= -4 && decoded.coords[0][i] < BOARD_ROWS &&
+            decoded.coords[1][i] >= 0 && decoded.coords[1][i] < BOARD_COLS;
+  }
+  for (int i = 0; i < SNAPSHOT_FIELD_SIZE && valid; ++i) {
+    valid = (decoded.field[i] & 0xf) <= 7 && (decoded.field[i] >> 4) <= 7;
+  }
+  if (valid) {
+    *state = decoded;
+  }
+  return valid;
+}
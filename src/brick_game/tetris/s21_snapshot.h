@@ -0,0 +1,75 @@
+/**
+ * @file s21_snapshot.h
+ * @brief Binary game snapshot header file.
+ *
+ * Snapshot layout (shared with the snake library, all integers are
+ * little-endian, floats are IEEE 754):
+ *   u32 magic "BGSS", u16 version, u8 engine, u8 reserved
+ *   u8 status, u8 pending action, u8 flags, u8 level, u8 speed,
+ *   u8 figure index, u8 FSM figure index, u8 next figure index,
+ *   i32 score, i32 high score, f32 timer, u64 PRNG state,
+ *   i8 coords[2][4], u8 field[100] (two cells per byte, low nibble first)
+ */
+#ifndef S21_SNAPSHOT_H
+#define S21_SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "s21_board.h"
+
+#define SNAPSHOT_MAGIC 0x53534742u /* "BGSS" */
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_ENGINE_SNAKE 1
+#define SNAPSHOT_ENGINE_TETRIS 2
+#define SNAPSHOT_MAX_SIZE 512 /* Enough for any snapshot of both engines */
+#define SNAPSHOT_FIELD_SIZE ((BOARD_CELLS + 1) / 2)
+#define SNAPSHOT_TETRIS_SIZE (44 + SNAPSHOT_FIELD_SIZE) /* 144 for 20x10 */
+#define SESSION_STATE_NO_FIGURE 0xff
+
+/**
+ * @brief Decoded state of a tetris session.
+ *
+ * @param flags bit 0 - pause, bit 1 - attach flag, bit 2 - first plant flag
+ * @param next_index Index of the next figure in TetFig matrix
+ * @param field Game field, two cells per byte (low nibble first)
+ **/
+typedef struct {
+  uint8_t status;
+  uint8_t action;
+  uint8_t flags;
+  uint8_t level;
+  uint8_t speed;
+  uint8_t figure_index;
+  uint8_t handler_figure_index;
+  uint8_t next_index;
+  int32_t score;
+  int32_t high_score;
+  float timer;
+  uint64_t rng_state;
+  int8_t coords[2][4];
+  uint8_t field[SNAPSHOT_FIELD_SIZE];
+} SessionState;
+
+/**
+ * @brief Encodes the state into the binary snapshot format.
+ * @param state Session state
+ * @param buffer Output buffer (may be NULL to query the size)
+ * @param capacity Buffer size
+ * @return Snapshot size, nothing is written if it exceeds capacity
+ **/
+size_t snapshot_encode(const SessionState* state, uint8_t* buffer,
+                       size_t capacity);
+
+/**
+ * @brief Decodes and validates a binary snapshot.
+ * @param buffer Snapshot
+ * @param length Snapshot size
+ * @param state Output state, untouched on failure
+ * @return false if the snapshot is malformed or made by another engine
+ **/
+bool snapshot_decode(const uint8_t* buffer, size_t length,
+                     SessionState* state);
+
+#endif  // S21_SNAPSHOT_H
@@ -6,24 +6,36 @@
 #ifndef S21_TETRIS_H
 #define S21_TETRIS_H
 
-// Needs for usleep()
-#define _XOPEN_SOURCE
+// Needs for usleep() and clock_gettime()
+#define _XOPEN_SOURCE 600
 #define _XOPEN_SOURCE_EXTENDED
-// Needs for pthread_kill()
-#define _REENTRANT
 
 #include <pthread.h>
-#include <signal.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
 
+#include "s21_board.h"
+#include "s21_frame_ring.h"
+#include "s21_journal.h"
+#include "s21_leaderboard.h"
+#include "s21_rewind.h"
+#include "s21_score_writer.h"
+#include "s21_snapshot.h"
+
 #define BLANK 0
-#define ROWS_FIELD 20
-#define COLS_FIELD 10
+#define ROWS_FIELD BOARD_ROWS
+#define COLS_FIELD BOARD_COLS
+#define SPAWN_COL (COLS_FIELD / 2 - 2) /* Left column of a new figure */
+
+_Static_assert(ROWS_FIELD <= FRAME_RING_ROWS && COLS_FIELD <= FRAME_RING_COLS,
+               "Game field must fit into a frame");
+_Static_assert(COLS_FIELD >= 4, "Figures must fit into the field");
+#define SCORE_FILE "tetris_score"
 
 /**
  * @brief Enum that defines states of FSM
@@ -82,7 +94,196 @@ typedef struct {
   pthread_mutex_t mutex;
 } ThreadStruct;
 
+/**
+ * @brief Struct holding the whole state of a single game session.
+ * Singleton-like getters resolve to the fields of the current session:
+ * the one bound to the calling game thread, or the active one otherwise.
+ **/
+typedef struct TetrisSession {
+  GameInfo_t info;
+  GameStatus_t status;
+  UserAction_t action;
+  bool hold;
+  int** sub_field;
+  int** coords;
+  int figure_index;
+  int handler_figure_index;  ///< Figure index owned by the FSM loop
+  bool attach_flag;
+  float timer;
+  int first_plant_flag;
+  ThreadStruct timer_thread;
+  ThreadStruct game_thread;
+  pthread_mutex_t park_mutex;
+  pthread_cond_t park_cond;
+  bool parked;  ///< Session waits in the pool, threads are asleep
+  bool stop;    ///< Threads have to leave their loops
+  unsigned input_count;          ///< Inputs received so far
+  unsigned settled_input_count;  ///< Inputs seen by a finished FSM step
+  bool hibernate_requested;      ///< Set by the idle monitor
+  uint64_t rng_state;            ///< xorshift64* state (figure choice)
+  Journal* journal;              ///< Replay journal, NULL if disabled
+  unsigned journaled_input_count;  ///< Inputs already in the journal
+  RewindBuffer* rewind;            ///< Rewind buffer, NULL if disabled
+  unsigned rewound_input_count;    ///< Inputs already in the rewind buffer
+  Leaderboard* leaderboard;        ///< Final scores go here, NULL if none
+  char player[LEADERBOARD_PLAYER_SIZE];  ///< Name scores are posted under
+  bool headless;  ///< Replay session without threads and score file
+  struct TetrisSession* next_pooled;
+} TetrisSession;
+
+/**
+ * @brief Pool of pre-initialized sessions.
+ **/
+typedef struct {
+  pthread_mutex_t mutex;
+  TetrisSession* head;
+  int size;
+  int capacity;
+} SessionPool;
+
+/**
+ * @brief Hibernation bookkeeping, guarded by the session mutex.
+ *
+ * @param active A session is hibernated into state
+ * @param last_activity Time of the last user input (CLOCK_MONOTONIC)
+ * @param timeout_ms Idle timeout, 0 disables hibernation
+ * @param monitor_cond Wakes the idle monitor up
+ * @param journal Journal of the hibernated session, continued on revive
+ **/
+typedef struct {
+  bool active;
+  SessionState state;
+  Journal* journal;
+  struct timespec last_activity;
+  int timeout_ms;
+  bool monitor_started;
+  pthread_cond_t monitor_cond;
+} Hibernation;
+
+/**
+ * @brief Replay journal settings, guarded by the session mutex.
+ *
+ * @param directory Directory for journal files, empty disables journals
+ * @param count Number of journals started by the process
+ **/
+typedef struct {
+  char directory[JOURNAL_PATH_SIZE];
+  unsigned count;
+} JournalSettings;
+
+/**
+ * @brief Rewind buffer settings, guarded by the session mutex.
+ *
+ * @param budget Memory budget per session in bytes, 0 disables rewinding
+ * @param buffer Buffer of the active (or hibernated) session
+ **/
+typedef struct {
+  size_t budget;
+  RewindBuffer* buffer;
+} RewindSettings;
+
+/**
+ * @brief Leaderboard settings, guarded by the session mutex.
+ *
+ * @param board Store shared by all sessions, NULL if none is open
+ * @param player Name the following sessions post their scores under
+ **/
+typedef struct {
+  Leaderboard* board;
+  char player[LEADERBOARD_PLAYER_SIZE];
+} LeaderboardSettings;
+
+/**
+ * @brief Journal playback on a headless session.
+ *
+ * @param reader Mapped journal
+ * @param session Headless session replaying the journal
+ * @param step Steps played
+ * @param quiet Quiet steps left before the pending record
+ * @param pending The record is still to be played
+ **/
+typedef struct ReplayPlayer {
+  JournalReader reader;
+  TetrisSession* session;
+  uint64_t step;
+  uint64_t quiet;
+  bool pending;
+  JournalRecord record;
+} ReplayPlayer;
+
 /* ---- Singleton-like Getters ---- */
+/**
+ * @brief Singletone-like function.
+ * Provides global access to the active session (the one driven by the
+ * controller). NULL if no game is running.
+ * @return Address of the static active session pointer
+ **/
+TetrisSession** get_active_session(void);
+
+/**
+ * @brief Singletone-like function.
+ * Provides access to the session bound to the calling thread.
+ * @return Address of the thread-local session pointer
+ **/
+TetrisSession** get_thread_session(void);
+
+/**
+ * @brief Resolves the current session: the thread-bound one if any,
+ * the active one otherwise. Never returns NULL – when no game is running
+ * a detached session in EXIT state is returned.
+ * @return Current session
+ **/
+TetrisSession* get_session(void);
+
+/**
+ * @brief Singletone-like function.
+ * Provides global access to the mutex guarding the active session pointer.
+ * @return Pointer to the static mutex
+ **/
+pthread_mutex_t* get_session_mutex(void);
+
+/**
+ * @brief Singletone-like function.
+ * Provides global access to the session pool.
+ * @return Pointer to the static pool
+ **/
+SessionPool* get_session_pool(void);
+
+/**
+ * @brief Singletone-like function.
+ * Provides global access to the hibernation state.
+ * @return Pointer to the static struct
+ **/
+Hibernation* get_hibernation_instance(void);
+
+/**
+ * @brief Singletone-like function.
+ * Provides global access to the replay journal settings.
+ * @return Pointer to the static struct
+ **/
+JournalSettings* get_journal_settings(void);
+
+/**
+ * @brief Singletone-like function.
+ * Provides global access to the rewind buffer settings.
+ * @return Pointer to the static struct
+ **/
+RewindSettings* get_rewind_settings(void);
+
+/**
+ * @brief Singletone-like function.
+ * Provides global access to the leaderboard settings.
+ * @return Pointer to the static struct
+ **/
+LeaderboardSettings* get_leaderboard_settings(void);
+
+/**
+ * @brief Singletone-like function.
+ * Provides global access to the best score known to the process.
+ * @return Pointer to the static score
+ **/
+int* get_best_score(void);
+
 /**
  * @brief Singletone-like function.
  * Provides global access to sub-field.
@@ -142,20 +343,6 @@ int get_figure_index(int* index);
  **/
 float* get_timer(void);
 
-/**
- * @brief Singletone-like function.
- * Provides global access to main thread pointer.
- * @return Address of the main thread variable.
- **/
-pthread_t* get_main_thread();
-
-/**
- * @brief Singletone-like function.
- * Provides global access to a signal-handled flag.
- * @return Address of static bool
- **/
-bool* get_signal_handled_flag();
-
 /**
  * @brief Singletone-like function.
  * Provides global access to a flag indicating the first planting of a figure.
@@ -177,12 +364,33 @@ UserAction_t* get_action_instance();
  **/
 bool* get_hold_instance();
 
+/**
+ * @brief Singletone-like function.
+ * Provides global access to the exported frame ring.
+ * @return Address of the static ring pointer (NULL if export is disabled)
+ **/
+FrameRing** get_frame_ring_instance();
+
+/**
+ * @brief Singletone-like function.
+ * Provides global access to the mutex guarding the frame ring pointer.
+ * @return Pointer to the static mutex
+ **/
+pthread_mutex_t* get_frame_ring_mutex();
+
 /* ---- Main Logic ---- */
 /**
- * @brief Initializes the game (memory allocations, seeding, thread creation).
+ * @brief Initializes the game. Claims a pre-initialized session from the
+ * pool, or creates a new one if the pool is empty.
  */
 void initialize_game(void);
 
+/**
+ * @brief Reads status of the current game, hibernated one included.
+ * @return Current game status, EXIT if no game is running
+ **/
+GameStatus_t current_game_status(void);
+
 /**
  * @brief Updates game state and returns its copy. FSM-based approach.
  * @return Copy of current game data struct
@@ -198,30 +406,362 @@ void userInput(UserAction_t action, bool hold);
 
 /**
  * @brief Timer thread function.
- * @param arg Pointer to GameInfo_t struct
+ * @param arg Pointer to TetrisSession struct
  * @return Stub as NULL
  */
 void* timer_handler(void* arg);
 
 /**
  * @brief Main game thread function (FSM loop).
- * @param arg Unused (NULL)
+ * @param arg Pointer to TetrisSession struct
  * @return Stub as NULL
  */
 void* game_handler(void* arg);
 
-/* ---- Signals and Memory Management ---- */
 /**
- * @brief Signal handler for SIGUSR1
- * @param signo The signal number
- */
-void sig_handler(int signo);
+ * @brief Performs one FSM step of the session bound to the calling thread,
+ * with the game mutex held by running sessions. Everything the step
+ * depends on besides the session state is the pending user input and
+ * tick_due, which makes the step replayable.
+ * @param session Current session
+ * @param tick_due Timer has reached the shift threshold
+ * @return true if the step consumed the timer tick
+ **/
+bool game_step(TetrisSession* session, bool tick_due);
 
+/* ---- Frame Export ---- */
 /**
- * @brief Frees up the memory allocated by the game.
- * @param tetris_game Game data struct
+ * @brief Starts exporting frames into a shared-memory ring. A ring already
+ * exported is unlinked first, even if the new one cannot be created.
+ * @param name POSIX shm name, memfd is used if NULL or empty
+ * @return true on success
+ **/
+bool export_frames(const char* name);
+
+/**
+ * @brief Stops exporting frames and unlinks the ring.
+ **/
+void stop_frame_export(void);
+
+/**
+ * @brief Publishes current state into the frame ring, if it has changed.
+ * Called by the game thread while holding the game mutex.
+ **/
+void publish_frame(void);
+
+/* ---- Sessions and Memory Management ---- */
+/**
+ * @brief Allocates a session and starts its (parked) threads.
+ * @return New session or NULL on failure
+ **/
+TetrisSession* session_create(void);
+
+/**
+ * @brief Stops session threads and frees up the memory of the session.
+ * Must not be called from the threads of the session itself.
+ * @param session Session to destroy
+ **/
+void session_destroy(TetrisSession* session);
+
+/**
+ * @brief Allocates a headless session: no threads, no score file and no
+ * leaderboard posts. The caller runs game_step() with the session bound
+ * to its thread (get_thread_session()).
+ * @return New session in START or NULL on failure
+ **/
+TetrisSession* session_create_headless(void);
+
+/**
+ * @brief Frees a headless session.
+ **/
+void session_free(TetrisSession* session);
+
+/**
+ * @brief Resets the session in place to a fresh START state.
+ * @param session Parked session
+ **/
+void session_reset(TetrisSession* session);
+
+/**
+ * @brief Takes a session from the pool, or creates one if it is empty.
+ * @return Running session or NULL on failure
+ **/
+TetrisSession* session_acquire(void);
+
+/**
+ * @brief Returns finished session back into the pool. If the pool is full
+ * the session is torn down instead. Called by the game thread on EXIT.
+ * @param session Finished session
+ * @return true if the session was parked in the pool
+ **/
+bool session_release(TetrisSession* session);
+
+/**
+ * @brief Sets the pool capacity, creating or destroying parked sessions.
+ * @param size Pool capacity
+ **/
+void set_session_pool_size(int size);
+
+/**
+ * @brief Seeds the PRNG of the session.
+ * @param session Session to seed
+ * @param seed Any value, zero is replaced with one
+ **/
+void session_seed_random(TetrisSession* session, uint64_t seed);
+
+/**
+ * @brief Next value of the current session PRNG (xorshift64*).
+ * Replaces rand(), so a snapshot fully determines upcoming figures.
+ * @return Pseudo-random 32-bit value
+ **/
+uint32_t session_random(void);
+
+/**
+ * @brief Blocks the calling session thread while the session is parked.
+ * @param session Session of the calling thread
+ **/
+void session_wait_while_parked(TetrisSession* session);
+
+/* ---- Snapshots ---- */
+/**
+ * @brief Takes a binary snapshot of the current game (see s21_snapshot.h).
+ * @param buffer Output buffer
+ * @param capacity Buffer size
+ * @return Snapshot size, 0 if no game is running. Nothing is copied if
+ * the size is larger than capacity
+ **/
+int snapshot_game(uint8_t* buffer, int capacity);
+
+/**
+ * @brief Restores the game from a binary snapshot, starting a new game if
+ * none is running.
+ * @param buffer Snapshot
+ * @param length Snapshot size
+ * @return true on success, the game is untouched otherwise
+ **/
+bool restore_game(const uint8_t* buffer, int length);
+
+/* ---- Hibernation ---- */
+/**
+ * @brief Sets idle timeout after which a session in START, PAUSE or
+ * GAMEOVER is hibernated. Starts the idle monitor on first use.
+ * @param timeout_ms Idle timeout, 0 disables hibernation
+ **/
+void set_hibernation_timeout(int timeout_ms);
+
+/**
+ * @brief Idle monitor thread function. Asks the game thread of an idle
+ * active session to hibernate it.
+ * @param arg Unused
+ * @return Stub as NULL
+ **/
+void* hibernation_monitor(void* arg);
+
+/**
+ * @brief Saves the session into the hibernation slot and detaches it.
+ * Called by the game thread, which then releases the session.
+ * @param session Session of the calling thread
+ * @return false if the session is not idle anymore
+ **/
+bool session_hibernate(TetrisSession* session);
+
+/**
+ * @brief Claims a session and restores the hibernated state into it.
+ * Called with the session mutex held.
+ **/
+void session_revive(void);
+
+/**
+ * @brief Claims a session, loads the state and makes it active.
+ * Called with the session mutex held.
+ * @param state State to start from
+ * @param journal Journal to continue, may be NULL
+ * @return Running session or NULL on failure
+ **/
+TetrisSession* session_start(const SessionState* state, Journal* journal);
+
+/**
+ * @brief Loads the state into a session whose threads are parked or
+ * blocked on the game and timer mutexes.
+ * @param session Target session
+ * @param state Decoded state
+ **/
+void session_load_state(TetrisSession* session, const SessionState* state);
+
+/**
+ * @brief Starts the idle monitor (once) and resets the idle timer.
+ * Called with the session mutex held.
+ **/
+void start_hibernation_monitor(void);
+
+/* ---- Replay Journal ---- */
+/**
+ * @brief Sets the directory for replay journals. Every new session (and
+ * every restored one) gets its own journal file there.
+ * @param directory Existing directory, NULL or "" disables journaling
+ **/
+void set_journal_directory(const char* directory);
+
+/**
+ * @brief Starts a journal from the current state of the session, if
+ * journaling is enabled. Called with the session mutex held.
+ * @param session Active session
+ **/
+void session_start_journal(TetrisSession* session);
+
+/**
+ * @brief Detaches and closes the journal of the active (or hibernated)
+ * session. Called with the session mutex held.
+ **/
+void session_close_journal(void);
+
+/**
+ * @brief Replays a journal on a headless session.
+ * @param path Journal file
+ * @param buffer Output buffer for the snapshot of the replayed game
+ * @param capacity Buffer size
+ * @return Snapshot size, 0 if the journal is malformed. Nothing is copied
+ * if the size is larger than capacity
+ **/
+int replay_journal(const char* path, uint8_t* buffer, int capacity);
+
+/**
+ * @brief Opens a tetris journal for playback, the player starts at step 0.
+ * @param path Journal file
+ * @return Player or NULL if the file is not a tetris journal
+ **/
+ReplayPlayer* replay_open(const char* path);
+
+/**
+ * @brief Moves the player to the state after the given number of steps.
+ * Restores the nearest keyframe at or before the step and plays the rest,
+ * so any step is at most JOURNAL_KEYFRAME_INTERVAL steps away.
+ * @return false if the journal ends before the step
+ **/
+bool replay_seek(ReplayPlayer* player, uint64_t step);
+
+/**
+ * @brief Plays one FSM step.
+ * @return false at the end of the journal
+ **/
+bool replay_step(ReplayPlayer* player);
+
+/**
+ * @brief Encodes the game at the current position.
+ * @return Snapshot size, nothing is copied if it is larger than capacity
+ **/
+int replay_snapshot(ReplayPlayer* player, uint8_t* buffer, int capacity);
+
+/**
+ * @brief Unmaps the journal and frees the player.
+ **/
+void replay_close(ReplayPlayer* player);
+
+/* ---- Rewind Buffer ---- */
+/**
+ * @brief Sets the memory budget of the rewind buffer. The current session
+ * starts a new buffer with the budget, so do the following ones.
+ * @param budget Bytes per session, 0 disables rewinding
+ **/
+void set_rewind_budget(int budget);
+
+/**
+ * @brief Starts a rewind buffer for the active (or hibernated) session,
+ * if rewinding is enabled. Called with the session mutex held.
+ * @param session Active session, NULL if it is hibernated
+ **/
+void session_start_rewind(TetrisSession* session);
+
+/**
+ * @brief Detaches and frees the rewind buffer of the active (or
+ * hibernated) session. Called with the session mutex held.
+ **/
+void session_close_rewind(void);
+
+/**
+ * @brief Steps of the current session that can be rebuilt.
+ * @return false if rewinding is disabled or no game is running
+ **/
+bool rewind_game_window(uint64_t* first, uint64_t* last);
+
+/**
+ * @brief Rebuilds the current session at a step of the rewind window on
+ * a headless session.
+ * @param step Step returned by rewind_game_window()
+ * @param buffer Output buffer for the snapshot
+ * @param capacity Buffer size
+ * @return Snapshot size, 0 if the step is outside of the window. Nothing
+ * is copied if the size is larger than capacity
+ **/
+int rewind_snapshot(uint64_t step, uint8_t* buffer, int capacity);
+
+/* ---- Leaderboard ---- */
+/**
+ * @brief Maps the leaderboard store shared by all sessions and processes
+ * (see s21_leaderboard.h), creating it if needed. Sessions post their
+ * final scores there and start with its best score.
+ * @param path Store file, NULL or empty string detaches the store
+ * @return false if the store cannot be mapped
+ **/
+bool open_leaderboard(const char* path);
+
+/**
+ * @brief Sets the name the following sessions post their scores under.
+ **/
+void set_player_name(const char* name);
+
+/**
+ * @brief Best tetris score of the leaderboard.
+ * @return 0 if no leaderboard is open
+ **/
+int leaderboard_game_best(void);
+
+/**
+ * @brief Rank a tetris score would have on the leaderboard, 1 is best.
+ * @return 0 if no leaderboard is open
+ **/
+int leaderboard_game_rank(int score);
+
+/**
+ * @brief Best tetris scores of the leaderboard, highest first.
+ * @param count Entries wanted
+ * @param scores Output scores, count elements
+ * @param players Output zero-padded names, count * LEADERBOARD_PLAYER_SIZE
+ * bytes, may be NULL
+ * @return Number of entries written
+ **/
+int leaderboard_game_top(int count, int* scores, char* players);
+
+/**
+ * @brief Best tetris score of the current player on the leaderboard.
+ * @return 0 if the player has not posted or no leaderboard is open
+ **/
+int leaderboard_player_game_best(void);
+
+/**
+ * @brief Attaches a leaderboard to a session and raises its high score
+ * to the best score of the store. Called with the session mutex held.
+ * @param session Session to attach to, NULL is ignored
+ * @param board Store, NULL detaches
+ **/
+void session_attach_leaderboard(TetrisSession* session, Leaderboard* board);
+
+/**
+ * @brief Serializes the session into a compact state.
+ * @param session Session with the game mutex held
+ * @param state Output state
+ **/
+void session_save_state(TetrisSession* session, SessionState* state);
+
+/**
+ * @brief Unpacks score, field and next figure of a saved state.
+ * @param state Saved state
+ * @param info Game info with allocated field and next
+ * @param with_figure Merge the falling figure into the field (unless the
+ * game is in START or SPAWN), as updateCurrentState() does
  **/
-void memfree(GameInfo_t* tetris_game);
+void session_state_render(const SessionState* state, GameInfo_t* info,
+                          bool with_figure);
 
 /* ---- Gameplay & Mechanics ---- */
 
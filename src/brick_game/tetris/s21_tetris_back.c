@@ -10,124 +10,470 @@
 /*                      SINGLETON-LIKE GETTERS & STATICS                      */
 /* -------------------------------------------------------------------------- */
 
-int*** get_sub_field(void) {
-  static int** subFieldPtr;
-  return &subFieldPtr;
+TetrisSession** get_active_session(void) {
+  static TetrisSession* activeSession;
+  return &activeSession;
 }
 
-int*** get_coords(void) {
-  static int** figureCoordsPtr;
-  return &figureCoordsPtr;
+TetrisSession** get_thread_session(void) {
+  static _Thread_local TetrisSession* threadSession;
+  return &threadSession;
 }
 
-GameInfo_t* get_info_instance(void) {
-  static GameInfo_t tetrisGame;
-  return &tetrisGame;
+TetrisSession* get_session(void) {
+  static TetrisSession detachedSession = {.status = EXIT};
+  TetrisSession* session = *get_thread_session();
+  if (session == NULL) {
+    session = *get_active_session();
+  }
+  return session != NULL ? session : &detachedSession;
+}
+
+pthread_mutex_t* get_session_mutex(void) {
+  static pthread_mutex_t sessionMutex = PTHREAD_MUTEX_INITIALIZER;
+  return &sessionMutex;
+}
+
+SessionPool* get_session_pool(void) {
+  static SessionPool sessionPool = {PTHREAD_MUTEX_INITIALIZER, NULL, 0, 1};
+  return &sessionPool;
+}
+
+Hibernation* get_hibernation_instance(void) {
+  static Hibernation hibernation = {.timeout_ms = 30000,
+                                    .monitor_cond = PTHREAD_COND_INITIALIZER};
+  return &hibernation;
+}
+
+JournalSettings* get_journal_settings(void) {
+  static JournalSettings settings;
+  return &settings;
+}
+
+RewindSettings* get_rewind_settings(void) {
+  static RewindSettings settings;
+  return &settings;
+}
+
+LeaderboardSettings* get_leaderboard_settings(void) {
+  static LeaderboardSettings settings = {NULL, "player"};
+  return &settings;
 }
 
-GameStatus_t* get_status_instance(void) {
-  static GameStatus_t gameStatus;
-  return &gameStatus;
+int* get_best_score(void) {
+  static int bestScore;
+  return &bestScore;
 }
 
+int*** get_sub_field(void) { return &get_session()->sub_field; }
+
+int*** get_coords(void) { return &get_session()->coords; }
+
+GameInfo_t* get_info_instance(void) { return &get_session()->info; }
+
+GameStatus_t* get_status_instance(void) { return &get_session()->status; }
+
 ThreadStruct* get_thread_struct_instance() {
-  static ThreadStruct timerThreadStruct;
-  return &timerThreadStruct;
+  return &get_session()->timer_thread;
 }
 
 ThreadStruct* get_game_thread_struct_instance() {
-  static ThreadStruct gameThreadStruct;
-  return &gameThreadStruct;
+  return &get_session()->game_thread;
 }
 
 int get_figure_index(int* index) {
-  static int figIndex;
+  TetrisSession* session = get_session();
   if (index != NULL) {
-    figIndex = *index;
+    session->figure_index = *index;
   }
-  return figIndex;
+  return session->figure_index;
 }
 
-float* get_timer(void) {
-  static float gameTimer;
-  return &gameTimer;
+float* get_timer(void) { return &get_session()->timer; }
+
+int* get_first_plant_flag() { return &get_session()->first_plant_flag; }
+
+UserAction_t* get_action_instance() { return &get_session()->action; }
+
+bool* get_hold_instance() { return &get_session()->hold; }
+
+FrameRing** get_frame_ring_instance() {
+  static FrameRing* frameRing;
+  return &frameRing;
 }
 
-pthread_t* get_main_thread() {
-  static pthread_t mainThread;
-  return &mainThread;
+pthread_mutex_t* get_frame_ring_mutex() {
+  static pthread_mutex_t frameRingMutex = PTHREAD_MUTEX_INITIALIZER;
+  return &frameRingMutex;
 }
 
-bool* get_signal_handled_flag() {
-  static bool signalHandled;
-  return &signalHandled;
+static Frame* get_last_frame_instance() {
+  static Frame lastFrame;
+  return &lastFrame;
 }
 
-int* get_first_plant_flag() {
-  static int firstPlantFlag;
-  return &firstPlantFlag;
+/* -------------------------------------------------------------------------- */
+/*                               FRAME EXPORT                                 */
+/* -------------------------------------------------------------------------- */
+
+bool export_frames(const char* name) {
+  /* The old ring unlinks its name, so it goes before the new one takes it */
+  stop_frame_export();
+  FrameRing* frameRing = frame_ring_create(name, FRAME_RING_DEFAULT_SLOTS);
+  if (frameRing == NULL) {
+    return false;
+  }
+
+  pthread_mutex_lock(get_frame_ring_mutex());
+  *get_frame_ring_instance() = frameRing;
+  get_last_frame_instance()->status = -1;
+  pthread_mutex_unlock(get_frame_ring_mutex());
+  return true;
 }
 
-UserAction_t* get_action_instance() {
-  static UserAction_t action;
-  return &action;
+void stop_frame_export(void) {
+  pthread_mutex_lock(get_frame_ring_mutex());
+  FrameRing* frameRing = *get_frame_ring_instance();
+  *get_frame_ring_instance() = NULL;
+  pthread_mutex_unlock(get_frame_ring_mutex());
+
+  frame_ring_destroy(frameRing);
 }
 
-bool* get_hold_instance() {
-  static bool hold;
-  return &hold;
+void publish_frame(void) {
+  pthread_mutex_lock(get_frame_ring_mutex());
+  FrameRing* frameRing = *get_frame_ring_instance();
+  if (frameRing != NULL) {
+    GameInfo_t* tetrisGame = get_info_instance();
+    GameStatus_t gameStatus = *get_status_instance();
+    Frame* lastFrame = get_last_frame_instance();
+    Frame frame;
+    memset(&frame, 0, sizeof(frame));
+
+    frame.status = gameStatus;
+    frame.score = tetrisGame->score;
+    frame.high_score = tetrisGame->high_score;
+    frame.level = tetrisGame->level;
+    frame.speed = tetrisGame->speed;
+    frame.pause = tetrisGame->pause;
+    frame.rows = ROWS_FIELD;
+    frame.cols = COLS_FIELD;
+
+    if (gameStatus != START) {
+      for (int i = 0; i < ROWS_FIELD; ++i) {
+        for (int j = 0; j < COLS_FIELD; ++j) {
+          frame.field[i][j] = tetrisGame->field[i][j];
+        }
+      }
+      for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+          frame.next[i][j] = tetrisGame->next[i][j];
+        }
+      }
+      if (gameStatus != SPAWN) {
+        int** coords = *get_coords();
+        for (int i = 0; i < 4; ++i) {
+          if (coords[0][i] >= 0 && coords[0][i] < ROWS_FIELD)
+            frame.field[coords[0][i]][coords[1][i]] = get_figure_index(NULL);
+        }
+      }
+    }
+
+    /* Readers only care about changes, so identical frames are not exported */
+    frame.generation = lastFrame->generation;
+    if (memcmp(&frame, lastFrame, sizeof(Frame)) != 0) {
+      frame_ring_publish(frameRing, &frame);
+      *lastFrame = frame;
+    }
+  }
+  pthread_mutex_unlock(get_frame_ring_mutex());
 }
 
 /* -------------------------------------------------------------------------- */
-/*                           SIGNAL HANDLER & FREE                            */
+/*                          SESSIONS & SESSION POOL                           */
 /* -------------------------------------------------------------------------- */
 
-/**
- * @brief Signal handler for SIGUSR1
- */
-void sig_handler(int signo) {
-  if (signo == SIGUSR1) {
-    bool* threadsStoppedFlag = get_signal_handled_flag();
-    if (*threadsStoppedFlag == false) {
-      *threadsStoppedFlag = true;
-      memfree(get_info_instance());
+static void session_free_memory(TetrisSession* session) {
+  if (session->info.field != NULL) {
+    for (int i = 0; i < ROWS_FIELD; ++i) {
+      free(session->info.field[i]);
     }
   }
-}
+  if (session->sub_field != NULL) {
+    for (int i = 0; i < ROWS_FIELD; ++i) {
+      free(session->sub_field[i]);
+    }
+  }
+  free(session->info.field);
+  free(session->sub_field);
 
-void memfree(GameInfo_t* tetrisGame) {
-  /* Cancel timer thread */
-  ThreadStruct* timerThread = get_thread_struct_instance();
-  pthread_cancel(timerThread->thread);
-  pthread_join(timerThread->thread, NULL);
-  pthread_mutex_destroy(&timerThread->mutex);
+  if (session->info.next != NULL) {
+    for (int i = 0; i < 4; ++i) {
+      free(session->info.next[i]);
+    }
+  }
+  free(session->info.next);
+
+  if (session->coords != NULL) {
+    for (int i = 0; i < 2; ++i) {
+      free(session->coords[i]);
+    }
+  }
+  free(session->coords);
 
-  /* Cancel game thread */
-  ThreadStruct* gameThread = get_game_thread_struct_instance();
-  pthread_mutex_destroy(&gameThread->mutex);
-  pthread_cancel(gameThread->thread);
-  pthread_join(gameThread->thread, NULL);
+  pthread_mutex_destroy(&session->timer_thread.mutex);
+  pthread_mutex_destroy(&session->game_thread.mutex);
+  pthread_mutex_destroy(&session->park_mutex);
+  pthread_cond_destroy(&session->park_cond);
+  free(session);
+}
 
-  /* Free fields */
-  int*** subFieldPtr = get_sub_field();
-  int** coordsPtr = *get_coords();
+static void session_stop_thread(TetrisSession* session, pthread_t thread) {
+  pthread_mutex_lock(&session->park_mutex);
+  session->stop = true;
+  pthread_cond_broadcast(&session->park_cond);
+  pthread_mutex_unlock(&session->park_mutex);
+  pthread_join(thread, NULL);
+}
+
+/* Allocates a session without threads, as used by replays */
+static TetrisSession* session_alloc(void) {
+  TetrisSession* session = (TetrisSession*)calloc(1, sizeof(TetrisSession));
+  if (session == NULL) {
+    return NULL;
+  }
 
+  /* Allocate memory for field and sub-field */
+  session->info.field = (int**)calloc(ROWS_FIELD, sizeof(int*));
+  session->sub_field = (int**)calloc(ROWS_FIELD, sizeof(int*));
   for (int i = 0; i < ROWS_FIELD; ++i) {
-    free(tetrisGame->field[i]);
-    free((*subFieldPtr)[i]);
+    session->info.field[i] = (int*)calloc(COLS_FIELD, sizeof(int));
+    session->sub_field[i] = (int*)calloc(COLS_FIELD, sizeof(int));
   }
-  free(tetrisGame->field);
-  free(*subFieldPtr);
 
+  /* Allocate memory for next figure */
+  session->info.next = (int**)calloc(4, sizeof(int*));
   for (int i = 0; i < 4; ++i) {
-    free(tetrisGame->next[i]);
+    session->info.next[i] = (int*)calloc(4, sizeof(int));
+  }
+
+  /* Allocate memory for coordinates */
+  session->coords = (int**)calloc(2, sizeof(int*));
+  for (int i = 0; i < 2; ++i) {
+    session->coords[i] = (int*)calloc(4, sizeof(int));
+  }
+
+  pthread_mutex_init(&session->timer_thread.mutex, NULL);
+  pthread_mutex_init(&session->game_thread.mutex, NULL);
+  pthread_mutex_init(&session->park_mutex, NULL);
+  pthread_cond_init(&session->park_cond, NULL);
+  session_reset(session);
+  return session;
+}
+
+TetrisSession* session_create(void) {
+  TetrisSession* session = session_alloc();
+  if (session == NULL) {
+    return NULL;
+  }
+
+  /* Load high score, pending updates included */
+  session->info.high_score = score_writer_load(SCORE_FILE);
+  session->parked = true;
+
+  /* Threads start parked and wait for the session to be claimed */
+  pthread_create(&session->timer_thread.thread, NULL, timer_handler, session);
+  pthread_create(&session->game_thread.thread, NULL, game_handler, session);
+  return session;
+}
+
+void session_destroy(TetrisSession* session) {
+  if (session == NULL) return;
+  session_stop_thread(session, session->timer_thread.thread);
+  pthread_join(session->game_thread.thread, NULL);
+  session_free_memory(session);
+}
+
+TetrisSession* session_create_headless(void) {
+  TetrisSession* session = session_alloc();
+  if (session != NULL) {
+    session->headless = true;
   }
-  free(tetrisGame->next);
+  return session;
+}
+
+void session_free(TetrisSession* session) {
+  if (session == NULL) return;
+  session_free_memory(session);
+}
+
+void session_reset(TetrisSession* session) {
+  session->status = START;
+  session->action = Up;
+  session->hold = false;
+  session->info.score = 0;
+  session->info.speed = 1;
+  session->info.pause = 0;
+  session->info.level = 1;
+  session->first_plant_flag = 0;
+  session->figure_index = 0;
+  session->handler_figure_index = 0;
+  session->attach_flag = false;
+  session->input_count = 0;
+  session->settled_input_count = 0;
+  session->hibernate_requested = false;
+  session_seed_random(session, (uint64_t)time(NULL) ^ (uintptr_t)session);
 
+  for (int i = 0; i < ROWS_FIELD; ++i) {
+    memset(session->info.field[i], 0, COLS_FIELD * sizeof(int));
+    memset(session->sub_field[i], 0, COLS_FIELD * sizeof(int));
+  }
+  for (int i = 0; i < 4; ++i) {
+    memset(session->info.next[i], 0, 4 * sizeof(int));
+  }
   for (int i = 0; i < 2; ++i) {
-    free(coordsPtr[i]);
+    memset(session->coords[i], 0, 4 * sizeof(int));
+  }
+
+  pthread_mutex_lock(&session->timer_thread.mutex);
+  session->timer = 0;
+  pthread_mutex_unlock(&session->timer_thread.mutex);
+}
+
+/* Takes a session out of the pool (or creates one), threads stay parked */
+static TetrisSession* session_claim(void) {
+  SessionPool* pool = get_session_pool();
+  pthread_mutex_lock(&pool->mutex);
+  TetrisSession* session = pool->head;
+  if (session != NULL) {
+    pool->head = session->next_pooled;
+    pool->size--;
+  }
+  pthread_mutex_unlock(&pool->mutex);
+
+  if (session == NULL) {
+    session = session_create();
+  }
+  if (session != NULL) {
+    session->next_pooled = NULL;
+  }
+  return session;
+}
+
+static void session_wake(TetrisSession* session) {
+  pthread_mutex_lock(&session->park_mutex);
+  session->parked = false;
+  pthread_cond_broadcast(&session->park_cond);
+  pthread_mutex_unlock(&session->park_mutex);
+}
+
+TetrisSession* session_acquire(void) {
+  TetrisSession* session = session_claim();
+  if (session != NULL) {
+    if (*get_best_score() > session->info.high_score) {
+      session->info.high_score = *get_best_score();
+    }
+    pthread_mutex_lock(&session->timer_thread.mutex);
+    session->timer = 0;
+    pthread_mutex_unlock(&session->timer_thread.mutex);
+    session_wake(session);
   }
-  free(coordsPtr);
+  return session;
+}
+
+bool session_release(TetrisSession* session) {
+  /* Hibernated session has handed its journal over, others end it here */
+  journal_close(session->journal);
+  session->journal = NULL;
+
+  /* Detach the session, so the controller can not reach it anymore */
+  pthread_mutex_lock(get_session_mutex());
+  if (*get_active_session() == session) {
+    session_close_rewind();
+    *get_active_session() = NULL;
+  }
+  session->rewind = NULL;
+  session->leaderboard = NULL;
+  if (session->info.high_score > *get_best_score()) {
+    *get_best_score() = session->info.high_score;
+  }
+  pthread_mutex_unlock(get_session_mutex());
+
+  SessionPool* pool = get_session_pool();
+  pthread_mutex_lock(&pool->mutex);
+  bool pooled = pool->size < pool->capacity;
+  if (pooled) {
+    session_reset(session);
+    pthread_mutex_lock(&session->park_mutex);
+    session->parked = true;
+    pthread_mutex_unlock(&session->park_mutex);
+    session->next_pooled = pool->head;
+    pool->head = session;
+    pool->size++;
+  }
+  pthread_mutex_unlock(&pool->mutex);
+
+  if (!pooled) {
+    /* Game thread can not join itself, so it only stops the timer thread */
+    session_stop_thread(session, session->timer_thread.thread);
+    pthread_detach(session->game_thread.thread);
+    session_free_memory(session);
+  }
+  return pooled;
+}
+
+void set_session_pool_size(int size) {
+  SessionPool* pool = get_session_pool();
+  TetrisSession* extra = NULL;
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->capacity = size > 0 ? size : 0;
+  while (pool->size > pool->capacity) {
+    TetrisSession* session = pool->head;
+    pool->head = session->next_pooled;
+    pool->size--;
+    session->next_pooled = extra;
+    extra = session;
+  }
+  int missing = pool->capacity - pool->size;
+  pthread_mutex_unlock(&pool->mutex);
+
+  while (extra != NULL) {
+    TetrisSession* next = extra->next_pooled;
+    session_destroy(extra);
+    extra = next;
+  }
+
+  for (int i = 0; i < missing; ++i) {
+    TetrisSession* session = session_create();
+    if (session == NULL) break;
+    pthread_mutex_lock(&pool->mutex);
+    session->next_pooled = pool->head;
+    pool->head = session;
+    pool->size++;
+    pthread_mutex_unlock(&pool->mutex);
+  }
+}
+
+void session_seed_random(TetrisSession* session, uint64_t seed) {
+  session->rng_state = seed != 0 ? seed : 1;
+}
+
+uint32_t session_random(void) {
+  /* xorshift64*: the whole generator state is a single word */
+  uint64_t* state = &get_session()->rng_state;
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return (*state * 2685821657736338717ull) >> 32;
+}
+
+void session_wait_while_parked(TetrisSession* session) {
+  pthread_mutex_lock(&session->park_mutex);
+  while (session->parked && !session->stop) {
+    pthread_cond_wait(&session->park_cond, &session->park_mutex);
+  }
+  pthread_mutex_unlock(&session->park_mutex);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -135,11 +481,15 @@ void memfree(GameInfo_t* tetrisGame) {
 /* -------------------------------------------------------------------------- */
 
 void* timer_handler(void* arg) {
+  TetrisSession* session = (TetrisSession*)arg;
+  *get_thread_session() = session;
+
   float* gameTimer = get_timer();
   ThreadStruct* timerThread = get_thread_struct_instance();
-  GameInfo_t* gameInfo = (GameInfo_t*)arg;
+  GameInfo_t* gameInfo = get_info_instance();
 
-  while (*get_status_instance() != EXIT) {
+  while (!session->stop) {
+    session_wait_while_parked(session);
     pthread_mutex_lock(&timerThread->mutex);
     if (gameInfo->speed == 1) {
       *gameTimer += 150 * 1e-3f;
@@ -157,77 +507,697 @@ void* timer_handler(void* arg) {
 /* -------------------------------------------------------------------------- */
 
 void initialize_game(void) {
-  srand(time(NULL));
-  GameInfo_t* tetrisGame = get_info_instance();
-  GameStatus_t* gameStatus = get_status_instance();
-  *gameStatus = START;
+  TetrisSession* session = session_acquire();
+  Hibernation* hibernation = get_hibernation_instance();
+
+  pthread_mutex_lock(get_session_mutex());
+  session_close_journal();
+  session_close_rewind();
+  session_attach_leaderboard(*get_active_session(), NULL);
+  *get_active_session() = session;
+  hibernation->active = false;
+  if (session != NULL) {
+    session_start_journal(session);
+    session_start_rewind(session);
+    session_attach_leaderboard(session, get_leaderboard_settings()->board);
+  }
+  start_hibernation_monitor();
+  pthread_mutex_unlock(get_session_mutex());
+}
 
-  UserAction_t* currentAction = get_action_instance();
-  *currentAction = Up;
+/* -------------------------------------------------------------------------- */
+/*                           SNAPSHOT & RESTORE                               */
+/* -------------------------------------------------------------------------- */
 
-  int*** subFieldPtr = get_sub_field();
-  tetrisGame->score = 0;
-  tetrisGame->speed = 1;
-  tetrisGame->pause = 0;
-  tetrisGame->level = 1;
-  *get_first_plant_flag() = 0;
+int snapshot_game(uint8_t* buffer, int capacity) {
+  SessionState state;
+  bool captured = true;
+
+  pthread_mutex_lock(get_session_mutex());
+  TetrisSession* session = *get_active_session();
+  Hibernation* hibernation = get_hibernation_instance();
+  if (session != NULL) {
+    pthread_mutex_lock(&session->game_thread.mutex);
+    pthread_mutex_lock(&session->timer_thread.mutex);
+    session_save_state(session, &state);
+    pthread_mutex_unlock(&session->timer_thread.mutex);
+    pthread_mutex_unlock(&session->game_thread.mutex);
+  } else if (hibernation->active) {
+    state = hibernation->state;
+  } else {
+    captured = false;
+  }
+  pthread_mutex_unlock(get_session_mutex());
 
-  bool* threadsStoppedFlag = get_signal_handled_flag();
-  *threadsStoppedFlag = false;
+  size_t size = 0;
+  if (captured) {
+    size = snapshot_encode(&state, buffer, capacity > 0 ? capacity : 0);
+  }
+  return (int)size;
+}
 
-  /* Allocate memory for field and sub-field */
-  tetrisGame->field = (int**)calloc(ROWS_FIELD, sizeof(int*));
-  *subFieldPtr = (int**)calloc(ROWS_FIELD, sizeof(int*));
-  for (int i = 0; i < ROWS_FIELD; ++i) {
-    tetrisGame->field[i] = (int*)calloc(COLS_FIELD, sizeof(int));
-    (*subFieldPtr)[i] = (int*)calloc(COLS_FIELD, sizeof(int));
+bool restore_game(const uint8_t* buffer, int length) {
+  SessionState state;
+  if (length <= 0 || !snapshot_decode(buffer, length, &state)) {
+    return false;
   }
 
-  /* Allocate memory for next figure */
-  tetrisGame->next = (int**)calloc(4, sizeof(int*));
-  for (int i = 0; i < 4; ++i) {
-    tetrisGame->next[i] = (int*)calloc(4, sizeof(int));
+  bool result = true;
+  pthread_mutex_lock(get_session_mutex());
+  /* Restored state does not follow from the journal, start a new one */
+  session_close_journal();
+  session_close_rewind();
+  TetrisSession* session = *get_active_session();
+  Hibernation* hibernation = get_hibernation_instance();
+  if (session != NULL) {
+    /* Both session threads wait on these mutexes while the state changes */
+    pthread_mutex_lock(&session->game_thread.mutex);
+    pthread_mutex_lock(&session->timer_thread.mutex);
+    session_load_state(session, &state);
+    session->input_count++;
+    pthread_mutex_unlock(&session->timer_thread.mutex);
+    pthread_mutex_unlock(&session->game_thread.mutex);
+  } else {
+    hibernation->active = false;
+    result = session_start(&state, NULL) != NULL;
   }
+  if (result) {
+    start_hibernation_monitor();
+  }
+  if (*get_active_session() != NULL) {
+    session_start_journal(*get_active_session());
+    session_start_rewind(*get_active_session());
+  }
+  pthread_mutex_unlock(get_session_mutex());
+  return result;
+}
 
-  /* Allocate memory for coordinates */
-  int*** coordsPtr = get_coords();
-  (*coordsPtr) = (int**)calloc(2, sizeof(int*));
+/* -------------------------------------------------------------------------- */
+/*                              HIBERNATION                                   */
+/* -------------------------------------------------------------------------- */
+
+void start_hibernation_monitor(void) {
+  Hibernation* hibernation = get_hibernation_instance();
+  clock_gettime(CLOCK_MONOTONIC, &hibernation->last_activity);
+  if (!hibernation->monitor_started) {
+    pthread_t monitor;
+    if (pthread_create(&monitor, NULL, hibernation_monitor, NULL) == 0) {
+      pthread_detach(monitor);
+      hibernation->monitor_started = true;
+    }
+  }
+}
+
+void set_hibernation_timeout(int timeout_ms) {
+  Hibernation* hibernation = get_hibernation_instance();
+  pthread_mutex_lock(get_session_mutex());
+  hibernation->timeout_ms = timeout_ms > 0 ? timeout_ms : 0;
+  pthread_cond_signal(&hibernation->monitor_cond);
+  pthread_mutex_unlock(get_session_mutex());
+}
+
+void* hibernation_monitor(void* arg) {
+  (void)arg;
+  Hibernation* hibernation = get_hibernation_instance();
+
+  pthread_mutex_lock(get_session_mutex());
+  while (true) {
+    /* Poll four times per timeout, but not more often than every 10 ms */
+    int period = 1000;
+    if (hibernation->timeout_ms > 0 && hibernation->timeout_ms / 4 < period) {
+      period = hibernation->timeout_ms > 40 ? hibernation->timeout_ms / 4 : 10;
+    }
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += (long)period * 1000000L;
+    deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+    deadline.tv_nsec %= 1000000000L;
+    pthread_cond_timedwait(&hibernation->monitor_cond, get_session_mutex(),
+                           &deadline);
+
+    TetrisSession* session = *get_active_session();
+    if (session == NULL || hibernation->timeout_ms == 0) continue;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long idle = (now.tv_sec - hibernation->last_activity.tv_sec) * 1000L +
+                (now.tv_nsec - hibernation->last_activity.tv_nsec) / 1000000L;
+    if (idle >= hibernation->timeout_ms) {
+      /* The game thread saves the session at the end of its next step */
+      pthread_mutex_lock(&session->game_thread.mutex);
+      session->hibernate_requested = true;
+      pthread_mutex_unlock(&session->game_thread.mutex);
+    }
+  }
+  pthread_mutex_unlock(get_session_mutex());
+  return NULL;
+}
+
+bool session_hibernate(TetrisSession* session) {
+  bool hibernated = false;
+  pthread_mutex_lock(get_session_mutex());
+  pthread_mutex_lock(&session->game_thread.mutex);
+  session->hibernate_requested = false;
+
+  GameStatus_t status = session->status;
+  if (*get_active_session() == session &&
+      session->settled_input_count == session->input_count &&
+      (status == START || status == PAUSE || status == GAMEOVER)) {
+    Hibernation* hibernation = get_hibernation_instance();
+    pthread_mutex_lock(&session->timer_thread.mutex);
+    session_save_state(session, &hibernation->state);
+    pthread_mutex_unlock(&session->timer_thread.mutex);
+    hibernation->journal = session->journal;
+    session->journal = NULL;
+    hibernation->active = true;
+    *get_active_session() = NULL;
+    hibernated = true;
+  }
+  pthread_mutex_unlock(&session->game_thread.mutex);
+  pthread_mutex_unlock(get_session_mutex());
+  return hibernated;
+}
+
+void session_revive(void) {
+  Hibernation* hibernation = get_hibernation_instance();
+  session_start(&hibernation->state, hibernation->journal);
+  hibernation->journal = NULL;
+  hibernation->active = false;
+}
+
+TetrisSession* session_start(const SessionState* state, Journal* journal) {
+  TetrisSession* session = session_claim();
+  if (session == NULL) {
+    journal_close(journal);
+    return NULL;
+  }
+
+  /* Threads of a claimed session are parked, nothing races with us */
+  session_load_state(session, state);
+  session->journal = journal;
+  session->journaled_input_count = session->input_count;
+  session->rewind = get_rewind_settings()->buffer;
+  session->rewound_input_count = session->input_count;
+  session_attach_leaderboard(session, get_leaderboard_settings()->board);
+  if (*get_best_score() > session->info.high_score) {
+    session->info.high_score = *get_best_score();
+  }
+  *get_active_session() = session;
+  session_wake(session);
+  return session;
+}
+
+void session_load_state(TetrisSession* session, const SessionState* state) {
+  session_state_render(state, &session->info, false);
+  session->status = (GameStatus_t)state->status;
+  session->action = (UserAction_t)state->action;
+  session->hold = false;
+  session->attach_flag = state->flags & 2;
+  session->first_plant_flag = (state->flags & 4) != 0;
+  session->figure_index = state->figure_index;
+  session->handler_figure_index = state->handler_figure_index;
+  session->timer = state->timer;
+  session_seed_random(session, state->rng_state);
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      session->coords[i][j] = state->coords[i][j];
+    }
+  }
+}
+
+void session_save_state(TetrisSession* session, SessionState* state) {
+  GameInfo_t* info = &session->info;
+  memset(state, 0, sizeof(SessionState));
+  state->status = session->status;
+  state->action = session->action;
+  state->flags = (info->pause ? 1 : 0) | (session->attach_flag ? 2 : 0) |
+                 (session->first_plant_flag ? 4 : 0);
+  state->score = info->score;
+  state->high_score = info->high_score;
+  state->level = info->level;
+  state->speed = info->speed;
+  state->figure_index = session->figure_index;
+  state->handler_figure_index = session->handler_figure_index;
+  state->timer = session->timer;
+  state->rng_state = session->rng_state;
+
+  state->next_index = SESSION_STATE_NO_FIGURE;
+  for (int i = 0; i < 7; ++i) {
+    if (is_equal(info->next, tet_fig[i])) {
+      state->next_index = i;
+    }
+  }
   for (int i = 0; i < 2; ++i) {
-    (*coordsPtr)[i] = (int*)calloc(4, sizeof(int));
+    for (int j = 0; j < 4; ++j) {
+      state->coords[i][j] = session->coords[i][j];
+    }
+  }
+  for (int i = 0; i < ROWS_FIELD * COLS_FIELD; ++i) {
+    int cell = info->field[i / COLS_FIELD][i % COLS_FIELD] & 0xf;
+    state->field[i / 2] |= i % 2 ? cell << 4 : cell;
+  }
+}
+
+void session_state_render(const SessionState* state, GameInfo_t* info,
+                          bool with_figure) {
+  info->score = state->score;
+  info->high_score = state->high_score;
+  info->level = state->level;
+  info->speed = state->speed;
+  info->pause = state->flags & 1;
+
+  for (int i = 0; i < ROWS_FIELD * COLS_FIELD; ++i) {
+    uint8_t cells = state->field[i / 2];
+    info->field[i / COLS_FIELD][i % COLS_FIELD] =
+        i % 2 ? cells >> 4 : cells & 0xf;
+  }
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      info->next[i][j] = state->next_index < 7
+                             ? tet_fig[state->next_index][i][j]
+                             : 0;
+    }
+  }
+  if (with_figure && state->status != START && state->status != SPAWN) {
+    for (int i = 0; i < 4; ++i) {
+      if (state->coords[0][i] >= 0 && state->coords[0][i] < ROWS_FIELD) {
+        info->field[state->coords[0][i]][state->coords[1][i]] =
+            state->figure_index;
+      }
+    }
   }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                             REPLAY JOURNAL                                 */
+/* -------------------------------------------------------------------------- */
 
-  /* Load high score from file */
-  FILE* database = fopen("tetris_score", "a+");
-  fscanf(database, "%d", &tetrisGame->high_score);
-  fclose(database);
+void set_journal_directory(const char* directory) {
+  JournalSettings* settings = get_journal_settings();
+  pthread_mutex_lock(get_session_mutex());
+  settings->directory[0] = '\0';
+  if (directory != NULL && strlen(directory) < JOURNAL_PATH_SIZE) {
+    strcpy(settings->directory, directory);
+  }
+  pthread_mutex_unlock(get_session_mutex());
+}
 
-  /* Store current thread as the main thread */
-  *get_main_thread() = pthread_self();
+void session_start_journal(TetrisSession* session) {
+  JournalSettings* settings = get_journal_settings();
+  if (settings->directory[0] == '\0') return;
+
+  char path[JOURNAL_PATH_SIZE + 64];
+  snprintf(path, sizeof(path), "%s/tetris-%ld-%u.bgj", settings->directory,
+           (long)time(NULL), ++settings->count);
+
+  /* The journal starts between two FSM steps */
+  SessionState state;
+  uint8_t buffer[SNAPSHOT_TETRIS_SIZE];
+  pthread_mutex_lock(&session->game_thread.mutex);
+  pthread_mutex_lock(&session->timer_thread.mutex);
+  session_save_state(session, &state);
+  pthread_mutex_unlock(&session->timer_thread.mutex);
+  size_t size = snapshot_encode(&state, buffer, sizeof(buffer));
+  session->journal = journal_open(path, SNAPSHOT_ENGINE_TETRIS,
+                                  state.rng_state, buffer, size);
+  session->journaled_input_count = session->input_count;
+  pthread_mutex_unlock(&session->game_thread.mutex);
+}
 
-  /* Set up signal handler for SIGUSR1 */
-  struct sigaction sa;
-  sa.sa_handler = sig_handler;
-  sigemptyset(&sa.sa_mask);
-  sa.sa_flags = 0;
-  sigaction(SIGUSR1, &sa, NULL);
+void session_close_journal(void) {
+  TetrisSession* session = *get_active_session();
+  Hibernation* hibernation = get_hibernation_instance();
+  Journal* journal = hibernation->journal;
+  hibernation->journal = NULL;
+  if (session != NULL) {
+    pthread_mutex_lock(&session->game_thread.mutex);
+    journal = session->journal;
+    session->journal = NULL;
+    pthread_mutex_unlock(&session->game_thread.mutex);
+  }
+  journal_close(journal);
+}
 
-  /* Create and init the timer thread */
-  ThreadStruct* timerThread = get_thread_struct_instance();
-  pthread_create(&timerThread->thread, NULL, timer_handler,
-                 get_info_instance());
-  pthread_mutex_init(&timerThread->mutex, NULL);
+int replay_journal(const char* path, uint8_t* buffer, int capacity) {
+  ReplayPlayer* player = replay_open(path);
+  int size = 0;
+  if (player != NULL && replay_seek(player, player->reader.steps)) {
+    size = replay_snapshot(player, buffer, capacity);
+  }
+  replay_close(player);
+  return size;
+}
+
+static bool replay_restart(ReplayPlayer* player, const uint8_t* state,
+                           size_t size, uint64_t step) {
+  SessionState decoded;
+  if (!snapshot_decode(state, size, &decoded)) {
+    return false;
+  }
+  session_load_state(player->session, &decoded);
+  player->step = step;
+  player->quiet = 0;
+  player->pending = false;
+  return true;
+}
+
+ReplayPlayer* replay_open(const char* path) {
+  ReplayPlayer* player = (ReplayPlayer*)calloc(1, sizeof(ReplayPlayer));
+  if (player == NULL) {
+    return NULL;
+  }
+  if (path == NULL || !journal_reader_open(&player->reader, path)) {
+    free(player);
+    return NULL;
+  }
+  JournalReader* reader = &player->reader;
+  if (reader->engine == SNAPSHOT_ENGINE_TETRIS) {
+    player->session = session_alloc();
+  }
+  if (player->session != NULL) {
+    player->session->headless = true;
+  }
+  if (player->session == NULL ||
+      !replay_restart(player, reader->state, reader->state_size, 0)) {
+    replay_close(player);
+    return NULL;
+  }
+  return player;
+}
+
+/* Headless session has no threads, so steps run without the mutexes, but
+   the getters resolve through the thread session */
+static bool replay_step_bound(ReplayPlayer* player) {
+  JournalRecord* record = &player->record;
+  while (player->quiet == 0 && !player->pending) {
+    if (!journal_reader_next(&player->reader, record)) {
+      return false;
+    }
+    /* Keyframe follows its quiet steps, a record is the last of them */
+    if ((record->flags & JOURNAL_KEYFRAME) != 0) {
+      player->quiet = record->delta;
+    } else {
+      player->quiet = record->delta != 0 ? record->delta - 1 : 0;
+      player->pending = true;
+    }
+  }
+
+  TetrisSession* session = player->session;
+  if (player->quiet != 0) {
+    player->quiet--;
+    game_step(session, false);
+  } else {
+    player->pending = false;
+    if (record->flags & JOURNAL_INPUT) {
+      session->action = (UserAction_t)(record->flags & JOURNAL_ACTION_MASK);
+      session->hold = record->flags & JOURNAL_HOLD;
+    }
+    game_step(session, record->flags & JOURNAL_TICK);
+  }
+  player->step++;
+  return true;
+}
+
+bool replay_step(ReplayPlayer* player) {
+  TetrisSession* bound = *get_thread_session();
+  *get_thread_session() = player->session;
+  bool result = replay_step_bound(player);
+  *get_thread_session() = bound;
+  return result;
+}
+
+bool replay_seek(ReplayPlayer* player, uint64_t step) {
+  JournalReader* reader = &player->reader;
+  /* Last keyframe at or before the step */
+  size_t low = 0;
+  size_t high = reader->keyframe_count;
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    if (reader->keyframes[middle].step <= step) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  uint64_t base = low != 0 ? reader->keyframes[low - 1].step : 0;
+
+  TetrisSession* bound = *get_thread_session();
+  *get_thread_session() = player->session;
+  bool result = true;
+  /* Playing forward is cheaper if no keyframe lies between */
+  if (step < player->step || base > player->step) {
+    if (low == 0) {
+      reader->position = journal_reader_first_entry(reader);
+      result = replay_restart(player, reader->state, reader->state_size, 0);
+    } else {
+      JournalRecord record;
+      reader->position = reader->keyframes[low - 1].offset;
+      result = journal_reader_next(reader, &record) &&
+               (record.flags & JOURNAL_KEYFRAME) != 0 &&
+               replay_restart(player, record.state, record.state_size, base);
+    }
+  }
+  while (result && player->step < step) {
+    result = replay_step_bound(player);
+  }
+  *get_thread_session() = bound;
+  return result;
+}
 
-  /* Create and init the game thread */
-  ThreadStruct* gameThread = get_game_thread_struct_instance();
-  pthread_create(&gameThread->thread, NULL, game_handler, NULL);
-  pthread_mutex_init(&gameThread->mutex, NULL);
+int replay_snapshot(ReplayPlayer* player, uint8_t* buffer, int capacity) {
+  SessionState state;
+  session_save_state(player->session, &state);
+  return (int)snapshot_encode(&state, buffer, capacity > 0 ? capacity : 0);
+}
+
+void replay_close(ReplayPlayer* player) {
+  if (player == NULL) return;
+  if (player->session != NULL) {
+    session_free_memory(player->session);
+  }
+  journal_reader_close(&player->reader);
+  free(player);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                               LEADERBOARD                                  */
+/* -------------------------------------------------------------------------- */
+
+bool open_leaderboard(const char* path) {
+  bool detach = path == NULL || path[0] == '\0';
+  Leaderboard* board =
+      detach ? NULL : leaderboard_open(path, LEADERBOARD_DEFAULT_CAPACITY);
+  pthread_mutex_lock(get_session_mutex());
+  LeaderboardSettings* settings = get_leaderboard_settings();
+  session_attach_leaderboard(*get_active_session(), board);
+  leaderboard_close(settings->board);
+  settings->board = board;
+  pthread_mutex_unlock(get_session_mutex());
+  return detach || board != NULL;
+}
+
+void set_player_name(const char* name) {
+  pthread_mutex_lock(get_session_mutex());
+  LeaderboardSettings* settings = get_leaderboard_settings();
+  memset(settings->player, 0, sizeof(settings->player));
+  if (name != NULL) {
+    strncpy(settings->player, name, sizeof(settings->player) - 1);
+  }
+  pthread_mutex_unlock(get_session_mutex());
+}
+
+int leaderboard_game_best(void) {
+  pthread_mutex_lock(get_session_mutex());
+  Leaderboard* board = get_leaderboard_settings()->board;
+  int best =
+      board != NULL ? leaderboard_best(board, SNAPSHOT_ENGINE_TETRIS) : 0;
+  pthread_mutex_unlock(get_session_mutex());
+  return best;
+}
+
+int leaderboard_game_rank(int score) {
+  pthread_mutex_lock(get_session_mutex());
+  Leaderboard* board = get_leaderboard_settings()->board;
+  int rank = board != NULL
+                 ? (int)leaderboard_rank(board, SNAPSHOT_ENGINE_TETRIS, score)
+                 : 0;
+  pthread_mutex_unlock(get_session_mutex());
+  return rank;
+}
+
+int leaderboard_game_top(int count, int* scores, char* players) {
+  LeaderboardRecord* records = NULL;
+  if (count > 0) {
+    records = (LeaderboardRecord*)malloc(count * sizeof(LeaderboardRecord));
+  }
+  if (records == NULL) {
+    return 0;
+  }
+  pthread_mutex_lock(get_session_mutex());
+  Leaderboard* board = get_leaderboard_settings()->board;
+  size_t written = 0;
+  if (board != NULL) {
+    written = leaderboard_top(board, SNAPSHOT_ENGINE_TETRIS, count, records);
+  }
+  pthread_mutex_unlock(get_session_mutex());
+  for (size_t i = 0; i < written; ++i) {
+    scores[i] = records[i].score;
+    if (players != NULL) {
+      memcpy(players + i * LEADERBOARD_PLAYER_SIZE, records[i].player,
+             LEADERBOARD_PLAYER_SIZE);
+    }
+  }
+  free(records);
+  return (int)written;
+}
+
+int leaderboard_player_game_best(void) {
+  pthread_mutex_lock(get_session_mutex());
+  LeaderboardSettings* settings = get_leaderboard_settings();
+  int best = settings->board != NULL
+                 ? leaderboard_player_best(settings->board,
+                                           SNAPSHOT_ENGINE_TETRIS,
+                                           settings->player)
+                 : 0;
+  pthread_mutex_unlock(get_session_mutex());
+  return best;
+}
+
+void session_attach_leaderboard(TetrisSession* session, Leaderboard* board) {
+  if (session == NULL) return;
+  pthread_mutex_lock(&session->game_thread.mutex);
+  session->leaderboard = board;
+  memcpy(session->player, get_leaderboard_settings()->player,
+         sizeof(session->player));
+  if (board != NULL &&
+      leaderboard_best(board, SNAPSHOT_ENGINE_TETRIS) >
+          session->info.high_score) {
+    session->info.high_score = leaderboard_best(board, SNAPSHOT_ENGINE_TETRIS);
+  }
+  pthread_mutex_unlock(&session->game_thread.mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              REWIND BUFFER                                 */
+/* -------------------------------------------------------------------------- */
+
+void set_rewind_budget(int budget) {
+  pthread_mutex_lock(get_session_mutex());
+  get_rewind_settings()->budget = budget > 0 ? budget : 0;
+  session_close_rewind();
+  session_start_rewind(*get_active_session());
+  pthread_mutex_unlock(get_session_mutex());
+}
+
+void session_start_rewind(TetrisSession* session) {
+  RewindSettings* settings = get_rewind_settings();
+  if (settings->budget == 0 ||
+      (session == NULL && !get_hibernation_instance()->active)) {
+    return;
+  }
+  settings->buffer = rewind_create(settings->budget);
+  if (session != NULL) {
+    /* The first snapshot is taken by the game thread on its next step */
+    pthread_mutex_lock(&session->game_thread.mutex);
+    session->rewind = settings->buffer;
+    session->rewound_input_count = session->input_count;
+    pthread_mutex_unlock(&session->game_thread.mutex);
+  }
+}
+
+void session_close_rewind(void) {
+  RewindSettings* settings = get_rewind_settings();
+  TetrisSession* session = *get_active_session();
+  if (session != NULL) {
+    pthread_mutex_lock(&session->game_thread.mutex);
+    session->rewind = NULL;
+    pthread_mutex_unlock(&session->game_thread.mutex);
+  }
+  rewind_free(settings->buffer);
+  settings->buffer = NULL;
+}
+
+bool rewind_game_window(uint64_t* first, uint64_t* last) {
+  pthread_mutex_lock(get_session_mutex());
+  RewindBuffer* buffer = get_rewind_settings()->buffer;
+  bool result = buffer != NULL && rewind_window(buffer, first, last);
+  pthread_mutex_unlock(get_session_mutex());
+  return result;
+}
+
+int rewind_snapshot(uint64_t step, uint8_t* buffer, int capacity) {
+  /* Only the segment holding the step is copied, the game goes on */
+  RewindSegment segment;
+  pthread_mutex_lock(get_session_mutex());
+  RewindBuffer* rewind = get_rewind_settings()->buffer;
+  bool result = rewind != NULL && rewind_copy_segment(rewind, step, &segment);
+  pthread_mutex_unlock(get_session_mutex());
+
+  SessionState state;
+  TetrisSession* session = NULL;
+  if (result && snapshot_decode(segment.state, segment.state_size, &state)) {
+    session = session_alloc();
+  }
+  size_t size = 0;
+  if (session != NULL) {
+    /* Headless session has no threads, so steps run without the mutexes */
+    TetrisSession* bound = *get_thread_session();
+    *get_thread_session() = session;
+    session->headless = true;
+    session_load_state(session, &state);
+
+    uint64_t current = segment.step;
+    size_t position = 0;
+    uint64_t delta = 0;
+    uint8_t flags = 0;
+    while (current < step) {
+      if (!rewind_next_record(&segment, &position, &delta, &flags) ||
+          current + delta > step) {
+        /* Only quiet steps are left before the target */
+        for (; current < step; ++current) {
+          game_step(session, false);
+        }
+        break;
+      }
+      for (uint64_t i = 1; i < delta; ++i) {
+        game_step(session, false);
+      }
+      if (flags & JOURNAL_INPUT) {
+        session->action = (UserAction_t)(flags & JOURNAL_ACTION_MASK);
+        session->hold = flags & JOURNAL_HOLD;
+      }
+      game_step(session, flags & JOURNAL_TICK);
+      current += delta;
+    }
+
+    session_save_state(session, &state);
+    size = snapshot_encode(&state, buffer, capacity > 0 ? capacity : 0);
+    *get_thread_session() = bound;
+    session_free_memory(session);
+  }
+  if (result) {
+    rewind_segment_free(&segment);
+  }
+  return (int)size;
 }
 
 /* -------------------------------------------------------------------------- */
 /*                            GAME STATE UPDATE                               */
 /* -------------------------------------------------------------------------- */
 
+GameStatus_t current_game_status(void) {
+  pthread_mutex_lock(get_session_mutex());
+  GameStatus_t status = *get_status_instance();
+  Hibernation* hibernation = get_hibernation_instance();
+  if (*get_active_session() == NULL && hibernation->active) {
+    status = (GameStatus_t)hibernation->state.status;
+  }
+  pthread_mutex_unlock(get_session_mutex());
+  return status;
+}
+
 GameInfo_t updateCurrentState(void) {
+  pthread_mutex_lock(get_session_mutex());
   GameInfo_t* tetrisGame = get_info_instance();
   GameInfo_t copyGameInfo = *tetrisGame;
   GameStatus_t* gameStatus = get_status_instance();
@@ -244,7 +1214,12 @@ GameInfo_t updateCurrentState(void) {
     copyGameInfo.next[i] = (int*)calloc(4, sizeof(int));
   }
 
-  if (*gameStatus != START) {
+  Hibernation* hibernation = get_hibernation_instance();
+  if (*get_active_session() == NULL && hibernation->active) {
+    /* Hibernated session is rendered from its state, it stays asleep */
+    session_state_render(&hibernation->state, &copyGameInfo, true);
+  } else if (*gameStatus != START && tetrisGame->field != NULL) {
+    /* Detached session (no game in progress) has no field to copy */
     for (int i = 0; i < ROWS_FIELD; ++i) {
       for (int j = 0; j < COLS_FIELD; ++j) {
         copyGameInfo.field[i][j] = tetrisGame->field[i][j];
@@ -261,6 +1236,7 @@ GameInfo_t updateCurrentState(void) {
       unit_fields(&copyGameInfo, figIndex);
     }
   }
+  pthread_mutex_unlock(get_session_mutex());
   return copyGameInfo;
 }
 
@@ -268,127 +1244,195 @@ GameInfo_t updateCurrentState(void) {
 /*                           GAME THREAD (FSM)                                */
 /* -------------------------------------------------------------------------- */
 
+/* Encodes a keyframe, called by the game thread with the game mutex held */
+static size_t session_encode_state(TetrisSession* session, uint8_t* buffer) {
+  SessionState state;
+  pthread_mutex_lock(&session->timer_thread.mutex);
+  session_save_state(session, &state);
+  pthread_mutex_unlock(&session->timer_thread.mutex);
+  return snapshot_encode(&state, buffer, SNAPSHOT_TETRIS_SIZE);
+}
+
 void* game_handler(void* arg) {
-  if (arg == NULL) {
-    /* Заглушка, чтобы не ругался компилятор */
-    printf(" ");
-  }
+  TetrisSession* session = (TetrisSession*)arg;
+  *get_thread_session() = session;
   bool continueLoop = true;
-  static int figureIndex;
-  static bool attachFlag = false;
 
   while (continueLoop) {
+    session_wait_while_parked(session);
+    if (session->stop) break;
     ThreadStruct* gameThread = get_game_thread_struct_instance();
     pthread_mutex_lock(&gameThread->mutex);
+    unsigned seenInputCount = session->input_count;
+    bool released = session->status == EXIT;
+
+    pthread_mutex_lock(&session->timer_thread.mutex);
+    bool tickDue = session->timer > 1.5f;
+    pthread_mutex_unlock(&session->timer_thread.mutex);
+
+    uint8_t input =
+        JOURNAL_INPUT | session->action | (session->hold ? JOURNAL_HOLD : 0);
+    uint8_t tick = 0;
+    if (!released && game_step(session, tickDue)) {
+      tick = JOURNAL_TICK;
+    }
+    session->settled_input_count = seenInputCount;
+    if (!released && session->journal != NULL) {
+      bool fresh = seenInputCount != session->journaled_input_count;
+      journal_step(session->journal, (fresh ? input : 0) | tick);
+      session->journaled_input_count = seenInputCount;
+      if (journal_keyframe_due(session->journal)) {
+        uint8_t buffer[SNAPSHOT_TETRIS_SIZE];
+        size_t size = session_encode_state(session, buffer);
+        journal_keyframe(session->journal, buffer, size);
+      }
+    }
+    if (!released && session->rewind != NULL) {
+      bool fresh = seenInputCount != session->rewound_input_count;
+      rewind_step(session->rewind, (fresh ? input : 0) | tick);
+      session->rewound_input_count = seenInputCount;
+      if (rewind_keyframe_due(session->rewind)) {
+        uint8_t buffer[SNAPSHOT_TETRIS_SIZE];
+        size_t size = session_encode_state(session, buffer);
+        rewind_keyframe(session->rewind, buffer, size);
+      }
+    }
+    bool hibernate = session->hibernate_requested;
+    if (!released) {
+      publish_frame();
+    }
+    pthread_mutex_unlock(&gameThread->mutex);
 
-    GameStatus_t* gameStatus = get_status_instance();
-    UserAction_t* action = get_action_instance();
-    GameInfo_t* tetrisGame = get_info_instance();
-    float* timerVal = get_timer();
-
-    switch (*gameStatus) {
-      case START:
-        switch (*action) {
-          case Start:
-            *gameStatus = SPAWN;
-            break;
-          case Terminate:
-            *gameStatus = EXIT;
-            break;
-          default:
-            *gameStatus = START;
-            break;
-        }
-        break;
+    if (!released && hibernate) {
+      released = session_hibernate(session);
+    }
 
-      case SPAWN:
-        init_block(tetrisGame, &figureIndex);
-        *gameStatus = MOVING;
-        break;
+    if (released) {
+      /* Session goes back to the pool or is freed together with the thread */
+      continueLoop = session_release(session);
+    } else {
+      usleep(5 * 10e3);
+    }
+  }
+  return NULL;
+}
 
-      case MOVING:
-        if (*action == Left) move_left(tetrisGame);
-        if (*action == Right) move_right(tetrisGame);
-        if (*action == Action && !attachFlag) {
-          rotate_block(tetrisGame, figureIndex);
-        }
-        if (*action == Down) {
-          force_down(tetrisGame);
-        }
-        if (*action == Terminate) {
+bool game_step(TetrisSession* session, bool tick_due) {
+  int* figureIndex = &session->handler_figure_index;
+  bool attachFlag = session->attach_flag;
+  GameStatus_t* gameStatus = get_status_instance();
+  UserAction_t* action = get_action_instance();
+  GameInfo_t* tetrisGame = get_info_instance();
+  float* timerVal = get_timer();
+
+  /* MOVING and SHIFTING read the timer whatever the input is */
+  bool tickUsed =
+      tick_due && (*gameStatus == MOVING || *gameStatus == SHIFTING);
+
+  switch (*gameStatus) {
+    case START:
+      switch (*action) {
+        case Start:
+          *gameStatus = SPAWN;
+          break;
+        case Terminate:
           *gameStatus = EXIT;
+          break;
+        default:
+          *gameStatus = START;
+          break;
+      }
+      break;
+
+    case SPAWN:
+      init_block(tetrisGame, figureIndex);
+      *gameStatus = MOVING;
+      break;
+
+    case MOVING:
+      if (*action == Left) move_left(tetrisGame);
+      if (*action == Right) move_right(tetrisGame);
+      if (*action == Action && !attachFlag) {
+        rotate_block(tetrisGame, *figureIndex);
+      }
+      if (*action == Down) {
+        force_down(tetrisGame);
+      }
+      if (*action == Terminate) {
+        *gameStatus = EXIT;
+      }
+      if (*action == Pause) {
+        pause_game(tetrisGame);
+        *gameStatus = PAUSE;
+      }
+      if (*gameStatus != EXIT && *gameStatus != PAUSE) {
+        if ((check_horizontal_collide(tetrisGame) && tick_due) ||
+            *action == Down) {
+          *gameStatus = ATTACHING;
+          break;
         }
-        if (*action == Pause) {
-          pause_game(tetrisGame);
-          *gameStatus = PAUSE;
-        }
-        if (*gameStatus != EXIT && *gameStatus != PAUSE) {
-          if ((check_horizontal_collide(tetrisGame) && *timerVal > 1.5f) ||
-              *action == Down) {
+      }
+      __attribute__((fallthrough));
+
+    case SHIFTING:
+      if (tick_due) {
+        pthread_mutex_lock(&get_thread_struct_instance()->mutex);
+        move_down(tetrisGame);
+        if (check_horizontal_collide(tetrisGame)) {
+          if (attachFlag) {
             *gameStatus = ATTACHING;
-            break;
-          }
-        }
-        __attribute__((fallthrough));
-
-      case SHIFTING:
-        if (*timerVal > 1.5f) {
-          pthread_mutex_lock(&get_thread_struct_instance()->mutex);
-          move_down(tetrisGame);
-          if (check_horizontal_collide(tetrisGame)) {
-            if (attachFlag) {
-              *gameStatus = ATTACHING;
-            } else {
-              *gameStatus = MOVING;
-              attachFlag = true;
-            }
+          } else {
+            *gameStatus = MOVING;
+            attachFlag = true;
           }
-          *timerVal = 0;
-          pthread_mutex_unlock(&get_thread_struct_instance()->mutex);
         }
-        break;
-
-      case ATTACHING:
-        unit_fields(tetrisGame, figureIndex);
-        line_handler(tetrisGame);
-        score_handler(tetrisGame);
-        if (check_gameover(tetrisGame)) {
-          *gameStatus = GAMEOVER;
-        } else {
-          *gameStatus = SPAWN;
-        }
-        attachFlag = false;
-        break;
+        *timerVal = 0;
+        pthread_mutex_unlock(&get_thread_struct_instance()->mutex);
+      }
+      break;
 
-      case GAMEOVER:
-        if (*action == Start) {
-          *gameStatus = SPAWN;
-          free_field(tetrisGame);
-        } else if (*action == Terminate) {
-          *gameStatus = EXIT;
+    case ATTACHING:
+      unit_fields(tetrisGame, *figureIndex);
+      line_handler(tetrisGame);
+      score_handler(tetrisGame);
+      if (check_gameover(tetrisGame)) {
+        *gameStatus = GAMEOVER;
+        /* Headless sessions (replays) must not post */
+        if (session->leaderboard != NULL && !session->headless) {
+          leaderboard_post(session->leaderboard, SNAPSHOT_ENGINE_TETRIS,
+                           session->player, tetrisGame->score);
         }
-        break;
+      } else {
+        *gameStatus = SPAWN;
+      }
+      attachFlag = false;
+      break;
 
-      case EXIT:
-        continueLoop = false;
-        pthread_kill(*get_main_thread(), SIGUSR1);
-        break;
+    case GAMEOVER:
+      if (*action == Start) {
+        *gameStatus = SPAWN;
+        free_field(tetrisGame);
+      } else if (*action == Terminate) {
+        *gameStatus = EXIT;
+      }
+      break;
 
-      case PAUSE:
-        if (*action == Pause) {
-          pause_game(tetrisGame);
-        }
-        if (tetrisGame->pause == 0) {
-          *gameStatus = MOVING;
-        }
-        break;
-    }
+    case EXIT:
+      break;
 
-    *action = Up;
-    pthread_mutex_unlock(&gameThread->mutex);
-    usleep(5 * 10e3);
+    case PAUSE:
+      if (*action == Pause) {
+        pause_game(tetrisGame);
+      }
+      if (tetrisGame->pause == 0) {
+        *gameStatus = MOVING;
+      }
+      break;
   }
-  return NULL;
+
+  *action = Up;
+  session->attach_flag = attachFlag;
+  return tickUsed;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -396,16 +1440,35 @@ void* game_handler(void* arg) {
 /* -------------------------------------------------------------------------- */
 
 void userInput(UserAction_t action, bool hold) {
-  ThreadStruct* gameThread = get_game_thread_struct_instance();
-  pthread_mutex_lock(&gameThread->mutex);
+  pthread_mutex_lock(get_session_mutex());
+  Hibernation* hibernation = get_hibernation_instance();
+  clock_gettime(CLOCK_MONOTONIC, &hibernation->last_activity);
+  if (*get_active_session() == NULL && hibernation->active) {
+    if (action == Terminate) {
+      /* Nothing to wake up just to exit */
+      session_close_journal();
+      session_close_rewind();
+      hibernation->active = false;
+    } else {
+      session_revive();
+    }
+  }
+
+  if (*get_active_session() != NULL) {
+    ThreadStruct* gameThread = get_game_thread_struct_instance();
+    pthread_mutex_lock(&gameThread->mutex);
 
-  UserAction_t* currentAction = get_action_instance();
-  *currentAction = action;
+    UserAction_t* currentAction = get_action_instance();
+    *currentAction = action;
 
-  bool* currentHold = get_hold_instance();
-  *currentHold = hold;
+    bool* currentHold = get_hold_instance();
+    *currentHold = hold;
+    get_session()->input_count++;
+    get_session()->hibernate_requested = false;
 
-  pthread_mutex_unlock(&gameThread->mutex);
+    pthread_mutex_unlock(&gameThread->mutex);
+  }
+  pthread_mutex_unlock(get_session_mutex());
 }
 
 void pause_game(GameInfo_t* tetrisGame) {
@@ -428,11 +1491,11 @@ void init_block(GameInfo_t* tetrisGame, int* figureIndex) {
 
   int currentRandomIndex = 0;
   if (!isFirstPlant) {
-    currentRandomIndex = rand() % 7;
+    currentRandomIndex = session_random() % 7;
   } else {
     currentRandomIndex = nextRandomIndex;
   }
-  nextRandomIndex = rand() % 7;
+  nextRandomIndex = session_random() % 7;
 
   plant_figure(tetrisGame, currentRandomIndex);
 
@@ -457,7 +1520,7 @@ void plant_figure(GameInfo_t* tetrisGame, int currentRandomIndex) {
     int iIndex = 0;
     for (int i = -3; i <= 0; ++i) {
       int jIndex = 0;
-      for (int j = 3; j <= 6; ++j) {
+      for (int j = SPAWN_COL; j < SPAWN_COL + 4; ++j) {
         if (tet_fig[currentRandomIndex][iIndex][jIndex]) {
           coordJ++;
           coords[coordI++][coordJ] = i;
@@ -474,7 +1537,7 @@ void plant_figure(GameInfo_t* tetrisGame, int currentRandomIndex) {
     int iIndex = 0;
     for (int i = -2; i <= 1; ++i) {
       int jIndex = 0;
-      for (int j = 3; j <= 6; ++j) {
+      for (int j = SPAWN_COL; j < SPAWN_COL + 4; ++j) {
         if (tetrisGame->next[iIndex][jIndex]) {
           coordJ++;
           coords[coordI++][coordJ] = i;
@@ -615,13 +1678,10 @@ bool check_horizontal_collide(GameInfo_t* tetrisGame) {
     }
   }
 
-  for (int i = 0; i < 4; ++i) {
-    if ((minY[i] < 19 && uniqueX[i] < 19)) {
-      if (tetrisGame->field[minY[i] + 1][uniqueX[i]] != 0) {
-        result = true;
-      } else if (minY[i] == 19) {
-        result = true;
-      }
+  for (int i = 0; i < k; ++i) {
+    if (board_contains(minY[i] + 1, uniqueX[i]) &&
+        tetrisGame->field[minY[i] + 1][uniqueX[i]] != 0) {
+      result = true;
     }
   }
   return result;
@@ -830,9 +1890,10 @@ void line_handler(GameInfo_t* tetrisGame) {
 void score_handler(GameInfo_t* tetrisGame) {
   if (tetrisGame->score > tetrisGame->high_score) {
     tetrisGame->high_score = tetrisGame->score;
-    FILE* database = fopen("tetris_score", "w");
-    fprintf(database, "%d", tetrisGame->score);
-    fclose(database);
+    /* Headless sessions (replays) must not touch the score file */
+    if (!get_session()->headless) {
+      score_writer_submit(SCORE_FILE, tetrisGame->score);
+    }
   }
   if ((tetrisGame->score / 600) > (tetrisGame->level - 1) &&
       tetrisGame->level < 10) {
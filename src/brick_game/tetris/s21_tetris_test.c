@@ -0,0 +1,433 @@
+/**
+ * @file s21_tetris_test.c
+ * @brief Checks that a snapshot holds the whole tetris session.
+ *
+ * A decoded snapshot must encode to the very same bytes, and a session
+ * loaded from it must keep playing exactly like the original one.
+ * Malformed snapshots must be rejected without touching the output state.
+ * A journal seeked to any step, forward or backward, and a rewind buffer
+ * rebuilt at any step of its window must hold the game a plain replay
+ * reaches there. A batch of environments must not depend on the number of
+ * threads stepping it.
+ */
+#include "s21_controller.h"
+
+static int failures = 0;
+
+#define CHECK(condition)                                            \
+  do {                                                              \
+    if (!(condition)) {                                             \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #condition); \
+      failures++;                                                   \
+    }                                                               \
+  } while (0)
+
+/* Offsets in a tetris snapshot */
+#define TEST_STATUS_OFFSET 8
+#define TEST_NEXT_OFFSET 15
+#define TEST_COORDS_OFFSET 36
+#define TEST_FIELD_OFFSET 44
+
+/* Moves of the test player, independent of the session PRNG */
+static uint64_t test_random(uint64_t* state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 0x2545F4914F6CDD1DULL;
+}
+
+/* START or GAMEOVER -> MOVING, as a player pressing Start */
+static void start_game(TetrisSession* session) {
+  session->action = Start;
+  game_step(session, false);
+}
+
+/* Plays the steps on the session bound to the calling thread */
+static void play_steps(TetrisSession* session, uint64_t* moves, int steps) {
+  static const UserAction_t actions[] = {Left, Right, Down, Action, Up};
+  *get_thread_session() = session;
+  for (int i = 0; i < steps; ++i) {
+    if (session->status == START || session->status == GAMEOVER) {
+      start_game(session);
+    } else {
+      session->action = actions[test_random(moves) % 5];
+      game_step(session, true);
+    }
+  }
+  *get_thread_session() = NULL;
+}
+
+static size_t save_snapshot(TetrisSession* session, uint8_t* buffer) {
+  SessionState state;
+  memset(&state, 0, sizeof(state));
+  session_save_state(session, &state);
+  return snapshot_encode(&state, buffer, SNAPSHOT_MAX_SIZE);
+}
+
+static void test_round_trip(void) {
+  TetrisSession* session = session_create_headless();
+  TetrisSession* copy = session_create_headless();
+  CHECK(session != NULL && copy != NULL);
+  if (session == NULL || copy == NULL) return;
+  session_seed_random(session, 7);
+  uint64_t moves = 1;
+
+  for (int round = 0; round < 20; ++round) {
+    play_steps(session, &moves, 37);
+    uint8_t saved[SNAPSHOT_MAX_SIZE];
+    size_t size = save_snapshot(session, saved);
+    CHECK(size == SNAPSHOT_TETRIS_SIZE);
+
+    SessionState state;
+    CHECK(snapshot_decode(saved, size, &state));
+    uint8_t encoded[SNAPSHOT_MAX_SIZE];
+    CHECK(snapshot_encode(&state, encoded, sizeof(encoded)) == size);
+    CHECK(memcmp(encoded, saved, size) == 0);
+
+    session_load_state(copy, &state);
+    uint8_t loaded[SNAPSHOT_MAX_SIZE];
+    CHECK(save_snapshot(copy, loaded) == size);
+    CHECK(memcmp(loaded, saved, size) == 0);
+
+    /* Upcoming figures come from the saved PRNG state as well */
+    uint64_t copy_moves = moves;
+    play_steps(session, &moves, 200);
+    play_steps(copy, &copy_moves, 200);
+    uint8_t left[SNAPSHOT_MAX_SIZE];
+    uint8_t right[SNAPSHOT_MAX_SIZE];
+    save_snapshot(session, left);
+    save_snapshot(copy, right);
+    CHECK(memcmp(left, right, size) == 0);
+    CHECK(memcmp(left, saved, size) != 0);
+  }
+  session_free(session);
+  session_free(copy);
+}
+
+/* The snapshot must be rejected and the state left as it was */
+static void check_rejected(const uint8_t* buffer, size_t length) {
+  SessionState state;
+  SessionState before;
+  memset(&state, 0xa5, sizeof(state));
+  memcpy(&before, &state, sizeof(state));
+  CHECK(!snapshot_decode(buffer, length, &state));
+  CHECK(memcmp(&state, &before, sizeof(state)) == 0);
+}
+
+static void test_malformed(void) {
+  TetrisSession* session = session_create_headless();
+  CHECK(session != NULL);
+  if (session == NULL) return;
+  session_seed_random(session, 11);
+  uint64_t moves = 3;
+  play_steps(session, &moves, 50);
+  uint8_t saved[SNAPSHOT_MAX_SIZE + 1] = {0};
+  size_t size = save_snapshot(session, saved);
+  session_free(session);
+
+  for (size_t length = 0; length < size; ++length) {
+    check_rejected(saved, length);
+  }
+  check_rejected(saved, size + 1);
+  check_rejected(NULL, size);
+
+  static const struct {
+    size_t offset;
+    uint8_t value;
+  } corruptions[] = {{0, 0},
+                     {6, SNAPSHOT_ENGINE_SNAKE},
+                     {TEST_STATUS_OFFSET, 8},
+                     {TEST_NEXT_OFFSET, 7},
+                     {TEST_COORDS_OFFSET, BOARD_ROWS},
+                     {TEST_COORDS_OFFSET + 4, BOARD_COLS},
+                     {TEST_FIELD_OFFSET, 0x08},
+                     {TEST_FIELD_OFFSET + 1, 0x80}};
+  for (size_t i = 0; i < sizeof(corruptions) / sizeof(corruptions[0]); ++i) {
+    uint8_t broken[SNAPSHOT_MAX_SIZE];
+    memcpy(broken, saved, size);
+    broken[corruptions[i].offset] = corruptions[i].value;
+    check_rejected(broken, size);
+  }
+}
+
+/* Steps of the test journals, a few keyframe intervals and a bit more */
+#define TEST_JOURNAL_STEPS (3 * JOURNAL_KEYFRAME_INTERVAL + 100)
+#define TEST_PLAIN_PATH "s21_tetris_test_plain.journal"
+#define TEST_KEYED_PATH "s21_tetris_test_keyed.journal"
+
+/* A move every seventh step and Start in between, which only restarts a
+ * lost game, with a timer tick on each step */
+static uint8_t journal_flags(uint64_t step, uint64_t* moves) {
+  static const UserAction_t keys[] = {Left, Right, Down, Action};
+  uint8_t flags = JOURNAL_TICK;
+  if (step % 7 == 0) {
+    flags |= JOURNAL_INPUT | Start;
+  } else if (step % 7 == 4) {
+    flags |= JOURNAL_INPUT | keys[test_random(moves) % 4];
+  }
+  return flags;
+}
+
+/* The flusher writes the file after journal_close(), the index comes last */
+static bool wait_for_index(const char* path) {
+  for (int attempt = 0; attempt < 500; ++attempt) {
+    uint8_t tail[4] = {0};
+    FILE* file = fopen(path, "rb");
+    if (file != NULL) {
+      if (fseek(file, -4, SEEK_END) == 0 && fread(tail, 1, 4, file) == 4 &&
+          (tail[0] | tail[1] << 8 | tail[2] << 16 | (uint32_t)tail[3] << 24) ==
+              JOURNAL_INDEX_MAGIC) {
+        fclose(file);
+        return true;
+      }
+      fclose(file);
+    }
+    usleep(10000);
+  }
+  return false;
+}
+
+/**
+ * @brief Writes the test journal, with keyframes taken from the states
+ * after each step if they are given.
+ **/
+static bool write_journal(const char* path, uint64_t seed,
+                          const uint8_t* start, const uint8_t* states) {
+  Journal* journal = journal_open(path, SNAPSHOT_ENGINE_TETRIS, seed, start,
+                                  SNAPSHOT_TETRIS_SIZE);
+  if (journal == NULL) {
+    return false;
+  }
+  uint64_t moves = 5;
+  for (uint64_t i = 0; i < TEST_JOURNAL_STEPS; ++i) {
+    journal_step(journal, journal_flags(i, &moves));
+    if (states != NULL && journal_keyframe_due(journal)) {
+      journal_keyframe(journal, states + (i + 1) * SNAPSHOT_TETRIS_SIZE,
+                       SNAPSHOT_TETRIS_SIZE);
+    }
+  }
+  journal_close(journal);
+  return wait_for_index(path);
+}
+
+/* Snapshot of the replayed game must be the recorded one */
+static bool same_state(ReplayPlayer* player, const uint8_t* states,
+                       uint64_t step) {
+  uint8_t state[SNAPSHOT_MAX_SIZE];
+  return replay_snapshot(player, state, sizeof(state)) ==
+             SNAPSHOT_TETRIS_SIZE &&
+         memcmp(state, states + step * SNAPSHOT_TETRIS_SIZE,
+                SNAPSHOT_TETRIS_SIZE) == 0;
+}
+
+/* States of the plain replay, step by step from the start */
+static bool replay_states(uint8_t* states) {
+  ReplayPlayer* player = replay_open(TEST_PLAIN_PATH);
+  CHECK(player != NULL);
+  if (player == NULL) return false;
+  CHECK(replayLength(player) == TEST_JOURNAL_STEPS);
+  uint64_t count = 0;
+  do {
+    replay_snapshot(player, states + count * SNAPSHOT_TETRIS_SIZE,
+                    SNAPSHOT_TETRIS_SIZE);
+    count++;
+  } while (count <= TEST_JOURNAL_STEPS && replay_step(player));
+  CHECK(!replay_step(player));
+  replay_close(player);
+  CHECK(count == TEST_JOURNAL_STEPS + 1);
+  return count == TEST_JOURNAL_STEPS + 1;
+}
+
+static void check_seeks(const uint8_t* states) {
+  ReplayPlayer* player = replay_open(TEST_KEYED_PATH);
+  CHECK(player != NULL);
+  if (player == NULL) return;
+  CHECK(player->reader.keyframe_count ==
+        TEST_JOURNAL_STEPS / JOURNAL_KEYFRAME_INTERVAL);
+  static const uint64_t targets[] = {TEST_JOURNAL_STEPS, 0, 1500, 1024, 3000,
+                                     5, 2048, 2047, 1023, TEST_JOURNAL_STEPS};
+  for (size_t i = 0; i < sizeof(targets) / sizeof(targets[0]); ++i) {
+    CHECK(replay_seek(player, targets[i]));
+    CHECK(replayPosition(player) == targets[i]);
+    CHECK(same_state(player, states, targets[i]));
+  }
+  CHECK(!replay_seek(player, TEST_JOURNAL_STEPS + 1));
+
+  /* Stepping through keyframes must not disturb the game either */
+  CHECK(replay_seek(player, 0));
+  for (uint64_t step = 1; step <= TEST_JOURNAL_STEPS; ++step) {
+    CHECK(replay_step(player));
+    CHECK(same_state(player, states, step));
+  }
+  CHECK(!replay_step(player));
+  replay_close(player);
+}
+
+static void test_journal_seek(void) {
+  TetrisSession* session = session_create_headless();
+  uint8_t* states = malloc((TEST_JOURNAL_STEPS + 1) * SNAPSHOT_TETRIS_SIZE);
+  CHECK(session != NULL && states != NULL);
+  if (session != NULL && states != NULL) {
+    session_seed_random(session, 5);
+    uint8_t start[SNAPSHOT_MAX_SIZE];
+    save_snapshot(session, start);
+    CHECK(write_journal(TEST_PLAIN_PATH, 5, start, NULL));
+    if (replay_states(states)) {
+      CHECK(memcmp(states, states + TEST_JOURNAL_STEPS * SNAPSHOT_TETRIS_SIZE,
+                   SNAPSHOT_TETRIS_SIZE) != 0);
+      CHECK(write_journal(TEST_KEYED_PATH, 5, start, states));
+      check_seeks(states);
+    }
+  }
+  session_free(session);
+  free(states);
+  remove(TEST_PLAIN_PATH);
+  remove(TEST_KEYED_PATH);
+}
+
+/* Every step of the window must rebuild to the state of the plain replay */
+static void check_rewind_window(RewindBuffer* rewind, const uint8_t* states) {
+  uint64_t first = 0;
+  uint64_t last = 0;
+  CHECK(rewind_window(rewind, &first, &last));
+  uint8_t state[SNAPSHOT_MAX_SIZE];
+  for (uint64_t step = first; step <= last; ++step) {
+    CHECK(rewind_snapshot(step, state, sizeof(state)) ==
+          SNAPSHOT_TETRIS_SIZE);
+    CHECK(memcmp(state, states + step * SNAPSHOT_TETRIS_SIZE,
+                 SNAPSHOT_TETRIS_SIZE) == 0);
+  }
+  CHECK(first == 0 || rewind_snapshot(first - 1, state, sizeof(state)) == 0);
+  CHECK(rewind_snapshot(last + 1, state, sizeof(state)) == 0);
+}
+
+/* Records the test steps the way the game thread does */
+static void record_rewind(RewindBuffer* rewind, const uint8_t* states) {
+  uint64_t moves = 5;
+  uint64_t previous_first = 0;
+  for (uint64_t i = 0; i < TEST_JOURNAL_STEPS; ++i) {
+    rewind_step(rewind, journal_flags(i, &moves));
+    if (rewind_keyframe_due(rewind)) {
+      rewind_keyframe(rewind, states + (i + 1) * SNAPSHOT_TETRIS_SIZE,
+                      SNAPSHOT_TETRIS_SIZE);
+    }
+    uint64_t first = 0;
+    uint64_t last = 0;
+    CHECK(rewind_window(rewind, &first, &last));
+    CHECK(last == i + 1 && first >= previous_first && first <= last);
+    CHECK((first - 1) % REWIND_KEYFRAME_INTERVAL == 0);
+    previous_first = first;
+    if ((i + 1) % 1000 == 0) {
+      check_rewind_window(rewind, states);
+    }
+  }
+  CHECK(previous_first > 2 * REWIND_KEYFRAME_INTERVAL);
+}
+
+static void test_rewind(void) {
+  /* Room for a few segments, the oldest ones have to go */
+  const size_t budget = 2048;
+  TetrisSession* session = session_create_headless();
+  RewindBuffer* rewind = rewind_create(budget);
+  uint8_t* states = malloc((TEST_JOURNAL_STEPS + 1) * SNAPSHOT_TETRIS_SIZE);
+  CHECK(session != NULL && rewind != NULL && states != NULL);
+  if (session != NULL && rewind != NULL && states != NULL) {
+    session_seed_random(session, 5);
+    uint8_t start[SNAPSHOT_MAX_SIZE];
+    save_snapshot(session, start);
+    CHECK(write_journal(TEST_PLAIN_PATH, 5, start, NULL));
+    if (replay_states(states)) {
+      get_rewind_settings()->buffer = rewind;
+      record_rewind(rewind, states);
+      CHECK(rewind->used <=
+            budget + SNAPSHOT_TETRIS_SIZE + 2 * REWIND_KEYFRAME_INTERVAL);
+      check_rewind_window(rewind, states);
+      get_rewind_settings()->buffer = NULL;
+    }
+  }
+  rewind_free(rewind);
+  session_free(session);
+  free(states);
+  remove(TEST_PLAIN_PATH);
+}
+
+/* Outputs of a vec_env run, every step one after the other */
+typedef struct {
+  uint8_t* obs;
+  float* reward;
+  uint8_t* done;
+} VecEnvRun;
+
+/* Plays the same random actions on a batch of the given thread count */
+static bool run_vec_env(int count, int threads, int steps, VecEnvRun* run) {
+  const size_t cells = (size_t)count * VEC_ENV_CELLS;
+  VecEnv* env = vec_env_create(count, threads);
+  uint8_t* actions = malloc(count);
+  run->obs = malloc(cells * (steps + 1));
+  run->reward = malloc((size_t)count * steps * sizeof(float));
+  run->done = malloc((size_t)count * steps);
+  bool ready = env != NULL && actions != NULL && run->obs != NULL &&
+               run->reward != NULL && run->done != NULL;
+  CHECK(ready);
+  if (ready) {
+    vec_env_reset_all(env, NULL, run->obs);
+    uint64_t moves = 13;
+    for (int step = 0; step < steps; ++step) {
+      for (int i = 0; i < count; ++i) {
+        actions[i] = test_random(&moves) % (Action + 1);
+      }
+      vec_env_step_all(env, actions, run->obs + cells * (step + 1),
+                       run->reward + (size_t)count * step,
+                       run->done + (size_t)count * step);
+    }
+  }
+  vec_env_destroy(env);
+  free(actions);
+  return ready;
+}
+
+static void free_vec_env_run(VecEnvRun* run) {
+  free(run->obs);
+  free(run->reward);
+  free(run->done);
+}
+
+static void test_vec_env(void) {
+  /* Not a multiple of VEC_ENV_CHUNK, so the last chunk is a short one */
+  const int count = 100;
+  const int steps = 2000;
+  VecEnvRun single = {NULL, NULL, NULL};
+  VecEnvRun pooled = {NULL, NULL, NULL};
+  if (run_vec_env(count, 1, steps, &single) &&
+      run_vec_env(count, 4, steps, &pooled)) {
+    CHECK(memcmp(single.obs, pooled.obs,
+                 (size_t)count * VEC_ENV_CELLS * (steps + 1)) == 0);
+    CHECK(memcmp(single.reward, pooled.reward,
+                 (size_t)count * steps * sizeof(float)) == 0);
+    CHECK(memcmp(single.done, pooled.done, (size_t)count * steps) == 0);
+    int dones = 0;
+    int rewards = 0;
+    for (size_t i = 0; i < (size_t)count * steps; ++i) {
+      dones += single.done[i];
+      rewards += single.reward[i] > 0;
+    }
+    CHECK(dones > count);
+    CHECK(rewards > 0);
+  }
+  free_vec_env_run(&single);
+  free_vec_env_run(&pooled);
+}
+
+int main() {
+  test_round_trip();
+  test_malformed();
+  test_journal_seek();
+  test_rewind();
+  test_vec_env();
+  if (failures != 0) {
+    fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+  printf("tetris: all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,265 @@
+/**
+ * @file s21_vec_env.c
+ * @brief Vectorized tetris environments source code.
+ */
+#include "s21_vec_env.h"
+
+#include <stdalign.h>
+#include <stdatomic.h>
+
+/**
+ * @brief Chunks a worker starts on, one cache line each.
+ **/
+struct VecEnvShard {
+  alignas(64) atomic_int next; /* Next chunk to claim */
+  int end;
+};
+
+struct VecEnvWorker {
+  VecEnv* env;
+  int index;
+  pthread_t thread;
+};
+
+/* Lets the figure settle: ATTACHING and SPAWN need no tick */
+static void vec_env_settle(TetrisSession* session) {
+  while (session->status == ATTACHING || session->status == SPAWN) {
+    game_step(session, false);
+  }
+}
+
+/* START or GAMEOVER -> MOVING, as a player pressing Start */
+static void vec_env_start(TetrisSession* session) {
+  session->action = Start;
+  game_step(session, false);
+  vec_env_settle(session);
+}
+
+/* Field with the falling figure, as updateCurrentState() renders it */
+static void vec_env_render(TetrisSession* session, uint8_t* cells) {
+  for (int i = 0; i < ROWS_FIELD; ++i) {
+    for (int j = 0; j < COLS_FIELD; ++j) {
+      cells[i * COLS_FIELD + j] = (uint8_t)session->info.field[i][j];
+    }
+  }
+  if (session->status != START && session->status != SPAWN) {
+    for (int k = 0; k < 4; ++k) {
+      int row = session->coords[0][k];
+      if (row >= 0 && row < ROWS_FIELD) {
+        cells[row * COLS_FIELD + session->coords[1][k]] =
+            (uint8_t)session->figure_index;
+      }
+    }
+  }
+}
+
+static void vec_env_reset_one(VecEnv* env, int index) {
+  TetrisSession* session = env->sessions[index];
+  session_reset(session);
+  session_seed_random(session, env->seeds != NULL ? env->seeds[index]
+                                                  : (uint64_t)index + 1);
+  vec_env_start(session);
+  env->scores[index] = 0;
+  if (env->obs != NULL) {
+    vec_env_render(session, env->obs + (size_t)index * VEC_ENV_CELLS);
+  }
+}
+
+static void vec_env_step_one(VecEnv* env, int index) {
+  TetrisSession* session = env->sessions[index];
+  UserAction_t action = (UserAction_t)env->actions[index];
+  if (action != Left && action != Right && action != Down &&
+      action != Action) {
+    action = Up; /* No-op, the FSM resets the action to it */
+  }
+  session->action = action;
+  game_step(session, true);
+  vec_env_settle(session);
+
+  int score = session->info.score;
+  env->reward[index] = (float)(score - env->scores[index]);
+  env->done[index] = session->status == GAMEOVER;
+  if (env->done[index]) {
+    vec_env_start(session);
+    score = session->info.score;
+  }
+  env->scores[index] = score;
+  vec_env_render(session, env->obs + (size_t)index * VEC_ENV_CELLS);
+}
+
+static void vec_env_work(VecEnv* env, int worker) {
+  /* Getters resolve through the thread session, rebind it per session */
+  TetrisSession* bound = *get_thread_session();
+  /* Own share first, then the leftovers of the others */
+  for (int i = 0; i < env->thread_count; ++i) {
+    struct VecEnvShard* shard =
+        &env->shards[(worker + i) % env->thread_count];
+    int chunk;
+    while ((chunk = atomic_fetch_add_explicit(&shard->next, 1,
+                                              memory_order_relaxed)) <
+           shard->end) {
+      int begin = chunk * VEC_ENV_CHUNK;
+      int end = begin + VEC_ENV_CHUNK < env->count ? begin + VEC_ENV_CHUNK
+                                                   : env->count;
+      for (int index = begin; index < end; ++index) {
+        *get_thread_session() = env->sessions[index];
+        if (env->reset_job) {
+          vec_env_reset_one(env, index);
+        } else {
+          vec_env_step_one(env, index);
+        }
+      }
+    }
+  }
+  *get_thread_session() = bound;
+}
+
+static void* vec_env_worker(void* arg) {
+  struct VecEnvWorker* worker = (struct VecEnvWorker*)arg;
+  VecEnv* env = worker->env;
+  uint64_t seen = 0;
+  while (true) {
+    pthread_mutex_lock(&env->mutex);
+    while (!env->stop && env->generation == seen) {
+      pthread_cond_wait(&env->wake, &env->mutex);
+    }
+    if (env->stop) {
+      pthread_mutex_unlock(&env->mutex);
+      break;
+    }
+    seen = env->generation;
+    pthread_mutex_unlock(&env->mutex);
+
+    vec_env_work(env, worker->index);
+
+    pthread_mutex_lock(&env->mutex);
+    if (--env->busy == 0) {
+      pthread_cond_signal(&env->finished);
+    }
+    pthread_mutex_unlock(&env->mutex);
+  }
+  return NULL;
+}
+
+/* Runs the current job on the pool and waits for it */
+static void vec_env_run(VecEnv* env) {
+  pthread_mutex_lock(&env->mutex);
+  for (int i = 0; i < env->thread_count; ++i) {
+    atomic_store_explicit(&env->shards[i].next,
+                          env->chunks * i / env->thread_count,
+                          memory_order_relaxed);
+    env->shards[i].end = env->chunks * (i + 1) / env->thread_count;
+  }
+  env->busy = env->thread_count - 1;
+  env->generation++;
+  pthread_cond_broadcast(&env->wake);
+  pthread_mutex_unlock(&env->mutex);
+
+  vec_env_work(env, 0);
+
+  pthread_mutex_lock(&env->mutex);
+  while (env->busy != 0) {
+    pthread_cond_wait(&env->finished, &env->mutex);
+  }
+  pthread_mutex_unlock(&env->mutex);
+}
+
+VecEnv* vec_env_create(int count, int threads) {
+  VecEnv* env = (VecEnv*)calloc(1, sizeof(VecEnv));
+  if (env == NULL) {
+    return NULL;
+  }
+  pthread_mutex_init(&env->mutex, NULL);
+  pthread_cond_init(&env->wake, NULL);
+  pthread_cond_init(&env->finished, NULL);
+  env->count = count > 1 ? count : 1;
+  env->chunks = (env->count + VEC_ENV_CHUNK - 1) / VEC_ENV_CHUNK;
+  if (threads <= 0) {
+    threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  env->thread_count = threads < 1             ? 1
+                      : threads > env->chunks ? env->chunks
+                                              : threads;
+
+  env->sessions =
+      (TetrisSession**)calloc(env->count, sizeof(TetrisSession*));
+  env->scores = (int*)calloc(env->count, sizeof(int));
+  env->shards = (struct VecEnvShard*)aligned_alloc(
+      alignof(struct VecEnvShard),
+      env->thread_count * sizeof(struct VecEnvShard));
+  env->workers = (struct VecEnvWorker*)calloc(env->thread_count,
+                                              sizeof(struct VecEnvWorker));
+  bool ok = env->sessions != NULL && env->scores != NULL &&
+            env->shards != NULL && env->workers != NULL;
+  for (int i = 0; ok && i < env->count; ++i) {
+    env->sessions[i] = session_create_headless();
+    ok = env->sessions[i] != NULL;
+  }
+  if (!ok) {
+    /* No workers are running yet */
+    env->thread_count = 1;
+    vec_env_destroy(env);
+    return NULL;
+  }
+
+  for (int i = 0; i < env->thread_count; ++i) {
+    atomic_init(&env->shards[i].next, 0);
+    env->shards[i].end = 0;
+  }
+  int started = 1;
+  for (int i = 1; i < env->thread_count; ++i) {
+    env->workers[i].env = env;
+    env->workers[i].index = i;
+    if (pthread_create(&env->workers[i].thread, NULL, vec_env_worker,
+                       &env->workers[i]) != 0) {
+      break;
+    }
+    ++started;
+  }
+  /* Jobs wait for every worker, so only the started ones may count. They
+   * read the count under the mutex, after this store */
+  env->thread_count = started;
+  vec_env_reset_all(env, NULL, NULL);
+  return env;
+}
+
+void vec_env_destroy(VecEnv* env) {
+  if (env == NULL) return;
+  if (env->thread_count > 1) {
+    pthread_mutex_lock(&env->mutex);
+    env->stop = true;
+    pthread_cond_broadcast(&env->wake);
+    pthread_mutex_unlock(&env->mutex);
+    for (int i = 1; i < env->thread_count; ++i) {
+      pthread_join(env->workers[i].thread, NULL);
+    }
+  }
+  pthread_mutex_destroy(&env->mutex);
+  pthread_cond_destroy(&env->wake);
+  pthread_cond_destroy(&env->finished);
+  for (int i = 0; env->sessions != NULL && i < env->count; ++i) {
+    session_free(env->sessions[i]);
+  }
+  free(env->sessions);
+  free(env->scores);
+  free(env->shards);
+  free(env->workers);
+  free(env);
+}
+
+void vec_env_reset_all(VecEnv* env, const uint64_t* seeds, uint8_t* obs) {
+  env->reset_job = true;
+  env->seeds = seeds;
+  env->obs = obs;
+  vec_env_run(env);
+}
+
+void vec_env_step_all(VecEnv* env, const uint8_t* actions, uint8_t* obs,
+                      float* reward, uint8_t* done) {
+  env->reset_job = false;
+  env->actions = actions;
+  env->obs = obs;
+  env->reward = reward;
+  env->done = done;
+  vec_env_run(env);
+}
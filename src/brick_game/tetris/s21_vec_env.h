@@ -0,0 +1,91 @@
+/**
+ * @file s21_vec_env.h
+ * @brief Vectorized tetris environments header file.
+ *
+ * A VecEnv owns N headless sessions (no threads, no score file) and
+ * advances all of them together: one call applies one action per session,
+ * plays one timer tick and writes all fields into a single
+ * [N][ROWS_FIELD][COLS_FIELD] byte buffer, the falling figure included.
+ *
+ * Sessions are split into chunks of VEC_ENV_CHUNK. Every worker (the
+ * calling thread included) starts on its own share of the chunks and
+ * then steals the chunks left in the shares of the others. A chunk is
+ * claimed with one atomic increment and a worker binds each session to
+ * its thread while stepping it, so no locks are taken per session.
+ */
+#ifndef S21_VEC_ENV_H
+#define S21_VEC_ENV_H
+
+#include "s21_tetris.h"
+
+#define VEC_ENV_CHUNK 16 /* Sessions claimed at once by a worker */
+#define VEC_ENV_CELLS (ROWS_FIELD * COLS_FIELD) /* Bytes per observation */
+
+struct VecEnvShard;
+struct VecEnvWorker;
+
+/**
+ * @brief Batch of headless tetris sessions and the pool stepping them.
+ **/
+typedef struct VecEnv {
+  int count;
+  int chunks;
+  TetrisSession** sessions;
+  int* scores; /* Score after the previous tick */
+
+  int thread_count; /* Workers, the calling thread included */
+  struct VecEnvShard* shards;
+  struct VecEnvWorker* workers;
+  pthread_mutex_t mutex;
+  pthread_cond_t wake;
+  pthread_cond_t finished;
+  uint64_t generation;
+  int busy;
+  bool stop;
+
+  /* Current job */
+  bool reset_job;
+  const uint64_t* seeds;
+  const uint8_t* actions;
+  uint8_t* obs;
+  float* reward;
+  uint8_t* done;
+} VecEnv;
+
+/**
+ * @brief Creates a batch, every session starts a game seeded with i + 1.
+ * @param count Number of sessions, at least one
+ * @param threads Workers, the calling thread included; 0 or less uses
+ * every core
+ * @return New batch or NULL
+ **/
+VecEnv* vec_env_create(int count, int threads);
+
+/**
+ * @brief Stops the workers and frees the sessions.
+ **/
+void vec_env_destroy(VecEnv* env);
+
+/**
+ * @brief Starts a new game in every session.
+ * @param seeds count PRNG seeds (figure choice), NULL seeds session i
+ * with i + 1
+ * @param obs Output [count][ROWS_FIELD][COLS_FIELD] cells, may be NULL
+ **/
+void vec_env_reset_all(VecEnv* env, const uint64_t* seeds, uint8_t* obs);
+
+/**
+ * @brief Advances every session by one timer tick. A finished game is
+ * restarted right away (its PRNG goes on), so obs holds the first field
+ * of the new game and done marks the restart.
+ * @param actions count actions (UserAction_t): Left, Right, Down and
+ * Action (rotation) move the figure, anything else just lets it fall
+ * @param obs Output [count][ROWS_FIELD][COLS_FIELD] cells: 0 for blank,
+ * figure index otherwise
+ * @param reward Output, points scored during the tick
+ * @param done Output, 1 if the game ended during the tick
+ **/
+void vec_env_step_all(VecEnv* env, const uint8_t* actions, uint8_t* obs,
+                      float* reward, uint8_t* done);
+
+#endif
@@ -1,18 +1,120 @@
 #include "s21_client_library.h"
 
-static char* get_handling_url() {
-  static char* handling_url = NULL;
-  if (handling_url == NULL) {
-    handling_url = calloc(100, sizeof(char));
-  }
-  return handling_url;
-}
+#include <ctype.h>
+#include <pthread.h>
+
+#include "s21_frame_parser.h"
+#include "s21_frame_stream.h"
+#include "s21_packed_frame.h"
+
+#define CLIENT_URL_SIZE 128
+#define ASYNC_REQUESTS 8 /* Transfers in flight at once */
+#define ASYNC_FRAME_JOBS (ASYNC_REQUESTS / 2)
+#define ETAG_SIZE 64
+#define PACKED_ACCEPT \
+  "Accept: " PACKED_FRAME_MEDIA_TYPE ", application/json;q=0.5"
+
+typedef enum { REQUEST_ACTION, REQUEST_FRAME } RequestKind_t;
+
+/**
+ * @brief Reusable receive buffer. A JSON frame body is also streamed
+ * through the parser while it arrives, the buffer keeps it for error
+ * messages and packed frames.
+ **/
+typedef struct {
+  MemoryStruct buffer;
+  FrameParser parser;
+  CURL* handle;
+  bool checked; /* Content type of the body looked at */
+  bool packed;  /* The body is a packed frame */
+  char etag[ETAG_SIZE];
+} Receiver;
+
+/**
+ * @brief Last frame of get_frame() with its ETag. While it is kept, the
+ * request carries If-None-Match and a 304 answer is served from here.
+ **/
+typedef struct {
+  Frame_t frame;
+  char etag[ETAG_SIZE];
+  struct curl_slist* headers; /* Accept and If-None-Match */
+} FrameCache;
+
+/**
+ * @brief Frame being fetched by a transfer.
+ **/
+typedef struct {
+  Frame_t frame;
+  FrameCallback_t callback;
+  void* user_data;
+  bool in_use;
+} FrameJob;
+
+/**
+ * @brief Slot of the multi handle. Its easy handle and buffer outlive the
+ * transfer, so the next request in the slot reuses both.
+ **/
+typedef struct {
+  CURL* handle;
+  Receiver receiver;
+  RequestKind_t kind;
+  char body[32];
+  ActionCallback_t callback;
+  void* user_data;
+  FrameJob* job;
+  bool in_use;
+} AsyncRequest;
+
+/**
+ * @brief Connection to one server. Reusing one easy handle keeps its TCP
+ * connection alive between requests, endpoint URLs are built once on
+ * creation and the receive buffers only grow. Nothing here is shared with
+ * other clients, so each thread may drive its own.
+ **/
+struct BrickClient {
+  CURL* handle;
+  struct curl_slist* json_headers;
+  struct curl_slist* packed_headers;
+  struct curl_slist* action_frame_headers; /* POST answered with a frame */
+  Receiver receiver;
+  char games_url[CLIENT_URL_SIZE];
+  char actions_url[CLIENT_URL_SIZE];
+  char state_url[CLIENT_URL_SIZE];
+  char status_url[CLIENT_URL_SIZE];
+  char frame_url[CLIENT_URL_SIZE];
+  char action_frame_url[CLIENT_URL_SIZE];
+  char stream_url[CLIENT_URL_SIZE];
+  Frame_t frame; /* Scratch frame of get_current_state() */
+  FrameCache cache;
+
+  CURLM* multi;
+  AsyncRequest requests[ASYNC_REQUESTS];
+  FrameJob jobs[ASYNC_FRAME_JOBS];
+
+  CURL* stream_handle;
+  struct curl_slist* stream_headers;
+  FrameStream stream;
+  FrameCallback_t stream_callback;
+  void* stream_user_data;
+  bool stream_open;
+
+  int field_rows;
+  int field_cols;
+  BrickClientMetrics_t metrics;
+};
+
+/* Clients alive, curl is set up with the first and cleaned with the last */
+static pthread_mutex_t clients_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int clients_count = 0;
 
 static ResponseStatus_t map_status(long response_status) {
   switch (response_status) {
     case 200:
       return STATUS_OK;
       break;
+    case 304:
+      return STATUS_NOT_MODIFIED;
+      break;
     case 400:
       return STATUS_BAD_REQUEST;
       break;
@@ -31,82 +133,247 @@ static ResponseStatus_t map_status(long response_status) {
   }
 }
 
-static GameStatus_t map_game_status(const char* status_string) {
-  if (strcmp(status_string, "Moving") == 0) return MOVING;
-  if (strcmp(status_string, "Spawn") == 0) return SPAWN;
-  if (strcmp(status_string, "Exit") == 0) return EXIT;
-  if (strcmp(status_string, "Pause") == 0) return PAUSE;
-  if (strcmp(status_string, "Start") == 0) return START;
-  if (strcmp(status_string, "Gameover") == 0) return GAMEOVER;
-  if (strcmp(status_string, "Shifting") == 0) return SHIFTING;
-  if (strcmp(status_string, "Attaching") == 0) return ATTACHING;
-  return -1;
-}
-
 static size_t write_callback(void* contents, size_t size, size_t nmemb,
                              void* userp) {
   size_t realsize = size * nmemb;
-  MemoryStruct* mem = (MemoryStruct*)userp;
-
-  char* ptr = realloc(mem->memory, mem->size + realsize + 1);  // +1 под '\0'
-  if (!ptr) {
-    fprintf(stderr, "Ошибка выделения памяти\n");
-    return 0;
+  Receiver* receiver = (Receiver*)userp;
+  MemoryStruct* mem = &receiver->buffer;
+
+  if (mem->size + realsize + 1 > mem->capacity) {  // +1 под '\0'
+    size_t capacity = mem->capacity > 0 ? mem->capacity : 1024;
+    while (capacity < mem->size + realsize + 1) capacity *= 2;
+    char* ptr = realloc(mem->memory, capacity);
+    if (!ptr) {
+      fprintf(stderr, "Ошибка выделения памяти\n");
+      return 0;
+    }
+    mem->memory = ptr;
+    mem->capacity = capacity;
   }
 
-  mem->memory = ptr;
   memcpy(&(mem->memory[mem->size]), contents, realsize);
   mem->size += realsize;
   mem->memory[mem->size] = '\0';
 
+  if (!receiver->checked) {
+    /* Headers are in by the first chunk, a packed frame is decoded whole */
+    char* content_type = NULL;
+    curl_easy_getinfo(receiver->handle, CURLINFO_CONTENT_TYPE, &content_type);
+    receiver->checked = true;
+    receiver->packed =
+        content_type != NULL &&
+        strncmp(content_type, PACKED_FRAME_MEDIA_TYPE,
+                strlen(PACKED_FRAME_MEDIA_TYPE)) == 0;
+    if (receiver->packed) receiver->parser.frame = NULL;
+  }
+  frame_parser_feed(&receiver->parser, contents, realsize);
   return realsize;
 }
 
-void init_library(char* server_url) {
-  char* handling_url = get_handling_url();
-  curl_global_init(CURL_GLOBAL_DEFAULT);
-  strcpy(handling_url, server_url);
+/* Keeps the ETag of the response for the next conditional request */
+static size_t header_callback(char* buffer, size_t size, size_t nitems,
+                              void* userp) {
+  size_t length = size * nitems;
+  Receiver* receiver = (Receiver*)userp;
+  const char* name = "etag:";
+  size_t begin = 0;
+  while (name[begin] != '\0' && begin < length &&
+         tolower((unsigned char)buffer[begin]) == name[begin]) {
+    ++begin;
+  }
+  if (name[begin] == '\0') {
+    while (begin < length && buffer[begin] == ' ') ++begin;
+    size_t end = length;
+    while (end > begin && isspace((unsigned char)buffer[end - 1])) --end;
+    size_t count = end - begin < ETAG_SIZE - 1 ? end - begin : ETAG_SIZE - 1;
+    memcpy(receiver->etag, buffer + begin, count);
+    receiver->etag[count] = '\0';
+  }
+  return length;
+}
+
+/**
+ * @brief Points a reused easy handle at the next request.
+ * @param url Prebuilt endpoint URL
+ * @param post_body JSON body of a POST, NULL for a GET
+ * @param frame Frame the body is parsed into, NULL to keep the raw body only
+ * @param changes Cells the body changed in the frame, may be NULL
+ **/
+static void prepare_request(BrickClient* client, CURL* curl_handle,
+                            Receiver* receiver, const char* url,
+                            const char* post_body, Frame_t* frame,
+                            FrameChanges_t* changes) {
+  receiver->buffer.size = 0;
+  if (receiver->buffer.memory != NULL) receiver->buffer.memory[0] = '\0';
+  frame_parser_begin(&receiver->parser, frame, changes);
+  receiver->handle = curl_handle;
+  receiver->checked = false;
+  receiver->packed = false;
+  receiver->etag[0] = '\0';
+
+  curl_easy_setopt(curl_handle, CURLOPT_URL, url);
+  curl_easy_setopt(curl_handle, CURLOPT_TCP_KEEPALIVE, 1L);
+  curl_easy_setopt(curl_handle, CURLOPT_TCP_NODELAY, 1L);
+  curl_easy_setopt(curl_handle, CURLOPT_NOSIGNAL, 1L); /* Threads */
+  curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, write_callback);
+  curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void*)receiver);
+  curl_easy_setopt(curl_handle, CURLOPT_HEADERFUNCTION, header_callback);
+  curl_easy_setopt(curl_handle, CURLOPT_HEADERDATA, (void*)receiver);
+  if (post_body != NULL) {
+    curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, client->json_headers);
+    curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, post_body);
+    curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE,
+                     (long)strlen(post_body));
+  } else {
+    curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, NULL);
+    curl_easy_setopt(curl_handle, CURLOPT_HTTPGET, 1L);
+  }
 }
 
-void clear_library() {
-  curl_global_cleanup();
-  free(get_handling_url());
+/* Adds a finished transfer to the metrics of its client */
+static void count_request(BrickClient* client, CURL* curl_handle,
+                          long response_code) {
+  BrickClientMetrics_t* metrics = &client->metrics;
+  curl_off_t bytes = 0;
+  curl_off_t time_us = 0;
+  curl_easy_getinfo(curl_handle, CURLINFO_SIZE_DOWNLOAD_T, &bytes);
+  curl_easy_getinfo(curl_handle, CURLINFO_TOTAL_TIME_T, &time_us);
+  metrics->requests++;
+  if (response_code == 304) {
+    metrics->not_modified++;
+  } else if (response_code != 200) {
+    metrics->failures++;
+  }
+  metrics->bytes_received += (uint64_t)bytes;
+  metrics->request_time_us += (uint64_t)time_us;
 }
 
-Response_t get_accesible_games(GameType_t** result) {
-  CURL* curl_handle = curl_easy_init();
-  Response_t response = {STATUS_OK, ""};
-  char* status_api_url = calloc(100, sizeof(char));
-  MemoryStruct chunk;
-  chunk.memory = malloc(1);
-  chunk.size = 0;
+/**
+ * @brief Performs the request prepared on the kept-alive handle.
+ * @return HTTP response code, 0 if the server could not be reached
+ **/
+static long perform_prepared(BrickClient* client) {
+  long response_code = 0;
+  if (curl_easy_perform(client->handle) == CURLE_OK) {
+    curl_easy_getinfo(client->handle, CURLINFO_RESPONSE_CODE,
+                      &response_code);
+  }
+  count_request(client, client->handle, response_code);
+  return response_code;
+}
 
-  strcat(status_api_url, get_handling_url());
-  strcat(status_api_url, "/api/games");
+/**
+ * @brief Performs one request on the kept-alive handle, the body lands in
+ * the client buffer.
+ * @return HTTP response code, 0 if the server could not be reached
+ **/
+static long perform_request(BrickClient* client, const char* url,
+                            const char* post_body, Frame_t* frame,
+                            FrameChanges_t* changes) {
+  prepare_request(client, client->handle, &client->receiver, url, post_body,
+                  frame, changes);
+  return perform_prepared(client);
+}
 
-  curl_easy_setopt(curl_handle, CURLOPT_URL, status_api_url);
-  curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, write_callback);
-  curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void*)&chunk);
-  curl_easy_perform(curl_handle);
+/* Fills the status and the server message of a failed request */
+static void read_error(Response_t* response, long response_code,
+                       const Receiver* receiver) {
+  response->response_status = map_status(response_code);
+  const char* body = receiver->buffer.memory;
+  json_object* parsed_json = body != NULL ? json_tokener_parse(body) : NULL;
+  json_object* error_message_object = NULL;
+  json_object_object_get_ex(parsed_json, "message", &error_message_object);
+  if (error_message_object != NULL) {
+    snprintf(response->message, sizeof(response->message), "%s",
+             json_object_get_string(error_message_object));
+  }
+  json_object_put(parsed_json);
+}
+
+/* Appends the API path to the server URL, false if it does not fit */
+static bool format_url(char* url, const char* server_url, const char* path) {
+  int length = snprintf(url, CLIENT_URL_SIZE, "%s%s", server_url, path);
+  return length >= 0 && length < CLIENT_URL_SIZE;
+}
+
+BrickClient* brick_client_create(const char* server_url) {
+  BrickClient* client = calloc(1, sizeof(BrickClient));
+  if (client == NULL) return NULL;
+  pthread_mutex_lock(&clients_mutex);
+  if (clients_count++ == 0) curl_global_init(CURL_GLOBAL_DEFAULT);
+  pthread_mutex_unlock(&clients_mutex);
+
+  bool urls_fit =
+      format_url(client->games_url, server_url, "/api/games") &&
+      format_url(client->actions_url, server_url, "/api/actions") &&
+      format_url(client->state_url, server_url, "/api/state") &&
+      format_url(client->status_url, server_url, "/api/status") &&
+      format_url(client->frame_url, server_url, "/api/frame") &&
+      format_url(client->action_frame_url, server_url,
+                 "/api/actions?frame=true") &&
+      format_url(client->stream_url, server_url, "/api/stream");
+
+  client->json_headers =
+      curl_slist_append(NULL, "Content-Type: application/json");
+  client->packed_headers = curl_slist_append(NULL, PACKED_ACCEPT);
+  client->action_frame_headers = curl_slist_append(
+      curl_slist_append(NULL, "Content-Type: application/json"),
+      PACKED_ACCEPT);
+  client->handle = curl_easy_init();
+  /* A truncated URL would send every request to the wrong place */
+  if (!urls_fit || client->handle == NULL || client->json_headers == NULL ||
+      client->packed_headers == NULL || client->action_frame_headers == NULL) {
+    brick_client_destroy(client);
+    return NULL;
+  }
+  /* Classic brick game screen until the server reports its board */
+  client->field_rows = 20;
+  client->field_cols = 10;
+  return client;
+}
 
-  long response_code;
-  curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &response_code);
+void brick_client_destroy(BrickClient* client) {
+  if (client == NULL) return;
+  curl_easy_cleanup(client->handle);
+  for (int i = 0; i < ASYNC_REQUESTS; ++i) {
+    AsyncRequest* request = &client->requests[i];
+    if (request->in_use) curl_multi_remove_handle(client->multi,
+                                                  request->handle);
+    curl_easy_cleanup(request->handle);
+    free(request->receiver.buffer.memory);
+  }
+  brick_client_unsubscribe(client);
+  curl_easy_cleanup(client->stream_handle);
+  curl_multi_cleanup(client->multi);
+  curl_slist_free_all(client->json_headers);
+  curl_slist_free_all(client->packed_headers);
+  curl_slist_free_all(client->action_frame_headers);
+  curl_slist_free_all(client->cache.headers);
+  curl_slist_free_all(client->stream_headers);
+  free(client->receiver.buffer.memory);
+  free(client);
+
+  pthread_mutex_lock(&clients_mutex);
+  if (--clients_count == 0) curl_global_cleanup();
+  pthread_mutex_unlock(&clients_mutex);
+}
 
-  json_object* parsed_json = NULL;
-  parsed_json = json_tokener_parse(chunk.memory);
+void brick_client_get_metrics(const BrickClient* client,
+                              BrickClientMetrics_t* result) {
+  *result = client->metrics;
+}
 
+Response_t brick_client_get_games(BrickClient* client, GameType_t** result) {
+  Response_t response = {STATUS_OK, ""};
+  long response_code =
+      perform_request(client, client->games_url, NULL, NULL, NULL);
   if (response_code != 200) {
-    response.response_status = map_status(response_code);
-    json_object* error_message_object;
-    json_object_object_get_ex(parsed_json, "message", &error_message_object);
-    if (error_message_object != NULL)
-      strcpy(response.message, json_object_get_string(error_message_object));
-    json_object_put(parsed_json);
-    free(chunk.memory);
-    free(status_api_url);
+    read_error(&response, response_code, &client->receiver);
     return response;
   }
 
+  json_object* parsed_json =
+      json_tokener_parse(client->receiver.buffer.memory);
   if (parsed_json && json_object_get_type(parsed_json) == json_type_array) {
     size_t lenght = json_object_array_length(parsed_json);
     *result = calloc(lenght, sizeof(GameType_t));
@@ -123,263 +390,424 @@ Response_t get_accesible_games(GameType_t** result) {
     }
   }
   json_object_put(parsed_json);
-  free(chunk.memory);
-  free(status_api_url);
-  curl_easy_cleanup(curl_handle);
   return response;
 }
 
-Response_t select_game(GameType_t type) {
-  CURL* curl_handle = curl_easy_init();
+Response_t brick_client_select_game(BrickClient* client, GameType_t type) {
   Response_t response = {STATUS_OK, ""};
-  char* select_api_url = calloc(100, sizeof(char));
-  MemoryStruct chunk;
-  chunk.memory = malloc(1);
-  chunk.size = 0;
-
-  strcat(select_api_url, get_handling_url());
-  strcat(select_api_url, "/api/games/");
-  char identified[3];
-  snprintf(identified, sizeof(identified), "%d", type.identifier);
-  strcat(select_api_url, identified);
-
-  curl_easy_setopt(curl_handle, CURLOPT_URL, select_api_url);
-  curl_easy_setopt(curl_handle, CURLOPT_POST, 1L);
-  curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, "\n");
-  curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, write_callback);
-  curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void*)&chunk);
-  curl_easy_perform(curl_handle);
-
-  long response_code;
-  curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &response_code);
+  char select_api_url[CLIENT_URL_SIZE + 16];
+  snprintf(select_api_url, sizeof(select_api_url), "%s/%d",
+           client->games_url, type.identifier);
 
+  long response_code =
+      perform_request(client, select_api_url, "\n", NULL, NULL);
   if (response_code != 200) {
-    json_object* parsed_json;
-    parsed_json = json_tokener_parse(chunk.memory);
-    response.response_status = map_status(response_code);
-    json_object* error_message_object;
-    json_object_object_get_ex(parsed_json, "message", &error_message_object);
-    strcpy(response.message, json_object_get_string(error_message_object));
-    json_object_put(parsed_json);
-  }
-
-  free(select_api_url);
-  free(chunk.memory);
-  curl_easy_cleanup(curl_handle);
+    read_error(&response, response_code, &client->receiver);
+  }
   return response;
 }
 
-Response_t submit_action(UserAction_t action, bool hold) {
-  CURL* curl_handle = curl_easy_init();
+Response_t brick_client_submit_action(BrickClient* client, UserAction_t action,
+                                      bool hold) {
   Response_t response = {STATUS_OK, ""};
-  char* actions_api_url = calloc(100, sizeof(char));
-  MemoryStruct chunk;
-  chunk.memory = malloc(1);
-  chunk.size = 0;
-
-  strcat(actions_api_url, get_handling_url());
-  strcat(actions_api_url, "/api/actions");
-
-  json_object* action_json = json_object_new_object();
-  json_object_object_add(action_json, "id", json_object_new_int(action + 1));
-  json_object_object_add(action_json, "hold", json_object_new_boolean(hold));
-
-  const char* json_string = json_object_to_json_string(action_json);
-  struct curl_slist* headers = NULL;
-  headers = curl_slist_append(headers, "Content-Type: application/json");
-
-  curl_easy_setopt(curl_handle, CURLOPT_URL, actions_api_url);
-  curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, headers);
-  curl_easy_setopt(curl_handle, CURLOPT_POST, 1L);
-  curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, json_string);
-  curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE, strlen(json_string));
-  curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, write_callback);
-  curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void*)&chunk);
-  // curl_easy_setopt(curl_handle, CURLOPT_TIMEOUT, 1L);
-  curl_easy_perform(curl_handle);
+  char action_json[32];
+  snprintf(action_json, sizeof(action_json), "{\"id\":%d,\"hold\":%s}",
+           action + 1, hold ? "true" : "false");
+
+  long response_code =
+      perform_request(client, client->actions_url, action_json, NULL, NULL);
+  if (response_code != 200) {
+    read_error(&response, response_code, &client->receiver);
+  }
+  return response;
+}
+
+/* Copies cells into newly allocated rows, as GameInfo_t holds them */
+static int** copy_rows(const uint8_t* cells, int rows, int cols) {
+  int** matrix = calloc(rows, sizeof(int*));
+  for (int i = 0; i < rows; ++i) {
+    matrix[i] = calloc(cols, sizeof(int));
+    for (int j = 0; j < cols; ++j) matrix[i][j] = cells[i * cols + j];
+  }
+  return matrix;
+}
 
-  long response_code;
-  curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &response_code);
+Response_t brick_client_get_state_frame(BrickClient* client,
+                                        Frame_t* result) {
+  Response_t response = {STATUS_OK, ""};
+  long response_code =
+      perform_request(client, client->state_url, NULL, result, NULL);
+  if (response_code != 200) {
+    read_error(&response, response_code, &client->receiver);
+    return response;
+  }
+  client->field_rows = result->rows;
+  client->field_cols = result->cols;
+  return response;
+}
 
+Response_t brick_client_get_state_delta(BrickClient* client, Frame_t* result,
+                                        FrameChanges_t* changes) {
+  Response_t response = {STATUS_OK, ""};
+  char delta_url[CLIENT_URL_SIZE + 32];
+  snprintf(delta_url, sizeof(delta_url), "%s?since=%llu",
+           client->state_url, (unsigned long long)result->generation);
+  long response_code =
+      perform_request(client, delta_url, NULL, result, changes);
   if (response_code != 200) {
-    json_object* parsed_json;
-    parsed_json = json_tokener_parse(chunk.memory);
-    response.response_status = map_status(response_code);
-    json_object* error_message_object;
-    json_object_object_get_ex(parsed_json, "message", &error_message_object);
-    if (error_message_object != NULL)
-      strcpy(response.message, json_object_get_string(error_message_object));
-    json_object_put(parsed_json);
-  }
-
-  json_object_put(action_json);
-  free(actions_api_url);
-  free(chunk.memory);
-  curl_slist_free_all(headers);
-  curl_easy_cleanup(curl_handle);
+    read_error(&response, response_code, &client->receiver);
+    return response;
+  }
+  client->field_rows = result->rows;
+  client->field_cols = result->cols;
   return response;
 }
 
-Response_t get_current_state(GameInfo_t* result) {
-  CURL* curl_handle = curl_easy_init();
+/* Decodes a finished frame transfer, JSON bodies are already parsed */
+static void finish_frame(BrickClient* client, Response_t* response,
+                         long response_code, Receiver* receiver,
+                         Frame_t* frame) {
+  if (response_code == 204) {
+    /* The action ended the game, the server has no frame left */
+    frame->status = EXIT;
+    return;
+  }
+  if (response_code != 200) {
+    read_error(response, response_code, receiver);
+    return;
+  }
+  if (receiver->packed &&
+      !packed_frame_decode((const uint8_t*)receiver->buffer.memory,
+                           receiver->buffer.size, frame)) {
+    response->response_status = STATUS_OTHER;
+    strcpy(response->message, "Malformed packed frame");
+    return;
+  }
+  client->field_rows = frame->rows;
+  client->field_cols = frame->cols;
+}
+
+/**
+ * @brief Requests a frame, packed if the server offers it.
+ * @param headers Accept (and Content-Type of a POST) headers
+ **/
+static Response_t request_frame(BrickClient* client, const char* url,
+                                const char* post_body,
+                                struct curl_slist* headers, Frame_t* result) {
   Response_t response = {STATUS_OK, ""};
-  char* state_api_url = calloc(100, sizeof(char));
-  MemoryStruct chunk;
-  chunk.memory = malloc(1);
-  chunk.size = 0;
+  prepare_request(client, client->handle, &client->receiver, url, post_body,
+                  result, NULL);
+  curl_easy_setopt(client->handle, CURLOPT_HTTPHEADER, headers);
+  long response_code = perform_prepared(client);
+  finish_frame(client, &response, response_code, &client->receiver, result);
+  return response;
+}
 
-  strcat(state_api_url, get_handling_url());
-  strcat(state_api_url, "/api/state");
+Response_t brick_client_get_packed_state(BrickClient* client,
+                                         Frame_t* result) {
+  return request_frame(client, client->state_url, NULL,
+                       client->packed_headers, result);
+}
 
-  curl_easy_setopt(curl_handle, CURLOPT_URL, state_api_url);
-  curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, write_callback);
-  curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void*)&chunk);
-  curl_easy_perform(curl_handle);
+/* Keeps a frame the server tagged, later requests for it are conditional */
+static void cache_frame(FrameCache* cache, const char* etag,
+                        const Frame_t* frame) {
+  if (strcmp(cache->etag, etag) != 0) {
+    curl_slist_free_all(cache->headers);
+    cache->headers = NULL;
+    strcpy(cache->etag, etag);
+    if (etag[0] != '\0') {
+      char if_none_match[ETAG_SIZE + 16];
+      snprintf(if_none_match, sizeof(if_none_match), "If-None-Match: %s",
+               etag);
+      cache->headers = curl_slist_append(
+          curl_slist_append(NULL, PACKED_ACCEPT), if_none_match);
+    }
+  }
+  if (cache->headers != NULL) cache->frame = *frame;
+}
+
+Response_t brick_client_get_frame(BrickClient* client, Frame_t* result) {
+  Response_t response = {STATUS_OK, ""};
+  FrameCache* cache = &client->cache;
+  prepare_request(client, client->handle, &client->receiver,
+                  client->frame_url, NULL, result, NULL);
+  curl_easy_setopt(client->handle, CURLOPT_HTTPHEADER,
+                   cache->headers != NULL ? cache->headers
+                                          : client->packed_headers);
+  long response_code = perform_prepared(client);
+  if (response_code == 304) {
+    /* Generations name frames, the caller may already hold this one */
+    if (result->generation != cache->frame.generation) {
+      *result = cache->frame;
+    }
+    response.response_status = STATUS_NOT_MODIFIED;
+    return response;
+  }
+  finish_frame(client, &response, response_code, &client->receiver, result);
+  if (response.response_status == STATUS_OK) {
+    cache_frame(cache, client->receiver.etag, result);
+  }
+  return response;
+}
 
-  long response_code;
-  curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &response_code);
+Response_t brick_client_submit_action_frame(BrickClient* client,
+                                            UserAction_t action, bool hold,
+                                            Frame_t* result) {
+  char action_json[32];
+  snprintf(action_json, sizeof(action_json), "{\"id\":%d,\"hold\":%s}",
+           action + 1, hold ? "true" : "false");
+  return request_frame(client, client->action_frame_url, action_json,
+                       client->action_frame_headers, result);
+}
 
-  json_object* parsed_json = NULL;
-  parsed_json = json_tokener_parse(chunk.memory);
+Response_t brick_client_get_state(BrickClient* client, GameInfo_t* result) {
+  Frame_t* frame = &client->frame;
+  frame->rows = 0;
+  frame->has_next = false;
+  Response_t response = brick_client_get_packed_state(client, frame);
+  result->field = NULL;
+  result->next = NULL;
+  if (response.response_status != STATUS_OK) return response;
+
+  if (frame->rows > 0) {
+    result->field = copy_rows(frame->cells, frame->rows, frame->cols);
+  }
+  if (frame->has_next) {
+    result->next = copy_rows(frame->next, FRAME_NEXT_SIZE, FRAME_NEXT_SIZE);
+  }
+  result->score = frame->score;
+  result->high_score = frame->high_score;
+  result->level = frame->level;
+  result->speed = frame->speed;
+  result->pause = frame->pause;
+  return response;
+}
 
+Response_t brick_client_get_status(BrickClient* client, GameStatus_t* result) {
+  Response_t response = {STATUS_OK, ""};
+  long response_code =
+      perform_request(client, client->status_url, NULL, &client->frame, NULL);
   if (response_code != 200) {
-    result->field = NULL;
-    result->next = NULL;
-    response.response_status = map_status(response_code);
-    json_object* error_message_object;
-    json_object_object_get_ex(parsed_json, "message", &error_message_object);
-    strcpy(response.message, json_object_get_string(error_message_object));
-    json_object_put(parsed_json);
-    free(chunk.memory);
-    free(state_api_url);
+    read_error(&response, response_code, &client->receiver);
     return response;
   }
+  *result = client->frame.status;
+  return response;
+}
 
-  if (parsed_json) {
-    /* Парсинг основного поля */
-    json_object* field_2d_array = NULL;
-    json_object_object_get_ex(parsed_json, "field", &field_2d_array);
-
-    if (field_2d_array &&
-        json_object_get_type(field_2d_array) == json_type_array) {
-      size_t field_rows_size = json_object_array_length(field_2d_array);
-      result->field = calloc(field_rows_size, sizeof(int*));
-      for (size_t i = 0; i < field_rows_size; ++i) {
-        json_object* field_row = json_object_array_get_idx(field_2d_array, i);
-        if (json_object_get_type(field_row) == json_type_array) {
-          size_t field_col_size = json_object_array_length(field_row);
-          result->field[i] = calloc(field_col_size, sizeof(int));
-          for (size_t j = 0; j < field_col_size; ++j) {
-            json_object* field_item = json_object_array_get_idx(field_row, j);
-            result->field[i][j] = json_object_get_int64(field_item);
-          }
-        }
-      }
-    } else {
-      result->field = NULL;
+/* Claims a free slot of the multi handle, NULL if all are busy */
+static AsyncRequest* claim_request(BrickClient* client, RequestKind_t kind) {
+  if (client->multi == NULL) client->multi = curl_multi_init();
+  for (int i = 0; i < ASYNC_REQUESTS; ++i) {
+    AsyncRequest* request = &client->requests[i];
+    if (!request->in_use) {
+      if (request->handle == NULL) request->handle = curl_easy_init();
+      request->in_use = true;
+      request->kind = kind;
+      request->callback = NULL;
+      request->user_data = NULL;
+      request->job = NULL;
+      return request;
     }
+  }
+  return NULL;
+}
 
-    /* Парсинг следующей фигуры */
-    json_object* next_2d_array = NULL;
-    json_object_object_get_ex(parsed_json, "next", &next_2d_array);
-
-    if (next_2d_array &&
-        json_object_get_type(next_2d_array) == json_type_array) {
-      size_t field_rows_size = json_object_array_length(next_2d_array);
-      result->next = calloc(field_rows_size, sizeof(int*));
-      for (size_t i = 0; i < field_rows_size; ++i) {
-        json_object* field_row = json_object_array_get_idx(next_2d_array, i);
-        if (json_object_get_type(field_row) == json_type_array) {
-          size_t field_col_size = json_object_array_length(field_row);
-          result->next[i] = calloc(field_col_size, sizeof(int));
-          for (size_t j = 0; j < field_col_size; ++j) {
-            json_object* field_item = json_object_array_get_idx(field_row, j);
-            result->next[i][j] = json_object_get_int64(field_item);
-          }
-        }
-      }
-    } else {
-      result->next = NULL;
-    }
+static void start_request(BrickClient* client, AsyncRequest* request,
+                          const char* url, const char* post_body) {
+  Frame_t* frame = request->job != NULL ? &request->job->frame : NULL;
+  prepare_request(client, request->handle, &request->receiver, url,
+                  post_body, frame, NULL);
+  if (request->kind == REQUEST_FRAME) {
+    curl_easy_setopt(request->handle, CURLOPT_HTTPHEADER,
+                     client->packed_headers);
+  }
+  curl_easy_setopt(request->handle, CURLOPT_PRIVATE, (void*)request);
+  curl_multi_add_handle(client->multi, request->handle);
+}
+
+Response_t brick_client_submit_action_async(BrickClient* client,
+                                            UserAction_t action, bool hold,
+                                            ActionCallback_t callback,
+                                            void* user_data) {
+  Response_t response = {STATUS_OK, ""};
+  AsyncRequest* request = claim_request(client, REQUEST_ACTION);
+  if (request == NULL) {
+    response.response_status = STATUS_OTHER;
+    strcpy(response.message, "Too many requests in flight");
+    return response;
+  }
+  snprintf(request->body, sizeof(request->body), "{\"id\":%d,\"hold\":%s}",
+           action + 1, hold ? "true" : "false");
+  request->callback = callback;
+  request->user_data = user_data;
+  start_request(client, request, client->actions_url, request->body);
+  return response;
+}
 
-    /* Парсинг счета */
-    json_object* score_object = NULL;
-    json_object_object_get_ex(parsed_json, "score", &score_object);
-    result->score = json_object_get_int(score_object);
+Response_t brick_client_fetch_frame_async(BrickClient* client,
+                                          FrameCallback_t callback,
+                                          void* user_data) {
+  Response_t response = {STATUS_OK, ""};
+  FrameJob* job = NULL;
+  for (int i = 0; i < ASYNC_FRAME_JOBS && job == NULL; ++i) {
+    if (!client->jobs[i].in_use) job = &client->jobs[i];
+  }
+  AsyncRequest* request =
+      job != NULL ? claim_request(client, REQUEST_FRAME) : NULL;
+  if (request == NULL) {
+    response.response_status = STATUS_OTHER;
+    strcpy(response.message, "Too many requests in flight");
+    return response;
+  }
 
-    /* Парсинг максимального счета */
-    json_object* highest_score_object = NULL;
-    json_object_object_get_ex(parsed_json, "highScore", &highest_score_object);
-    result->high_score = json_object_get_int(highest_score_object);
+  job->in_use = true;
+  job->callback = callback;
+  job->user_data = user_data;
+  request->job = job;
+  start_request(client, request, client->frame_url, NULL);
+  return response;
+}
 
-    /* Парсинг уровня */
-    json_object* level_object = NULL;
-    json_object_object_get_ex(parsed_json, "level", &level_object);
-    result->level = json_object_get_int(level_object);
+/* Hands a finished transfer to its callback and frees its slot */
+static void finish_request(BrickClient* client, AsyncRequest* request,
+                           long response_code) {
+  Response_t response = {STATUS_OK, ""};
+  request->in_use = false;
 
-    /* Парсинг скорости */
-    json_object* speed_object = NULL;
-    json_object_object_get_ex(parsed_json, "speed", &speed_object);
-    result->speed = json_object_get_int(speed_object);
+  if (request->kind == REQUEST_ACTION) {
+    if (response_code != 200) {
+      read_error(&response, response_code, &request->receiver);
+    }
+    if (request->callback != NULL) {
+      request->callback(response, request->user_data);
+    }
+    return;
+  }
 
-    /* Парсинг флага паузы */
-    json_object* pause_object = NULL;
-    json_object_object_get_ex(parsed_json, "pause", &pause_object);
-    const char* pause_string = json_object_get_string(pause_object);
-    if (strcmp(pause_string, "true") == 0)
-      result->pause = 1;
-    else if (strcmp(pause_string, "false") == 0)
-      result->pause = 0;
+  FrameJob* job = request->job;
+  finish_frame(client, &response, response_code, &request->receiver,
+               &job->frame);
+  if (job->callback != NULL) {
+    job->callback(response, &job->frame, job->user_data);
   }
+  job->in_use = false;
+}
 
-  json_object_put(parsed_json);
-  free(chunk.memory);
-  free(state_api_url);
-  curl_easy_cleanup(curl_handle);
-  return response;
+static size_t stream_write_callback(void* contents, size_t size,
+                                    size_t nmemb, void* userp) {
+  frame_stream_feed((FrameStream*)userp, contents, size * nmemb);
+  return size * nmemb;
 }
 
-Response_t get_current_game_status(GameStatus_t* result) {
-  CURL* curl_handle = curl_easy_init();
+Response_t brick_client_subscribe(BrickClient* client,
+                                  FrameCallback_t callback, void* user_data) {
   Response_t response = {STATUS_OK, ""};
-  char* status_api_url = calloc(100, sizeof(char));
-  MemoryStruct chunk;
-  chunk.memory = malloc(1);
-  chunk.size = 0;
+  client->stream_callback = callback;
+  client->stream_user_data = user_data;
+  if (client->stream_open) return response;
+
+  if (client->multi == NULL) client->multi = curl_multi_init();
+  if (client->stream_handle == NULL) {
+    client->stream_handle = curl_easy_init();
+    client->stream_headers =
+        curl_slist_append(NULL, "Accept: text/event-stream");
+  }
+  CURL* curl_handle = client->stream_handle;
+  frame_stream_begin(&client->stream);
+  curl_easy_setopt(curl_handle, CURLOPT_URL, client->stream_url);
+  curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER,
+                   client->stream_headers);
+  curl_easy_setopt(curl_handle, CURLOPT_TCP_KEEPALIVE, 1L);
+  curl_easy_setopt(curl_handle, CURLOPT_TCP_NODELAY, 1L);
+  curl_easy_setopt(curl_handle, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, stream_write_callback);
+  curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA,
+                   (void*)&client->stream);
+  curl_easy_setopt(curl_handle, CURLOPT_PRIVATE, NULL);
+  curl_multi_add_handle(client->multi, curl_handle);
+  client->stream_open = true;
+  return response;
+}
+
+void brick_client_unsubscribe(BrickClient* client) {
+  if (!client->stream_open) return;
+  curl_multi_remove_handle(client->multi, client->stream_handle);
+  client->stream_open = false;
+}
 
-  strcat(status_api_url, get_handling_url());
-  strcat(status_api_url, "/api/status");
+bool brick_client_take_frame(BrickClient* client, Frame_t* result) {
+  FrameStream* stream = &client->stream;
+  if (!stream->has_ready) return false;
+  memcpy(result, &stream->ready, sizeof(Frame_t));
+  stream->has_ready = false;
+  return true;
+}
 
-  curl_easy_setopt(curl_handle, CURLOPT_URL, status_api_url);
-  curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, write_callback);
-  curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void*)&chunk);
-  curl_easy_perform(curl_handle);
+/* Delivers the newest streamed frame, or the end of the stream */
+static void deliver_stream(BrickClient* client, bool closed,
+                           long response_code) {
+  FrameCallback_t callback = client->stream_callback;
+  FrameStream* stream = &client->stream;
+  if (callback != NULL && stream->has_ready) {
+    Response_t response = {STATUS_OK, ""};
+    stream->has_ready = false;
+    callback(response, &stream->ready, client->stream_user_data);
+  }
+  if (callback != NULL && closed) {
+    /* Even a clean end of the stream is an error for the subscriber */
+    Response_t response = {
+        response_code == 200 ? STATUS_OTHER : map_status(response_code),
+        "Stream closed"};
+    callback(response, &stream->ready, client->stream_user_data);
+  }
+}
 
-  long response_code;
-  curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &response_code);
+int brick_client_poll(BrickClient* client, int timeout_ms) {
+  if (client->multi == NULL) return 0;
 
-  json_object* parsed_json = NULL;
-  parsed_json = json_tokener_parse(chunk.memory);
+  int running = 0;
+  curl_multi_perform(client->multi, &running);
+  if (running > 0 && timeout_ms > 0) {
+    curl_multi_poll(client->multi, NULL, 0, timeout_ms, NULL);
+    curl_multi_perform(client->multi, &running);
+  }
 
-  if (response_code != 200) {
-    response.response_status = map_status(response_code);
-    json_object* error_message_object;
-    json_object_object_get_ex(parsed_json, "message", &error_message_object);
-    strcpy(response.message, json_object_get_string(error_message_object));
-    json_object_put(parsed_json);
-    free(chunk.memory);
-    free(status_api_url);
-    return response;
+  CURLMsg* message;
+  int queued;
+  bool stream_closed = false;
+  long stream_code = 0;
+  while ((message = curl_multi_info_read(client->multi, &queued))) {
+    if (message->msg != CURLMSG_DONE) continue;
+    CURL* curl_handle = message->easy_handle;
+    long response_code = 0;
+    if (message->data.result == CURLE_OK) {
+      curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &response_code);
+    }
+    curl_multi_remove_handle(client->multi, curl_handle);
+    count_request(client, curl_handle, response_code);
+    if (curl_handle == client->stream_handle) {
+      client->stream_open = false;
+      stream_closed = true;
+      stream_code = response_code;
+    } else {
+      AsyncRequest* request = NULL;
+      curl_easy_getinfo(curl_handle, CURLINFO_PRIVATE, &request);
+      finish_request(client, request, response_code);
+    }
   }
+  deliver_stream(client, stream_closed, stream_code);
 
-  json_object* status_object = NULL;
-  json_object_object_get_ex(parsed_json, "status", &status_object);
-  const char* status_string = json_object_get_string(status_object);
-  *result = map_game_status(status_string);
+  int in_flight = 0;
+  for (int i = 0; i < ASYNC_REQUESTS; ++i) {
+    in_flight += client->requests[i].in_use;
+  }
+  return in_flight;
+}
 
-  json_object_put(parsed_json);
-  free(chunk.memory);
-  free(status_api_url);
-  curl_easy_cleanup(curl_handle);
-  return response;
+void brick_client_get_field_size(const BrickClient* client, int* rows,
+                                 int* cols) {
+  *rows = client->field_rows;
+  *cols = client->field_cols;
 }
@@ -15,6 +15,7 @@ Ubuntu 24.04.2 LTS
 #include <json-c/json.h>
 #include <locale.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -60,6 +61,7 @@ typedef struct {
 
 typedef enum {
   STATUS_OK = 200,
+  STATUS_NOT_MODIFIED = 304, /* The frame did not change, nothing to redraw */
   STATUS_BAD_REQUEST = 400,
   STATUS_NOT_FOUND = 404,
   STATUS_CONFLICT = 409,
@@ -75,8 +77,145 @@ typedef struct {
 typedef struct {
   char* memory;
   size_t size;
+  size_t capacity;
 } MemoryStruct;
 
+#define FRAME_MAX_ROWS 64
+#define FRAME_MAX_COLS 64
+#define FRAME_MAX_CELLS (FRAME_MAX_ROWS * FRAME_MAX_COLS)
+#define FRAME_NEXT_SIZE 4
+
+/* Status and state of the game in flat buffers, cells row by row */
+typedef struct {
+  uint64_t generation; /* Grows with every change on the server */
+  GameStatus_t status;
+  int rows;
+  int cols;
+  uint8_t cells[FRAME_MAX_CELLS];
+  bool has_next;
+  uint8_t next[FRAME_NEXT_SIZE * FRAME_NEXT_SIZE];
+  int score;
+  int high_score;
+  int level;
+  int speed;
+  int pause;
+} Frame_t;
+
+/* Cells a state update changed, to redraw only those */
+typedef struct {
+  bool full; /* The whole field was sent, redraw everything */
+  int count;
+  uint16_t cells[FRAME_MAX_CELLS]; /* Indices into Frame_t.cells */
+} FrameChanges_t;
+
+/* Completion callbacks, called from client_poll() */
+typedef void (*ActionCallback_t)(Response_t response, void* user_data);
+typedef void (*FrameCallback_t)(Response_t response, const Frame_t* frame,
+                                void* user_data);
+
+/* Connection to one server with its own URL, kept-alive handles, buffers,
+ * frame cache and metrics. Clients share nothing, so several threads may
+ * each drive their own at once; one client is used by one thread at a time,
+ * its callbacks run on that thread from brick_client_poll() */
+typedef struct BrickClient BrickClient;
+
+/* Counters of the requests a client finished */
+typedef struct {
+  uint64_t requests;
+  uint64_t failures;       /* No answer or an error status */
+  uint64_t not_modified;   /* 304 answers served from the frame cache */
+  uint64_t bytes_received; /* Response bodies */
+  uint64_t request_time_us;
+} BrickClientMetrics_t;
+
+/* Creates a client of the server at server_url. NULL if out of memory, if
+ * curl fails to start or if the URL is too long for the API paths */
+BrickClient* brick_client_create(const char* server_url);
+
+/* Closes the connections of the client and frees it */
+void brick_client_destroy(BrickClient* client);
+
+void brick_client_get_metrics(const BrickClient* client,
+                              BrickClientMetrics_t* result);
+
+Response_t brick_client_get_games(BrickClient* client, GameType_t** result);
+
+Response_t brick_client_select_game(BrickClient* client, GameType_t type);
+
+Response_t brick_client_submit_action(BrickClient* client, UserAction_t action,
+                                      bool hold);
+
+Response_t brick_client_get_state(BrickClient* client, GameInfo_t* result);
+
+/* Streams the state into the caller's frame without allocating, the
+ * status of the frame is left as it is */
+Response_t brick_client_get_state_frame(BrickClient* client,
+                                        Frame_t* result);
+
+/* Fills the caller's frame from the compact binary format, status
+ * included, or from JSON if the server does not offer it (the status is
+ * left as it is then) */
+Response_t brick_client_get_packed_state(BrickClient* client,
+                                         Frame_t* result);
+
+/* Fetches status, state and generation as one consistent snapshot in a
+ * single request, packed if the server offers it. The last frame is kept
+ * with its ETag: if the server still has it, the answer is a bodiless 304,
+ * result gets the kept frame and the status is STATUS_NOT_MODIFIED */
+Response_t brick_client_get_frame(BrickClient* client, Frame_t* result);
+
+/* Submits an action and fills the frame as it is right after it, saving
+ * the separate get_frame(). If the action ended the game the server answers
+ * 204: the status is STATUS_OK and only frame status is set, to EXIT */
+Response_t brick_client_submit_action_frame(BrickClient* client,
+                                            UserAction_t action, bool hold,
+                                            Frame_t* result);
+
+/* Brings the caller's frame up to date in place: the server only sends the
+ * cells changed since result->generation (0 asks for a full frame), or the
+ * whole field if it no longer has that generation. changes may be NULL */
+Response_t brick_client_get_state_delta(BrickClient* client, Frame_t* result,
+                                        FrameChanges_t* changes);
+
+Response_t brick_client_get_status(BrickClient* client, GameStatus_t* result);
+
+/* Field size of the last frame, 20 by 10 before the first one */
+void brick_client_get_field_size(const BrickClient* client, int* rows,
+                                 int* cols);
+
+/* Queues an action, the callback (may be NULL) gets the server answer */
+Response_t brick_client_submit_action_async(BrickClient* client,
+                                            UserAction_t action, bool hold,
+                                            ActionCallback_t callback,
+                                            void* user_data);
+
+/* Queues a get_frame(), the callback gets the frame, which is only valid
+ * during the call */
+Response_t brick_client_fetch_frame_async(BrickClient* client,
+                                          FrameCallback_t callback,
+                                          void* user_data);
+
+/* Opens the server frame stream, the callback gets every new frame from
+ * brick_client_poll(), and the stream error once it closes. With a NULL
+ * callback frames wait in a slot for brick_client_take_frame() */
+Response_t brick_client_subscribe(BrickClient* client,
+                                  FrameCallback_t callback, void* user_data);
+
+/* Closes the frame stream */
+void brick_client_unsubscribe(BrickClient* client);
+
+/* Copies the newest streamed frame, false if none arrived since last time */
+bool brick_client_take_frame(BrickClient* client, Frame_t* result);
+
+/* Drives queued requests, waiting up to timeout_ms for network activity,
+ * and runs the callbacks of finished ones. Returns requests in flight */
+int brick_client_poll(BrickClient* client, int timeout_ms);
+
+/* The functions below drive one process-wide client, created by
+ * init_library() and destroyed by clear_library(); they are not meant to be
+ * called from several threads. Without a client (init_library() failed or
+ * was not called) they answer STATUS_OTHER "library not initialized" */
+
 void init_library(char* server_url);
 
 void clear_library();
@@ -89,6 +228,33 @@ Response_t submit_action(UserAction_t action, bool hold);
 
 Response_t get_current_state(GameInfo_t* result);
 
+Response_t get_current_state_frame(Frame_t* result);
+
+Response_t get_packed_state(Frame_t* result);
+
+Response_t get_frame(Frame_t* result);
+
+Response_t submit_action_frame(UserAction_t action, bool hold,
+                               Frame_t* result);
+
+Response_t get_current_state_delta(Frame_t* result, FrameChanges_t* changes);
+
 Response_t get_current_game_status(GameStatus_t* result);
 
-#endif
\ No newline at end of file
+void get_field_size(int* rows, int* cols);
+
+Response_t client_submit_action_async(UserAction_t action, bool hold,
+                                      ActionCallback_t callback,
+                                      void* user_data);
+
+Response_t client_fetch_frame_async(FrameCallback_t callback, void* user_data);
+
+Response_t client_subscribe(FrameCallback_t callback, void* user_data);
+
+void client_unsubscribe();
+
+bool client_take_frame(Frame_t* result);
+
+int client_poll(int timeout_ms);
+
+#endif
@@ -0,0 +1,119 @@
+/**
+ * @file s21_default_client.c
+ * @brief Original single-server API on top of a process-wide BrickClient.
+ */
+#include "s21_client_library.h"
+
+/* Client behind the original single-server API */
+static BrickClient* default_client = NULL;
+
+/* Answer of the calls made while init_library() has no client */
+static Response_t not_initialized() {
+  Response_t response = {STATUS_OTHER, "library not initialized"};
+  return response;
+}
+
+void init_library(char* server_url) {
+  brick_client_destroy(default_client);
+  default_client = brick_client_create(server_url);
+}
+
+void clear_library() {
+  brick_client_destroy(default_client);
+  default_client = NULL;
+}
+
+Response_t get_accesible_games(GameType_t** result) {
+  if (default_client == NULL) return not_initialized();
+  return brick_client_get_games(default_client, result);
+}
+
+Response_t select_game(GameType_t type) {
+  if (default_client == NULL) return not_initialized();
+  return brick_client_select_game(default_client, type);
+}
+
+Response_t submit_action(UserAction_t action, bool hold) {
+  if (default_client == NULL) return not_initialized();
+  return brick_client_submit_action(default_client, action, hold);
+}
+
+Response_t get_current_state(GameInfo_t* result) {
+  if (default_client == NULL) return not_initialized();
+  return brick_client_get_state(default_client, result);
+}
+
+Response_t get_current_state_frame(Frame_t* result) {
+  if (default_client == NULL) return not_initialized();
+  return brick_client_get_state_frame(default_client, result);
+}
+
+Response_t get_packed_state(Frame_t* result) {
+  if (default_client == NULL) return not_initialized();
+  return brick_client_get_packed_state(default_client, result);
+}
+
+Response_t get_frame(Frame_t* result) {
+  if (default_client == NULL) return not_initialized();
+  return brick_client_get_frame(default_client, result);
+}
+
+Response_t submit_action_frame(UserAction_t action, bool hold,
+                               Frame_t* result) {
+  if (default_client == NULL) return not_initialized();
+  return brick_client_submit_action_frame(default_client, action, hold,
+                                          result);
+}
+
+Response_t get_current_state_delta(Frame_t* result, FrameChanges_t* changes) {
+  if (default_client == NULL) return not_initialized();
+  return brick_client_get_state_delta(default_client, result, changes);
+}
+
+Response_t get_current_game_status(GameStatus_t* result) {
+  if (default_client == NULL) return not_initialized();
+  return brick_client_get_status(default_client, result);
+}
+
+void get_field_size(int* rows, int* cols) {
+  if (default_client == NULL) {
+    *rows = 20;
+    *cols = 10;
+    return;
+  }
+  brick_client_get_field_size(default_client, rows, cols);
+}
+
+Response_t client_submit_action_async(UserAction_t action, bool hold,
+                                      ActionCallback_t callback,
+                                      void* user_data) {
+  if (default_client == NULL) return not_initialized();
+  return brick_client_submit_action_async(default_client, action, hold,
+                                          callback, user_data);
+}
+
+Response_t client_fetch_frame_async(FrameCallback_t callback,
+                                    void* user_data) {
+  if (default_client == NULL) return not_initialized();
+  return brick_client_fetch_frame_async(default_client, callback, user_data);
+}
+
+Response_t client_subscribe(FrameCallback_t callback, void* user_data) {
+  if (default_client == NULL) return not_initialized();
+  return brick_client_subscribe(default_client, callback, user_data);
+}
+
+void client_unsubscribe() {
+  if (default_client == NULL) return;
+  brick_client_unsubscribe(default_client);
+}
+
+bool client_take_frame(Frame_t* result) {
+  if (default_client == NULL) return false;
+  return brick_client_take_frame(default_client, result);
+}
+
+int client_poll(int timeout_ms) {
+  if (default_client == NULL) return 0;
+  return brick_client_poll(default_client, timeout_ms);
+}
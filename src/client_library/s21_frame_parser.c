@@ -0,0 +1,238 @@
+/**
+ * @file s21_frame_parser.c
+ * @brief Streaming parser of /api/state and /api/status bodies.
+ */
+#include "s21_frame_parser.h"
+
+GameStatus_t map_game_status(const char* status_string) {
+  if (strcmp(status_string, "Moving") == 0) return MOVING;
+  if (strcmp(status_string, "Spawn") == 0) return SPAWN;
+  if (strcmp(status_string, "Exit") == 0) return EXIT;
+  if (strcmp(status_string, "Pause") == 0) return PAUSE;
+  if (strcmp(status_string, "Start") == 0) return START;
+  if (strcmp(status_string, "Gameover") == 0) return GAMEOVER;
+  if (strcmp(status_string, "Shifting") == 0) return SHIFTING;
+  if (strcmp(status_string, "Attaching") == 0) return ATTACHING;
+  return -1;
+}
+
+void frame_parser_begin(FrameParser* parser, Frame_t* frame,
+                        FrameChanges_t* changes) {
+  memset(parser, 0, sizeof(FrameParser));
+  parser->frame = frame;
+  parser->changes = changes;
+  if (changes != NULL) {
+    changes->full = false;
+    changes->count = 0;
+  }
+}
+
+static int parse_int(const char* text) {
+  bool negative = *text == '-';
+  if (negative) ++text;
+  int value = 0;
+  while (*text >= '0' && *text <= '9') value = value * 10 + (*text++ - '0');
+  return negative ? -value : value;
+}
+
+static uint64_t parse_uint64(const char* text) {
+  uint64_t value = 0;
+  while (*text >= '0' && *text <= '9') value = value * 10 + (*text++ - '0');
+  return value;
+}
+
+static bool key_is(const FrameParser* parser, const char* key) {
+  return strcmp(parser->key, key) == 0;
+}
+
+/* Matrix cell, rows of the field are packed with the first row width */
+static void store_cell(FrameParser* parser, int value) {
+  Frame_t* frame = parser->frame;
+  int row = parser->row;
+  int col = parser->col++;
+  if (parser->matrix == MATRIX_NEXT) {
+    if (row < FRAME_NEXT_SIZE && col < FRAME_NEXT_SIZE) {
+      frame->next[row * FRAME_NEXT_SIZE + col] = (uint8_t)value;
+    }
+  } else if (row == 0) {
+    if (col < FRAME_MAX_COLS) frame->cells[col] = (uint8_t)value;
+  } else if (row < FRAME_MAX_ROWS && col < parser->cols) {
+    frame->cells[row * parser->cols + col] = (uint8_t)value;
+  }
+}
+
+/* Next number of the runs array */
+static void store_change(FrameParser* parser, int value) {
+  if (parser->change_step == 0) {
+    parser->change_index = value;
+    parser->change_step = 1;
+  } else if (parser->change_step == 1) {
+    parser->change_left = value;
+    parser->change_step = value > 0 ? 2 : 0;
+  } else {
+    int index = parser->change_index++;
+    if (index >= 0 && index < FRAME_MAX_CELLS) {
+      parser->frame->cells[index] = (uint8_t)value;
+      FrameChanges_t* changes = parser->changes;
+      if (changes != NULL && changes->count < FRAME_MAX_CELLS) {
+        changes->cells[changes->count++] = (uint16_t)index;
+      }
+    }
+    if (--parser->change_left == 0) parser->change_step = 0;
+  }
+}
+
+/* Scalar of the top object: counters, flags or a null matrix */
+static void store_value(FrameParser* parser) {
+  Frame_t* frame = parser->frame;
+  const char* text = parser->text;
+  if (key_is(parser, "generation")) {
+    frame->generation = parse_uint64(text);
+  } else if (key_is(parser, "score")) {
+    frame->score = parse_int(text);
+  } else if (key_is(parser, "highScore")) {
+    frame->high_score = parse_int(text);
+  } else if (key_is(parser, "level")) {
+    frame->level = parse_int(text);
+  } else if (key_is(parser, "speed")) {
+    frame->speed = parse_int(text);
+  } else if (key_is(parser, "pause")) {
+    frame->pause = text[0] == 't';
+  } else if (key_is(parser, "field")) {
+    frame->rows = 0;
+    frame->cols = 0;
+  } else if (key_is(parser, "next")) {
+    frame->has_next = false;
+  }
+}
+
+static void end_scalar(FrameParser* parser) {
+  if (!parser->in_scalar) return;
+  parser->in_scalar = false;
+  parser->text[parser->text_length] = '\0';
+  if (parser->depth == 3 && parser->matrix != MATRIX_NONE) {
+    store_cell(parser, parse_int(parser->text));
+  } else if (parser->depth == 2 && parser->matrix == MATRIX_CHANGES) {
+    store_change(parser, parse_int(parser->text));
+  } else if (parser->depth == 1) {
+    store_value(parser);
+  }
+}
+
+static void end_string(FrameParser* parser) {
+  parser->in_string = false;
+  if (parser->string_is_key) {
+    parser->key[parser->key_length] = '\0';
+  } else if (parser->depth == 1 && key_is(parser, "status")) {
+    parser->text[parser->text_length] = '\0';
+    parser->frame->status = map_game_status(parser->text);
+  }
+}
+
+static void open_array(FrameParser* parser) {
+  parser->depth++;
+  if (parser->depth == 2) {
+    parser->matrix = key_is(parser, "field")     ? MATRIX_FIELD
+                     : key_is(parser, "next")    ? MATRIX_NEXT
+                     : key_is(parser, "changes") ? MATRIX_CHANGES
+                                                 : MATRIX_NONE;
+    parser->row = -1;
+    parser->cols = 0;
+    if (parser->matrix == MATRIX_FIELD && parser->changes != NULL) {
+      parser->changes->full = true;
+    } else if (parser->matrix == MATRIX_NEXT) {
+      memset(parser->frame->next, 0, sizeof(parser->frame->next));
+      parser->frame->has_next = true;
+    }
+  } else if (parser->depth == 3 && parser->matrix != MATRIX_NONE) {
+    parser->row++;
+    parser->col = 0;
+  }
+}
+
+static void close_array(FrameParser* parser) {
+  if (parser->depth == 3 && parser->matrix != MATRIX_NONE) {
+    if (parser->row == 0) {
+      parser->cols = parser->col < FRAME_MAX_COLS ? parser->col
+                                                  : FRAME_MAX_COLS;
+    }
+  } else if (parser->depth == 2 && parser->matrix == MATRIX_FIELD) {
+    int rows = parser->row + 1;
+    parser->frame->rows = rows < FRAME_MAX_ROWS ? rows : FRAME_MAX_ROWS;
+    parser->frame->cols = parser->cols;
+  }
+  if (parser->depth == 2) parser->matrix = MATRIX_NONE;
+  parser->depth--;
+}
+
+void frame_parser_feed(FrameParser* parser, const char* data, size_t size) {
+  if (parser->frame == NULL) return;
+  for (size_t i = 0; i < size; ++i) {
+    char c = data[i];
+    if (parser->in_string) {
+      if (parser->escape) {
+        parser->escape = false;
+      } else if (c == '\\') {
+        parser->escape = true;
+      } else if (c == '"') {
+        end_string(parser);
+      } else if (parser->string_is_key) {
+        if (parser->key_length < FRAME_PARSER_TOKEN - 1) {
+          parser->key[parser->key_length++] = c;
+        }
+      } else if (parser->text_length < FRAME_PARSER_TOKEN - 1) {
+        parser->text[parser->text_length++] = c;
+      }
+      continue;
+    }
+
+    switch (c) {
+      case '"':
+        parser->in_string = true;
+        parser->string_is_key = parser->depth == 1 && parser->expect_key;
+        if (parser->string_is_key) {
+          parser->key_length = 0;
+        } else {
+          parser->text_length = 0;
+        }
+        break;
+      case '{':
+        parser->depth++;
+        parser->expect_key = parser->depth == 1;
+        break;
+      case '}':
+        end_scalar(parser);
+        parser->depth--;
+        break;
+      case '[':
+        open_array(parser);
+        break;
+      case ']':
+        end_scalar(parser);
+        close_array(parser);
+        break;
+      case ',':
+        end_scalar(parser);
+        parser->expect_key = parser->depth == 1;
+        break;
+      case ':':
+        parser->expect_key = false;
+        break;
+      case ' ':
+      case '\t':
+      case '\r':
+      case '\n':
+        end_scalar(parser);
+        break;
+      default:
+        if (!parser->in_scalar) {
+          parser->in_scalar = true;
+          parser->text_length = 0;
+        }
+        if (parser->text_length < FRAME_PARSER_TOKEN - 1) {
+          parser->text[parser->text_length++] = c;
+        }
+        break;
+    }
+  }
+}
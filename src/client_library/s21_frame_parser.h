@@ -0,0 +1,71 @@
+/**
+ * @file s21_frame_parser.h
+ * @brief Streaming parser of /api/state and /api/status bodies.
+ *
+ * The parser is fed the body chunk by chunk straight from the curl write
+ * callback and writes cells, counters and the status into a Frame_t as
+ * they go by, so a frame is parsed in one pass without building a DOM or
+ * allocating anything. Only the keys of a frame are looked at, anything
+ * else (nested objects included) is skipped.
+ *
+ * A delta body carries "changes" instead of "field": runs of changed cells
+ * as index, length and values, flattened into one array. They are patched
+ * into the cells the frame already holds.
+ */
+#ifndef S21_FRAME_PARSER_H
+#define S21_FRAME_PARSER_H
+
+#include "s21_client_library.h"
+
+#define FRAME_PARSER_TOKEN 24 /* Longest key or scalar kept, any uint64 fits */
+
+typedef enum {
+  MATRIX_NONE,
+  MATRIX_FIELD,
+  MATRIX_NEXT,
+  MATRIX_CHANGES
+} FrameMatrix_t;
+
+typedef struct {
+  Frame_t* frame;           /* Target, NULL while the parser is off */
+  FrameChanges_t* changes;  /* Changed cells, may be NULL */
+  int depth;      /* Open objects and arrays */
+  bool expect_key;
+  bool in_string;
+  bool escape;
+  bool string_is_key;
+  bool in_scalar;
+  char key[FRAME_PARSER_TOKEN];
+  int key_length;
+  char text[FRAME_PARSER_TOKEN];
+  int text_length;
+
+  FrameMatrix_t matrix; /* Matrix being filled */
+  int row;
+  int col;
+  int cols; /* Width of the first row */
+
+  int change_step; /* 0 - index, 1 - length, 2 - values of a run */
+  int change_index;
+  int change_left;
+} FrameParser;
+
+/**
+ * @brief Starts parsing a new body into the frame. Fields missing from the
+ * body keep their values.
+ * @param changes Output, cells the body changed (may be NULL)
+ **/
+void frame_parser_begin(FrameParser* parser, Frame_t* frame,
+                        FrameChanges_t* changes);
+
+/**
+ * @brief Consumes the next chunk of the body.
+ **/
+void frame_parser_feed(FrameParser* parser, const char* data, size_t size);
+
+/**
+ * @brief Maps a status name of the server ("Moving", ...) to GameStatus_t.
+ **/
+GameStatus_t map_game_status(const char* status_string);
+
+#endif
@@ -0,0 +1,144 @@
+/**
+ * @file s21_frame_parser_test.c
+ * @brief Checks that the streaming frame parser does not depend on how the
+ * body is split into chunks.
+ *
+ * Every body is parsed once in one piece, checked against the expected
+ * values, and then parsed again split in two at every offset and fed byte
+ * by byte. Each of those parses must give the same frame and changes.
+ */
+#include <stdio.h>
+
+#include "s21_frame_parser.h"
+
+static int failures = 0;
+
+#define CHECK(condition)                                            \
+  do {                                                              \
+    if (!(condition)) {                                             \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #condition); \
+      failures++;                                                   \
+    }                                                               \
+  } while (0)
+
+/* GET /api/frame, with a nested object the parser has to skip */
+static const char* frame_body =
+    "{\"generation\":18446744073709551615,\"status\":\"Moving\","
+    "\"extra\":{\"field\":[[9,9]],\"status\":\"Pause\"},"
+    "\"field\":[[0,1,2],[3,4,5]],\"rows\":2,\"cols\":3,"
+    "\"next\":[[1,1],[0,1]],\"score\":-12,\"highScore\":340,"
+    "\"level\":3,\"speed\":4,\"pause\":false}";
+
+/* GET /api/state, no status and a null next */
+static const char* state_body =
+    "{ \"field\" : [ [ 7 , 0 ] , [ 0 , 7 ] ] ,\n"
+    "  \"next\" : null , \"score\" : 5 , \"highScore\" : 9 ,\n"
+    "  \"level\" : 1 , \"speed\" : 2 , \"pause\" : true }";
+
+/* GET /api/state?since=, runs of index, length and values */
+static const char* delta_body =
+    "{\"generation\":42,\"base\":41,\"changes\":[1,2,8,9,5,1,6],"
+    "\"rows\":2,\"cols\":3,\"next\":null,\"score\":7,\"highScore\":9,"
+    "\"level\":2,\"speed\":2,\"pause\":false}";
+
+/* Frame every parse starts from, as the previous answer left it */
+static void base_frame(Frame_t* frame) {
+  memset(frame, 0, sizeof(Frame_t));
+  frame->status = START;
+  frame->rows = 2;
+  frame->cols = 3;
+  for (int i = 0; i < 6; ++i) frame->cells[i] = (uint8_t)(i + 1);
+  frame->has_next = true;
+}
+
+static void parse_chunks(const char* body, size_t split, size_t step,
+                         Frame_t* frame, FrameChanges_t* changes) {
+  FrameParser parser;
+  size_t size = strlen(body);
+  base_frame(frame);
+  memset(changes, 0, sizeof(FrameChanges_t));
+  frame_parser_begin(&parser, frame, changes);
+  if (step == 0) {
+    frame_parser_feed(&parser, body, split);
+    frame_parser_feed(&parser, body + split, size - split);
+  } else {
+    for (size_t i = 0; i < size; i += step) {
+      frame_parser_feed(&parser, body + i, size - i < step ? size - i : step);
+    }
+  }
+}
+
+/* Every split of the body must give the frame parsed in one piece */
+static void check_splits(const char* body, const Frame_t* expected,
+                         const FrameChanges_t* expected_changes) {
+  static Frame_t frame;
+  static FrameChanges_t changes;
+  size_t size = strlen(body);
+  for (size_t split = 0; split <= size; ++split) {
+    parse_chunks(body, split, 0, &frame, &changes);
+    CHECK(memcmp(&frame, expected, sizeof(Frame_t)) == 0);
+    CHECK(memcmp(&changes, expected_changes, sizeof(FrameChanges_t)) == 0);
+  }
+  parse_chunks(body, 0, 1, &frame, &changes);
+  CHECK(memcmp(&frame, expected, sizeof(Frame_t)) == 0);
+  CHECK(memcmp(&changes, expected_changes, sizeof(FrameChanges_t)) == 0);
+}
+
+static void test_frame(void) {
+  static Frame_t frame;
+  static FrameChanges_t changes;
+  parse_chunks(frame_body, strlen(frame_body), 0, &frame, &changes);
+  CHECK(frame.generation == UINT64_MAX);
+  CHECK(frame.status == MOVING);
+  CHECK(frame.rows == 2 && frame.cols == 3);
+  for (int i = 0; i < 6; ++i) CHECK(frame.cells[i] == i);
+  CHECK(frame.has_next);
+  CHECK(frame.next[0] == 1 && frame.next[1] == 1);
+  CHECK(frame.next[FRAME_NEXT_SIZE] == 0 && frame.next[FRAME_NEXT_SIZE + 1]);
+  CHECK(frame.score == -12 && frame.high_score == 340);
+  CHECK(frame.level == 3 && frame.speed == 4 && frame.pause == 0);
+  CHECK(changes.full && changes.count == 0);
+  check_splits(frame_body, &frame, &changes);
+}
+
+static void test_state(void) {
+  static Frame_t frame;
+  static FrameChanges_t changes;
+  parse_chunks(state_body, strlen(state_body), 0, &frame, &changes);
+  CHECK(frame.status == START);
+  CHECK(frame.rows == 2 && frame.cols == 2);
+  CHECK(frame.cells[0] == 7 && frame.cells[1] == 0);
+  CHECK(frame.cells[2] == 0 && frame.cells[3] == 7);
+  CHECK(!frame.has_next);
+  CHECK(frame.score == 5 && frame.high_score == 9);
+  CHECK(frame.level == 1 && frame.speed == 2 && frame.pause == 1);
+  check_splits(state_body, &frame, &changes);
+}
+
+static void test_delta(void) {
+  static Frame_t frame;
+  static FrameChanges_t changes;
+  parse_chunks(delta_body, strlen(delta_body), 0, &frame, &changes);
+  CHECK(frame.generation == 42);
+  CHECK(frame.rows == 2 && frame.cols == 3);
+  const uint8_t cells[6] = {1, 8, 9, 4, 5, 6};
+  CHECK(memcmp(frame.cells, cells, sizeof(cells)) == 0);
+  CHECK(!changes.full && changes.count == 3);
+  CHECK(changes.cells[0] == 1 && changes.cells[1] == 2 &&
+        changes.cells[2] == 5);
+  CHECK(!frame.has_next);
+  CHECK(frame.score == 7 && frame.level == 2);
+  check_splits(delta_body, &frame, &changes);
+}
+
+int main() {
+  test_frame();
+  test_state();
+  test_delta();
+  if (failures != 0) {
+    fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+  printf("frame parser: all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file s21_frame_stream.c
+ * @brief Reader of the server-sent frame stream (/api/stream).
+ */
+#include "s21_frame_stream.h"
+
+void frame_stream_begin(FrameStream* stream) {
+  memset(stream, 0, sizeof(FrameStream));
+  stream->line = LINE_FIELD;
+}
+
+/* Blank line: the event is complete */
+static int end_event(FrameStream* stream) {
+  if (!stream->in_event) return 0;
+  stream->in_event = false;
+  memcpy(&stream->ready, &stream->frame, sizeof(Frame_t));
+  stream->has_ready = true;
+  return 1;
+}
+
+static void end_field(FrameStream* stream) {
+  stream->field[stream->field_length] = '\0';
+  if (strcmp(stream->field, "data") != 0) {
+    stream->line = LINE_SKIP;
+    return;
+  }
+  stream->line = LINE_DATA;
+  stream->skip_space = true;
+  if (!stream->in_event) {
+    stream->in_event = true;
+    frame_parser_begin(&stream->parser, &stream->frame, NULL);
+  } else {
+    /* Data lines of one event are joined by a line feed */
+    frame_parser_feed(&stream->parser, "\n", 1);
+  }
+}
+
+int frame_stream_feed(FrameStream* stream, const char* data, size_t size) {
+  int events = 0;
+  size_t i = 0;
+  while (i < size) {
+    if (stream->line == LINE_FIELD) {
+      char c = data[i++];
+      if (c == '\n') {
+        events += stream->field_length == 0 ? end_event(stream) : 0;
+        stream->field_length = 0;
+      } else if (c == ':') {
+        end_field(stream);
+      } else if (c != '\r' &&
+                 stream->field_length < FRAME_STREAM_FIELD - 1) {
+        stream->field[stream->field_length++] = c;
+      }
+      continue;
+    }
+
+    if (stream->skip_space) {
+      stream->skip_space = false;
+      if (data[i] == ' ') {
+        ++i;
+        continue;
+      }
+    }
+    const char* end = memchr(data + i, '\n', size - i);
+    size_t length = end != NULL ? (size_t)(end - data) - i : size - i;
+    if (stream->line == LINE_DATA) {
+      frame_parser_feed(&stream->parser, data + i, length);
+    }
+    i += length;
+    if (end != NULL) {
+      ++i;
+      stream->line = LINE_FIELD;
+      stream->field_length = 0;
+    }
+  }
+  return events;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file s21_frame_stream.h
+ * @brief Reader of the server-sent frame stream (/api/stream).
+ *
+ * The server sends one "frame" event each time the generation changes,
+ * its data line holds the same JSON as a frame body. The reader splits the
+ * stream into lines as chunks arrive and pipes data lines through the
+ * streaming frame parser, so events are decoded without buffering them.
+ */
+#ifndef S21_FRAME_STREAM_H
+#define S21_FRAME_STREAM_H
+
+#include "s21_frame_parser.h"
+
+#define FRAME_STREAM_FIELD 8 /* Longest field name kept ("data") */
+
+typedef enum { LINE_FIELD, LINE_DATA, LINE_SKIP } StreamLine_t;
+
+typedef struct {
+  FrameParser parser;
+  Frame_t frame; /* Event being received */
+  Frame_t ready; /* Last complete event */
+  bool has_ready;
+
+  StreamLine_t line;
+  char field[FRAME_STREAM_FIELD];
+  int field_length;
+  bool skip_space; /* Space after "data:" */
+  bool in_event;   /* A data line of the current event was seen */
+} FrameStream;
+
+/**
+ * @brief Starts reading a new stream.
+ **/
+void frame_stream_begin(FrameStream* stream);
+
+/**
+ * @brief Consumes the next chunk of the stream.
+ * @return Events completed by the chunk, the newest one is in ready
+ **/
+int frame_stream_feed(FrameStream* stream, const char* data, size_t size);
+
+#endif
@@ -0,0 +1,41 @@
+/**
+ * @file s21_packed_frame.c
+ * @brief Binary frame format (application/x-brickgame-frame).
+ */
+#include "s21_packed_frame.h"
+
+static uint32_t read_u32(const uint8_t* data) {
+  return (uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 |
+         (uint32_t)data[2] << 8 | data[3];
+}
+
+bool packed_frame_decode(const uint8_t* data, size_t size, Frame_t* frame) {
+  if (size < PACKED_FRAME_HEADER || data[0] != PACKED_FRAME_VERSION) {
+    return false;
+  }
+  int rows = data[21];
+  int cols = data[22];
+  bool has_next = data[2] & PACKED_FRAME_NEXT;
+  size_t cells = (size_t)rows * cols;
+  size_t next = has_next ? FRAME_NEXT_SIZE * FRAME_NEXT_SIZE : 0;
+  if (rows > FRAME_MAX_ROWS || cols > FRAME_MAX_COLS ||
+      size < PACKED_FRAME_HEADER + cells + next) {
+    return false;
+  }
+
+  frame->status = (GameStatus_t)data[1];
+  frame->pause = (data[2] & PACKED_FRAME_PAUSE) != 0;
+  frame->level = data[3];
+  frame->generation = (uint64_t)read_u32(data + 4) << 32 | read_u32(data + 8);
+  frame->score = (int32_t)read_u32(data + 12);
+  frame->high_score = (int32_t)read_u32(data + 16);
+  frame->speed = data[20];
+  frame->rows = rows;
+  frame->cols = cols;
+  memcpy(frame->cells, data + PACKED_FRAME_HEADER, cells);
+  frame->has_next = has_next;
+  if (has_next) {
+    memcpy(frame->next, data + PACKED_FRAME_HEADER + cells, next);
+  }
+  return true;
+}
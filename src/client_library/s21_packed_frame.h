@@ -0,0 +1,42 @@
+/**
+ * @file s21_packed_frame.h
+ * @brief Binary frame format (application/x-brickgame-frame).
+ *
+ * A packed frame is the status and the state of the game in one body,
+ * integers in network byte order:
+ *
+ *   0  u8   version (PACKED_FRAME_VERSION)
+ *   1  u8   status (GameStatus_t)
+ *   2  u8   flags (PACKED_FRAME_PAUSE, PACKED_FRAME_NEXT)
+ *   3  u8   level
+ *   4  u64  generation
+ *   12 i32  score
+ *   16 i32  high score
+ *   20 u8   speed
+ *   21 u8   rows
+ *   22 u8   cols
+ *   23 u8   reserved
+ *   24 u8   cells[rows * cols], row by row
+ *   ?  u8   next[4 * 4] if PACKED_FRAME_NEXT is set
+ *
+ * A classic 20x10 field with the next figure takes 240 bytes.
+ */
+#ifndef S21_PACKED_FRAME_H
+#define S21_PACKED_FRAME_H
+
+#include "s21_client_library.h"
+
+#define PACKED_FRAME_MEDIA_TYPE "application/x-brickgame-frame"
+#define PACKED_FRAME_VERSION 1
+#define PACKED_FRAME_HEADER 24
+#define PACKED_FRAME_PAUSE 0x01
+#define PACKED_FRAME_NEXT 0x02
+
+/**
+ * @brief Decodes a packed frame.
+ * @return false if the body is not a complete packed frame, the frame is
+ * left untouched then
+ **/
+bool packed_frame_decode(const uint8_t* data, size_t size, Frame_t* frame);
+
+#endif
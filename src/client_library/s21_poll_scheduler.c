@@ -0,0 +1,199 @@
+/**
+ * @file s21_poll_scheduler.c
+ * @brief Tick-aligned planning of frame fetches.
+ */
+// Needs for clock_gettime()
+#define _POSIX_C_SOURCE 199309L
+
+#include "s21_poll_scheduler.h"
+
+#include <time.h>
+
+#define POLL_REJECTS_TO_RELEARN 3
+/* Widest window between an early fetch and the next one that still places
+ * a tick precisely */
+#define POLL_EXACT_WINDOW_US (2 * POLL_LEARN_STEP_US)
+
+static int64_t clamp(int64_t value, int64_t low, int64_t high) {
+  return value < low ? low : value > high ? high : value;
+}
+
+/* START, PAUSE and GAMEOVER wait for the player */
+static bool is_idle(const Frame_t* frame) {
+  return frame->status == START || frame->status == PAUSE ||
+         frame->status == GAMEOVER;
+}
+
+/**
+ * @brief Learns the period from the time between two precise ticks.
+ * @param steps Ticks that went by between them
+ **/
+static void learn_period(PollScheduler* scheduler, int64_t interval,
+                         int64_t steps) {
+  int64_t sample = interval / steps;
+  if (scheduler->period_us == 0) {
+    scheduler->period_us = sample;
+  } else {
+    int64_t ticks =
+        (interval + scheduler->period_us / 2) / scheduler->period_us;
+    if (ticks == steps) {
+      scheduler->period_us += (sample - scheduler->period_us) / 4;
+      scheduler->rejects = 0;
+    } else if (++scheduler->rejects >= POLL_REJECTS_TO_RELEARN) {
+      /* The game changed its pace */
+      scheduler->period_us = sample;
+      scheduler->rejects = 0;
+    }
+  }
+  scheduler->period_us =
+      clamp(scheduler->period_us, POLL_MIN_PERIOD_US, POLL_MAX_PERIOD_US);
+}
+
+/**
+ * @brief Places the tick that brought a new generation.
+ * @param seen_us When the server looked at the frame
+ **/
+static void place_tick(PollScheduler* scheduler, uint64_t generation,
+                       int64_t seen_us) {
+  int64_t window = seen_us - scheduler->seen_us;
+  if (scheduler->early && window <= POLL_EXACT_WINDOW_US) {
+    /* Between the early fetch and this one */
+    scheduler->tick_us = seen_us - window / 2;
+    if (scheduler->exact_us != 0 && generation > scheduler->exact_generation &&
+        scheduler->tick_us > scheduler->exact_us) {
+      learn_period(scheduler, scheduler->tick_us - scheduler->exact_us,
+                   (int64_t)(generation - scheduler->exact_generation));
+    }
+    scheduler->exact_us = scheduler->tick_us;
+    scheduler->exact_generation = generation;
+    scheduler->slip_us = 0;
+  } else {
+    /* Came sooner than expected: aim earlier and earlier until a fetch
+     * is early again */
+    int64_t limit = scheduler->period_us > 0 ? scheduler->period_us / 2
+                                             : POLL_LEARN_STEP_US;
+    if (scheduler->period_us > 0 && scheduler->slip_us >= limit) {
+      /* Still no fetch before a tick: the game sped up, learn it anew */
+      scheduler->period_us = 0;
+      scheduler->exact_us = 0;
+      scheduler->slip_us = 0;
+      scheduler->rejects = 0;
+      limit = POLL_LEARN_STEP_US;
+    }
+    scheduler->slip_us = clamp(scheduler->slip_us * 2, POLL_STEP_US, limit);
+    scheduler->tick_us = seen_us - scheduler->slip_us;
+  }
+}
+
+/**
+ * @brief Next fetch of a running game: just before the expected tick.
+ * @param learn_us Fetch step while the period or the tick is unknown
+ **/
+static void plan_tick(PollScheduler* scheduler, int64_t now_us,
+                      int64_t learn_us) {
+  scheduler->early = false;
+  if (scheduler->period_us == 0 || scheduler->tick_us == 0) {
+    scheduler->step_us = learn_us;
+    scheduler->next_us = now_us + scheduler->step_us;
+    return;
+  }
+  scheduler->step_us = POLL_STEP_US;
+  scheduler->next_us =
+      scheduler->tick_us + scheduler->period_us - POLL_LEAD_US;
+  if (scheduler->next_us <= now_us) {
+    scheduler->next_us = now_us + scheduler->step_us;
+  }
+}
+
+/* Forgets where the ticks were: started, resumed or another game */
+static void forget_ticks(PollScheduler* scheduler) {
+  scheduler->tick_us = 0;
+  scheduler->exact_us = 0;
+  scheduler->slip_us = 0;
+}
+
+void poll_scheduler_init(PollScheduler* scheduler) {
+  memset(scheduler, 0, sizeof(PollScheduler));
+}
+
+int64_t poll_scheduler_now_us() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+void poll_scheduler_update(PollScheduler* scheduler, const Frame_t* frame,
+                           int64_t sent_us, int64_t received_us) {
+  bool idle = is_idle(frame);
+  bool changed = frame->generation != scheduler->generation;
+  /* The server looked at the frame about halfway through the request */
+  int64_t seen_us = sent_us + (received_us - sent_us) / 2;
+  if (changed && !idle && !scheduler->idle && scheduler->generation != 0 &&
+      frame->generation > scheduler->generation) {
+    place_tick(scheduler, frame->generation, seen_us);
+  } else if (changed) {
+    forget_ticks(scheduler);
+  }
+  scheduler->generation = frame->generation;
+  scheduler->seen_us = seen_us;
+
+  if (idle) {
+    scheduler->early = false;
+    scheduler->step_us =
+        scheduler->idle && !changed
+            ? clamp(scheduler->step_us * 2, POLL_IDLE_MIN_US, POLL_IDLE_MAX_US)
+            : POLL_IDLE_MIN_US;
+    scheduler->next_us = received_us + scheduler->step_us;
+  } else if (changed || scheduler->idle) {
+    /* A new tick on every fetch: ticks come faster than the step, halve it
+     * until a fetch falls between two of them */
+    int64_t learn_us = changed && !scheduler->early && !scheduler->idle
+                           ? scheduler->step_us / 2
+                           : POLL_LEARN_STEP_US;
+    plan_tick(scheduler, received_us,
+              clamp(learn_us, POLL_STEP_US, POLL_LEARN_STEP_US));
+  } else {
+    /* Too early or the tick is late: retry, backing off while it is */
+    scheduler->early = true;
+    scheduler->next_us = received_us + scheduler->step_us;
+    int64_t limit = scheduler->period_us > 0 ? scheduler->period_us
+                                             : POLL_LEARN_STEP_US;
+    scheduler->step_us = clamp(scheduler->step_us * 2, 0, limit);
+  }
+  scheduler->idle = idle;
+}
+
+void poll_scheduler_wake(PollScheduler* scheduler, const Frame_t* frame,
+                         int64_t now_us) {
+  bool idle = is_idle(frame);
+  if (scheduler->idle != idle) forget_ticks(scheduler);
+  /* Ticks due by now are already in the answered frame */
+  int64_t absorbed = 0;
+  if (scheduler->tick_us != 0 && scheduler->period_us != 0 &&
+      scheduler->tick_us + scheduler->period_us <= now_us) {
+    absorbed = (now_us - scheduler->tick_us) / scheduler->period_us;
+    scheduler->tick_us += absorbed * scheduler->period_us;
+  }
+  /* The other generations are the action, not ticks to learn from */
+  if (scheduler->exact_us != 0 && frame->generation > scheduler->generation) {
+    int64_t moves = (int64_t)(frame->generation - scheduler->generation);
+    if (moves > absorbed) {
+      scheduler->exact_generation += (uint64_t)(moves - absorbed);
+    }
+  }
+  scheduler->generation = frame->generation;
+  scheduler->seen_us = now_us;
+  scheduler->idle = idle;
+  if (idle) {
+    scheduler->early = false;
+    scheduler->step_us = POLL_IDLE_MIN_US;
+    scheduler->next_us = now_us + scheduler->step_us;
+  } else {
+    plan_tick(scheduler, now_us, POLL_LEARN_STEP_US);
+  }
+}
+
+int poll_scheduler_delay_ms(const PollScheduler* scheduler, int64_t now_us) {
+  int64_t delay_us = scheduler->next_us - now_us;
+  return delay_us > 0 ? (int)((delay_us + 999) / 1000) : 0;
+}
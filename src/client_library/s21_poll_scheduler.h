@@ -0,0 +1,79 @@
+/**
+ * @file s21_poll_scheduler.h
+ * @brief Tick-aligned planning of frame fetches.
+ *
+ * The server changes the frame on its game ticks, so polling at a fixed
+ * rate either asks many times between two ticks or shows a tick late. The
+ * scheduler aims each fetch just before the expected tick and retries a
+ * few milliseconds later, doubling the step while the tick is late. A tick
+ * caught between such an early fetch and the next one is placed precisely,
+ * and the time between precise ticks, divided by the generations that went
+ * by, teaches it the tick period. Until then it fetches every
+ * POLL_LEARN_STEP_US, halving the step while every fetch finds a new tick,
+ * and it learns anew once the ticks keep coming before the aimed fetches.
+ *
+ * In START, PAUSE and GAMEOVER the frame only changes on input, so the
+ * delay backs off exponentially from POLL_IDLE_MIN_US to POLL_IDLE_MAX_US.
+ * Frames answered to actions go through poll_scheduler_wake(): they are not
+ * ticks, and the game usually goes on right after them.
+ */
+#ifndef S21_POLL_SCHEDULER_H
+#define S21_POLL_SCHEDULER_H
+
+#include "s21_client_library.h"
+
+#define POLL_MIN_PERIOD_US 10000   /* Fastest tick believed */
+#define POLL_MAX_PERIOD_US 2000000 /* Slowest tick believed */
+#define POLL_LEARN_STEP_US 20000   /* Fetch step until a tick is placed */
+#define POLL_STEP_US 4000          /* First retry step after an early fetch */
+#define POLL_LEAD_US 2000          /* Fetch this long before the tick */
+#define POLL_IDLE_MIN_US 50000     /* Idle backoff bounds */
+#define POLL_IDLE_MAX_US 1000000
+
+typedef struct {
+  uint64_t generation; /* Newest generation seen */
+  int64_t seen_us;     /* When the server looked at the previous fetch */
+  int64_t tick_us;     /* Estimated time of the last tick, 0 if unknown */
+  int64_t exact_us;    /* Last precisely placed tick, 0 if none */
+  uint64_t exact_generation; /* Ticks since then are counted from it */
+  int64_t period_us;   /* Learned tick period, 0 until learned */
+  int64_t step_us;     /* Current retry step or idle delay */
+  int64_t slip_us;     /* How much sooner the ticks came than expected */
+  int64_t next_us;     /* When to fetch next */
+  int rejects;         /* Intervals in a row that did not fit the period */
+  bool early;          /* The previous fetch came before the tick */
+  bool idle;
+} PollScheduler;
+
+/**
+ * @brief Starts with nothing learned, the first fetch is due at once.
+ **/
+void poll_scheduler_init(PollScheduler* scheduler);
+
+/**
+ * @brief Monotonic clock in microseconds, the time base of the scheduler.
+ **/
+int64_t poll_scheduler_now_us();
+
+/**
+ * @brief Learns from a polled frame (also a kept one of a 304 answer) and
+ * plans the next fetch.
+ * @param sent_us Time the request went out
+ * @param received_us Time the answer arrived
+ **/
+void poll_scheduler_update(PollScheduler* scheduler, const Frame_t* frame,
+                           int64_t sent_us, int64_t received_us);
+
+/**
+ * @brief Takes the frame answered to an action without learning from it,
+ * and ends an idle backoff.
+ **/
+void poll_scheduler_wake(PollScheduler* scheduler, const Frame_t* frame,
+                         int64_t now_us);
+
+/**
+ * @brief Milliseconds left until the next fetch, 0 if it is due.
+ **/
+int poll_scheduler_delay_ms(const PollScheduler* scheduler, int64_t now_us);
+
+#endif
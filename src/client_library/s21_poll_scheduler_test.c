@@ -0,0 +1,246 @@
+/**
+ * @file s21_poll_scheduler_test.c
+ * @brief Checks that the poll scheduler learns the tick period of a game
+ * and aims its fetches just before the ticks.
+ *
+ * A synthetic server ticks at a fixed period, with jitter, or speeding up
+ * and slowing down on the way, and answers every fetch with the generation
+ * it has at the time it looks at the request. The scheduler is driven only
+ * by those answers and must end up with the period of the server, seeing
+ * every tick soon after it at two fetches per tick at most. A paused game
+ * must back the fetches off.
+ */
+#include <stdio.h>
+
+#include "s21_poll_scheduler.h"
+
+static int failures = 0;
+
+#define CHECK(condition)                                            \
+  do {                                                              \
+    if (!(condition)) {                                             \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #condition); \
+      failures++;                                                   \
+    }                                                               \
+  } while (0)
+
+#define TEST_LATENCY_US 1000 /* Round trip of a fetch */
+
+/* Ticks of the synthetic server, from start_us on */
+typedef struct {
+  int64_t start_us;
+  int64_t period_us;
+  int64_t jitter_us; /* Ticks come up to this much late, below the period */
+  uint64_t generation; /* Generation before the first tick */
+} TestServer;
+
+/* Lateness of tick k, the same for every run */
+static int64_t tick_jitter(const TestServer* server, int64_t k) {
+  if (server->jitter_us == 0) return 0;
+  uint64_t mixed = (uint64_t)(k + 1) * 0x9e3779b97f4a7c15ull;
+  mixed ^= mixed >> 29;
+  return (int64_t)(mixed % (uint64_t)server->jitter_us);
+}
+
+static int64_t tick_time(const TestServer* server, int64_t k) {
+  return server->start_us + k * server->period_us + tick_jitter(server, k);
+}
+
+/* Generation the server has at a time */
+static uint64_t server_generation(const TestServer* server, int64_t now_us) {
+  if (now_us < server->start_us) return server->generation;
+  int64_t k = (now_us - server->start_us) / server->period_us;
+  if (tick_time(server, k) > now_us) k--;
+  return server->generation + (uint64_t)(k + 1);
+}
+
+/**
+ * @brief Fetches a frame when the scheduler asks for it.
+ * @return Time the answer arrived
+ **/
+static int64_t fetch(PollScheduler* scheduler, const TestServer* server,
+                     GameStatus_t status, int64_t now_us) {
+  int64_t sent_us = scheduler->next_us > now_us ? scheduler->next_us : now_us;
+  int64_t received_us = sent_us + TEST_LATENCY_US;
+  Frame_t frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.status = status;
+  frame.generation =
+      server_generation(server, sent_us + TEST_LATENCY_US / 2);
+  poll_scheduler_update(scheduler, &frame, sent_us, received_us);
+  return received_us;
+}
+
+/* Fetches made while the server goes through the ticks */
+typedef struct {
+  int fetches;
+  int ticks;
+  int64_t delay_us;     /* Longest time from a tick to the fetch seeing it */
+  int64_t total_us;     /* Sum of those times, one per seen tick */
+  int64_t shortest_us;  /* Shortest wait planned after a new tick */
+} TestRun;
+
+/**
+ * @brief Follows a running game until a time, measuring how late the
+ * fetches see the ticks and how soon they come back after one.
+ **/
+static int64_t follow(PollScheduler* scheduler, const TestServer* server,
+                      int64_t now_us, int64_t until_us, TestRun* run) {
+  memset(run, 0, sizeof(TestRun));
+  run->shortest_us = INT64_MAX;
+  uint64_t first = server_generation(server, now_us);
+  while (now_us < until_us) {
+    uint64_t before = scheduler->generation;
+    now_us = fetch(scheduler, server, MOVING, now_us);
+    run->fetches++;
+    if (scheduler->generation != before) {
+      int64_t seen_us = now_us - TEST_LATENCY_US / 2;
+      int64_t k = (int64_t)(scheduler->generation - server->generation) - 1;
+      int64_t delay_us = seen_us - tick_time(server, k);
+      run->delay_us = delay_us > run->delay_us ? delay_us : run->delay_us;
+      run->total_us += delay_us;
+      if (scheduler->next_us - now_us < run->shortest_us) {
+        run->shortest_us = scheduler->next_us - now_us;
+      }
+    }
+  }
+  run->ticks = (int)(server_generation(server, now_us) - first);
+  return now_us;
+}
+
+/* The learned period must be within POLL_LEAD_US of the real one */
+static bool near_period(const PollScheduler* scheduler, int64_t period_us) {
+  int64_t error = scheduler->period_us - period_us;
+  return error <= POLL_LEAD_US && error >= -POLL_LEAD_US;
+}
+
+/**
+ * @brief Checks a run after the period is learned: every tick is seen
+ * within a few retry steps and the average one within one, at two fetches
+ * per tick at most and without fetching again right after a tick.
+ * @param late_us How late the ticks may come
+ **/
+static void check_run(const TestRun* run, int64_t period_us, int64_t ticks,
+                      int64_t late_us) {
+  CHECK(run->ticks >= ticks - 1 && run->ticks <= ticks + 1);
+  CHECK(run->fetches <= 2 * run->ticks);
+  CHECK(run->delay_us <= 3 * POLL_STEP_US + TEST_LATENCY_US + 2 * late_us);
+  CHECK(run->total_us <= run->ticks * (POLL_STEP_US + late_us / 2));
+  CHECK(run->shortest_us >= period_us - 2 * POLL_STEP_US - late_us);
+}
+
+static void test_fixed_period(void) {
+  static const int64_t periods[] = {POLL_MIN_PERIOD_US, 15000, 20000, 100000,
+                                    350000, POLL_MAX_PERIOD_US};
+  for (size_t i = 0; i < sizeof(periods) / sizeof(periods[0]); ++i) {
+    TestServer server = {1000000 + periods[i] / 3, periods[i], 0, 7};
+    PollScheduler scheduler;
+    poll_scheduler_init(&scheduler);
+    TestRun run;
+    int64_t now_us = follow(&scheduler, &server, 1000000,
+                            1000000 + 20 * periods[i], &run);
+    CHECK(near_period(&scheduler, periods[i]));
+    now_us = follow(&scheduler, &server, now_us, now_us + 100 * periods[i],
+                    &run);
+    CHECK(near_period(&scheduler, periods[i]));
+    check_run(&run, periods[i], 100, 0);
+  }
+}
+
+static void test_jitter(void) {
+  TestServer server = {1050000, 100000, 10000, 1};
+  PollScheduler scheduler;
+  poll_scheduler_init(&scheduler);
+  TestRun run;
+  int64_t now_us = follow(&scheduler, &server, 1000000, 4000000, &run);
+  CHECK(near_period(&scheduler, server.period_us));
+  follow(&scheduler, &server, now_us, now_us + 20000000, &run);
+  CHECK(near_period(&scheduler, server.period_us));
+  check_run(&run, server.period_us, 200, server.jitter_us);
+}
+
+static void test_pace_change(void) {
+  TestServer slow = {1020000, 200000, 0, 1};
+  PollScheduler scheduler;
+  poll_scheduler_init(&scheduler);
+  TestRun run;
+  int64_t now_us = follow(&scheduler, &slow, 1000000, 5000000, &run);
+  CHECK(near_period(&scheduler, slow.period_us));
+
+  /* A level up: the ticks after the next one come on the new pace */
+  TestServer fast = {0, 80000, 0, 0};
+  fast.start_us = tick_time(&slow, (now_us - slow.start_us) / slow.period_us +
+                                       1);
+  fast.generation = server_generation(&slow, fast.start_us) - 1;
+  now_us = follow(&scheduler, &fast, now_us, fast.start_us + 3000000, &run);
+  CHECK(near_period(&scheduler, fast.period_us));
+  now_us = follow(&scheduler, &fast, now_us, now_us + 100 * fast.period_us,
+                  &run);
+  CHECK(near_period(&scheduler, fast.period_us));
+  check_run(&run, fast.period_us, 100, 0);
+
+  /* And slowing down again */
+  TestServer calm = {0, 150000, 0, 0};
+  calm.start_us = tick_time(&fast, (now_us - fast.start_us) / fast.period_us +
+                                       1);
+  calm.generation = server_generation(&fast, calm.start_us) - 1;
+  now_us = follow(&scheduler, &calm, now_us, calm.start_us + 3000000, &run);
+  CHECK(near_period(&scheduler, calm.period_us));
+  follow(&scheduler, &calm, now_us, now_us + 100 * calm.period_us, &run);
+  CHECK(near_period(&scheduler, calm.period_us));
+  check_run(&run, calm.period_us, 100, 0);
+}
+
+static void test_pause_backoff(void) {
+  TestServer server = {1010000, 100000, 0, 1};
+  PollScheduler scheduler;
+  poll_scheduler_init(&scheduler);
+  TestRun run;
+  int64_t now_us = follow(&scheduler, &server, 1000000, 3000000, &run);
+  CHECK(near_period(&scheduler, server.period_us));
+
+  /* Paused by the player, the frame stays the same */
+  Frame_t frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.status = PAUSE;
+  frame.generation = server_generation(&server, now_us) + 1;
+  TestServer paused = {INT64_MAX, server.period_us, 0, frame.generation};
+  poll_scheduler_wake(&scheduler, &frame, now_us);
+  CHECK(scheduler.next_us == now_us + POLL_IDLE_MIN_US);
+  int64_t delay_us = POLL_IDLE_MIN_US;
+  for (int i = 0; i < 10; ++i) {
+    now_us = fetch(&scheduler, &paused, PAUSE, now_us);
+    delay_us = delay_us * 2 < POLL_IDLE_MAX_US ? delay_us * 2
+                                               : POLL_IDLE_MAX_US;
+    CHECK(scheduler.next_us - now_us == delay_us);
+    CHECK(poll_scheduler_delay_ms(&scheduler, now_us) == delay_us / 1000);
+  }
+  CHECK(delay_us == POLL_IDLE_MAX_US);
+
+  /* Resumed: the ticks start over from the action */
+  frame.status = MOVING;
+  frame.generation++;
+  poll_scheduler_wake(&scheduler, &frame, now_us);
+  CHECK(scheduler.next_us == now_us + POLL_LEARN_STEP_US);
+  CHECK(scheduler.tick_us == 0 && scheduler.exact_us == 0);
+  TestServer resumed = {now_us + 30000, server.period_us, 0,
+                        frame.generation};
+  now_us = follow(&scheduler, &resumed, now_us, now_us + 2000000, &run);
+  CHECK(near_period(&scheduler, resumed.period_us));
+  follow(&scheduler, &resumed, now_us, now_us + 100 * resumed.period_us,
+         &run);
+  check_run(&run, resumed.period_us, 100, 0);
+}
+
+int main() {
+  test_fixed_period();
+  test_jitter();
+  test_pace_change();
+  test_pause_backoff();
+  if (failures != 0) {
+    fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+  printf("poll scheduler: all checks passed\n");
+  return 0;
+}
@@ -116,7 +116,7 @@ void clear_screen() {
 
 void cli_game_loop() {
   init_library("http://localhost:8080");
-  GameInfo_t game_info;
+  Frame_t frame = {0};
   int key = -1;
   int prev_key = -1;
   bool hold = false;
@@ -124,41 +124,58 @@ void cli_game_loop() {
   while (selected_game != -1) {
     GameType_t selected_type = {"", selected_game};
     select_game(selected_type);
+    PollScheduler scheduler;
+    poll_scheduler_init(&scheduler);
+    int64_t key_us = 0;
     bool break_flag = true;
     while (break_flag) {
-      GameStatus_t game_status;
-      if (get_current_game_status(&game_status).response_status != 200) {
-        game_status = EXIT;
-      }
+      /* One round trip per iteration: the action answers with the frame,
+       * otherwise wait for input until the scheduler expects a tick */
+      Response_t response;
+      int64_t now_us = poll_scheduler_now_us();
+      timeout(poll_scheduler_delay_ms(&scheduler, now_us));
       key = getch();
+      now_us = poll_scheduler_now_us();
       if (key != ERR) {
+        key_us = now_us;
         UserAction_t action = get_action(key, &hold, &prev_key);
-        if (submit_action(action, hold).response_status != 200) {
-          game_status = EXIT;
-        }
+        response = submit_action_frame(action, hold, &frame);
+        poll_scheduler_wake(&scheduler, &frame, poll_scheduler_now_us());
       } else {
-        prev_key = -1;
+        /* A held key repeats sooner than that */
+        if (now_us - key_us > CLI_HOLD_RELEASE_US) prev_key = -1;
+        response = get_frame(&frame);
+        poll_scheduler_update(&scheduler, &frame, now_us,
+                              poll_scheduler_now_us());
+      }
+      if (response.response_status == STATUS_NOT_MODIFIED) {
+        continue; /* The screen already shows this frame */
       }
+      GameStatus_t game_status =
+          response.response_status == 200 ? frame.status : EXIT;
+      int field_rows, field_cols;
+      get_field_size(&field_rows, &field_cols);
       if (game_status != PAUSE) {
-        get_current_state(&game_info);
         if (game_status == START) {
-          draw_start_screen();
-          draw_user_interface(game_info, game_status, selected_game);
+          draw_start_screen(field_rows, field_cols);
+          draw_user_interface(&frame, game_status, selected_game, field_rows,
+                              field_cols);
         } else if (game_status == GAMEOVER) {
-          draw_gameover_screen(game_info);
-          draw_user_interface(game_info, game_status, selected_game);
+          draw_gameover_screen(&frame, field_rows, field_cols);
+          draw_user_interface(&frame, game_status, selected_game, field_rows,
+                              field_cols);
         } else if (game_status != SPAWN) {
-          draw_user_interface(game_info, game_status, selected_game);
-          draw_field(game_info);
+          draw_user_interface(&frame, game_status, selected_game, field_rows,
+                              field_cols);
+          draw_field(&frame, field_rows, field_cols);
         }
         refresh();
         if (game_status == EXIT) {
           break_flag = false;
         }
-        free_game_state(&game_info);
       } else {
-        mvprintw(1 + CLI_ROWS_FIELD / 2, CLI_COLS_FIELD - 1, "PAUSE");
-        move(CLI_ROWS_FIELD + 1, CLI_COLS_FIELD * 2 + CLI_COLS_FIELD * 2 + 3);
+        mvprintw(1 + field_rows / 2, field_cols - 1, "PAUSE");
+        move(field_rows + 1, field_cols * 2 + field_cols * 2 + 3);
       }
     }
     clear();
@@ -196,79 +213,80 @@ UserAction_t get_action(int key, bool *hold, int *prev_key) {
   return result;
 }
 
-void draw_user_interface(GameInfo_t game_info, GameStatus_t game_status,
-                         int game_type) {
-  mvhline(0, 0, ACS_HLINE, CLI_COLS_FIELD * 2 + INFO_COLS * 2 + 2);
-  mvhline(CLI_ROWS_FIELD + 1, 0, ACS_HLINE,
-          CLI_COLS_FIELD * 2 + INFO_COLS * 2 + 2);
-  mvvline(1, 0, ACS_VLINE, CLI_ROWS_FIELD);
-  mvvline(1, CLI_COLS_FIELD * 2 + 1, ACS_VLINE, CLI_ROWS_FIELD);
-  mvvline(1, CLI_COLS_FIELD * 2 + INFO_COLS * 2 + 2, ACS_VLINE, CLI_ROWS_FIELD);
+void draw_user_interface(const Frame_t *frame, GameStatus_t game_status,
+                         int game_type, int field_rows, int field_cols) {
+  mvhline(0, 0, ACS_HLINE, field_cols * 2 + INFO_COLS * 2 + 2);
+  mvhline(field_rows + 1, 0, ACS_HLINE,
+          field_cols * 2 + INFO_COLS * 2 + 2);
+  mvvline(1, 0, ACS_VLINE, field_rows);
+  mvvline(1, field_cols * 2 + 1, ACS_VLINE, field_rows);
+  mvvline(1, field_cols * 2 + INFO_COLS * 2 + 2, ACS_VLINE, field_rows);
 
   mvaddch(0, 0, ACS_ULCORNER);
-  mvaddch(0, CLI_COLS_FIELD * 2 + INFO_COLS * 2 + 2, ACS_URCORNER);
-  mvaddch(CLI_ROWS_FIELD + 1, 0, ACS_LLCORNER);
-  mvaddch(CLI_ROWS_FIELD + 1, CLI_COLS_FIELD * 2 + INFO_COLS * 2 + 2,
+  mvaddch(0, field_cols * 2 + INFO_COLS * 2 + 2, ACS_URCORNER);
+  mvaddch(field_rows + 1, 0, ACS_LLCORNER);
+  mvaddch(field_rows + 1, field_cols * 2 + INFO_COLS * 2 + 2,
           ACS_LRCORNER);
 
-  mvaddch(0, CLI_COLS_FIELD * 2 + 1, ACS_TTEE);
-  mvaddch(CLI_ROWS_FIELD + 1, CLI_COLS_FIELD * 2 + 1, ACS_BTEE);
+  mvaddch(0, field_cols * 2 + 1, ACS_TTEE);
+  mvaddch(field_rows + 1, field_cols * 2 + 1, ACS_BTEE);
 
-  move(CLI_ROWS_FIELD + 1, CLI_COLS_FIELD * 2 + INFO_COLS * 2 + 3);
+  move(field_rows + 1, field_cols * 2 + INFO_COLS * 2 + 3);
 
-  mvprintw(2, CLI_COLS_FIELD * 2 + 3, "HIGH SCORE: %d", game_info.high_score);
-  mvprintw(4, CLI_COLS_FIELD * 2 + 3, "SCORE: %4d", game_info.score);
-  mvprintw(6, CLI_COLS_FIELD * 2 + 3, "LEVEL: %d", game_info.level);
-  mvprintw(8, CLI_COLS_FIELD * 2 + 3, "SPEED: %d", game_info.speed);
+  mvprintw(2, field_cols * 2 + 3, "HIGH SCORE: %d", frame->high_score);
+  mvprintw(4, field_cols * 2 + 3, "SCORE: %4d", frame->score);
+  mvprintw(6, field_cols * 2 + 3, "LEVEL: %d", frame->level);
+  mvprintw(8, field_cols * 2 + 3, "SPEED: %d", frame->speed);
   if (game_type == 1) {
-    mvprintw(10, CLI_COLS_FIELD * 2 + 3, "NEXT");
-    if (game_status != START && game_info.next != NULL) {
+    mvprintw(10, field_cols * 2 + 3, "NEXT");
+    if (game_status != START && frame->has_next) {
       for (int row = 0; row < 2; row++)
         for (int col = 0; col < 4; col++) {
-          if (game_info.next[row][col]) {
-            attron(COLOR_PAIR(game_info.next[row][col]));
-            mvaddch(11 + row, CLI_COLS_FIELD * 2 + 6 * 2 + col * 2,
+          int cell = frame->next[row * FRAME_NEXT_SIZE + col];
+          if (cell) {
+            attron(COLOR_PAIR(cell));
+            mvaddch(11 + row, field_cols * 2 + 6 * 2 + col * 2,
                     ACS_CKBOARD);
-            mvaddch(11 + row, CLI_COLS_FIELD * 2 + 6 * 2 + col * 2 + 1,
+            mvaddch(11 + row, field_cols * 2 + 6 * 2 + col * 2 + 1,
                     ACS_CKBOARD);
-            attroff(COLOR_PAIR(game_info.next[row][col]));
+            attroff(COLOR_PAIR(cell));
           } else {
             attron(COLOR_PAIR(8));
-            mvaddch(11 + row, CLI_COLS_FIELD * 2 + 6 * 2 + col * 2,
+            mvaddch(11 + row, field_cols * 2 + 6 * 2 + col * 2,
                     ACS_CKBOARD);
-            mvaddch(11 + row, CLI_COLS_FIELD * 2 + 6 * 2 + col * 2 + 1,
+            mvaddch(11 + row, field_cols * 2 + 6 * 2 + col * 2 + 1,
                     ACS_CKBOARD);
             attroff(COLOR_PAIR(8));
           }
         }
     }
   }
-  mvprintw(15, CLI_COLS_FIELD * 2 + 5, "P - Pause game");
-  mvaddch(16, CLI_COLS_FIELD * 2 + 5, ACS_LARROW);
+  mvprintw(15, field_cols * 2 + 5, "P - Pause game");
+  mvaddch(16, field_cols * 2 + 5, ACS_LARROW);
   addstr(" - Move left");
-  mvaddch(17, CLI_COLS_FIELD * 2 + 5, ACS_RARROW);
+  mvaddch(17, field_cols * 2 + 5, ACS_RARROW);
   addstr(" - Move right");
-  mvaddch(18, CLI_COLS_FIELD * 2 + 5, ACS_DARROW);
+  mvaddch(18, field_cols * 2 + 5, ACS_DARROW);
   addstr(" - Move down");
   if (game_type == 1) {
-    mvaddstr(19, CLI_COLS_FIELD * 2 + 3, "  R - Rotate");
+    mvaddstr(19, field_cols * 2 + 3, "  R - Rotate");
   } else {
-    mvaddch(19, CLI_COLS_FIELD * 2 + 5, ACS_UARROW);
+    mvaddch(19, field_cols * 2 + 5, ACS_UARROW);
     addstr(" - Move Up");
   }
-  mvaddstr(20, CLI_COLS_FIELD * 2 + 5, "Q  - Exit game");
-  move(CLI_ROWS_FIELD + 1, CLI_COLS_FIELD * 2 + INFO_COLS * 2 + 3);
+  mvaddstr(20, field_cols * 2 + 5, "Q  - Exit game");
+  move(field_rows + 1, field_cols * 2 + INFO_COLS * 2 + 3);
 }
 
-void draw_field(GameInfo_t game_info) {
+void draw_field(const Frame_t *frame, int field_rows, int field_cols) {
   chtype left_bar = '[' | A_DIM;
   chtype right_bar = ']' | A_DIM;
   int color_pair;
-  if (game_info.field != NULL) {
-    for (int row = 0; row < CLI_ROWS_FIELD; row++) {
-      for (int col = 0; col < CLI_COLS_FIELD; col++)
-        if (game_info.field[row][col] != 0) {
-          color_pair = game_info.field[row][col];
+  if (frame->rows != 0) {
+    for (int row = 0; row < frame->rows; row++) {
+      for (int col = 0; col < frame->cols; col++)
+        if (frame->cells[row * frame->cols + col] != 0) {
+          color_pair = frame->cells[row * frame->cols + col];
           if (color_pair > 8 && color_pair < 26) {
             color_pair = 1;
           }
@@ -285,7 +303,7 @@ void draw_field(GameInfo_t game_info) {
         }
     }
   }
-  move(CLI_ROWS_FIELD + 1, CLI_COLS_FIELD * 2 + CLI_COLS_FIELD * 2 + 3);
+  move(field_rows + 1, field_cols * 2 + field_cols * 2 + 3);
 }
 
 bool check_hold(int prev_key, int key) {
@@ -296,20 +314,21 @@ bool check_hold(int prev_key, int key) {
   return result;
 }
 
-void draw_start_screen() {
-  mvprintw(1 + CLI_ROWS_FIELD / 2, 1, "Press ENTER to start");
-  move(CLI_ROWS_FIELD + 1, CLI_COLS_FIELD * 2 + INFO_COLS * 2 + 3);
+void draw_start_screen(int field_rows, int field_cols) {
+  mvprintw(1 + field_rows / 2, 1, "Press ENTER to start");
+  move(field_rows + 1, field_cols * 2 + INFO_COLS * 2 + 3);
 }
 
-void draw_gameover_screen(GameInfo_t game_info) {
-  draw_field(game_info);
+void draw_gameover_screen(const Frame_t *frame, int field_rows,
+                          int field_cols) {
+  draw_field(frame, field_rows, field_cols);
 
-  mvprintw(CLI_ROWS_FIELD / 2, 7, "GAMEOVER");
-  mvprintw(CLI_ROWS_FIELD / 2 + 1, 5, "Press  ENTER");
-  mvprintw(CLI_ROWS_FIELD / 2 + 2, 9, "again");
-  mvprintw(CLI_ROWS_FIELD / 2 + 4, 3, "Your Score is %d", game_info.score);
+  mvprintw(field_rows / 2, 7, "GAMEOVER");
+  mvprintw(field_rows / 2 + 1, 5, "Press  ENTER");
+  mvprintw(field_rows / 2 + 2, 9, "again");
+  mvprintw(field_rows / 2 + 4, 3, "Your Score is %d", frame->score);
 
-  move(CLI_ROWS_FIELD + 1, CLI_COLS_FIELD * 2 + INFO_COLS * 2 + 3);
+  move(field_rows + 1, field_cols * 2 + INFO_COLS * 2 + 3);
 }
 
 void print_in_middle(WINDOW *win, int starty, int startx, int width,
@@ -331,21 +350,3 @@ void print_in_middle(WINDOW *win, int starty, int startx, int width,
   wattroff(win, color);
   refresh();
 }
-
-void free_game_state(GameInfo_t *current_state) {
-  if (current_state->field != NULL) {
-    for (int i = 0; i < CLI_ROWS_FIELD; ++i) {
-      free(current_state->field[i]);
-    }
-    free(current_state->field);
-    current_state->field = NULL;
-  }
-
-  if (current_state->next != NULL) {
-    for (int i = 0; i < 4; ++i) {
-      free(current_state->next[i]);
-    }
-    free(current_state->next);
-    current_state->next = NULL;
-  }
-}
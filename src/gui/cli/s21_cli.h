@@ -14,12 +14,11 @@
 #include <wchar.h>
 
 #include "../../client_library/s21_client_library.h"
+#include "../../client_library/s21_poll_scheduler.h"
 
 #define INFO_ROWS 20
 #define INFO_COLS 10
-
-#define CLI_ROWS_FIELD 20
-#define CLI_COLS_FIELD 10
+#define CLI_HOLD_RELEASE_US 50000 /* No repeat for this long: key released */
 
 #define ARRAY_SIZE(a) (sizeof(a) / sizeof(a[0]))
 
@@ -62,29 +61,37 @@ bool check_hold(int prev_key, int key);
  * @brief Draws start screen of the game.
  * @param tetris_game Game data struct.
  * @param game_type Current game type.
+ * @param field_rows Number of field rows reported by the server.
+ * @param field_cols Number of field columns.
  **/
-void draw_start_screen();
+void draw_start_screen(int field_rows, int field_cols);
 
 /**
  * @brief Draws user interface of the game.
- * @param tetris_game Game data struct.
+ * @param frame Current frame.
  * @param game_type Current game type.
+ * @param field_rows Number of field rows reported by the server.
+ * @param field_cols Number of field columns.
  **/
-void draw_user_interface(GameInfo_t game_info, GameStatus_t game_status,
-                         int game_type);
+void draw_user_interface(const Frame_t* frame, GameStatus_t game_status,
+                         int game_type, int field_rows, int field_cols);
 
 /**
  * @brief Draws field of the game.
- * @param tetris_game Game data struct.
+ * @param frame Current frame.
+ * @param field_rows Number of field rows reported by the server.
+ * @param field_cols Number of field columns.
  **/
-void draw_field(GameInfo_t tetris_game);
+void draw_field(const Frame_t* frame, int field_rows, int field_cols);
 
 /**
  * @brief Draws gameover screen of the game.
- * @param tetris_game Game data struct.
- * @param game_type Current game type.
+ * @param frame Current frame.
+ * @param field_rows Number of field rows reported by the server.
+ * @param field_cols Number of field columns.
  **/
-void draw_gameover_screen(GameInfo_t game_info);
+void draw_gameover_screen(const Frame_t* frame, int field_rows,
+                          int field_cols);
 
 /**
  * @brief Prints given string in a middle of a window
@@ -97,10 +104,5 @@ void draw_gameover_screen(GameInfo_t game_info);
  **/
 void print_in_middle(WINDOW* win, int starty, int startx, int width,
                      char* string, chtype color);
-/**
- * @brief Frees up GameInfo_t struct.
- * @param current_state Pointer to strcut that will be freed up.
-**/
-void free_game_state(GameInfo_t* current_state);
 
 #endif
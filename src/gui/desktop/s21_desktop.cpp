@@ -64,10 +64,12 @@ GameGraphicsScene::GameGraphicsScene(int gameId) : gameId(gameId) {
 
   initializeTextures();
 
-  // Set up timer for ~60FPS redraw
+  // Set up the fetch timer, drawGame() plans each next shot
+  poll_scheduler_init(&scheduler);
   drawTimer = new QTimer();
+  drawTimer->setSingleShot(true);
   connect(drawTimer, SIGNAL(timeout()), this, SLOT(drawGame()));
-  drawTimer->start(17);
+  drawTimer->start(0);
 }
 
 GameGraphicsScene::~GameGraphicsScene() {
@@ -88,8 +90,8 @@ GameGraphicsScene::~GameGraphicsScene() {
   }
 }
 
-void GameGraphicsScene::drawStartScreen(GameInfo_t gameInfo) {
-  drawInterface(gameInfo);
+void GameGraphicsScene::drawStartScreen(const Frame_t& frame) {
+  drawInterface(frame);
   if (!startText) {
     startText = new QGraphicsTextItem("Press ENTER to start");
     startText->setPos(BLOCK_WIDTH * 1.8, VIEW_HEIGHT / 2);
@@ -98,13 +100,13 @@ void GameGraphicsScene::drawStartScreen(GameInfo_t gameInfo) {
   }
 }
 
-void GameGraphicsScene::drawGameoverScreen(GameInfo_t gameInfo) {
+void GameGraphicsScene::drawGameoverScreen(const Frame_t& frame) {
   if (gameOverText.empty()) {
     gameOverText.push_back(new QGraphicsTextItem("GAMEOVER"));
     gameOverText.back()->setPos(BLOCK_WIDTH * 3.5, VIEW_HEIGHT / 2 - 60);
 
     gameOverText.push_back(new QGraphicsTextItem(
-        "Your score is " + QString::number(gameInfo.score)));
+        "Your score is " + QString::number(frame.score)));
     gameOverText.back()->setPos(BLOCK_WIDTH * 3, VIEW_HEIGHT / 2 - 30);
 
     gameOverText.push_back(new QGraphicsTextItem("again"));
@@ -117,16 +119,16 @@ void GameGraphicsScene::drawGameoverScreen(GameInfo_t gameInfo) {
   }
 }
 
-void GameGraphicsScene::drawInterface(GameInfo_t gameInfo) {
+void GameGraphicsScene::drawInterface(const Frame_t& frame) {
   clearDynamicText();
   dynamicText.push_back(new QGraphicsTextItem(
-      "High score: " + QString::number(gameInfo.high_score)));
+      "High score: " + QString::number(frame.high_score)));
   dynamicText.push_back(
-      new QGraphicsTextItem("Score: " + QString::number(gameInfo.score)));
+      new QGraphicsTextItem("Score: " + QString::number(frame.score)));
   dynamicText.push_back(
-      new QGraphicsTextItem("Level: " + QString::number(gameInfo.level)));
+      new QGraphicsTextItem("Level: " + QString::number(frame.level)));
   dynamicText.push_back(
-      new QGraphicsTextItem("Speed: " + QString::number(gameInfo.speed)));
+      new QGraphicsTextItem("Speed: " + QString::number(frame.speed)));
 
   if (gameId == 1) {
     dynamicText.push_back(new QGraphicsTextItem("Next: "));
@@ -139,14 +141,14 @@ void GameGraphicsScene::drawInterface(GameInfo_t gameInfo) {
   }
 }
 
-void GameGraphicsScene::drawField(GameInfo_t gameInfo) {
+void GameGraphicsScene::drawField(const Frame_t& frame) {
   clearField();
-  if (gameInfo.field) {
-    for (int i = 0; i < FIELD_BLOCKS_HEIGHT_COUNT; ++i) {
-      for (int j = 0; j < FIELD_BLOCKS_WIDTH_COUNT; ++j) {
-        if (gameInfo.field[i][j] != BLANK) {
-          field.push_back(
-              new QGraphicsPixmapItem(textures[gameInfo.field[i][j]]));
+  if (frame.rows != 0) {
+    for (int i = 0; i < frame.rows; ++i) {
+      for (int j = 0; j < frame.cols; ++j) {
+        int cell = frame.cells[i * frame.cols + j];
+        if (cell != BLANK) {
+          field.push_back(new QGraphicsPixmapItem(textures[cell]));
           field.back()->setPos((j + 1) * BLOCK_WIDTH, (i + 1) * BLOCK_HEIGHT);
           addItem(field.back());
         }
@@ -163,17 +165,17 @@ void GameGraphicsScene::drawField(GameInfo_t gameInfo) {
     }
   }
   if (gameId == 1) {
-    drawNextFigure(gameInfo);
+    drawNextFigure(frame);
   }
 }
 
-void GameGraphicsScene::drawNextFigure(GameInfo_t gameInfo) {
-  if (gameInfo.next) {
-    for (int i = 0; i < 4; ++i) {
-      for (int j = 0; j < 4; ++j) {
-        if (gameInfo.next[i][j] != 0) {
-          field.push_back(
-              new QGraphicsPixmapItem(textures[gameInfo.next[i][j]]));
+void GameGraphicsScene::drawNextFigure(const Frame_t& frame) {
+  if (frame.has_next) {
+    for (int i = 0; i < FRAME_NEXT_SIZE; ++i) {
+      for (int j = 0; j < FRAME_NEXT_SIZE; ++j) {
+        int cell = frame.next[i * FRAME_NEXT_SIZE + j];
+        if (cell != 0) {
+          field.push_back(new QGraphicsPixmapItem(textures[cell]));
           field.back()->setPos(
               GAME_FIELD_WIDTH + BLOCK_WIDTH * 5 + (BLOCK_WIDTH * j),
               (GAME_FIELD_HEIGHT * 0.4) + (i * BLOCK_HEIGHT));
@@ -299,51 +301,54 @@ void GameGraphicsScene::keyPressEvent(QKeyEvent* event) {
     default:
       return;  // no recognized key, ignore
   }
-  submit_action(action, hold);
+  // The answer carries the frame, no need to wait for the next fetch
+  Response_t response = submit_action_frame(action, hold, &currentFrame);
+  int64_t nowUs = poll_scheduler_now_us();
+  poll_scheduler_wake(&scheduler, &currentFrame, nowUs);
+  if (response.response_status == STATUS_OK && currentFrame.status != EXIT) {
+    drawTimer->start(poll_scheduler_delay_ms(&scheduler, nowUs));
+    showFrame(response);
+  } else {
+    // Ends the game from the timer, not from inside the key event
+    drawTimer->start(0);
+  }
 }
 
 void GameGraphicsScene::drawGame() {
-  clearPauseText();
-  GameInfo_t gameInfo;
-  GameStatus_t gameStatus;
+  // Status and field come in one snapshot, so they always agree
+  int64_t sentUs = poll_scheduler_now_us();
+  Response_t response = get_frame(&currentFrame);
+  int64_t nowUs = poll_scheduler_now_us();
+  poll_scheduler_update(&scheduler, &currentFrame, sentUs, nowUs);
+  drawTimer->start(poll_scheduler_delay_ms(&scheduler, nowUs));
+  showFrame(response);
+}
 
-  get_current_game_status(&gameStatus);
+void GameGraphicsScene::showFrame(const Response_t& response) {
+  if (response.response_status == STATUS_NOT_MODIFIED) {
+    return;  // the scene already shows this frame
+  }
+  clearPauseText();
+  GameStatus_t gameStatus = EXIT;
+  if (response.response_status == STATUS_OK) {
+    gameStatus = currentFrame.status;
+  }
 
   if (gameStatus != PAUSE) {
-    if (get_current_state(&gameInfo).response_status != STATUS_OK) {
-      gameStatus = EXIT;
-    }
-
     if (gameStatus == EXIT) {
       emit endGame();
     }
 
     if (gameStatus == START) {
-      drawStartScreen(gameInfo);
+      drawStartScreen(currentFrame);
     } else if (gameStatus == GAMEOVER) {
-      drawGameoverScreen(gameInfo);
+      drawGameoverScreen(currentFrame);
     } else if (gameStatus != SPAWN && gameStatus != EXIT) {
       clearGameOverText();
       clearStartText();
-      drawInterface(gameInfo);
-      drawField(gameInfo);
-    }
-
-    if (gameInfo.field) {
-      for (int i = 0; i < FIELD_BLOCKS_HEIGHT_COUNT; ++i) {
-        free(gameInfo.field[i]);
-      }
-      free(gameInfo.field);
-      gameInfo.field = nullptr;
-    }
-    if (gameInfo.next) {
-      for (int i = 0; i < 4; ++i) {
-        free(gameInfo.next[i]);
-      }
-      free(gameInfo.next);
-      gameInfo.next = nullptr;
+      drawInterface(currentFrame);
+      drawField(currentFrame);
     }
-
   } else {
     drawPause();
   }
@@ -19,6 +19,7 @@
 
 extern "C" {
 #include "../../client_library/s21_client_library.h"
+#include "../../client_library/s21_poll_scheduler.h"
 }
 
 namespace s21 {
@@ -68,13 +69,18 @@ class GameGraphicsScene : public QGraphicsScene {
   ~GameGraphicsScene();
 
   /* ---- Rendering Methods ---- */
-  void drawStartScreen(GameInfo_t gameInfo);
-  void drawGameoverScreen(GameInfo_t gameInfo);
-  void drawInterface(GameInfo_t gameInfo);
-  void drawField(GameInfo_t gameInfo);
-  void drawNextFigure(GameInfo_t gameInfo);
+  void drawStartScreen(const Frame_t& frame);
+  void drawGameoverScreen(const Frame_t& frame);
+  void drawInterface(const Frame_t& frame);
+  void drawField(const Frame_t& frame);
+  void drawNextFigure(const Frame_t& frame);
   void drawPause();
 
+  /**
+   * @brief Draws currentFrame as answered with response, may end the game.
+   */
+  void showFrame(const Response_t& response);
+
   /**
    * @brief Initializes a map of Pixmaps (textures).
    */
@@ -97,7 +103,7 @@ class GameGraphicsScene : public QGraphicsScene {
  private:
   int gameId;
   QFont* gameFont;               ///< Font used in the GUI.
-  QTimer* drawTimer;             ///< Timer controlling redraw (~60 FPS).
+  QTimer* drawTimer;             ///< Fires when the next frame is due.
   QGraphicsTextItem* startText;  ///< Text displayed before game starts.
   QGraphicsTextItem* pauseText;  ///< Text displayed during pause.
   std::vector<QGraphicsPixmapItem*> walls;  ///< Window border textures.
@@ -108,6 +114,8 @@ class GameGraphicsScene : public QGraphicsScene {
   std::vector<QGraphicsTextItem*>
       gameOverText;                 ///< Text for "Game Over" screen.
   std::map<int, QPixmap> textures;  ///< Map of textures per object ID.
+  Frame_t currentFrame{};  ///< Last frame fetched from the server.
+  PollScheduler scheduler{};  ///< Plans fetches around the game ticks.
 
  signals:
   void endGame();  ///< Signal emitted when it's time to exit the game.